@@ -162,6 +162,7 @@ void drawLine(int x1, int y1, int x2, int y2, Uint32 color)
     }
 
     err = dx - dy;
+    GFX_markScreen(screen);
 
     while (1)
     {
@@ -200,6 +201,7 @@ int _renderText(const char *text, TTF_Font *font, SDL_Color color, SDL_Rect *rec
             SDL_BlitSurface(textSurface, NULL, screen, &(SDL_Rect){rect->x - textSurface->w, rect->y, rect->w, rect->h});
         else
             SDL_BlitSurface(textSurface, NULL, screen, rect);
+        GFX_markScreen(screen);
         SDL_FreeSurface(textSurface);
     }
     return text_width;
@@ -556,6 +558,7 @@ void renderPage()
             }
         }
         SDL_UnlockSurface(screen);
+        GFX_markScreen(screen);
         if (x_end != 0)
             GFX_blitAsset(ASSET_BATTERY_LOW, NULL, screen, &(SDL_Rect){x_end, y_end});
     }
@@ -70,6 +70,7 @@ int main(int argc , char* argv[]) {
 	// x,y,w are pre-scaled
 	int blit(int i, int x, int y) {
 		SDL_BlitSurface(digits, &(SDL_Rect){i*SCALE1(10),0,SCALE2(10,16)}, screen, &(SDL_Rect){x,y});
+		GFX_markScreen(screen);
 		return x + SCALE1(10);
 	}
 	void blitBar(int x, int y, int w) {
@@ -291,6 +292,7 @@ int main(int argc , char* argv[]) {
 				SDL_Surface* text = TTF_RenderUTF8_Blended(font.large, am_selected ? "AM" : "PM", COLOR_WHITE);
 				ampm_w = text->w + SCALE1(2);
 				SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){x,y-SCALE1(3)});
+				GFX_markScreen(screen);
 				SDL_FreeSurface(text);
 			}
 		
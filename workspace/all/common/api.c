@@ -18,6 +18,7 @@
 
 #include "utils.h"
 #include "config.h"
+#include "blit.h"
 
 #include <pthread.h>
 
@@ -331,11 +332,25 @@ SDL_Surface *GFX_init(int mode)
 	if (!exists(asset_path))
 		LOG_info("missing assets, you're about to segfault dummy!\n");
 	gfx.assets = IMG_Load(asset_path);
+	if (gfx.assets && gfx.assets->format->format != gfx.screen->format->format)
+	{
+		// match the screen so GFX_blitAssetColor can take the BLIT_ path
+		SDL_Surface *converted = SDL_ConvertSurfaceFormat(gfx.assets, gfx.screen->format->format, 0);
+		if (converted)
+		{
+			SDL_FreeSurface(gfx.assets);
+			gfx.assets = converted;
+			SDL_SetSurfaceBlendMode(gfx.assets, SDL_BLENDMODE_BLEND);
+		}
+	}
+	if (gfx.assets)
+		PLAT_setAssetAtlas(gfx.assets);
 
 	PLAT_clearAll();
 
 	return gfx.screen;
 }
+static void AMB_quit(void);
 void GFX_quit(void)
 {
 
@@ -349,6 +364,7 @@ void GFX_quit(void)
 	CFG_quit();
 
 	GFX_freeAAScaler();
+	AMB_quit();
 
 	PLAT_quitVideo();
 }
@@ -422,109 +438,222 @@ void chmodfile(const char *file, int writable)
 	}
 }
 
-uint32_t GFX_extract_average_color(const void *data, unsigned width, unsigned height, size_t pitch)
-{
-	if (!data)
-	{
-		return 0;
-	}
+///////////////////////////////
+// ambient leds, sampled off the emulation thread
 
-	const uint16_t *pixels = (const uint16_t *)data;
-	int pixel_count = width * height;
+#define AMBIENT_INTERVAL 100	// ms between snapshots, ~10 Hz
+#define AMBIENT_SMOOTHING 0.35f // how far each sample moves the colour
+#define AMBIENT_THRESHOLD 6		// per channel change worth rewriting the leds for
 
-	uint64_t total_r = 0;
-	uint64_t total_g = 0;
-	uint64_t total_b = 0;
-	uint32_t colorful_pixel_count = 0;
+static struct AMB_Context
+{
+	int initialized;
+	int quit;
+	pthread_t pt;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+
+	// snapshot, owned by the thread while pending is set
+	int pending;
+	uint32_t taken;
+	void *frame;
+	size_t frame_size;
+	int width;
+	int height;
+	int pitch;
+	int bpp;
+	int mode;
+	int generation; // leds_generation when the snapshot was taken
+
+	// under leds_lock
+	float r, g, b;
+	uint32_t pushed;
+	int pushed_mode; // 0 until the next snapshot has been pushed
+} amb = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.ready = PTHREAD_COND_INITIALIZER,
+};
 
-	for (unsigned y = 0; y < height; y++)
-	{
-		for (unsigned x = 0; x < width; x++)
-		{
-			uint16_t pixel = pixels[y * (pitch / 2) + x];
+// lights and the leds themselves are written by both the main thread and AMB_thread,
+// every LED_* and LEDS_* call holds leds_lock. resetting the leds bumps the generation
+// so a snapshot taken before doesn't paint over them, and clears pushed_mode so the
+// next one is pushed even if the colour hasn't moved
+static pthread_mutex_t leds_lock = PTHREAD_MUTEX_INITIALIZER;
+static int leds_generation;
 
-			uint8_t r = ((pixel & 0xF800) >> 11) << 3;
-			uint8_t g = ((pixel & 0x07E0) >> 5) << 2;
-			uint8_t b = (pixel & 0x001F) << 3;
+static void updateLeds(void);
 
-			r |= r >> 5;
-			g |= g >> 6;
-			b |= b >> 5;
+// with leds_lock held
+static void AMB_invalidate(void)
+{
+	amb.pushed_mode = 0;
+	__atomic_add_fetch(&leds_generation, 1, __ATOMIC_RELAXED);
+}
 
-			uint8_t max_c = fmaxf(fmaxf(r, g), b);
-			uint8_t min_c = fminf(fminf(r, g), b);
-			uint8_t saturation = max_c == 0 ? 0 : (max_c - min_c) * 255 / max_c;
+uint32_t GFX_extract_average_color(const void *data, unsigned width, unsigned height, size_t pitch, int bpp)
+{
+	return BLIT_averageColor(data, bpp, width, height, pitch);
+}
 
-			if (saturation > 50 && max_c > 50)
-			{
-				total_r += r;
-				total_g += g;
-				total_b += b;
-				colorful_pixel_count++;
-			}
-		}
+static void applyAmbientColor(uint32_t dominant_color, int mode)
+{
+	if (mode == 1 || mode == 2 || mode == 5)
+	{
+		(*lights)[2].color1 = dominant_color;
+		(*lights)[2].effect = 4;
+		(*lights)[2].brightness = 100;
 	}
+	if (mode == 1 || mode == 3)
+	{
+		(*lights)[0].color1 = dominant_color;
+		(*lights)[0].effect = 4;
+		(*lights)[0].brightness = 100;
+		(*lights)[1].color1 = dominant_color;
+		(*lights)[1].effect = 4;
+		(*lights)[1].brightness = 100;
+	}
+	if (mode == 1 || mode == 4 || mode == 5)
+	{
+		(*lights)[3].color1 = dominant_color;
+		(*lights)[3].effect = 4;
+		(*lights)[3].brightness = 100;
+	}
+}
 
-	if (colorful_pixel_count == 0)
+static int ambientChanged(uint32_t a, uint32_t b)
+{
+	for (int shift = 0; shift < 24; shift += 8)
 	{
+		int d = (int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF);
+		if (d > AMBIENT_THRESHOLD || d < -AMBIENT_THRESHOLD)
+			return 1;
+	}
+	return 0;
+}
 
-		colorful_pixel_count = pixel_count;
-		total_r = total_g = total_b = 0;
-		for (unsigned y = 0; y < height; y++)
+static void *AMB_thread(void *arg)
+{
+	pthread_mutex_lock(&amb.lock);
+	while (!amb.quit)
+	{
+		if (!amb.pending)
 		{
-			for (unsigned x = 0; x < width; x++)
-			{
-				uint16_t pixel = pixels[y * (pitch / 2) + x];
-				uint8_t r = ((pixel & 0xF800) >> 11) << 3;
-				uint8_t g = ((pixel & 0x07E0) >> 5) << 2;
-				uint8_t b = (pixel & 0x001F) << 3;
+			pthread_cond_wait(&amb.ready, &amb.lock);
+			continue;
+		}
+		int mode = amb.mode;
+		int generation = amb.generation;
+		pthread_mutex_unlock(&amb.lock);
 
-				r |= r >> 5;
-				g |= g >> 6;
-				b |= b >> 5;
+		uint32_t color = GFX_extract_average_color(amb.frame, amb.width, amb.height, amb.pitch, amb.bpp);
+		float r = (color >> 16) & 0xFF;
+		float g = (color >> 8) & 0xFF;
+		float b = color & 0xFF;
+
+		pthread_mutex_lock(&leds_lock);
+		if (generation == leds_generation)
+		{
+			// a new mode starts from the current frame instead of fading in from the last one
+			if (amb.pushed_mode != mode)
+			{
+				amb.r = r;
+				amb.g = g;
+				amb.b = b;
+			}
+			else
+			{
+				amb.r += (r - amb.r) * AMBIENT_SMOOTHING;
+				amb.g += (g - amb.g) * AMBIENT_SMOOTHING;
+				amb.b += (b - amb.b) * AMBIENT_SMOOTHING;
+			}
 
-				total_r += r;
-				total_g += g;
-				total_b += b;
+			uint32_t smoothed = ((uint32_t)(amb.r + 0.5f) << 16) | ((uint32_t)(amb.g + 0.5f) << 8) | (uint32_t)(amb.b + 0.5f);
+			if (amb.pushed_mode != mode || ambientChanged(smoothed, amb.pushed))
+			{
+				applyAmbientColor(smoothed, mode);
+				updateLeds();
+				amb.pushed = smoothed;
+				amb.pushed_mode = mode;
 			}
 		}
+		pthread_mutex_unlock(&leds_lock);
+
+		pthread_mutex_lock(&amb.lock);
+		amb.pending = 0;
 	}
+	pthread_mutex_unlock(&amb.lock);
+	return 0;
+}
 
-	uint8_t avg_r = total_r / colorful_pixel_count;
-	uint8_t avg_g = total_g / colorful_pixel_count;
-	uint8_t avg_b = total_b / colorful_pixel_count;
+static void AMB_quit(void)
+{
+	if (!amb.initialized)
+		return;
+
+	pthread_mutex_lock(&amb.lock);
+	amb.quit = 1;
+	pthread_cond_signal(&amb.ready);
+	pthread_mutex_unlock(&amb.lock);
+	pthread_join(amb.pt, NULL);
 
-	return (avg_r << 16) | (avg_g << 8) | avg_b;
+	free(amb.frame);
+	amb.frame = NULL;
+	amb.frame_size = 0;
+	amb.pending = 0;
+	amb.quit = 0;
+	amb.initialized = 0;
 }
 
-void GFX_setAmbientColor(const void *data, unsigned width, unsigned height, size_t pitch, int mode)
+void GFX_setAmbientColor(const void *data, unsigned width, unsigned height, size_t pitch, int bpp, int mode)
 {
-	if (mode == 0)
+	if (mode == 0 || !data)
 		return;
 
-	uint32_t dominant_color = GFX_extract_average_color(data, width, height, pitch);
+	uint32_t now = SDL_GetTicks();
+	if (now - amb.taken < AMBIENT_INTERVAL)
+		return;
 
-	if (mode == 1 || mode == 2 || mode == 5)
+	// the thread is still on the last snapshot, try again next frame
+	if (pthread_mutex_trylock(&amb.lock) != 0)
+		return;
+	if (amb.pending)
 	{
-		(*lights)[2].color1 = dominant_color;
-		(*lights)[2].effect = 4;
-		(*lights)[2].brightness = 100;
+		pthread_mutex_unlock(&amb.lock);
+		return;
 	}
-	if (mode == 1 || mode == 3)
+
+	size_t size = pitch * height;
+	if (size > amb.frame_size)
 	{
-		(*lights)[0].color1 = dominant_color;
-		(*lights)[0].effect = 4;
-		(*lights)[0].brightness = 100;
-		(*lights)[1].color1 = dominant_color;
-		(*lights)[1].effect = 4;
-		(*lights)[1].brightness = 100;
+		void *frame = realloc(amb.frame, size);
+		if (!frame)
+		{
+			pthread_mutex_unlock(&amb.lock);
+			return;
+		}
+		amb.frame = frame;
+		amb.frame_size = size;
 	}
-	if (mode == 1 || mode == 4 || mode == 5)
+	memcpy(amb.frame, data, size);
+
+	amb.width = width;
+	amb.height = height;
+	amb.pitch = pitch;
+	amb.bpp = bpp;
+	amb.mode = mode;
+	amb.generation = __atomic_load_n(&leds_generation, __ATOMIC_RELAXED);
+	amb.taken = now;
+	amb.pending = 1;
+
+	if (!amb.initialized)
 	{
-		(*lights)[3].color1 = dominant_color;
-		(*lights)[3].effect = 4;
-		(*lights)[3].brightness = 100;
+		if (pthread_create(&amb.pt, NULL, &AMB_thread, NULL) == 0)
+			amb.initialized = 1;
+		else
+			amb.pending = 0;
 	}
+	pthread_cond_signal(&amb.ready);
+	pthread_mutex_unlock(&amb.lock);
 }
 
 void GFX_flip(SDL_Surface *screen)
@@ -730,6 +859,8 @@ void GFX_delay(void)
 }
 
 FALLBACK_IMPLEMENTATION int PLAT_supportsOverscan(void) { return 0; }
+FALLBACK_IMPLEMENTATION void PLAT_enableGPUTimers(int enable) {}
+FALLBACK_IMPLEMENTATION int PLAT_getGPUPassTimings(GPU_PassTiming *timings, int max) { return 0; }
 FALLBACK_IMPLEMENTATION void PLAT_setEffectColor(int next_color) {}
 
 int GFX_truncateText(TTF_Font *font, const char *in_name, char *out_name, int max_width, int padding)
@@ -842,286 +973,19 @@ int GFX_wrapText(TTF_Font *font, char *str, int max_width, int max_lines)
 
 ///////////////////////////////
 
-// scale_blend (and supporting logic) from picoarch
-
-struct blend_args
-{
-	int w_ratio_in;
-	int w_ratio_out;
-	uint16_t w_bp[2];
-	int h_ratio_in;
-	int h_ratio_out;
-	uint16_t h_bp[2];
-	uint16_t *blend_line;
-} blend_args;
-
-// Pure C fallbacks
-static inline uint32_t average16_c(uint32_t c1, uint32_t c2)
-{
-	return (c1 + c2 + ((c1 ^ c2) & 0x0821)) >> 1;
-}
-
-static inline uint32_t average32_c(uint32_t c1, uint32_t c2)
-{
-	uint32_t sum = c1 + c2;
-	uint32_t ret = sum + ((c1 ^ c2) & 0x08210821);
-	uint32_t of = ((sum < c1) | (ret < sum)) << 31;
-
-	return (ret >> 1) | of;
-}
-
-// not sure we are activating this anywhere currently, but we could.
-// to be honest, I'm not sure if we're using this function at all right now,
-// but I'm fixing it anyway so might as well improve it.
-#ifdef HAS_NEON
-// #if defined(__ARM_NEON) || defined(__ARM_NEON__)
-static inline uint32x4_t average32_neon(uint32x4_t a, uint32x4_t b)
-{
-	return vhaddq_u32(a, b); // vector halving add (a + b) >> 1
-}
-#endif
-
-// aarch32 asm
-#if defined(__arm__) && !defined(__aarch64__)
-static inline uint32_t average16(uint32_t c1, uint32_t c2)
-{
-	uint32_t ret, lowbits = 0x0821;
-	asm volatile(
-			"eor %0, %2, %3\n\t"
-			"and %0, %0, %1\n\t"
-			"add %0, %3, %0\n\t"
-			"add %0, %0, %2\n\t"
-			"lsr %0, %0, #1\n\t"
-			: "=&r"(ret)
-			: "r"(lowbits), "r"(c1), "r"(c2));
-	return ret;
-}
-
-static inline uint32_t average32(uint32_t c1, uint32_t c2)
-{
-	uint32_t ret, lowbits = 0x08210821;
-	asm volatile(
-			"eor %0, %3, %1\n\t"
-			"and %0, %0, %2\n\t"
-			"adds %0, %1, %0\n\t"
-			"and %1, %1, #0\n\t"
-			"movcs %1, #0x80000000\n\t"
-			"adds %0, %0, %3\n\t"
-			"rrx %0, %0\n\t"
-			"orr %0, %0, %1\n\t"
-			: "=&r"(ret), "+r"(c2)
-			: "r"(lowbits), "r"(c1)
-			: "cc");
-	return ret;
-}
-
-// aarch64 asm
-#elif defined(__aarch64__)
-
-static inline uint32_t average16(uint32_t c1, uint32_t c2)
-{
-	uint32_t result;
-	asm volatile(
-			"and w2, %w0, %w1\n\t"
-			"eor w3, %w0, %w1\n\t"
-			"lsr w3, w3, #1\n\t"
-			"add %w2, w2, w3\n\t"
-			"mov %w0, w2\n\t"
-			: "+r"(c1)
-			: "r"(c2)
-			: "w2", "w3");
-	return c1;
-}
-
-static inline uint32_t average32(uint32_t c1, uint32_t c2)
-{
-	uint32_t result;
-	asm volatile(
-			"and w2, %w0, %w1\n\t"
-			"eor w3, %w0, %w1\n\t"
-			"lsr w3, w3, #1\n\t"
-			"add w2, w2, w3\n\t"
-			"mov %w0, w2\n\t"
-			: "+r"(c1)
-			: "r"(c2)
-			: "w2", "w3");
-	return c1;
-}
-
-// fallback if nothing else works
-#else
-#define average16 average16_c
-#define average32 average32_c
-#endif
+// scale_blend from picoarch, lives in scaler.c as scaler_getAA
 
-#define AVERAGE16_NOCHK(c1, c2) (average16((c1), (c2)))
-#define AVERAGE32_NOCHK(c1, c2) (average32((c1), (c2)))
-
-#define AVERAGE16(c1, c2) ((c1) == (c2) ? (c1) : AVERAGE16_NOCHK((c1), (c2)))
-#define AVERAGE16_1_3(c1, c2) ((c1) == (c2) ? (c1) : (AVERAGE16_NOCHK(AVERAGE16_NOCHK((c1), (c2)), (c2))))
-
-#define AVERAGE32(c1, c2) ((c1) == (c2) ? (c1) : AVERAGE32_NOCHK((c1), (c2)))
-#define AVERAGE32_1_3(c1, c2) ((c1) == (c2) ? (c1) : (AVERAGE32_NOCHK(AVERAGE32_NOCHK((c1), (c2)), (c2))))
-
-static inline int gcd(int a, int b)
-{
-	return b ? gcd(b, a % b) : a;
-}
-
-static void scaleAA(void *__restrict src, void *__restrict dst, uint32_t w, uint32_t h, uint32_t pitch, uint32_t dst_w, uint32_t dst_h, uint32_t dst_p)
+scaler_t GFX_getAAScaler(GFX_Renderer *renderer)
 {
-	int dy = 0;
-	int lines = h;
-
-	int rat_w = blend_args.w_ratio_in;
-	int rat_dst_w = blend_args.w_ratio_out;
-	uint16_t *bw = blend_args.w_bp;
-
-	int rat_h = blend_args.h_ratio_in;
-	int rat_dst_h = blend_args.h_ratio_out;
-	uint16_t *bh = blend_args.h_bp;
-
-	while (lines--)
-	{
-		while (dy < rat_dst_h)
-		{
-			uint16_t *dst16 = (uint16_t *)dst;
-			uint16_t *pblend = (uint16_t *)blend_args.blend_line;
-			int col = w;
-			int dx = 0;
-
-			uint16_t *pnext = (uint16_t *)(src + pitch);
-			if (!lines)
-				pnext -= (pitch / sizeof(uint16_t));
-
-			if (dy > rat_dst_h - bh[0])
-			{
-				pblend = pnext;
-			}
-			else if (dy <= bh[0])
-			{
-				/* Drops const, won't get touched later though */
-				pblend = (uint16_t *)src;
-			}
-			else
-			{
-				const uint32_t *src32 = (const uint32_t *)src;
-				const uint32_t *pnext32 = (const uint32_t *)pnext;
-				uint32_t *pblend32 = (uint32_t *)pblend;
-				int count = w / 2;
-
-				if (dy <= bh[1])
-				{
-					const uint32_t *tmp = pnext32;
-					pnext32 = src32;
-					src32 = tmp;
-				}
-
-				if (dy > rat_dst_h - bh[1] || dy <= bh[1])
-				{
-					while (count--)
-					{
-						*pblend32++ = AVERAGE32_1_3(*src32, *pnext32);
-						src32++;
-						pnext32++;
-					}
-				}
-				else
-				{
-					while (count--)
-					{
-						*pblend32++ = AVERAGE32(*src32, *pnext32);
-						src32++;
-						pnext32++;
-					}
-				}
-			}
-
-			while (col--)
-			{
-				uint16_t a, b, out;
-
-				a = *pblend;
-				b = *(pblend + 1);
-
-				while (dx < rat_dst_w)
-				{
-					if (a == b)
-					{
-						out = a;
-					}
-					else if (dx > rat_dst_w - bw[0])
-					{ // top quintile, bbbb
-						out = b;
-					}
-					else if (dx <= bw[0])
-					{ // last quintile, aaaa
-						out = a;
-					}
-					else
-					{
-						if (dx > rat_dst_w - bw[1])
-						{ // 2nd quintile, abbb
-							a = AVERAGE16_NOCHK(a, b);
-						}
-						else if (dx <= bw[1])
-						{ // 4th quintile, aaab
-							b = AVERAGE16_NOCHK(a, b);
-						}
-
-						out = AVERAGE16_NOCHK(a, b); // also 3rd quintile, aabb
-					}
-					*dst16++ = out;
-					dx += rat_w;
-				}
-
-				dx -= rat_dst_w;
-				pblend++;
-			}
-
-			dy += rat_h;
-			dst += dst_p;
-		}
-
-		dy -= rat_dst_h;
-		src += pitch;
-	}
+	return scaler_getAA(SCALER_FORMAT_16, renderer->src_w, renderer->src_h, renderer->dst_w, renderer->dst_h);
 }
-
-scaler_t GFX_getAAScaler(GFX_Renderer *renderer)
+scaler_t GFX_getAAScaler32(GFX_Renderer *renderer)
 {
-	int gcd_w, div_w, gcd_h, div_h;
-	blend_args.blend_line = (uint16_t *)calloc(renderer->src_w, sizeof(uint16_t));
-
-	gcd_w = gcd(renderer->src_w, renderer->dst_w);
-	blend_args.w_ratio_in = renderer->src_w / gcd_w;
-	blend_args.w_ratio_out = renderer->dst_w / gcd_w;
-
-	double blend_denominator = (renderer->src_w > renderer->dst_w) ? 5 : 2.5; // TODO: these values are really only good for the nano...
-	// blend_denominator = 5.0; // better for trimui
-	// LOG_info("blend_denominator: %f (%i && %i)\n", blend_denominator, HAS_SKINNY_SCREEN, renderer->dst_w>renderer->src_w);
-
-	div_w = round(blend_args.w_ratio_out / blend_denominator);
-	blend_args.w_bp[0] = div_w;
-	blend_args.w_bp[1] = blend_args.w_ratio_out >> 1;
-
-	gcd_h = gcd(renderer->src_h, renderer->dst_h);
-	blend_args.h_ratio_in = renderer->src_h / gcd_h;
-	blend_args.h_ratio_out = renderer->dst_h / gcd_h;
-
-	div_h = round(blend_args.h_ratio_out / blend_denominator);
-	blend_args.h_bp[0] = div_h;
-	blend_args.h_bp[1] = blend_args.h_ratio_out >> 1;
-
-	return scaleAA;
+	return scaler_getAA(SCALER_FORMAT_32, renderer->src_w, renderer->src_h, renderer->dst_w, renderer->dst_h);
 }
 void GFX_freeAAScaler(void)
 {
-	if (blend_args.blend_line != NULL)
-	{
-		free(blend_args.blend_line);
-		blend_args.blend_line = NULL;
-	}
+	scaler_freeAA();
 }
 
 ///////////////////////////////
@@ -1159,6 +1023,7 @@ SDL_Rect GFX_blitStretch(SDL_Surface *src, SDL_Surface *dst)
 		SDL_Rect none = {0, 0};
 		return none;
 	}
+	GFX_markScreen(dst);
 
 	SDL_Rect image_rect = {0, 0, dst->w, dst->h};
 	SDL_BlitScaled(src, NULL, dst, &image_rect);
@@ -1201,6 +1066,7 @@ SDL_Rect GFX_blitScaleAspect(SDL_Surface *src, SDL_Surface *dst)
 		SDL_Rect none = {0, 0};
 		return none;
 	}
+	GFX_markScreen(dst);
 
 	SDL_Rect src_rect = {0, 0, src->w, src->h};
 	SDL_Rect dst_rect = {0, 0, dst->w, dst->h};
@@ -1247,6 +1113,7 @@ SDL_Rect GFX_blitScaleToFill(SDL_Surface *src, SDL_Surface *dst)
 		SDL_Rect none = {0, 0};
 		return none;
 	}
+	GFX_markScreen(dst);
 
 	SDL_Rect src_rect = {0, 0, src->w, src->h};
 	SDL_Rect dst_rect = {0, 0, dst->w, dst->h};
@@ -1267,33 +1134,14 @@ void GFX_ApplyRoundedCorners16(SDL_Surface *surface, SDL_Rect *rect, int radius)
 	if (rect)
 		target = *rect;
 
-	if (fmt->format != SDL_PIXELFORMAT_RGBA8888)
+	if (fmt->BytesPerPixel != 2)
 	{
 		SDL_Log("Unsupported pixel format: %s", SDL_GetPixelFormatName(fmt->format));
 		return;
 	}
 
-	Uint16 *pixels = (Uint16 *)surface->pixels; // RGB565 uses 16-bit pixels
-	Uint16 transparent_black = 0x0000;					// RGB565 has no alpha, so use black (0)
-
-	const int xBeg = target.x;
-	const int xEnd = target.x + target.w;
-	const int yBeg = target.y;
-	const int yEnd = target.y + target.h;
-	for (int y = yBeg; y < yEnd; ++y)
-	{
-		for (int x = xBeg; x < xEnd; ++x)
-		{
-			int dx = (x < xBeg + radius) ? xBeg + radius - x : (x >= xEnd - radius) ? x - (xEnd - radius - 1)
-																																							: 0;
-			int dy = (y < yBeg + radius) ? yBeg + radius - y : (y >= yEnd - radius) ? y - (yEnd - radius - 1)
-																																							: 0;
-			if (dx * dx + dy * dy > radius * radius)
-			{
-				pixels[y * (surface->pitch / 2) + x] = transparent_black; // Set to black (0)
-			}
-		}
-	}
+	// RGB565 has no alpha, so use black (0)
+	BLIT_cornerMask(surface->pixels, surface->pitch, 2, surface->w, surface->h, target.x, target.y, target.w, target.h, radius, 0x0000);
 }
 
 void GFX_ApplyRoundedCorners(SDL_Surface *surface, SDL_Rect *rect, int radius)
@@ -1301,32 +1149,16 @@ void GFX_ApplyRoundedCorners(SDL_Surface *surface, SDL_Rect *rect, int radius)
 	if (!surface)
 		return;
 
-	Uint32 *pixels = (Uint32 *)surface->pixels;
 	SDL_PixelFormat *fmt = surface->format;
 	SDL_Rect target = {0, 0, surface->w, surface->h};
 	if (rect)
 		target = *rect;
 
-	Uint32 transparent_black = SDL_MapRGBA(fmt, 0, 0, 0, 0); // Fully transparent black
+	if (fmt->BytesPerPixel != 2 && fmt->BytesPerPixel != 4)
+		return;
 
-	const int xBeg = target.x;
-	const int xEnd = target.x + target.w;
-	const int yBeg = target.y;
-	const int yEnd = target.y + target.h;
-	for (int y = yBeg; y < yEnd; ++y)
-	{
-		for (int x = xBeg; x < xEnd; ++x)
-		{
-			int dx = (x < xBeg + radius) ? xBeg + radius - x : (x >= xEnd - radius) ? x - (xEnd - radius - 1)
-																																							: 0;
-			int dy = (y < yBeg + radius) ? yBeg + radius - y : (y >= yEnd - radius) ? y - (yEnd - radius - 1)
-																																							: 0;
-			if (dx * dx + dy * dy > radius * radius)
-			{
-				pixels[y * target.w + x] = transparent_black; // Set to fully transparent black
-			}
-		}
-	}
+	Uint32 transparent_black = SDL_MapRGBA(fmt, 0, 0, 0, 0); // Fully transparent black
+	BLIT_cornerMask(surface->pixels, surface->pitch, fmt->BytesPerPixel, surface->w, surface->h, target.x, target.y, target.w, target.h, radius, transparent_black);
 }
 
 // Need a roundercorners for rgba4444 now too to have transparant rounder corners :D
@@ -1335,32 +1167,11 @@ void GFX_ApplyRoundedCorners_RGBA4444(SDL_Surface *surface, SDL_Rect *rect, int
 	if (!surface || surface->format->format != SDL_PIXELFORMAT_RGBA4444)
 		return;
 
-	Uint16 *pixels = (Uint16 *)surface->pixels;
-	int pitch = surface->pitch / 2;
 	SDL_Rect target = {0, 0, surface->w, surface->h};
 	if (rect)
 		target = *rect;
 
-	Uint16 transparent_black = 0x0000;
-
-	const int xBeg = target.x;
-	const int xEnd = target.x + target.w;
-	const int yBeg = target.y;
-	const int yEnd = target.y + target.h;
-	for (int y = yBeg; y < yEnd; ++y)
-	{
-		for (int x = xBeg; x < xEnd; ++x)
-		{
-			int dx = (x < xBeg + radius) ? xBeg + radius - x : (x >= xEnd - radius) ? x - (xEnd - radius - 1)
-																																							: 0;
-			int dy = (y < yBeg + radius) ? yBeg + radius - y : (y >= yEnd - radius) ? y - (yEnd - radius - 1)
-																																							: 0;
-			if (dx * dx + dy * dy > radius * radius)
-			{
-				pixels[y * pitch + x] = transparent_black;
-			}
-		}
-	}
+	BLIT_cornerMask(surface->pixels, surface->pitch, 2, surface->w, surface->h, target.x, target.y, target.w, target.h, radius, 0x0000);
 }
 
 void GFX_ApplyRoundedCorners_RGBA8888(SDL_Surface *surface, SDL_Rect *rect, int radius)
@@ -1368,100 +1179,147 @@ void GFX_ApplyRoundedCorners_RGBA8888(SDL_Surface *surface, SDL_Rect *rect, int
 	if (!surface || surface->format->format != SDL_PIXELFORMAT_RGBA8888)
 		return;
 
-	Uint32 *pixels = (Uint32 *)surface->pixels;
-	int pitch = surface->pitch / 4; // Since each pixel is 4 bytes in RGBA8888
-
 	SDL_Rect target = {0, 0, surface->w, surface->h};
 	if (rect)
 		target = *rect;
 
-	Uint32 transparent_black = 0x00000000; // Fully transparent (RGBA8888: 0xAARRGGBB)
-
-	const int xBeg = target.x;
-	const int xEnd = target.x + target.w;
-	const int yBeg = target.y;
-	const int yEnd = target.y + target.h;
-
-	for (int y = yBeg; y < yEnd; ++y)
-	{
-		for (int x = xBeg; x < xEnd; ++x)
-		{
-			int dx = (x < xBeg + radius) ? xBeg + radius - x : (x >= xEnd - radius) ? x - (xEnd - radius - 1)
-																																							: 0;
-			int dy = (y < yBeg + radius) ? yBeg + radius - y : (y >= yEnd - radius) ? y - (yEnd - radius - 1)
-																																							: 0;
-
-			// Check if the pixel is outside the rounded corner radius
-			if (dx * dx + dy * dy > radius * radius)
-			{
-				pixels[y * pitch + x] = transparent_black;
-			}
-		}
-	}
+	// Fully transparent (RGBA8888: 0xRRGGBBAA)
+	BLIT_cornerMask(surface->pixels, surface->pitch, 4, surface->w, surface->h, target.x, target.y, target.w, target.h, radius, 0x00000000);
 }
 
 // i wrote my own blit function cause its faster at converting rgba4444 to rgba565 then SDL's one lol
 void BlitRGBA4444toRGB565(SDL_Surface *src, SDL_Surface *dest, SDL_Rect *dest_rect)
 {
-	Uint8 *srcPixels = (Uint8 *)src->pixels;
-	Uint8 *destPixels = (Uint8 *)dest->pixels;
-
-	int width = src->w;
-	int height = src->h;
+	int sx = 0;
+	int sy = 0;
+	int dx = dest_rect->x;
+	int dy = dest_rect->y;
+	int w = src->w;
+	int h = src->h;
 
-	for (int y = 0; y < height; ++y)
+	if (dx < 0)
 	{
-		Uint16 *srcRow = (Uint16 *)(srcPixels + y * src->pitch);
-		Uint16 *destRow = (Uint16 *)(destPixels + (y + dest_rect->y) * dest->pitch);
-
-		for (int x = 0; x < width; ++x)
-		{
-			Uint16 srcPixel = srcRow[x];
-
-			Uint8 r = (srcPixel >> 12) & 0xF;
-			Uint8 g = (srcPixel >> 8) & 0xF;
-			Uint8 b = (srcPixel >> 4) & 0xF;
-			Uint8 a = (srcPixel) & 0xF;
+		sx = -dx;
+		w += dx;
+		dx = 0;
+	}
+	if (dy < 0)
+	{
+		sy = -dy;
+		h += dy;
+		dy = 0;
+	}
+	if (dx + w > dest->w)
+		w = dest->w - dx;
+	if (dy + h > dest->h)
+		h = dest->h - dy;
+	if (w <= 0 || h <= 0)
+		return;
 
-			r = (r * 255 / 15) >> 3;
-			g = (g * 255 / 15) >> 2;
-			b = (b * 255 / 15) >> 3;
+	BLIT_blend4444to565((Uint8 *)src->pixels + sy * src->pitch + sx * 2, src->pitch,
+											(Uint8 *)dest->pixels + dy * dest->pitch + dx * 2, dest->pitch, w, h);
+}
 
-			int destX = x + dest_rect->x;
-			int destY = y + dest_rect->y;
+// GFX_blitAssetColor without SDL's generic blitter, when the assets and dst share a 32bpp format.
+// clips like SDL_BlitSurface (including writing the final rect back to dst_rect), returns 0 if it can't
+static int blitAssetFast(SDL_Rect *src_rect, SDL_Surface *dst, SDL_Rect *dst_rect, Uint8 r, Uint8 g, Uint8 b)
+{
+	SDL_Surface *src = gfx.assets;
+	SDL_PixelFormat *fmt = src->format;
+	SDL_BlendMode mode;
+	Uint8 alpha;
+	Uint32 key;
 
-			if (destX >= 0 && destX < dest->w && destY >= 0 && destY < dest->h)
-			{
-				Uint16 *destPixelPtr = &destRow[destX];
+	if (!dst || fmt->format != dst->format->format || fmt->BytesPerPixel != 4)
+		return 0;
+	if ((fmt->Ashift != 0 && fmt->Ashift != 24) || fmt->Amask != (0xFFu << fmt->Ashift))
+		return 0;
+	if (SDL_GetSurfaceBlendMode(src, &mode) || mode != SDL_BLENDMODE_BLEND)
+		return 0;
+	if (SDL_GetSurfaceAlphaMod(src, &alpha) || alpha != 255 || SDL_GetColorKey(src, &key) == 0)
+		return 0;
+	if (SDL_MUSTLOCK(src) || SDL_MUSTLOCK(dst))
+		return 0;
 
-				if (a == 0)
-					continue;
+	int sx = src_rect->x;
+	int sy = src_rect->y;
+	int w = src_rect->w;
+	int h = src_rect->h;
+	int dx = dst_rect ? dst_rect->x : 0;
+	int dy = dst_rect ? dst_rect->y : 0;
 
-				if (a == 15)
-				{
-					*destPixelPtr = (r << 11) | (g << 5) | b;
-				}
-				else
-				{
-					Uint16 existingPixel = *destPixelPtr;
+	if (sx < 0)
+	{
+		dx -= sx;
+		w += sx;
+		sx = 0;
+	}
+	if (sy < 0)
+	{
+		dy -= sy;
+		h += sy;
+		sy = 0;
+	}
+	if (sx + w > src->w)
+		w = src->w - sx;
+	if (sy + h > src->h)
+		h = src->h - sy;
 
-					Uint8 destR = (existingPixel >> 11) & 0x1F;
-					Uint8 destG = (existingPixel >> 5) & 0x3F;
-					Uint8 destB = existingPixel & 0x1F;
+	SDL_Rect *clip = &dst->clip_rect;
+	if (dx < clip->x)
+	{
+		sx += clip->x - dx;
+		w -= clip->x - dx;
+		dx = clip->x;
+	}
+	if (dy < clip->y)
+	{
+		sy += clip->y - dy;
+		h -= clip->y - dy;
+		dy = clip->y;
+	}
+	if (dx + w > clip->x + clip->w)
+		w = clip->x + clip->w - dx;
+	if (dy + h > clip->y + clip->h)
+		h = clip->y + clip->h - dy;
 
-					destR = ((r * a) + (destR * (15 - a))) / 15;
-					destG = ((g * a) + (destG * (15 - a))) / 15;
-					destB = ((b * a) + (destB * (15 - a))) / 15;
+	if (w <= 0 || h <= 0)
+	{
+		w = 0;
+		h = 0;
+	}
+	if (dst_rect)
+		*dst_rect = (SDL_Rect){dx, dy, w, h};
+	if (w && h)
+		BLIT_blendModulate32((Uint8 *)src->pixels + sy * src->pitch + sx * 4, src->pitch,
+												 (Uint8 *)dst->pixels + dy * dst->pitch + dx * 4, dst->pitch, w, h,
+												 SDL_MapRGBA(fmt, r, g, b, 255), fmt->Ashift);
+	return 1;
+}
 
-					*destPixelPtr = (destR << 11) | (destG << 5) | destB;
-				}
-			}
-		}
+// SDL_FillRect for the 16/32bpp surfaces the UI draws into
+static void fillSurfaceRect(SDL_Surface *dst, SDL_Rect *rect, uint32_t color)
+{
+	SDL_Rect area;
+	int bpp = dst->format->BytesPerPixel;
+	if ((bpp != 2 && bpp != 4) || SDL_MUSTLOCK(dst))
+	{
+		SDL_FillRect(dst, rect, color);
+		return;
 	}
+	if (!SDL_IntersectRect(rect, &dst->clip_rect, &area))
+		return;
+
+	void *pixels = (Uint8 *)dst->pixels + area.y * dst->pitch + area.x * bpp;
+	if (bpp == 2)
+		BLIT_fill16(pixels, dst->pitch, area.w, area.h, color);
+	else
+		BLIT_fill32(pixels, dst->pitch, area.w, area.h, color);
 }
 
 void GFX_blitAssetColor(int asset, SDL_Rect *src_rect, SDL_Surface *dst, SDL_Rect *dst_rect, uint32_t asset_color)
 {
+	GFX_markScreen(dst);
 
 	SDL_Rect *rect = &asset_rects[asset];
 	SDL_Rect adj_rect = {
@@ -1496,6 +1354,9 @@ void GFX_blitAssetColor(int asset, SDL_Rect *src_rect, SDL_Surface *dst, SDL_Rec
 		else if (asset_color == THEME_COLOR6)
 			asset_color = THEME_COLOR6_255;
 
+		if (blitAssetFast(&adj_rect, dst, dst_rect, (asset_color >> 16) & 0xFF, (asset_color >> 8) & 0xFF, asset_color & 0xFF))
+			return;
+
 		SDL_Color restore;
 		SDL_GetSurfaceColorMod(gfx.assets, &restore.r, &restore.g, &restore.b);
 		SDL_SetSurfaceColorMod(gfx.assets,
@@ -1507,9 +1368,35 @@ void GFX_blitAssetColor(int asset, SDL_Rect *src_rect, SDL_Surface *dst, SDL_Rec
 	}
 	else
 	{
+		SDL_Color mod;
+		SDL_GetSurfaceColorMod(gfx.assets, &mod.r, &mod.g, &mod.b);
+		if (blitAssetFast(&adj_rect, dst, dst_rect, mod.r, mod.g, mod.b))
+			return;
+
 		SDL_BlitSurface(gfx.assets, &adj_rect, dst, dst_rect);
 	}
 }
+void GFX_drawAssetOnLayer(int asset, SDL_Rect *src_rect, SDL_Rect *dst_rect, uint32_t rgb, int layer)
+{
+	SDL_Rect src = asset_rects[asset];
+	if (src_rect)
+	{
+		src.x += src_rect->x;
+		src.y += src_rect->y;
+		src.w = src_rect->w;
+		src.h = src_rect->h;
+	}
+	// like SDL_BlitSurface, only the position of dst_rect is used
+	SDL_Rect dst = {dst_rect ? dst_rect->x : 0, dst_rect ? dst_rect->y : 0, src.w, src.h};
+	PLAT_drawAtlasOnLayer(&src, &dst, rgb, layer);
+}
+void GFX_drawPillOnLayer(int asset, SDL_Rect *dst_rect, uint32_t rgb, int layer)
+{
+	SDL_Rect dst = *dst_rect;
+	if (dst.h == 0)
+		dst.h = asset_rects[asset].h;
+	PLAT_drawPillOnLayer(&asset_rects[asset], &dst, rgb, layer);
+}
 void GFX_blitAsset(int asset, SDL_Rect *src_rect, SDL_Surface *dst, SDL_Rect *dst_rect)
 {
 	GFX_blitAssetColor(asset, src_rect, dst, dst_rect, RGB_WHITE);
@@ -1534,7 +1421,7 @@ void GFX_blitPillColor(int asset, SDL_Surface *dst, SDL_Rect *dst_rect, uint32_t
 	if (w > 0)
 	{
 		// SDL_FillRect(dst, &(SDL_Rect){x,y,w,h}, UintMult(fill_color, asset_color));
-		SDL_FillRect(dst, &(SDL_Rect){x, y, w, h}, asset_color);
+		fillSurfaceRect(dst, &(SDL_Rect){x, y, w, h}, asset_color);
 		x += w;
 	}
 	GFX_blitAssetColor(asset, &(SDL_Rect){r, 0, r, h}, dst, &(SDL_Rect){x, y}, asset_color);
@@ -1573,6 +1460,7 @@ void GFX_blitRect(int asset, SDL_Surface *dst, SDL_Rect *dst_rect)
 }
 int GFX_blitBattery(SDL_Surface *dst, SDL_Rect *dst_rect)
 {
+	GFX_markScreen(dst);
 	// LOG_info("dst: %p\n", dst);
 	int x = 0;
 	int y = 0;
@@ -1649,6 +1537,7 @@ int GFX_getButtonWidth(const char *hint, const char *button)
 }
 void GFX_blitButton(const char *hint, const char *button, SDL_Surface *dst, SDL_Rect *dst_rect)
 {
+	GFX_markScreen(dst);
 	SDL_Surface *text;
 	int ox = 0;
 
@@ -1688,6 +1577,7 @@ void GFX_blitButton(const char *hint, const char *button, SDL_Surface *dst, SDL_
 }
 void GFX_blitMessage(TTF_Font *font, const char *msg, SDL_Surface *dst, SDL_Rect *dst_rect)
 {
+	GFX_markScreen(dst);
 	if (!dst_rect)
 		dst_rect = &(SDL_Rect){0, 0, dst->w, dst->h};
 
@@ -1743,6 +1633,7 @@ void GFX_blitMessage(TTF_Font *font, const char *msg, SDL_Surface *dst, SDL_Rect
 
 int GFX_blitHardwareGroup(SDL_Surface *dst, int show_setting)
 {
+	GFX_markScreen(dst);
 	int ox;
 	int oy;
 	int ow = 0;
@@ -1961,6 +1852,7 @@ void GFX_sizeText(TTF_Font *font, const char *str, int leading, int *w, int *h)
 }
 void GFX_blitText(TTF_Font *font, const char *str, int leading, SDL_Color color, SDL_Surface *dst, SDL_Rect *dst_rect)
 {
+	GFX_markScreen(dst);
 	if (dst_rect == NULL)
 		dst_rect = &(SDL_Rect){0, 0, dst->w, dst->h};
 
@@ -3350,8 +3242,7 @@ void PWR_update(int *_dirty, int *_show_setting, PWR_callback_t before_sleep, PW
 			}
 			else
 			{
-				PLAT_initLeds(lightsDefault);
-				LEDS_updateLeds();
+				LEDS_resetLeds();
 			}
 			was_charging = is_charging;
 			dirty = 1;
@@ -3450,8 +3341,11 @@ void PWR_update(int *_dirty, int *_show_setting, PWR_callback_t before_sleep, PW
 			setting_shown_at = now;
 			if (CFG_getMuteLEDs())
 			{
+				pthread_mutex_lock(&leds_lock);
 				lights = muted ? &lightsMuted : &lightsDefault;
-				LEDS_updateLeds();
+				AMB_invalidate();
+				updateLeds();
+				pthread_mutex_unlock(&leds_lock);
 			}
 		}
 	}
@@ -3534,12 +3428,12 @@ static void PWR_enterSleep(void)
 	system("killall -STOP keymon.elf");
 	system("killall -STOP batmon.elf");
 
+	PLAT_flushLeds(); // the sleep indicator has to be on before we suspend
 	sync();
 }
 static void PWR_exitSleep(void)
 {
-	PLAT_initLeds(lightsDefault);
-	LEDS_updateLeds();
+	LEDS_resetLeds();
 	if (pwr.is_charging)
 	{
 		LED_setIndicator(2, 0xFF0000, -1, 2);
@@ -3720,10 +3614,12 @@ FALLBACK_IMPLEMENTATION void PLAT_setLedColor(LightSettings *led) {}
 FALLBACK_IMPLEMENTATION void PLAT_setLedInbrightness(LightSettings *led) {}
 FALLBACK_IMPLEMENTATION void PLAT_setLedEffectCycles(LightSettings *led) {}
 FALLBACK_IMPLEMENTATION void PLAT_setLedEffectSpeed(LightSettings *led) {}
+FALLBACK_IMPLEMENTATION void PLAT_flushLeds(void) {}
 
 // only indicator leds may work when battery is below PWR_LOW_CHARGE
 void LED_setIndicator(int effect, uint32_t color, int cycles, int ledindex)
 {
+	pthread_mutex_lock(&leds_lock);
 	int lightsize = sizeof(*lights) / sizeof(LightSettings);
 	(*lights)[ledindex].effect = effect;
 	(*lights)[ledindex].color1 = color;
@@ -3733,9 +3629,11 @@ void LED_setIndicator(int effect, uint32_t color, int cycles, int ledindex)
 	PLAT_setLedEffectCycles(&(*lights)[ledindex]);
 	PLAT_setLedColor(&(*lights)[ledindex]);
 	PLAT_setLedEffect(&(*lights)[ledindex]);
+	pthread_mutex_unlock(&leds_lock);
 }
 void LEDS_setIndicator(int effect, uint32_t color, int cycles)
 {
+	pthread_mutex_lock(&leds_lock);
 	int lightsize = sizeof(*lights) / sizeof(LightSettings);
 	for (int i = 0; i < lightsize; i++)
 	{
@@ -3751,23 +3649,27 @@ void LEDS_setIndicator(int effect, uint32_t color, int cycles)
 		PLAT_setLedColor(&(*lights)[i]);
 		PLAT_setLedEffect(&(*lights)[i]);
 	}
+	pthread_mutex_unlock(&leds_lock);
 }
 void LEDS_setEffect(int effect)
 {
 	if (pwr.charge > PWR_LOW_CHARGE)
 	{
+		pthread_mutex_lock(&leds_lock);
 		int lightsize = sizeof(*lights) / sizeof(LightSettings);
 		for (int i = 0; i < lightsize; i++)
 		{
 			(*lights)[i].effect = effect;
 			PLAT_setLedEffect(&(*lights)[i]);
 		}
+		pthread_mutex_unlock(&leds_lock);
 	}
 }
 void LEDS_setColor(uint32_t color)
 {
 	if (pwr.charge > PWR_LOW_CHARGE)
 	{
+		pthread_mutex_lock(&leds_lock);
 		int lightsize = sizeof(*lights) / sizeof(LightSettings);
 		for (int i = 0; i < lightsize; i++)
 		{
@@ -3775,6 +3677,7 @@ void LEDS_setColor(uint32_t color)
 			PLAT_setLedColor(&(*lights)[i]);
 			PLAT_setLedEffect(&(*lights)[i]);
 		}
+		pthread_mutex_unlock(&leds_lock);
 	}
 }
 
@@ -3782,13 +3685,16 @@ void LED_setColor(uint32_t color, int ledindex)
 {
 	if (pwr.charge > PWR_LOW_CHARGE)
 	{
+		pthread_mutex_lock(&leds_lock);
 		(*lights)[ledindex].color1 = color;
 		PLAT_setLedColor(&(*lights)[ledindex]);
 		PLAT_setLedEffect(&(*lights)[ledindex]);
+		pthread_mutex_unlock(&leds_lock);
 	}
 }
 
-void LEDS_updateLeds()
+// with leds_lock held
+static void updateLeds(void)
 {
 	if (pwr.charge > PWR_LOW_CHARGE)
 	{
@@ -3805,10 +3711,19 @@ void LEDS_updateLeds()
 	}
 }
 
+void LEDS_updateLeds()
+{
+	pthread_mutex_lock(&leds_lock);
+	updateLeds();
+	pthread_mutex_unlock(&leds_lock);
+}
+
 void LEDS_initLeds()
 {
+	pthread_mutex_lock(&leds_lock);
 	PLAT_getBatteryStatusFine(&pwr.is_charging, &pwr.charge);
 	PLAT_initLeds(lightsDefault);
+	AMB_invalidate();
 
 	int lightsize = sizeof(lightsDefault) / sizeof(LightSettings);
 	for (int i = 0; i < lightsize; i++)
@@ -3819,6 +3734,16 @@ void LEDS_initLeds()
 	}
 
 	lights = &lightsDefault;
+	pthread_mutex_unlock(&leds_lock);
+}
+
+void LEDS_resetLeds()
+{
+	pthread_mutex_lock(&leds_lock);
+	PLAT_initLeds(lightsDefault);
+	AMB_invalidate();
+	updateLeds();
+	pthread_mutex_unlock(&leds_lock);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
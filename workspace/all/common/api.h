@@ -233,6 +233,15 @@ typedef struct
 	GLint uniformLocation;
 } ShaderParam;
 
+// rolling gpu time of a single shader/composite pass, see PLAT_getGPUPassTimings
+typedef struct GPU_PassTiming
+{
+	char name[8];
+	float avg_ms;
+	float p95_ms;
+	int samples;
+} GPU_PassTiming;
+
 SDL_Surface *GFX_init(int mode);
 #define GFX_resize PLAT_resizeVideo																					 // (int w, int h, int pitch);
 #define GFX_setScaleClip PLAT_setVideoScaleClip															 // (int x, int y, int width, int height)
@@ -243,6 +252,13 @@ SDL_Surface *GFX_init(int mode);
 #define GFX_setOffsetX PLAT_setOffsetX																			 // (int effect)
 #define GFX_setOffsetY PLAT_setOffsetY																			 // (int effect)
 #define GFX_drawOnLayer PLAT_drawOnLayer																		 //(SDL_Surface *inputSurface,int x, int y)
+#define GFX_drawOnLayerOpacity PLAT_drawOnLayerOpacity								 //(SDL_Surface *inputSurface, int x, int y, int w, int h, int opacity, int layer)
+#define GFX_markSurface PLAT_markSurface																 //(SDL_Surface *surface)
+#define GFX_markScreen PLAT_markScreen																 //(SDL_Surface *screen)
+#define GFX_drawTextOnLayer PLAT_drawTextOnLayer																 //(TTF_Font *font, const char *text, SDL_Color color, int x, int y, int max_width, int layer)
+#define GFX_setMenuBackdrop PLAT_setMenuBackdrop																 //(SDL_Surface *frame, float brightness)
+#define GFX_drawMenuBackdrop PLAT_drawMenuBackdrop															 //(int layer)
+#define GFX_freeMenuBackdrop PLAT_freeMenuBackdrop															 //(void)
 #define GFX_clearLayers PLAT_clearLayers																		 //(SDL_Surface *inputSurface,int x, int y)
 #define GFX_captureRendererToSurface PLAT_captureRendererToSurface					 //(void)
 #define GFX_animateSurface PLAT_animateSurface															 //(SDL_Surface *inputSurface,int x, int y)
@@ -298,8 +314,11 @@ int GFX_wrapText(TTF_Font *font, char *str, int max_width, int max_lines);
 #define GFX_clearShaders PLAT_clearShaders // void:(GFX_Renderer* renderer)
 #define GFX_updateShader PLAT_updateShader // void:(GFX_Renderer* renderer)
 #define GFX_initShaders PLAT_initShaders	 // void:(GFX_Renderer* renderer)
+#define GFX_enableGPUTimers PLAT_enableGPUTimers // void:(int enable)
+#define GFX_getGPUPassTimings PLAT_getGPUPassTimings // int:(GPU_PassTiming* timings, int max)
 
-scaler_t GFX_getAAScaler(GFX_Renderer *renderer);
+scaler_t GFX_getAAScaler(GFX_Renderer *renderer);	 // RGB565
+scaler_t GFX_getAAScaler32(GFX_Renderer *renderer); // RGBA8888, what minarch hands the blit path
 void GFX_freeAAScaler(void);
 
 // calls the appropriate scale function based on the enum value.
@@ -320,6 +339,9 @@ void GFX_blitPill(int asset, SDL_Surface *dst, SDL_Rect *dst_rect);
 void GFX_blitPillLight(int asset, SDL_Surface *dst, SDL_Rect *dst_rect);
 void GFX_blitPillDark(int asset, SDL_Surface *dst, SDL_Rect *dst_rect);
 void GFX_blitRect(int asset, SDL_Surface *dst, SDL_Rect *dst_rect);
+// same as the blits above but drawn by the GPU from the asset atlas into a layer, rgb is 0xRRGGBB
+void GFX_drawAssetOnLayer(int asset, SDL_Rect *src_rect, SDL_Rect *dst_rect, uint32_t rgb, int layer);
+void GFX_drawPillOnLayer(int asset, SDL_Rect *dst_rect, uint32_t rgb, int layer);
 int GFX_blitBattery(SDL_Surface *dst, SDL_Rect *dst_rect);
 int GFX_getButtonWidth(const char *hint, const char *button);
 void GFX_blitButton(const char *hint, const char *button, SDL_Surface *dst, SDL_Rect *dst_rect);
@@ -331,7 +353,9 @@ int GFX_blitButtonGroup(char **hints, int primary, SDL_Surface *dst, int align_r
 
 void GFX_sizeText(TTF_Font *font, const char *str, int leading, int *w, int *h);
 void GFX_blitText(TTF_Font *font, const char *str, int leading, SDL_Color color, SDL_Surface *dst, SDL_Rect *dst_rect);
-void GFX_setAmbientColor(const void *data, unsigned width, unsigned height, size_t pitch, int mode);
+// hands a libretro frame (bpp 2 is RGB565, 4 is XRGB8888) to the ambient led thread, cheap to
+// call every frame, it only takes a copy ~10 times a second and updates the leds itself
+void GFX_setAmbientColor(const void *data, unsigned width, unsigned height, size_t pitch, int bpp, int mode);
 
 void GFX_ApplyRoundedCorners(SDL_Surface *surface, SDL_Rect *rect, int radius);
 void GFX_ApplyRoundedCorners16(SDL_Surface *surface, SDL_Rect *rect, int radius);
@@ -458,6 +482,7 @@ int PWR_getBattery(void);
 
 void LEDS_initLeds();
 void LEDS_updateLeds();
+void LEDS_resetLeds(); // back to lightsDefault as PLAT_initLeds reads it, and push them
 void LEDS_SaveSettings();
 void LEDS_setEffect(int);
 void LEDS_setColor(uint32_t color);
@@ -500,7 +525,29 @@ void PLAT_setOverlay(const char *filename, const char *tag);
 void PLAT_setOffsetX(int x);
 void PLAT_setOffsetY(int y);
 void PLAT_drawOnLayer(SDL_Surface *inputSurface, int x, int y, int w, int h, float brightness, bool maintainAspectRatio, int layer);
+// blended at opacity (0-255), for transitions drawn a frame at a time from the caller's loop
+void PLAT_drawOnLayerOpacity(SDL_Surface *inputSurface, int x, int y, int w, int h, int opacity, int layer);
+// lets the layer draws keep surface's texture between draws. call it once the pixels are
+// final and again after every write to them, a marked surface that's changed without it
+// keeps showing its old pixels. unmarked surfaces are uploaded on every draw. uses
+// surface->userdata
+void PLAT_markSurface(SDL_Surface *surface);
+// tells the next flip that screen was drawn into directly (SDL_BlitSurface, SDL_FillRect,
+// pixel writes) so vid.screen gets uploaded again. the GFX_blit* helpers and GFX_clear
+// mark it themselves, surfaces other than the screen are ignored
+void PLAT_markScreen(SDL_Surface *screen);
 void PLAT_clearLayers(int layer);
+// draws text from a per font glyph atlas, returns the width drawn. max_width 0 is unclipped
+int PLAT_drawTextOnLayer(TTF_Font *font, const char *text, SDL_Color color, int x, int y, int max_width, int layer);
+// assets uploaded once as a texture for the layer draws below, rects are in the assets surface
+void PLAT_setAssetAtlas(SDL_Surface *assets);
+void PLAT_drawAtlasOnLayer(SDL_Rect *src_rect, SDL_Rect *dst_rect, uint32_t rgb, int layer);
+// the two halves of cap_rect (a circle) at either end of dst_rect and a fill between them
+void PLAT_drawPillOnLayer(SDL_Rect *cap_rect, SDL_Rect *dst_rect, uint32_t rgb, int layer);
+// blurs and darkens frame once into a cached texture, PLAT_drawMenuBackdrop copies it into a layer
+void PLAT_setMenuBackdrop(SDL_Surface *frame, float brightness);
+void PLAT_drawMenuBackdrop(int layer);
+void PLAT_freeMenuBackdrop(void);
 SDL_Surface *PLAT_captureRendererToSurface();
 void PLAT_animateSurface(
 		SDL_Surface *inputSurface,
@@ -587,6 +634,8 @@ void PLAT_setShader3(const char *filename);
 void PLAT_updateShader(int i, const char *filename, int *scale, int *filter, int *scaletype, int *inputtype);
 void PLAT_initShaders();
 ShaderParam *PLAT_getShaderPragmas(int i);
+void PLAT_enableGPUTimers(int enable);
+int PLAT_getGPUPassTimings(GPU_PassTiming *timings, int max); // returns number of passes with samples
 int PLAT_supportsOverscan(void);
 
 SDL_Surface *PLAT_initOverlay(void);
@@ -619,6 +668,7 @@ void PLAT_setLedBrightness(LightSettings *led);
 void PLAT_setLedInbrightness(LightSettings *led);
 void PLAT_setLedEffectSpeed(LightSettings *led);
 void PLAT_setLedEffectCycles(LightSettings *led);
+void PLAT_flushLeds(void); // the PLAT_setLed* calls may be written asynchronously, this writes them out now
 
 ///////////////////
 
@@ -0,0 +1,325 @@
+//
+//	Desktop microbenchmarks for the software pixel paths in scaler.c and blit.c
+//	builds without SDL or a device toolchain, see "make bench" in ../makefile
+//
+//	usage:	bench [samples] [filter]
+//		samples	timed samples per case, default 15
+//		filter	only run cases whose name contains this
+//
+//	prints one CSV row per case on stdout, ns_px is per output pixel (per frame
+//	pixel for average_color, which only samples a grid of it), gbps counts the
+//	src + dst bytes the call stands for
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "platform.h"
+#include "scaler.h"
+#include "blit.h"
+
+#define BENCH_SCREEN_W 1024
+#define BENCH_SCREEN_H 768
+#define BENCH_MIN_SAMPLE_NS 20000000ull // repeat calls until a sample is at least 20ms
+
+typedef struct {
+	const char* name;
+	uint32_t w, h;
+} System;
+
+static const System systems[] = {
+	{"gb",   160, 144},
+	{"gba",  240, 160},
+	{"snes", 256, 224},
+	{"ps1",  320, 240},
+};
+#define SYSTEM_COUNT (sizeof(systems)/sizeof(systems[0]))
+
+static const char* simd_names[SCALER_SIMD_COUNT] = {"c", "neon"};
+static const char* format_names[SCALER_FORMAT_COUNT] = {"16", "32", "16to32"};
+
+typedef struct Case {
+	const char* kernel;
+	const char* simd;
+	const char* format;
+	const System* system;
+	uint32_t sw, sh, dw, dh;
+	uint64_t pixels;	// what ns_px is counted against
+	uint64_t bytes;		// src + dst bytes per call
+	void (*run)(struct Case* c);
+	scaler_t scaler;
+	void* src;
+	void* dst;
+	uint32_t sp, dp;
+} Case;
+
+static volatile uint32_t sink; // keeps the reductions from being optimized out
+
+///////////////////////////////
+
+static uint32_t rng_state = 0x9e3779b9;
+static uint32_t rng(void) {
+	rng_state ^= rng_state<<13;
+	rng_state ^= rng_state>>17;
+	rng_state ^= rng_state<<5;
+	return rng_state;
+}
+
+// something that looks like a game frame: flat areas, gradients and a bit of noise
+static void fillFrame565(uint16_t* pixels, uint32_t w, uint32_t h) {
+	for (uint32_t y=0; y<h; y++) {
+		for (uint32_t x=0; x<w; x++) {
+			uint32_t r = (x*31)/w, g = (y*63)/h, b = ((x^y)>>3)&31;
+			if ((x/16+y/16)&1) r = g = b = 0; // flat tiles
+			if ((rng()&15)==0) r = rng()&31;
+			pixels[y*w+x] = (r<<11) | (g<<5) | b;
+		}
+	}
+}
+static void fillFrame32(uint32_t* pixels, uint32_t w, uint32_t h) {
+	for (uint32_t y=0; y<h; y++) {
+		for (uint32_t x=0; x<w; x++) {
+			uint32_t r = (x*255)/w, g = (y*255)/h, b = (x^y)&255;
+			if ((x/16+y/16)&1) r = g = b = 0;
+			if ((rng()&15)==0) r = rng()&255;
+			pixels[y*w+x] = 0xFF000000 | (r<<16) | (g<<8) | b;
+		}
+	}
+}
+static void fillRandom(void* pixels, size_t size) {
+	uint8_t* p = pixels;
+	for (size_t i=0; i<size; i++) p[i] = rng();
+}
+
+static uint64_t now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+///////////////////////////////
+
+static void runScaler(Case* c) {
+	c->scaler(c->src, c->dst, c->sw, c->sh, c->sp, c->dw, c->dh, c->dp);
+}
+static void runPooled(Case* c) {
+	scaler_run(c->scaler, c->src, c->dst, c->sw, c->sh, c->sp, c->dw, c->dh, c->dp);
+}
+static void runAverage(Case* c) {
+	sink += BLIT_averageColor(c->src, c->sp/c->sw, c->sw, c->sh, c->sp);
+}
+static void runBlend4444(Case* c) {
+	BLIT_blend4444to565(c->src, c->sp, c->dst, c->dp, c->dw, c->dh);
+}
+static void runConvert565(Case* c) {
+	BLIT_convert565toABGR8888(c->src, c->sp, c->dst, c->dp, c->sw, c->sh);
+}
+static void runConvertXRGB(Case* c) {
+	BLIT_convertXRGB8888toABGR8888(c->src, c->sp, c->dst, c->dp, c->sw, c->sh);
+}
+static void runConvert565x2(Case* c) {
+	BLIT_convert565toABGR8888x2(c->src, c->sp, c->dst, c->dp, c->sw, c->sh);
+}
+static void runConvertXRGBx2(Case* c) {
+	BLIT_convertXRGB8888toABGR8888x2(c->src, c->sp, c->dst, c->dp, c->sw, c->sh);
+}
+
+static void measure(Case* c, int samples) {
+	// warm up the caches and the pool, and find how many calls make a sample long enough
+	uint64_t reps = 1;
+	for (;;) {
+		uint64_t start = now();
+		for (uint64_t i=0; i<reps; i++) c->run(c);
+		uint64_t elapsed = now() - start;
+		if (elapsed>=BENCH_MIN_SAMPLE_NS) break;
+		reps *= elapsed ? (BENCH_MIN_SAMPLE_NS/elapsed>8 ? 8 : 2) : 8;
+	}
+
+	double sum = 0, sum2 = 0, best = 0;
+	for (int s=0; s<samples; s++) {
+		uint64_t start = now();
+		for (uint64_t i=0; i<reps; i++) c->run(c);
+		double ns_px = (double)(now()-start) / reps / c->pixels;
+		sum += ns_px;
+		sum2 += ns_px*ns_px;
+		if (!s || ns_px<best) best = ns_px;
+	}
+
+	double mean = sum / samples;
+	double variance = samples>1 ? (sum2 - sum*sum/samples) / (samples-1) : 0;
+	if (variance<0) variance = 0;
+	double gbps = c->bytes / (mean * c->pixels); // bytes per ns is GB/s
+
+	printf("%s,%s,%s,%s,%u,%u,%u,%u,%.4f,%.4f,%.6f,%.4f,%.3f,%d,%llu\n",
+		c->kernel, c->simd, c->format, c->system ? c->system->name : "-",
+		c->sw, c->sh, c->dw, c->dh,
+		mean, best, variance, sqrt(variance), gbps,
+		samples, (unsigned long long)reps);
+	fflush(stdout);
+}
+
+static int wanted(const char* filter, const char* kernel) {
+	return !filter || strstr(kernel, filter);
+}
+
+///////////////////////////////
+
+int main(int argc, char* argv[]) {
+	int samples = argc>1 ? atoi(argv[1]) : 15;
+	const char* filter = argc>2 ? argv[2] : NULL;
+	if (samples<1) samples = 1;
+
+	uint32_t max_pixels = 0;
+	for (int i=0; i<SYSTEM_COUNT; i++) {
+		if (systems[i].w*systems[i].h>max_pixels) max_pixels = systems[i].w*systems[i].h;
+	}
+	uint16_t* frame16 = malloc(max_pixels*sizeof(uint16_t));
+	uint32_t* frame32 = malloc(max_pixels*sizeof(uint32_t));
+	uint16_t* overlay = malloc(max_pixels*sizeof(uint16_t));
+	size_t screen_size = (size_t)BENCH_SCREEN_W*BENCH_SCREEN_H*4*2; // room for up to 8x on the widest source
+	size_t dst_size = (size_t)320*SCALER_MAX_MUL*240*SCALER_MAX_MUL*4;
+	if (dst_size<screen_size) dst_size = screen_size;
+	void* dst = malloc(dst_size);
+	if (!frame16 || !frame32 || !overlay || !dst) {
+		fprintf(stderr, "bench: out of memory\n");
+		return 1;
+	}
+	memset(dst, 0, dst_size);
+
+	printf("kernel,simd,format,system,src_w,src_h,dst_w,dst_h,ns_px,ns_px_min,ns_px_var,ns_px_stddev,gbps,samples,reps\n");
+
+	for (int i=0; i<SYSTEM_COUNT; i++) {
+		const System* sys = &systems[i];
+		uint32_t w = sys->w, h = sys->h;
+		fillFrame565(frame16, w, h);
+		fillFrame32(frame32, w, h);
+
+		// the largest integer factor that fits the screen, what the device picks for a 1024x768 panel
+		uint32_t mul = BENCH_SCREEN_W/w < BENCH_SCREEN_H/h ? BENCH_SCREEN_W/w : BENCH_SCREEN_H/h;
+		if (mul<1) mul = 1;
+		if (mul>SCALER_MAX_MUL) mul = SCALER_MAX_MUL;
+
+		// aspect fit for the AA scaler
+		uint32_t fit_w = BENCH_SCREEN_W, fit_h = (uint64_t)h*BENCH_SCREEN_W/w;
+		if (fit_h>BENCH_SCREEN_H) {
+			fit_h = BENCH_SCREEN_H;
+			fit_w = (uint64_t)w*BENCH_SCREEN_H/h;
+		}
+
+		for (int simd=0; simd<SCALER_SIMD_COUNT; simd++) {
+			for (int format=0; format<SCALER_FORMAT_COUNT; format++) {
+				scaler_t scaler = scaler_get_simd(simd, format, mul, mul);
+				if (!scaler) continue;
+
+				int src_bpp = format==SCALER_FORMAT_32 ? 4 : 2;
+				int dst_bpp = format==SCALER_FORMAT_16 ? 2 : 4;
+				Case c = {
+					.kernel = "scale", .simd = simd_names[simd], .format = format_names[format], .system = sys,
+					.sw = w, .sh = h, .dw = w*mul, .dh = h*mul,
+					.scaler = scaler, .src = src_bpp==2 ? (void*)frame16 : (void*)frame32, .dst = dst,
+					.sp = w*src_bpp, .dp = w*mul*dst_bpp,
+				};
+				c.pixels = (uint64_t)c.dw*c.dh;
+				c.bytes = (uint64_t)c.sp*c.sh + (uint64_t)c.dp*c.dh;
+
+				c.run = runScaler;
+				if (wanted(filter, c.kernel)) measure(&c, samples);
+				c.kernel = "scale_pool";
+				c.run = runPooled;
+				if (wanted(filter, c.kernel)) measure(&c, samples);
+			}
+
+			for (int format=SCALER_FORMAT_16; format<=SCALER_FORMAT_32; format++) {
+				if (!wanted(filter, "scale_aa")) continue;
+				scaler_t scaler = scaler_getAA_simd(simd, format, w, h, fit_w, fit_h);
+				if (!scaler) continue;
+
+				int bpp = format==SCALER_FORMAT_16 ? 2 : 4;
+				Case c = {
+					.kernel = "scale_aa", .simd = simd_names[simd], .format = format_names[format], .system = sys,
+					.sw = w, .sh = h, .dw = fit_w, .dh = fit_h,
+					.run = runScaler, .scaler = scaler, .src = bpp==2 ? (void*)frame16 : (void*)frame32, .dst = dst,
+					.sp = w*bpp, .dp = fit_w*bpp,
+				};
+				c.pixels = (uint64_t)c.dw*c.dh;
+				c.bytes = (uint64_t)c.sp*c.sh + (uint64_t)c.dp*c.dh;
+				measure(&c, samples);
+				scaler_freeAA();
+			}
+		}
+
+		// blit.c picks NEON at build time so these report whichever one got built
+#ifdef HAS_NEON
+		const char* blit_simd = "neon";
+#else
+		const char* blit_simd = "c";
+#endif
+
+		Case avg = {
+			.kernel = "average_color", .simd = blit_simd, .format = "16", .system = sys,
+			.sw = w, .sh = h, .dw = 1, .dh = 1,
+			.pixels = (uint64_t)w*h, .bytes = (uint64_t)w*h*2,
+			.run = runAverage, .src = frame16, .sp = w*2,
+		};
+		if (wanted(filter, avg.kernel)) measure(&avg, samples);
+		avg.format = "32";
+		avg.bytes = (uint64_t)w*h*4;
+		avg.src = frame32;
+		avg.sp = w*4;
+		if (wanted(filter, avg.kernel)) measure(&avg, samples);
+
+		Case convert = {
+			.kernel = "convert_565_abgr", .simd = blit_simd, .format = "16to32", .system = sys,
+			.sw = w, .sh = h, .dw = w, .dh = h,
+			.pixels = (uint64_t)w*h, .bytes = (uint64_t)w*h*(2+4),
+			.run = runConvert565, .src = frame16, .dst = dst, .sp = w*2, .dp = w*4,
+		};
+		if (wanted(filter, convert.kernel)) measure(&convert, samples);
+
+		Case convert_xrgb = {
+			.kernel = "convert_xrgb_abgr", .simd = blit_simd, .format = "32", .system = sys,
+			.sw = w, .sh = h, .dw = w, .dh = h,
+			.pixels = (uint64_t)w*h, .bytes = (uint64_t)w*h*(4+4),
+			.run = runConvertXRGB, .src = frame32, .dst = dst, .sp = w*4, .dp = w*4,
+		};
+		if (wanted(filter, convert_xrgb.kernel)) measure(&convert_xrgb, samples);
+
+		Case convert_2x = {
+			.kernel = "convert_565_abgr_2x", .simd = blit_simd, .format = "16to32", .system = sys,
+			.sw = w, .sh = h, .dw = w*2, .dh = h*2,
+			.pixels = (uint64_t)w*h*4, .bytes = (uint64_t)w*h*(2+4*4),
+			.run = runConvert565x2, .src = frame16, .dst = dst, .sp = w*2, .dp = w*2*4,
+		};
+		if (wanted(filter, convert_2x.kernel)) measure(&convert_2x, samples);
+
+		Case convert_xrgb_2x = {
+			.kernel = "convert_xrgb_abgr_2x", .simd = blit_simd, .format = "32", .system = sys,
+			.sw = w, .sh = h, .dw = w*2, .dh = h*2,
+			.pixels = (uint64_t)w*h*4, .bytes = (uint64_t)w*h*(4+4*4),
+			.run = runConvertXRGBx2, .src = frame32, .dst = dst, .sp = w*4, .dp = w*2*4,
+		};
+		if (wanted(filter, convert_xrgb_2x.kernel)) measure(&convert_xrgb_2x, samples);
+
+		// a full frame of translucent overlay, the worst case for the menu/OSD path
+		fillRandom(overlay, w*h*2);
+		memcpy(dst, frame16, w*h*2);
+		Case blend = {
+			.kernel = "blend_4444_565", .simd = blit_simd, .format = "16", .system = sys,
+			.sw = w, .sh = h, .dw = w, .dh = h,
+			.pixels = (uint64_t)w*h, .bytes = (uint64_t)w*h*(2+2+2),
+			.run = runBlend4444, .src = overlay, .dst = dst, .sp = w*2, .dp = w*2,
+		};
+		if (wanted(filter, blend.kernel)) measure(&blend, samples);
+	}
+
+	scaler_quitPool();
+	free(frame16);
+	free(frame32);
+	free(overlay);
+	free(dst);
+	return 0;
+}
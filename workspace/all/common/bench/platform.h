@@ -0,0 +1,13 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// stand-in for the device platform.h so scaler.c and blit.c build on a desktop,
+// only what those two read from it
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAS_NEON
+#endif
+
+#define FIXED_BPP 2 // the gambatte line/grid scalers, matches tg5040
+
+#endif
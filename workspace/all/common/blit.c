@@ -0,0 +1,600 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "platform.h" // for HAS_NEON
+#include "blit.h"
+
+#ifdef HAS_NEON
+#include <arm_neon.h>
+#endif
+
+///////////////////////////////
+
+#define ROW(p, pitch, y) ((void *)((uint8_t *)(p) + (y) * (pitch)))
+
+void BLIT_fill16(void *dst, int dst_pitch, int w, int h, uint16_t color)
+{
+	for (int y = 0; y < h; y++)
+	{
+		uint16_t *d = ROW(dst, dst_pitch, y);
+		int x = 0;
+#ifdef HAS_NEON
+		uint16x8_t c = vdupq_n_u16(color);
+		for (; x + 8 <= w; x += 8)
+			vst1q_u16(d + x, c);
+#endif
+		for (; x < w; x++)
+			d[x] = color;
+	}
+}
+
+void BLIT_fill32(void *dst, int dst_pitch, int w, int h, uint32_t color)
+{
+	for (int y = 0; y < h; y++)
+	{
+		uint32_t *d = ROW(dst, dst_pitch, y);
+		int x = 0;
+#ifdef HAS_NEON
+		uint32x4_t c = vdupq_n_u32(color);
+		for (; x + 8 <= w; x += 8)
+		{
+			vst1q_u32(d + x, c);
+			vst1q_u32(d + x + 4, c);
+		}
+#endif
+		for (; x < w; x++)
+			d[x] = color;
+	}
+}
+
+///////////////////////////////
+
+// 4 bit channel to 5/6 bits the way the original blit did it, (c * 255 / 15) >> n
+#define EXPAND4(c, n) (((c) * 17) >> (n))
+// (c * a + d * (15 - a)) / 15, x / 15 == x * 17 / 255
+#define MIX15(c, d, a) BLIT_DIV255(((c) * (a) + (d) * (15 - (a))) * 17)
+
+static inline uint16_t blend4444to565(uint16_t s, uint16_t d)
+{
+	uint32_t a = s & 0xF;
+	if (a == 0)
+		return d;
+
+	uint32_t r = EXPAND4(s >> 12, 3);
+	uint32_t g = EXPAND4((s >> 8) & 0xF, 2);
+	uint32_t b = EXPAND4((s >> 4) & 0xF, 3);
+	if (a == 15)
+		return (r << 11) | (g << 5) | b;
+
+	r = MIX15(r, d >> 11, a);
+	g = MIX15(g, (d >> 5) & 0x3F, a);
+	b = MIX15(b, d & 0x1F, a);
+	return (r << 11) | (g << 5) | b;
+}
+
+#ifdef HAS_NEON
+static inline uint16x8_t div255x8(uint16x8_t x)
+{
+	return vshrq_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+static inline uint16x8_t mix15x8(uint16x8_t c, uint16x8_t d, uint16x8_t a, uint16x8_t ia)
+{
+	return div255x8(vmulq_n_u16(vmlaq_u16(vmulq_u16(c, a), d, ia), 17));
+}
+#endif
+
+void BLIT_blend4444to565(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		const uint16_t *s = ROW(src, src_pitch, y);
+		uint16_t *d = ROW(dst, dst_pitch, y);
+		int x = 0;
+#ifdef HAS_NEON
+		const uint16x8_t m4 = vdupq_n_u16(0xF);
+		for (; x + 8 <= w; x += 8)
+		{
+			uint16x8_t sp = vld1q_u16(s + x);
+			uint16x8_t dp = vld1q_u16(d + x);
+			uint16x8_t a = vandq_u16(sp, m4);
+			uint16x8_t ia = vsubq_u16(m4, a);
+
+			uint16x8_t r = vshrq_n_u16(vmulq_n_u16(vshrq_n_u16(sp, 12), 17), 3);
+			uint16x8_t g = vshrq_n_u16(vmulq_n_u16(vandq_u16(vshrq_n_u16(sp, 8), m4), 17), 2);
+			uint16x8_t b = vshrq_n_u16(vmulq_n_u16(vandq_u16(vshrq_n_u16(sp, 4), m4), 17), 3);
+
+			r = mix15x8(r, vshrq_n_u16(dp, 11), a, ia);
+			g = mix15x8(g, vandq_u16(vshrq_n_u16(dp, 5), vdupq_n_u16(0x3F)), a, ia);
+			b = mix15x8(b, vandq_u16(dp, vdupq_n_u16(0x1F)), a, ia);
+
+			vst1q_u16(d + x, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+		}
+#endif
+		for (; x < w; x++)
+			d[x] = blend4444to565(s[x], d[x]);
+	}
+}
+
+///////////////////////////////
+
+// modulate, then premultiplied over, the same steps SDL's modulate+blend blitters take
+static inline uint32_t blendModulate32(uint32_t s, uint32_t d, uint32_t modulate, int alpha_shift)
+{
+	uint32_t sa = BLIT_DIV255(((s >> alpha_shift) & 0xFF) * ((modulate >> alpha_shift) & 0xFF));
+	if (sa == 0)
+		return d;
+
+	uint32_t out = 0;
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		uint32_t dc = (d >> shift) & 0xFF;
+		uint32_t c;
+		if (shift == alpha_shift)
+			c = sa;
+		else
+			c = BLIT_DIV255(BLIT_DIV255(((s >> shift) & 0xFF) * ((modulate >> shift) & 0xFF)) * sa);
+		out |= (c + BLIT_DIV255((255 - sa) * dc)) << shift;
+	}
+	return out;
+}
+
+#ifdef HAS_NEON
+static inline uint8x8_t mul255x8(uint8x8_t a, uint8x8_t b)
+{
+	return vmovn_u16(div255x8(vmull_u8(a, b)));
+}
+#endif
+
+void BLIT_blendModulate32(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h, uint32_t modulate, int alpha_shift)
+{
+#ifdef HAS_NEON
+	int ai = alpha_shift / 8;
+	uint8x8_t mod[4];
+	for (int c = 0; c < 4; c++)
+		mod[c] = vdup_n_u8((modulate >> (c * 8)) & 0xFF);
+#endif
+	for (int y = 0; y < h; y++)
+	{
+		const uint32_t *s = ROW(src, src_pitch, y);
+		uint32_t *d = ROW(dst, dst_pitch, y);
+		int x = 0;
+#ifdef HAS_NEON
+		for (; x + 8 <= w; x += 8)
+		{
+			uint8x8x4_t sp = vld4_u8((const uint8_t *)(s + x));
+			uint8x8x4_t dp = vld4_u8((const uint8_t *)(d + x));
+			uint8x8_t sa = mul255x8(sp.val[ai], mod[ai]);
+			uint8x8_t ia = vmvn_u8(sa);
+			for (int c = 0; c < 4; c++)
+			{
+				uint8x8_t sc = c == ai ? sa : mul255x8(mul255x8(sp.val[c], mod[c]), sa);
+				dp.val[c] = vadd_u8(sc, mul255x8(ia, dp.val[c]));
+			}
+			vst4_u8((uint8_t *)(d + x), dp);
+		}
+#endif
+		for (; x < w; x++)
+			d[x] = blendModulate32(s[x], d[x], modulate, alpha_shift);
+	}
+}
+
+///////////////////////////////
+
+static inline void clearPixel(void *pixels, int pitch, int bpp, int x, int y, uint32_t clear)
+{
+	if (bpp == 2)
+		((uint16_t *)ROW(pixels, pitch, y))[x] = clear;
+	else
+		((uint32_t *)ROW(pixels, pitch, y))[x] = clear;
+}
+
+// same distance test the per pixel loops in api.c used, but only over the corner squares
+void BLIT_cornerMask(void *pixels, int pitch, int bpp, int surface_w, int surface_h, int x, int y, int w, int h, int radius, uint32_t clear)
+{
+	if (!pixels || radius <= 0 || w <= 0 || h <= 0)
+		return;
+
+	const int xBeg = x;
+	const int xEnd = x + w;
+	const int yBeg = y;
+	const int yEnd = y + h;
+	const int r2 = radius * radius;
+
+	// rows/columns with a distance of 0 on that axis can't be outside the radius
+	int top = yBeg + radius < yEnd ? yBeg + radius : yEnd;
+	int bottom = yEnd - radius > top ? yEnd - radius : top;
+	int left = xBeg + radius < xEnd ? xBeg + radius : xEnd;
+	int right = xEnd - radius > left ? xEnd - radius : left;
+
+	for (int py = yBeg; py < yEnd; py++)
+	{
+		if (py == top)
+			py = bottom;
+		if (py >= yEnd)
+			break;
+		if (py < 0 || py >= surface_h)
+			continue;
+
+		int dy = (py < yBeg + radius) ? yBeg + radius - py : py - (yEnd - radius - 1);
+		for (int px = xBeg; px < xEnd; px++)
+		{
+			if (px == left)
+				px = right;
+			if (px >= xEnd)
+				break;
+			if (px < 0 || px >= surface_w)
+				continue;
+
+			int dx = (px < xBeg + radius) ? xBeg + radius - px : px - (xEnd - radius - 1);
+			if (dx * dx + dy * dy > r2)
+				clearPixel(pixels, pitch, bpp, px, py, clear);
+		}
+	}
+}
+
+///////////////////////////////
+
+// everything below writes ABGR8888, R,G,B,A in memory, which is what the GL_RGBA upload reads
+
+static inline uint32_t convert565(uint16_t pixel)
+{
+	uint32_t r = pixel >> 11;
+	uint32_t g = (pixel >> 5) & 0x3F;
+	uint32_t b = pixel & 0x1F;
+
+	r = (r << 3) | (r >> 2);
+	g = (g << 2) | (g >> 4);
+	b = (b << 3) | (b >> 2);
+
+	return 0xFF000000 | (b << 16) | (g << 8) | r;
+}
+
+static inline uint32_t convertXRGB(uint32_t pixel)
+{
+	return 0xFF000000 | ((pixel & 0xFF) << 16) | (pixel & 0xFF00) | ((pixel >> 16) & 0xFF);
+}
+
+#ifdef HAS_NEON
+// 8 RGB565 pixels to R,G,B,A planes, the top bits of each channel are copied into
+// the low ones so 0x1F becomes 0xFF like the C path
+static inline uint8x8x4_t convert565x8(uint16x8_t p)
+{
+	uint8x8_t r = vshrn_n_u16(p, 8);				   // RRRRRGGG
+	uint8x8_t g = vshrn_n_u16(p, 3);				   // GGGGGGBB
+	uint8x8_t b = vshrn_n_u16(vshlq_n_u16(p, 11), 8); // BBBBB000
+
+	uint8x8x4_t c;
+	c.val[0] = vsri_n_u8(r, r, 5);
+	c.val[1] = vsri_n_u8(g, g, 6);
+	c.val[2] = vsri_n_u8(b, b, 5);
+	c.val[3] = vdup_n_u8(0xFF);
+	return c;
+}
+
+// XRGB8888 is B,G,R,X in memory, swapping the planes is the whole conversion
+static inline uint8x8x4_t convertXRGBx8(const uint32_t *p)
+{
+	uint8x8x4_t s = vld4_u8((const uint8_t *)p);
+	uint8x8x4_t c;
+	c.val[0] = s.val[2];
+	c.val[1] = s.val[1];
+	c.val[2] = s.val[0];
+	c.val[3] = vdup_n_u8(0xFF);
+	return c;
+}
+
+// each of 8 pixels twice across and on both rows
+static inline void store2x8(uint32_t *d0, uint32_t *d1, uint8x8x4_t c)
+{
+	uint8x8x4_t lo, hi;
+	for (int i = 0; i < 4; i++)
+	{
+		uint8x8x2_t z = vzip_u8(c.val[i], c.val[i]);
+		lo.val[i] = z.val[0];
+		hi.val[i] = z.val[1];
+	}
+	vst4_u8((uint8_t *)d0, lo);
+	vst4_u8((uint8_t *)(d0 + 8), hi);
+	vst4_u8((uint8_t *)d1, lo);
+	vst4_u8((uint8_t *)(d1 + 8), hi);
+}
+#endif
+
+void BLIT_convert565toABGR8888(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		const uint16_t *s = ROW(src, src_pitch, y);
+		uint32_t *d = ROW(dst, dst_pitch, y);
+		int x = 0;
+#ifdef HAS_NEON
+		for (; x + 16 <= w; x += 16)
+		{
+			uint16x8_t p0 = vld1q_u16(s + x);
+			uint16x8_t p1 = vld1q_u16(s + x + 8);
+			vst4_u8((uint8_t *)(d + x), convert565x8(p0));
+			vst4_u8((uint8_t *)(d + x + 8), convert565x8(p1));
+		}
+		for (; x + 8 <= w; x += 8)
+			vst4_u8((uint8_t *)(d + x), convert565x8(vld1q_u16(s + x)));
+#endif
+		for (; x < w; x++)
+			d[x] = convert565(s[x]);
+	}
+}
+
+void BLIT_convertXRGB8888toABGR8888(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		const uint32_t *s = ROW(src, src_pitch, y);
+		uint32_t *d = ROW(dst, dst_pitch, y);
+		int x = 0;
+#ifdef HAS_NEON
+		uint8x16_t alpha = vdupq_n_u8(0xFF);
+		for (; x + 16 <= w; x += 16)
+		{
+			uint8x16x4_t p = vld4q_u8((const uint8_t *)(s + x));
+			uint8x16_t b = p.val[0];
+			p.val[0] = p.val[2];
+			p.val[2] = b;
+			p.val[3] = alpha;
+			vst4q_u8((uint8_t *)(d + x), p);
+		}
+		for (; x + 8 <= w; x += 8)
+			vst4_u8((uint8_t *)(d + x), convertXRGBx8(s + x));
+#endif
+		for (; x < w; x++)
+			d[x] = convertXRGB(s[x]);
+	}
+}
+
+void BLIT_convert565toABGR8888x2(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		const uint16_t *s = ROW(src, src_pitch, y);
+		uint32_t *d0 = ROW(dst, dst_pitch, y * 2);
+		uint32_t *d1 = ROW(dst, dst_pitch, y * 2 + 1);
+		int x = 0;
+#ifdef HAS_NEON
+		for (; x + 8 <= w; x += 8)
+			store2x8(d0 + x * 2, d1 + x * 2, convert565x8(vld1q_u16(s + x)));
+#endif
+		for (; x < w; x++)
+		{
+			uint32_t c = convert565(s[x]);
+			d0[x * 2] = d0[x * 2 + 1] = c;
+			d1[x * 2] = d1[x * 2 + 1] = c;
+		}
+	}
+}
+
+void BLIT_convertXRGB8888toABGR8888x2(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		const uint32_t *s = ROW(src, src_pitch, y);
+		uint32_t *d0 = ROW(dst, dst_pitch, y * 2);
+		uint32_t *d1 = ROW(dst, dst_pitch, y * 2 + 1);
+		int x = 0;
+#ifdef HAS_NEON
+		for (; x + 8 <= w; x += 8)
+			store2x8(d0 + x * 2, d1 + x * 2, convertXRGBx8(s + x));
+#endif
+		for (; x < w; x++)
+		{
+			uint32_t c = convertXRGB(s[x]);
+			d0[x * 2] = d0[x * 2 + 1] = c;
+			d1[x * 2] = d1[x * 2 + 1] = c;
+		}
+	}
+}
+
+///////////////////////////////
+
+#define SAMPLE_GRID 16 // cells across and down the frame
+#define SAMPLE_RUN 8	 // contiguous pixels taken from the middle of each cell
+
+enum
+{
+	SUM_R,
+	SUM_G,
+	SUM_B,
+	SUM_COUNT,
+	SUM_ALL_R,
+	SUM_ALL_G,
+	SUM_ALL_B,
+	SUM_SIZE,
+};
+
+// saturation > 50 && max > 50, with saturation = (max - min) * 255 / max rounded down
+static inline void sampleColor(uint32_t color, uint32_t *sums)
+{
+	uint32_t r = color & 0xFF;
+	uint32_t g = (color >> 8) & 0xFF;
+	uint32_t b = (color >> 16) & 0xFF;
+	uint32_t max_c = r > g ? (r > b ? r : b) : (g > b ? g : b);
+	uint32_t min_c = r < g ? (r < b ? r : b) : (g < b ? g : b);
+
+	if (max_c > 50 && (max_c - min_c) * 255 >= 51 * max_c)
+	{
+		sums[SUM_R] += r;
+		sums[SUM_G] += g;
+		sums[SUM_B] += b;
+		sums[SUM_COUNT]++;
+	}
+	sums[SUM_ALL_R] += r;
+	sums[SUM_ALL_G] += g;
+	sums[SUM_ALL_B] += b;
+}
+
+#ifdef HAS_NEON
+static inline uint32_t sum8(uint8x8_t v)
+{
+	uint32x2_t s = vpaddl_u16(vpaddl_u8(v));
+	return vget_lane_u32(s, 0) + vget_lane_u32(s, 1);
+}
+
+static inline void sampleColorx8(uint8x8x4_t c, uint32_t *sums)
+{
+	uint8x8_t r = c.val[0], g = c.val[1], b = c.val[2];
+	uint8x8_t max_c = vmax_u8(vmax_u8(r, g), b);
+	uint8x8_t min_c = vmin_u8(vmin_u8(r, g), b);
+	uint16x8_t spread = vmull_u8(vsub_u8(max_c, min_c), vdup_n_u8(255));
+	uint16x8_t limit = vmull_u8(max_c, vdup_n_u8(51));
+	uint8x8_t mask = vand_u8(vmovn_u16(vcgeq_u16(spread, limit)), vcgt_u8(max_c, vdup_n_u8(50)));
+
+	sums[SUM_R] += sum8(vand_u8(r, mask));
+	sums[SUM_G] += sum8(vand_u8(g, mask));
+	sums[SUM_B] += sum8(vand_u8(b, mask));
+	sums[SUM_COUNT] += sum8(vand_u8(mask, vdup_n_u8(1)));
+	sums[SUM_ALL_R] += sum8(r);
+	sums[SUM_ALL_G] += sum8(g);
+	sums[SUM_ALL_B] += sum8(b);
+}
+#endif
+
+uint32_t BLIT_averageColor(const void *data, int bpp, int width, int height, int pitch)
+{
+	if (!data || width <= 0 || height <= 0 || (bpp != 2 && bpp != 4))
+		return 0;
+
+	int run = width < SAMPLE_RUN ? width : SAMPLE_RUN;
+	int cols = width / SAMPLE_RUN;
+	int rows = height;
+	if (cols < 1)
+		cols = 1;
+	if (cols > SAMPLE_GRID)
+		cols = SAMPLE_GRID;
+	if (rows > SAMPLE_GRID)
+		rows = SAMPLE_GRID;
+
+	uint32_t sums[SUM_SIZE] = {0};
+	for (int j = 0; j < rows; j++)
+	{
+		const uint8_t *row = ROW(data, pitch, (2 * j + 1) * height / (2 * rows));
+		for (int i = 0; i < cols; i++)
+		{
+			int x = (2 * i + 1) * width / (2 * cols) - run / 2;
+			if (x < 0)
+				x = 0;
+			if (x > width - run)
+				x = width - run;
+
+			const uint8_t *p = row + x * bpp;
+#ifdef HAS_NEON
+			if (run == SAMPLE_RUN)
+			{
+				if (bpp == 2)
+					sampleColorx8(convert565x8(vld1q_u16((const uint16_t *)p)), sums);
+				else
+					sampleColorx8(convertXRGBx8((const uint32_t *)p), sums);
+				continue;
+			}
+#endif
+			for (int k = 0; k < run; k++)
+			{
+				if (bpp == 2)
+					sampleColor(convert565(((const uint16_t *)p)[k]), sums);
+				else
+					sampleColor(convertXRGB(((const uint32_t *)p)[k]), sums);
+			}
+		}
+	}
+
+	// nothing colourful, plain average of the samples
+	uint32_t count = sums[SUM_COUNT];
+	const uint32_t *total = sums;
+	if (count == 0)
+	{
+		count = rows * cols * run;
+		total = sums + SUM_ALL_R;
+	}
+
+	uint32_t r = total[0] / count;
+	uint32_t g = total[1] / count;
+	uint32_t b = total[2] / count;
+
+	return (r << 16) | (g << 8) | b;
+}
+
+///////////////////////////////
+
+// separable box filter, each dst pixel averages the src area it covers with partial
+// weights at the edges. colours are weighted by alpha so transparent pixels don't
+// bleed into the edges, which is the same as filtering premultiplied
+int BLIT_resizeArea32(const void *src, int src_pitch, int sw, int sh, void *dst, int dst_pitch, int dw, int dh, int alpha_shift)
+{
+	if (sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0)
+		return -1;
+
+	// src rows resized across, as premultiplied a,c,c,c
+	float *tmp = malloc(sizeof(float) * 4 * dw * sh);
+	if (!tmp)
+		return -1;
+
+	int shifts[3];
+	for (int c = 0, n = 0; c < 4; c++)
+	{
+		if (c * 8 != alpha_shift)
+			shifts[n++] = c * 8;
+	}
+
+	float sx_scale = (float)sw / dw;
+	for (int y = 0; y < sh; y++)
+	{
+		const uint32_t *s = ROW(src, src_pitch, y);
+		float *t = tmp + y * dw * 4;
+		for (int x = 0; x < dw; x++)
+		{
+			float x0 = x * sx_scale;
+			float x1 = x0 + sx_scale;
+			float sum[4] = {0};
+			for (int sx = (int)x0; sx < sw && sx < x1; sx++)
+			{
+				float weight = (sx + 1 < x1 ? sx + 1 : x1) - (sx > x0 ? sx : x0);
+				uint32_t p = s[sx];
+				float a = ((p >> alpha_shift) & 0xFF) * weight;
+				sum[0] += a;
+				for (int c = 0; c < 3; c++)
+					sum[c + 1] += ((p >> shifts[c]) & 0xFF) * a;
+			}
+			for (int c = 0; c < 4; c++)
+				t[x * 4 + c] = sum[c] / sx_scale;
+		}
+	}
+
+	float sy_scale = (float)sh / dh;
+	for (int y = 0; y < dh; y++)
+	{
+		float y0 = y * sy_scale;
+		float y1 = y0 + sy_scale;
+		uint32_t *d = ROW(dst, dst_pitch, y);
+		for (int x = 0; x < dw; x++)
+		{
+			float sum[4] = {0};
+			for (int sy = (int)y0; sy < sh && sy < y1; sy++)
+			{
+				float weight = (sy + 1 < y1 ? sy + 1 : y1) - (sy > y0 ? sy : y0);
+				const float *t = tmp + (sy * dw + x) * 4;
+				for (int c = 0; c < 4; c++)
+					sum[c] += t[c] * weight;
+			}
+			float a = sum[0] / sy_scale;
+			uint32_t p = (uint32_t)(a + 0.5f) << alpha_shift;
+			if (a > 0)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					float v = sum[c + 1] / sy_scale / a + 0.5f;
+					p |= (uint32_t)(v > 255 ? 255 : v) << shifts[c];
+				}
+			}
+			d[x] = p;
+		}
+	}
+
+	free(tmp);
+	return 0;
+}
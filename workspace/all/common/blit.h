@@ -0,0 +1,44 @@
+#ifndef __BLIT_H__
+#define __BLIT_H__
+#include <stdint.h>
+
+//
+//	2D pixel ops on raw buffers for the UI primitives in api.c and minarch
+//	pitches are in bytes, rects are already clipped by the caller,
+//	NEON paths work 8 pixels at a time and produce the same output as the C ones
+//
+
+// exact x/255 for x <= 255*255
+#define BLIT_DIV255(x) (((x) + 1 + ((x) >> 8)) >> 8)
+
+void BLIT_fill16(void *dst, int dst_pitch, int w, int h, uint16_t color);
+void BLIT_fill32(void *dst, int dst_pitch, int w, int h, uint32_t color);
+
+// RGBA4444 over RGB565, alpha in 1/15ths
+void BLIT_blend4444to565(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h);
+
+// 32bpp src over 32bpp dst in the same format, src channels multiplied by modulate first
+// (same layout, alpha ignored), alpha_shift is 0 or 24 for where that format keeps alpha
+void BLIT_blendModulate32(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h, uint32_t modulate, int alpha_shift);
+
+// sets the pixels outside a rounded rect (x,y,w,h inside a surface_w x surface_h buffer) to clear,
+// bpp is 2 or 4. only the radius x radius corner squares are visited
+void BLIT_cornerMask(void *pixels, int pitch, int bpp, int surface_w, int surface_h, int x, int y, int w, int h, int radius, uint32_t clear);
+
+// dominant colour of a libretro frame for the ambient leds as 0xRRGGBB, bpp 2 is RGB565 and
+// 4 is XRGB8888. samples a 16x16 grid of 8 pixel runs and averages the saturated samples,
+// or all of them if there are none
+uint32_t BLIT_averageColor(const void *data, int bpp, int width, int height, int pitch);
+
+// libretro frames -> ABGR8888 (R,G,B,A bytes), what minarch hands the renderer
+void BLIT_convert565toABGR8888(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h);
+void BLIT_convertXRGB8888toABGR8888(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h);
+// same, converted and scaled 2x in one pass, dst is w*2 x h*2
+void BLIT_convert565toABGR8888x2(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h);
+void BLIT_convertXRGB8888toABGR8888x2(const void *src, int src_pitch, void *dst, int dst_pitch, int w, int h);
+
+// resizes 32bpp src to dst with a box filter, for downscaling art once rather than per draw.
+// alpha_shift is where the format keeps alpha, returns -1 if the scratch buffer can't be had
+int BLIT_resizeArea32(const void *src, int src_pitch, int sw, int sh, void *dst, int dst_pitch, int dw, int dh, int alpha_shift);
+
+#endif
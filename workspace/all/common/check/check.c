@@ -0,0 +1,266 @@
+//
+//	Desktop bit-exactness check for the integer scalers in scaler.c
+//	builds without SDL or a device toolchain, see "make check" in ../makefile
+//
+//	usage:	check [seed]
+//		seed	for the random source pixels, default 1
+//
+//	every dispatch table entry that's built (C everywhere, NEON on ARM) is run over
+//	random source buffers for each width, height and pitch combination below and
+//	memcmp'd against a plain per-pixel reference, the whole dst buffer is compared
+//	so writes past a row or the clipped width show up too. scaler_run has to give the
+//	same frame as calling the scaler directly, for frames big enough to be split into
+//	bands. with NEON built the AA scalers are compared against their C versions as
+//	well. prints the failing cases and exits non-zero if there are any
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+#include "scaler.h"
+
+#define CHECK_CANARY 0xA5 // what dst holds wherever a scaler mustn't write
+
+static const uint32_t widths[] = {1, 3, 7, 8, 13, 16, 33, 161};
+static const uint32_t heights[] = {1, 2, 5};
+#define WIDTH_COUNT (sizeof(widths)/sizeof(widths[0]))
+#define HEIGHT_COUNT (sizeof(heights)/sizeof(heights[0]))
+#define MAX_WIDTH 161
+#define MAX_HEIGHT 5
+
+static const char* simd_names[SCALER_SIMD_COUNT] = {"c", "neon"};
+static const char* format_names[SCALER_FORMAT_COUNT] = {"16", "32", "16to32"};
+static const uint32_t src_bpp[SCALER_FORMAT_COUNT] = {2, 4, 2};
+static const uint32_t dst_bpp[SCALER_FORMAT_COUNT] = {2, 4, 4};
+
+// pitches as extra bytes on top of the packed row, PITCH_PACKED passes 0 so the
+// scaler works it out, dst pitches below the packed row clip the width
+#define PITCH_PACKED INT32_MIN
+static const int32_t src_pads[] = {PITCH_PACKED, 0, 2, 6};
+static const int32_t dst_pads[] = {PITCH_PACKED, 0, 4, 12, -1}; // -1 = one scaled pixel short
+#define SRC_PAD_COUNT (sizeof(src_pads)/sizeof(src_pads[0]))
+#define DST_PAD_COUNT (sizeof(dst_pads)/sizeof(dst_pads[0]))
+
+#define SRC_SIZE (MAX_WIDTH*4*2*MAX_HEIGHT + 64)
+#define DST_SIZE ((MAX_WIDTH*4*SCALER_MAX_MUL + 64)*MAX_HEIGHT*SCALER_MAX_MUL + 64)
+
+///////////////////////////////
+
+static uint32_t rng_state = 1;
+static uint32_t rng(void) {
+	rng_state ^= rng_state<<13;
+	rng_state ^= rng_state>>17;
+	rng_state ^= rng_state<<5;
+	return rng_state;
+}
+static void fillRandom(void* pixels, size_t size) {
+	uint8_t* p = pixels;
+	for (size_t i=0; i<size; i++) p[i] = rng();
+}
+
+static uint32_t readPixel(const uint8_t* p, uint32_t bpp) {
+	if (bpp==2) { uint16_t v; memcpy(&v, p, 2); return v; }
+	uint32_t v; memcpy(&v, p, 4); return v;
+}
+static void writePixel(uint8_t* p, uint32_t bpp, uint32_t v) {
+	if (bpp==2) { uint16_t w = v; memcpy(p, &w, 2); return; }
+	memcpy(p, &v, 4);
+}
+static uint32_t convertPixel(int format, uint32_t p) {
+	if (format!=SCALER_FORMAT_16TO32) return p;
+	return 0xFF000000 | ((p & 0xF800) << 8) | ((p & 0x07E0) << 5) | ((p & 0x001F) << 3);
+}
+
+// the scaler.h contract one pixel at a time, including the pitch defaults and clipping
+static void reference(int format, uint32_t xmul, uint32_t ymul, const uint8_t* src, uint8_t* dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dp) {
+	uint32_t sb = src_bpp[format], db = dst_bpp[format];
+	if (!sp) sp = sw*sb;
+	if (!dp) dp = sw*db*xmul;
+	if (sw*db*xmul>dp) sw = dp/(db*xmul);
+	for (uint32_t y=0; y<sh; y++) {
+		for (uint32_t r=0; r<ymul; r++) {
+			uint8_t* d = dst + (y*ymul+r)*dp;
+			for (uint32_t x=0; x<sw; x++) {
+				uint32_t pix = convertPixel(format, readPixel(src + y*sp + x*sb, sb));
+				for (uint32_t i=0; i<xmul; i++) writePixel(d + (x*xmul+i)*db, db, pix);
+			}
+		}
+	}
+}
+
+static int firstDifference(const uint8_t* a, const uint8_t* b, size_t size) {
+	for (size_t i=0; i<size; i++) {
+		if (a[i]!=b[i]) return (int)i;
+	}
+	return -1;
+}
+
+///////////////////////////////
+
+static int cases;
+static int failures;
+
+static void checkTable(uint8_t* src, uint8_t* dst, uint8_t* expected) {
+	for (int simd=0; simd<SCALER_SIMD_COUNT; simd++) {
+		for (int format=0; format<SCALER_FORMAT_COUNT; format++) {
+			uint32_t sb = src_bpp[format], db = dst_bpp[format];
+			for (uint32_t xmul=1; xmul<=SCALER_MAX_MUL; xmul++) {
+				for (uint32_t ymul=1; ymul<=SCALER_MAX_MUL; ymul++) {
+					scaler_t scaler = scaler_get_simd(simd, format, xmul, ymul);
+					if (!scaler) continue;
+
+					for (int wi=0; wi<WIDTH_COUNT; wi++) {
+						for (int hi=0; hi<HEIGHT_COUNT; hi++) {
+							for (int si=0; si<SRC_PAD_COUNT; si++) {
+								for (int di=0; di<DST_PAD_COUNT; di++) {
+									uint32_t sw = widths[wi], sh = heights[hi];
+									uint32_t row = sw*db*xmul;
+									if (dst_pads[di]==-1 && sw==1) continue; // would clip to nothing
+									uint32_t sp = src_pads[si]==PITCH_PACKED ? 0 : sw*sb + src_pads[si];
+									uint32_t dp = dst_pads[di]==PITCH_PACKED ? 0 : dst_pads[di]==-1 ? row - db*xmul : row + dst_pads[di];
+									uint32_t dw = sw*xmul, dh = sh*ymul;
+
+									// a pixel's worth of misalignment now and then so the NEON
+									// loads and stores don't only see aligned pointers
+									uint8_t* s = src + (rng()&1)*sb;
+									uint8_t* d = dst + (rng()&1)*db;
+									uint8_t* e = expected + (d - dst);
+									fillRandom(src, SRC_SIZE);
+									memset(dst, CHECK_CANARY, DST_SIZE);
+									memset(expected, CHECK_CANARY, DST_SIZE);
+
+									reference(format, xmul, ymul, s, e, sw, sh, sp, dp);
+									scaler(s, d, sw, sh, sp, dw, dh, dp);
+
+									cases += 1;
+									if (!memcmp(dst, expected, DST_SIZE)) continue;
+									failures += 1;
+									printf("FAIL scale%ux%u_%s%s sw=%u sh=%u sp=%u dp=%u: first difference at byte %d\n",
+										xmul, ymul, simd_names[simd], format_names[format], sw, sh, sp, dp,
+										firstDifference(dst, expected, DST_SIZE));
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// the row band pool against the same scaler called directly, on frames big enough to split
+static void checkPool(void) {
+	static const uint32_t sizes[][2] = {{160, 144}, {240, 160}, {256, 224}, {320, 240}, {321, 237}};
+	size_t src_size = 328*4*240 + 64;
+	size_t dst_size = (size_t)(328*4*SCALER_MAX_MUL + 64)*240*SCALER_MAX_MUL + 64;
+	uint8_t* src = malloc(src_size);
+	uint8_t* dst = malloc(dst_size);
+	uint8_t* expected = malloc(dst_size);
+	if (!src || !dst || !expected) {
+		fprintf(stderr, "check: out of memory\n");
+		failures += 1;
+		goto done;
+	}
+
+	for (int simd=0; simd<SCALER_SIMD_COUNT; simd++) {
+		for (int format=0; format<SCALER_FORMAT_COUNT; format++) {
+			uint32_t sb = src_bpp[format], db = dst_bpp[format];
+			for (uint32_t mul=2; mul<=SCALER_MAX_MUL; mul++) {
+				scaler_t scaler = scaler_get_simd(simd, format, mul, mul);
+				if (!scaler) continue;
+				for (int i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+					uint32_t sw = sizes[i][0], sh = sizes[i][1];
+					uint32_t sp = sw*sb + (i&1)*8; // every other size gets padded pitches
+					uint32_t dw = sw*mul, dh = sh*mul, dp = dw*db + (i&1)*12;
+					uint8_t* d = dst + (rng()&1)*db; // and bands that don't start on a cache line
+					uint8_t* e = expected + (d - dst);
+					size_t used = (size_t)dp*dh + db;
+					fillRandom(src, src_size);
+					memset(dst, CHECK_CANARY, used);
+					memset(expected, CHECK_CANARY, used);
+
+					scaler(src, e, sw, sh, sp, dw, dh, dp);
+					scaler_run(scaler, src, d, sw, sh, sp, dw, dh, dp);
+
+					cases += 1;
+					if (!memcmp(dst, expected, used)) continue;
+					failures += 1;
+					printf("FAIL scaler_run scale%ux%u_%s%s %ux%u: first difference at byte %d\n",
+						mul, mul, simd_names[simd], format_names[format], sw, sh,
+						firstDifference(dst, expected, used));
+				}
+			}
+		}
+	}
+	scaler_quitPool();
+
+done:
+	free(src);
+	free(dst);
+	free(expected);
+}
+
+// there's no independent reference for the AA blends, the NEON ones have to match C
+static void checkAA(uint8_t* src, uint8_t* dst, uint8_t* expected) {
+#ifdef HAS_NEON
+	static const uint32_t geometry[][4] = {
+		{160, 5, 240, 7}, {160, 4, 400, 10}, {33, 5, 50, 8}, {161, 3, 322, 5}, {8, 2, 13, 3},
+	};
+	for (int format=SCALER_FORMAT_16; format<=SCALER_FORMAT_32; format++) {
+		uint32_t bpp = src_bpp[format];
+		for (int g=0; g<sizeof(geometry)/sizeof(geometry[0]); g++) {
+			uint32_t sw = geometry[g][0], sh = geometry[g][1], dw = geometry[g][2], dh = geometry[g][3];
+			uint32_t sp = sw*bpp, dp = dw*bpp;
+			fillRandom(src, SRC_SIZE);
+			memset(dst, CHECK_CANARY, DST_SIZE);
+			memset(expected, CHECK_CANARY, DST_SIZE);
+
+			scaler_t c = scaler_getAA_simd(SCALER_SIMD_C, format, sw, sh, dw, dh);
+			if (c) c(src, expected, sw, sh, sp, dw, dh, dp);
+			scaler_t n = scaler_getAA_simd(SCALER_SIMD_NEON, format, sw, sh, dw, dh);
+			if (n) n(src, dst, sw, sh, sp, dw, dh, dp);
+
+			cases += 1;
+			if (c && n && !memcmp(dst, expected, DST_SIZE)) continue;
+			failures += 1;
+			printf("FAIL scaleAA_neon%s %ux%u -> %ux%u: first difference at byte %d\n",
+				format_names[format], sw, sh, dw, dh, firstDifference(dst, expected, DST_SIZE));
+		}
+	}
+	scaler_freeAA();
+#endif
+}
+
+///////////////////////////////
+
+int main(int argc, char* argv[]) {
+	rng_state = argc>1 ? strtoul(argv[1], NULL, 0) : 1;
+	if (!rng_state) rng_state = 1;
+
+	uint8_t* src = malloc(SRC_SIZE);
+	uint8_t* dst = malloc(DST_SIZE);
+	uint8_t* expected = malloc(DST_SIZE);
+	if (!src || !dst || !expected) {
+		fprintf(stderr, "check: out of memory\n");
+		return 1;
+	}
+
+	checkTable(src, dst, expected);
+	checkPool();
+	checkAA(src, dst, expected);
+
+#ifdef HAS_NEON
+	const char* built = "c, neon";
+#else
+	const char* built = "c";
+#endif
+	printf("%d cases (%s), %d failed\n", cases, built, failures);
+
+	free(src);
+	free(dst);
+	free(expected);
+	return failures ? 1 : 0;
+}
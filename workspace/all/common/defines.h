@@ -27,6 +27,7 @@
 #define AUTO_RESUME_PATH SHARED_USERDATA_PATH "/.minos/auto_resume.txt"
 #define AUTO_RESUME_SLOT 9
 #define GAME_SWITCHER_PERSIST_PATH SHARED_USERDATA_PATH "/.minos/game_switcher.txt"
+#define LIBRARY_INDEX_PATH SHARED_USERDATA_PATH "/.minos/index"
 
 #define FAUX_RECENT_PATH SDCARD_PATH "/Recently Played"
 #define COLLECTIONS_PATH SDCARD_PATH "/Collections"
@@ -0,0 +1,463 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "ktx.h"
+
+///////////////////////////////
+
+static const uint8_t ktx_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+typedef struct KTX_Header
+{
+	uint8_t identifier[12];
+	uint32_t endianness;
+	uint32_t glType;
+	uint32_t glTypeSize;
+	uint32_t glFormat;
+	uint32_t glInternalFormat;
+	uint32_t glBaseInternalFormat;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t numberOfArrayElements;
+	uint32_t numberOfFaces;
+	uint32_t numberOfMipmapLevels;
+	uint32_t bytesOfKeyValueData;
+} KTX_Header;
+
+#define KTX_ENDIAN_REF 0x04030201
+#define KTX_GL_RGBA 0x1908
+
+///////////////////////////////
+
+// ETC1/ETC2 intensity modifiers, a pixel index picks {+a, +b, -a, -b}
+static const int etc_modifiers[8][2] = {
+		{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+// EAC alpha modifiers, value = base + modifier * multiplier
+static const int eac_modifiers[16][8] = {
+		{-3, -6, -9, -15, 2, 5, 8, 14},
+		{-3, -7, -10, -13, 2, 6, 9, 12},
+		{-2, -5, -8, -13, 1, 4, 7, 12},
+		{-2, -4, -6, -13, 1, 3, 5, 12},
+		{-3, -6, -8, -12, 2, 5, 7, 11},
+		{-3, -7, -9, -11, 2, 6, 8, 10},
+		{-4, -7, -8, -11, 3, 6, 7, 10},
+		{-3, -5, -8, -11, 2, 4, 7, 10},
+		{-2, -6, -8, -10, 1, 5, 7, 9},
+		{-2, -5, -8, -10, 1, 4, 7, 9},
+		{-2, -4, -8, -10, 1, 3, 7, 9},
+		{-2, -5, -7, -10, 1, 4, 6, 9},
+		{-3, -4, -7, -10, 2, 3, 6, 9},
+		{-1, -2, -3, -10, 0, 1, 2, 9},
+		{-4, -6, -8, -9, 3, 5, 7, 8},
+		{-3, -5, -7, -9, 2, 4, 6, 8},
+};
+
+static inline int clamp255(int v)
+{
+	return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static inline void putBE64(uint8_t *out, uint64_t word)
+{
+	for (int i = 0; i < 8; i++)
+		out[i] = word >> (56 - i * 8);
+}
+
+// pixels within a block are numbered column first (p = x*4 + y) as in the ETC spec
+static inline int inSubblock(int p, int flip, int sub)
+{
+	return (flip ? ((p & 3) >= 2) : (p >= 8)) == sub;
+}
+
+// picks the modifier table and per pixel modifiers for one half of a block, returns its error
+static uint32_t etcFitSubblock(const uint8_t px[16][4], const uint8_t weight[16], int flip, int sub,
+															 int r, int g, int b, int *out_table, uint32_t *msb, uint32_t *lsb)
+{
+	uint32_t best_err = UINT32_MAX;
+	uint32_t best_msb = 0, best_lsb = 0;
+
+	for (int t = 0; t < 8; t++)
+	{
+		const int mods[4] = {etc_modifiers[t][0], etc_modifiers[t][1], -etc_modifiers[t][0], -etc_modifiers[t][1]};
+		uint32_t err = 0, m = 0, l = 0;
+
+		for (int p = 0; p < 16 && err < best_err; p++)
+		{
+			if (!inSubblock(p, flip, sub))
+				continue;
+
+			uint32_t pixel_err = UINT32_MAX;
+			int pixel_idx = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				int dr = clamp255(r + mods[i]) - px[p][0];
+				int dg = clamp255(g + mods[i]) - px[p][1];
+				int db = clamp255(b + mods[i]) - px[p][2];
+				uint32_t e = dr * dr + dg * dg + db * db;
+				if (e < pixel_err)
+				{
+					pixel_err = e;
+					pixel_idx = i;
+				}
+			}
+			err += pixel_err * weight[p];
+			m |= ((pixel_idx >> 1) & 1) << p;
+			l |= (pixel_idx & 1) << p;
+		}
+
+		if (err < best_err)
+		{
+			best_err = err;
+			best_msb = m;
+			best_lsb = l;
+			*out_table = t;
+		}
+	}
+
+	*msb |= best_msb;
+	*lsb |= best_lsb;
+	return best_err;
+}
+
+static void etcEncodeColor(const uint8_t px[16][4], const uint8_t weight[16], uint8_t out[8])
+{
+	uint32_t best_err = UINT32_MAX;
+	uint64_t best_word = 0;
+
+	for (int flip = 0; flip < 2; flip++)
+	{
+		int avg[2][3];
+		for (int sub = 0; sub < 2; sub++)
+		{
+			int sum[3] = {0, 0, 0}, total = 0;
+			for (int p = 0; p < 16; p++)
+			{
+				if (!inSubblock(p, flip, sub) || !weight[p])
+					continue;
+				sum[0] += px[p][0];
+				sum[1] += px[p][1];
+				sum[2] += px[p][2];
+				total++;
+			}
+			for (int c = 0; c < 3; c++)
+				avg[sub][c] = total ? (sum[c] + total / 2) / total : 0;
+		}
+
+		// individual mode, two 4 bit colors
+		{
+			int q[2][3], e[2][3];
+			for (int sub = 0; sub < 2; sub++)
+				for (int c = 0; c < 3; c++)
+				{
+					q[sub][c] = (avg[sub][c] * 15 + 127) / 255;
+					e[sub][c] = (q[sub][c] << 4) | q[sub][c];
+				}
+
+			int t1 = 0, t2 = 0;
+			uint32_t msb = 0, lsb = 0;
+			uint32_t err = etcFitSubblock(px, weight, flip, 0, e[0][0], e[0][1], e[0][2], &t1, &msb, &lsb);
+			err += etcFitSubblock(px, weight, flip, 1, e[1][0], e[1][1], e[1][2], &t2, &msb, &lsb);
+			if (err < best_err)
+			{
+				best_err = err;
+				best_word = ((uint64_t)q[0][0] << 60) | ((uint64_t)q[1][0] << 56) |
+										((uint64_t)q[0][1] << 52) | ((uint64_t)q[1][1] << 48) |
+										((uint64_t)q[0][2] << 44) | ((uint64_t)q[1][2] << 40) |
+										((uint64_t)t1 << 37) | ((uint64_t)t2 << 34) |
+										((uint64_t)flip << 32) | ((uint64_t)msb << 16) | lsb;
+			}
+		}
+
+		// differential mode, a 5 bit color plus a 3 bit signed delta
+		{
+			int q[2][3], e[2][3], valid = 1;
+			for (int sub = 0; sub < 2; sub++)
+				for (int c = 0; c < 3; c++)
+				{
+					q[sub][c] = (avg[sub][c] * 31 + 127) / 255;
+					e[sub][c] = (q[sub][c] << 3) | (q[sub][c] >> 2);
+				}
+			for (int c = 0; c < 3; c++)
+			{
+				int d = q[1][c] - q[0][c];
+				if (d < -4 || d > 3)
+					valid = 0;
+			}
+
+			if (valid)
+			{
+				int t1 = 0, t2 = 0;
+				uint32_t msb = 0, lsb = 0;
+				uint32_t err = etcFitSubblock(px, weight, flip, 0, e[0][0], e[0][1], e[0][2], &t1, &msb, &lsb);
+				err += etcFitSubblock(px, weight, flip, 1, e[1][0], e[1][1], e[1][2], &t2, &msb, &lsb);
+				if (err < best_err)
+				{
+					best_err = err;
+					best_word = ((uint64_t)q[0][0] << 59) | ((uint64_t)((q[1][0] - q[0][0]) & 7) << 56) |
+											((uint64_t)q[0][1] << 51) | ((uint64_t)((q[1][1] - q[0][1]) & 7) << 48) |
+											((uint64_t)q[0][2] << 43) | ((uint64_t)((q[1][2] - q[0][2]) & 7) << 40) |
+											((uint64_t)t1 << 37) | ((uint64_t)t2 << 34) | ((uint64_t)1 << 33) |
+											((uint64_t)flip << 32) | ((uint64_t)msb << 16) | lsb;
+				}
+			}
+		}
+	}
+
+	putBE64(out, best_word);
+}
+
+static void eacEncodeAlpha(const uint8_t px[16][4], uint8_t out[8])
+{
+	int min = 255, max = 0;
+	for (int p = 0; p < 16; p++)
+	{
+		if (px[p][3] < min)
+			min = px[p][3];
+		if (px[p][3] > max)
+			max = px[p][3];
+	}
+
+	int best_base = min, best_mult = 1, best_table = 13;
+	uint8_t best_idx[16];
+	memset(best_idx, 4, sizeof(best_idx)); // table 13 index 4 is a zero modifier, exact for flat blocks
+
+	if (min != max)
+	{
+		uint32_t best_err = UINT32_MAX;
+		for (int t = 0; t < 16 && best_err; t++)
+		{
+			const int *mods = eac_modifiers[t];
+			int range = mods[7] - mods[3];
+			int mult = ((max - min) + range / 2) / range;
+
+			for (int m = mult - 1; m <= mult + 1; m++)
+			{
+				if (m < 1 || m > 15)
+					continue;
+				int base = clamp255((min + max - m * (mods[7] + mods[3]) + 1) / 2);
+
+				uint32_t err = 0;
+				uint8_t idx[16];
+				for (int p = 0; p < 16 && err < best_err; p++)
+				{
+					uint32_t pixel_err = UINT32_MAX;
+					for (int i = 0; i < 8; i++)
+					{
+						int d = clamp255(base + mods[i] * m) - px[p][3];
+						if ((uint32_t)(d * d) < pixel_err)
+						{
+							pixel_err = d * d;
+							idx[p] = i;
+						}
+					}
+					err += pixel_err;
+				}
+
+				if (err < best_err)
+				{
+					best_err = err;
+					best_base = base;
+					best_mult = m;
+					best_table = t;
+					memcpy(best_idx, idx, sizeof(idx));
+				}
+			}
+		}
+	}
+
+	uint64_t word = ((uint64_t)best_base << 56) | ((uint64_t)best_mult << 52) | ((uint64_t)best_table << 48);
+	for (int p = 0; p < 16; p++)
+		word |= (uint64_t)best_idx[p] << (45 - p * 3);
+	putBE64(out, word);
+}
+
+int KTX_encodeRGBA8(const uint8_t *rgba, int width, int height, int pitch, KTX_Image *out)
+{
+	if (!rgba || width <= 0 || height <= 0 || !out)
+		return -1;
+
+	int blocks_w = (width + 3) / 4;
+	int blocks_h = (height + 3) / 4;
+
+	out->format = KTX_RGBA8_ETC2_EAC;
+	out->width = width;
+	out->height = height;
+	out->size = blocks_w * blocks_h * 16;
+	out->data = malloc(out->size);
+	if (!out->data)
+		return -1;
+
+	uint8_t *dst = out->data;
+	for (int by = 0; by < blocks_h; by++)
+	{
+		for (int bx = 0; bx < blocks_w; bx++)
+		{
+			uint8_t px[16][4];
+			uint8_t weight[16];
+			for (int x = 0; x < 4; x++)
+			{
+				// edge blocks repeat the last row/column
+				int sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+				for (int y = 0; y < 4; y++)
+				{
+					int sy = by * 4 + y < height ? by * 4 + y : height - 1;
+					const uint8_t *src = rgba + sy * pitch + sx * 4;
+					int p = x * 4 + y;
+					memcpy(px[p], src, 4);
+					weight[p] = src[3] ? 1 : 0; // color under fully transparent pixels is never seen
+				}
+			}
+
+			int visible = 0;
+			for (int p = 0; p < 16; p++)
+				visible |= weight[p];
+			if (!visible)
+				memset(weight, 1, sizeof(weight));
+
+			eacEncodeAlpha(px, dst);
+			etcEncodeColor(px, weight, dst + 8);
+			dst += 16;
+		}
+	}
+	return 0;
+}
+
+///////////////////////////////
+
+int KTX_load(const char *path, KTX_Image *out)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return -1;
+
+	KTX_Header header;
+	uint32_t size = 0;
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+			memcmp(header.identifier, ktx_identifier, sizeof(ktx_identifier)) ||
+			header.endianness != KTX_ENDIAN_REF ||
+			header.glInternalFormat != KTX_RGBA8_ETC2_EAC ||
+			fseek(file, header.bytesOfKeyValueData, SEEK_CUR) ||
+			fread(&size, sizeof(size), 1, file) != 1)
+	{
+		fclose(file);
+		return -1;
+	}
+
+	uint32_t expected = ((header.pixelWidth + 3) / 4) * ((header.pixelHeight + 3) / 4) * 16;
+	if (size != expected)
+	{
+		fclose(file);
+		return -1;
+	}
+
+	out->data = malloc(size);
+	if (!out->data || fread(out->data, 1, size, file) != size)
+	{
+		free(out->data);
+		out->data = NULL;
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+
+	out->format = header.glInternalFormat;
+	out->width = header.pixelWidth;
+	out->height = header.pixelHeight;
+	out->size = size;
+	return 0;
+}
+
+int KTX_save(const char *path, const KTX_Image *image)
+{
+	KTX_Header header = {
+			.endianness = KTX_ENDIAN_REF,
+			.glType = 0, // compressed
+			.glTypeSize = 1,
+			.glFormat = 0,
+			.glInternalFormat = image->format,
+			.glBaseInternalFormat = KTX_GL_RGBA,
+			.pixelWidth = image->width,
+			.pixelHeight = image->height,
+			.pixelDepth = 0,
+			.numberOfArrayElements = 0,
+			.numberOfFaces = 1,
+			.numberOfMipmapLevels = 1,
+			.bytesOfKeyValueData = 0,
+	};
+	memcpy(header.identifier, ktx_identifier, sizeof(ktx_identifier));
+
+	// write to a temp file first so a crash never leaves a truncated ktx behind
+	char tmp_path[512];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	FILE *file = fopen(tmp_path, "wb");
+	if (!file)
+		return -1;
+
+	int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+					 fwrite(&image->size, sizeof(image->size), 1, file) == 1 &&
+					 fwrite(image->data, 1, image->size, file) == image->size;
+	ok = (fclose(file) == 0) && ok;
+
+	if (!ok || rename(tmp_path, path) != 0)
+	{
+		remove(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+void KTX_free(KTX_Image *image)
+{
+	if (!image)
+		return;
+	free(image->data);
+	memset(image, 0, sizeof(*image));
+}
+
+#define KTX_HASH_LEN 16 // hex digits of the path hash that start every cache file name
+
+int KTX_getCachePath(const char *cache_dir, const char *src_path, char *ktx_path, int max_len)
+{
+	struct stat st;
+	if (stat(src_path, &st) != 0)
+		return 0;
+
+	uint64_t hash = 14695981039346656037ull; // FNV-1a
+	for (const unsigned char *s = (const unsigned char *)src_path; *s; s++)
+	{
+		hash ^= *s;
+		hash *= 1099511628211ull;
+	}
+	snprintf(ktx_path, max_len, "%s/%016llx-%llx-%llx%s", cache_dir, (unsigned long long)hash,
+					 (unsigned long long)st.st_mtime, (unsigned long long)st.st_size, KTX_EXTENSION);
+	return 1;
+}
+
+void KTX_removeStale(const char *ktx_path)
+{
+	char dir_path[512];
+	snprintf(dir_path, sizeof(dir_path), "%s", ktx_path);
+	char *name = strrchr(dir_path, '/');
+	if (!name || strlen(name + 1) <= KTX_HASH_LEN)
+		return;
+	*name++ = '\0';
+
+	DIR *dir = opendir(dir_path);
+	if (!dir)
+		return;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (strncmp(entry->d_name, name, KTX_HASH_LEN + 1) != 0 || strcmp(entry->d_name, name) == 0)
+			continue;
+		char stale_path[768];
+		snprintf(stale_path, sizeof(stale_path), "%s/%s", dir_path, entry->d_name);
+		unlink(stale_path);
+	}
+	closedir(dir);
+}
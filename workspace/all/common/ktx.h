@@ -0,0 +1,35 @@
+#ifndef __KTX_H__
+#define __KTX_H__
+#include <stdint.h>
+
+//
+//	minimal KTX 1.1 container + ETC2/EAC encoder
+//	used to keep GPU ready copies of the overlay/effect pngs in a cache folder,
+//	ETC2 is part of core GLES 3.0 so every device with our GL context can sample it
+//
+
+#define KTX_RGBA8_ETC2_EAC 0x9278 // GL_COMPRESSED_RGBA8_ETC2_EAC
+#define KTX_EXTENSION ".ktx"
+
+typedef struct KTX_Image
+{
+	uint32_t format; // glInternalFormat
+	int width;
+	int height;
+	uint32_t size; // bytes in data
+	uint8_t *data;
+} KTX_Image;
+
+// rgba is R,G,B,A byte order (SDL_PIXELFORMAT_RGBA32), pitch in bytes. returns 0 on success
+int KTX_encodeRGBA8(const uint8_t *rgba, int width, int height, int pitch, KTX_Image *out);
+int KTX_load(const char *path, KTX_Image *out); // returns 0 on success
+int KTX_save(const char *path, const KTX_Image *image); // returns 0 on success
+void KTX_free(KTX_Image *image);
+
+// builds the path of src_path's .ktx in cache_dir, named after a hash of src_path and its
+// mtime and size so a changed source just misses. returns 0 if src_path can't be stat'd
+int KTX_getCachePath(const char *cache_dir, const char *src_path, char *ktx_path, int max_len);
+// deletes the .ktx files next to ktx_path made from older versions of the same source
+void KTX_removeStale(const char *ktx_path);
+
+#endif
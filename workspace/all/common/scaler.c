@@ -1,11 +1,19 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "platform.h" // for HAS_NEON
+#include "scaler.h"
+
+#ifdef HAS_NEON
+#include <arm_neon.h>
+#endif
 
 //
-//	arm NEON / C integer scalers for ARMv7 devices
+//	arm NEON / C integer scalers for ARMv7 and AArch64 devices
 //	args/	src :	src offset		address of top left corner
 //		dst :	dst offset		address	of top left corner
 //		sw  :	src width		pixels
@@ -16,2879 +24,684 @@
 //		dp  :	dst pitch (stride)	bytes	if 0, (src width * [2|4] * multiplier) is used
 //
 //	** NOTE **
-//	since 32bit aligned addresses need to be processed for NEON scalers,
-//	x-offset and stride pixels must be even# in the case of 16bpp,
-//	if odd#, then handled by the C scaler
+//	the NEON scalers have no alignment requirements and produce exactly
+//	the same output as the C scalers, they only differ in speed
+//
+//	every scaler is generated from two pieces:
+//		a line kernel	expands one source line by xmul, specialized per (xmul, format, simd)
+//		SCALER_ROWS	walks the source lines and copies each expanded line ymul-1 times
+//	ymul only changes how often a finished line is copied so it stays a runtime
+//	argument of the row walker, the fixed scaleNxM_* entry points just tail call
+//	it (noinline keeps the 64 entry points per family from each carrying a copy)
 //
 
-static void dummy(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {}
+// source pixel -> destination pixel per format
+#define CONVERT_16(p) (p)
+#define CONVERT_32(p) (p)
+#define CONVERT_16to32(p) (0xFF000000 | (((uint32_t)(p) & 0xF800) << 8) | (((uint32_t)(p) & 0x07E0) << 5) | (((uint32_t)(p) & 0x001F) << 3))
 
-// 
-// C scalers for Trimui Model S and GKD Pixel
-//
-void scale1x_c16to32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t x, dx, pix, dpix1, dpix2, swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } swl*=2; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<(sw/2); x++, dx+=2) {
-			pix = s[x];
-			dpix1 = 0xFF000000 | ((pix & 0xF800) << 8) | ((pix & 0x07E0) << 5) | ((pix & 0x001F) << 3);
-			dpix2 = 0xFF000000 | ((pix & 0xF8000000) >> 8) | ((pix & 0x07E00000) >> 11) | ((pix & 0x001F0000) >> 13);			d[dx  ] = dpix1; d[dx+1] = dpix1;
-			d[dx  ] = dpix1; d[dx+1] = dpix2;
-		}
-		if (sw&1) {
-			uint16_t *s16 = (uint16_t*)s;
-			uint16_t pix16 = s16[x*2];
-			pix16 = 0xFF000000 | ((pix16 & 0xF800) << 8) | ((pix16 & 0x07E0) << 5) | ((pix16 & 0x001F) << 3);
-			d[dx  ] = pix16; d[dx+1] = pix16;
-		}
-		dst = (uint8_t*)dst+dp;
-	}
-}
-void scale2x_c16to32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t x, dx, pix, dpix1, dpix2, swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } swl*=2; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<(sw/2); x++, dx+=4) {
-			pix = s[x];
-			dpix1 = 0xFF000000 | ((pix & 0xF800) << 8) | ((pix & 0x07E0) << 5) | ((pix & 0x001F) << 3);
-			dpix2 = 0xFF000000 | ((pix & 0xF8000000) >> 8) | ((pix & 0x07E00000) >> 11) | ((pix & 0x001F0000) >> 13);			d[dx  ] = dpix1; d[dx+1] = dpix1;
-			d[dx+2] = dpix2; d[dx+3] = dpix2;
-		}
-		if (sw&1) {
-			uint16_t *s16 = (uint16_t*)s;
-			uint16_t pix16 = s16[x*2];
-			pix16 = 0xFF000000 | ((pix16 & 0xF800) << 8) | ((pix16 & 0x07E0) << 5) | ((pix16 & 0x001F) << 3);
-			d[dx  ] = pix16; d[dx+1] = pix16;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		memcpy(dst, dstsrc, swl); dst = (uint8_t*)dst+dp;
-	}
-}
+#define COPY_c memcpy
+#ifdef HAS_NEON
+#define COPY_n memcpy_neon
+#endif
 
 //
-//	C scalers
+//	C line kernels
 //
-void scale1x_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*1; }
-	if ((ymul == 1)&&(swl == sp)&&(sp == dp)) memcpy(dst, src, sp*sh);
-	else {
-		if (swl>dp) swl = dp;
-		for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-			for (uint32_t i=ymul; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, src, swl);
-		}
-	}
-}
-
-void scale1x1_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale1x2_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale1x3_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale1x4_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale1x_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*1; }
-	if ((ymul == 1)&&(swl == sp)&&(sp == dp)) memcpy(dst, src, sp*sh);
-	else {
-		for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-			for (uint32_t i=ymul; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, src, swl);
-		}
-	}
-}
-
-void scale1x1_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale1x2_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale1x3_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale1x4_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale1x_c32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale2x_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, dpix1, dpix2, swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } swl*=2; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<(sw/2); x++, dx+=2) {
-			pix = s[x];
-			dpix1=(pix & 0x0000FFFF)|(pix<<16);
-			dpix2=(pix & 0xFFFF0000)|(pix>>16);
-			d[dx] = dpix1; d[dx+1] = dpix2;
-		}
-		if (sw&1) {
-			uint16_t *s16 = (uint16_t*)s;
-			uint16_t pix16 = s16[x*2];
-			d[dx] = pix16|(pix16<<16);
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
 
-void scale2x1_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale2x2_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale2x3_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale2x4_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale2x_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } swl*=2; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<sw; x++, dx+=2) {
-			pix = s[x];
-			d[dx] = pix; d[dx+1] = pix;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
+#define SCALER_LINE_C(X, fmt, src_t, dst_t) \
+static inline void scale##X##x_c##fmt##line(src_t* __restrict s, dst_t* __restrict d, uint32_t sw) { \
+	if (X==1 && sizeof(src_t)==sizeof(dst_t)) { memcpy(d, s, sw*sizeof(dst_t)); return; } \
+	for (uint32_t x=0; x<sw; x++, d+=X) { \
+		dst_t pix = CONVERT_##fmt(s[x]); \
+		for (uint32_t i=0; i<X; i++) d[i] = pix; \
+	} \
 }
 
-void scale2x1_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale2x2_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale2x3_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale2x4_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale2x_c32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale3x_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, dpix1, dpix2, swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } swl*=3; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<(sw/2); x++, dx+=3) {
-			pix = s[x];
-			dpix1=(pix & 0x0000FFFF)|(pix<<16);
-			dpix2=(pix & 0xFFFF0000)|(pix>>16);
-			d[dx] = dpix1; d[dx+1] = pix; d[dx+2] = dpix2;
-		}
-		if (sw&1) {
-			uint16_t *s16 = (uint16_t*)s;
-			uint16_t *d16 = (uint16_t*)d;
-			uint16_t pix16 = s16[x*2];
-			dpix1 = pix16|(pix16<<16);
-			d[dx] = dpix1; d16[(dx+1)*2] = pix16;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
+#define SCALER_LINES_C(fmt, src_t, dst_t) \
+	SCALER_LINE_C(1, fmt, src_t, dst_t) SCALER_LINE_C(2, fmt, src_t, dst_t) \
+	SCALER_LINE_C(3, fmt, src_t, dst_t) SCALER_LINE_C(4, fmt, src_t, dst_t) \
+	SCALER_LINE_C(5, fmt, src_t, dst_t) SCALER_LINE_C(6, fmt, src_t, dst_t) \
+	SCALER_LINE_C(7, fmt, src_t, dst_t) SCALER_LINE_C(8, fmt, src_t, dst_t)
 
-void scale3x1_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale3x2_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale3x3_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale3x4_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale3x_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } swl*=3; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<sw; x++, dx+=3) {
-			pix = s[x];
-			d[dx] = pix; d[dx+1] = pix; d[dx+2] = pix;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
-
-void scale3x1_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale3x2_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale3x3_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale3x4_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale3x_c32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale4x_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, dpix1, dpix2, swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } swl*=4; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<(sw/2); x++, dx+=4) {
-			pix = s[x];
-			dpix1=(pix & 0x0000FFFF)|(pix<<16);
-			dpix2=(pix & 0xFFFF0000)|(pix>>16);
-			d[dx] = dpix1; d[dx+1] = dpix1; d[dx+2] = dpix2; d[dx+3] = dpix2;
-		}
-		if (sw&1) {
-			uint16_t *s16 = (uint16_t*)s;
-			uint16_t pix16 = s16[x*2];
-			dpix1 = pix16|(pix16<<16);
-			d[dx] = dpix1; d[dx+1] = dpix1;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
-
-void scale4x1_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale4x2_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale4x3_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale4x4_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale4x_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } swl*=4; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<sw; x++, dx+=4) {
-			pix = s[x];
-			d[dx] = pix; d[dx+1] = pix; d[dx+2] = pix; d[dx+3] = pix;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
-
-void scale4x1_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale4x2_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale4x3_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale4x4_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale4x_c32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-
-void scale5x_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, dpix1, dpix2, swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } swl*=5; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<(sw/2); x++, dx+=5) {
-			pix = s[x];
-			dpix1=(pix & 0x0000FFFF)|(pix<<16);
-			dpix2=(pix & 0xFFFF0000)|(pix>>16);
-			d[dx] = dpix1; d[dx+1] = dpix1; d[dx+2] = pix; d[dx+3] = dpix2; d[dx+4] = dpix2;
-		}
-		if (sw&1) {
-			uint16_t *s16 = (uint16_t*)s;
-			uint16_t *d16 = (uint16_t*)d;
-			uint16_t pix16 = s16[x*2];
-			dpix1 = pix16|(pix16<<16);
-			d[dx] = dpix1; d[dx+1] = dpix1; d16[(dx+2)*2] = pix16;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
-
-void scale5x1_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale5x2_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale5x3_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale5x4_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale5x5_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c16(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-
-void scale5x_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } swl*=5; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<sw; x++, dx+=5) {
-			pix = s[x];
-			d[dx] = pix; d[dx+1] = pix; d[dx+2] = pix; d[dx+3] = pix; d[dx+4] = pix;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
-
-void scale5x1_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale5x2_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale5x3_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale5x4_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale5x5_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_c32(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-
-void scale6x_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, dpix1, dpix2, swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } swl*=6; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<(sw/2); x++, dx+=6) {
-			pix = s[x];
-			dpix1=(pix & 0x0000FFFF)|(pix<<16);
-			dpix2=(pix & 0xFFFF0000)|(pix>>16);
-			d[dx] = dpix1; d[dx+1] = dpix1; d[dx+2] = dpix1; d[dx+3] = dpix2; d[dx+4] = dpix2; d[dx+5] = dpix2;
-		}
-		if (sw&1) {
-			uint16_t *s16 = (uint16_t*)s;
-			uint16_t pix16 = s16[x*2];
-			dpix1 = pix16|(pix16<<16);
-			d[dx] = dpix1; d[dx+1] = dpix1; d[dx+2] = dpix1;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
-
-void scale6x1_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale6x2_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale6x3_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale6x4_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale6x5_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c16(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-void scale6x6_c16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c16(src, dst, sw, sh, sp, dw, dh, dp, 6); }
-
-void scale6x_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t x, dx, pix, swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } swl*=6; if (!dp) { dp = swl; }
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		uint32_t *s = (uint32_t* __restrict)src;
-		uint32_t *d = (uint32_t* __restrict)dst;
-		for (x=dx=0; x<sw; x++, dx+=6) {
-			pix = s[x];
-			d[dx] = pix; d[dx+1] = pix; d[dx+2] = pix; d[dx+3] = pix; d[dx+4] = pix; d[dx+5] = pix;
-		}
-		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy(dst, dstsrc, swl);
-	}
-}
-
-void scale6x1_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale6x2_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale6x3_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale6x4_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale6x5_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c32(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-void scale6x6_c32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_c32(src, dst, sw, sh, sp, dw, dh, dp, 6); }
+SCALER_LINES_C(16, uint16_t, uint16_t)
+SCALER_LINES_C(32, uint32_t, uint32_t)
+SCALER_LINES_C(16to32, uint16_t, uint32_t)
 
 #ifdef HAS_NEON
 
 //
-//	memcpy_neon (dst/src must be aligned 4, size must be aligned 2)
+//	memcpy_neon (dst/src have no alignment requirement, size in bytes)
 //
 void memcpy_neon(void* dst, void* src, uint32_t size) {
-	asm volatile (
-	"	bic r4, %[sz], #127	;"
-	"	add r3, %[s], %[sz]	;"	// r3 = endofs
-	"	add r4, %[s], r4	;"	// r4 = s128ofs
-	"	cmp %[s], r4		;"
-	"	beq 2f			;"
-	"1:	vldmia %[s]!, {q8-q15}	;"	// 128 bytes
-	"	vstmia %[d]!, {q8-q15}	;"
-	"	cmp %[s], r4		;"
-	"	bne 1b			;"
-	"2:	cmp %[s], r3		;"
-	"	beq 7f			;"
-	"	tst %[sz], #64		;"
-	"	beq 3f			;"
-	"	vldmia %[s]!, {q8-q11}	;"	// 64 bytes
-	"	vstmia %[d]!, {q8-q11}	;"
-	"	cmp %[s], r3		;"
-	"	beq 7f			;"
-	"3:	tst %[sz], #32		;"
-	"	beq 4f			;"
-	"	vldmia %[s]!, {q12-q13}	;"	// 32 bytes
-	"	vstmia %[d]!, {q12-q13}	;"
-	"	cmp %[s], r3		;"
-	"	beq 7f			;"
-	"4:	tst %[sz], #16		;"
-	"	beq 5f			;"
-	"	vldmia %[s]!, {q14}	;"	// 16 bytes
-	"	vstmia %[d]!, {q14}	;"
-	"	cmp %[s], r3		;"
-	"	beq 7f			;"
-	"5:	tst %[sz], #8		;"
-	"	beq 6f			;"
-	"	vldmia %[s]!, {d30}	;"	// 8 bytes
-	"	vstmia %[d]!, {d30}	;"
-	"	cmp %[s], r3		;"
-	"	beq 7f			;"
-	"6:	ldrh r4, [%[s]],#2	;"	// rest
-	"	strh r4, [%[d]],#2	;"
-	"	cmp %[s], r3		;"
-	"	bne 6b			;"
-	"7:				"
-	: [s]"+r"(src), [d]"+r"(dst)
-	: [sz]"r"(size)
-	: "r3","r4","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+	uint8_t* d = (uint8_t*)dst;
+	uint8_t* s = (uint8_t*)src;
+	for (; size>=64; size-=64, s+=64, d+=64) {
+		uint8x16_t q0 = vld1q_u8(s);
+		uint8x16_t q1 = vld1q_u8(s+16);
+		uint8x16_t q2 = vld1q_u8(s+32);
+		uint8x16_t q3 = vld1q_u8(s+48);
+		vst1q_u8(d, q0);
+		vst1q_u8(d+16, q1);
+		vst1q_u8(d+32, q2);
+		vst1q_u8(d+48, q3);
+	}
+	for (; size>=16; size-=16, s+=16, d+=16) vst1q_u8(d, vld1q_u8(s));
+	if (size) memcpy(d, s, size);
 }
 
 //
-//	NEON scalers
+//	NEON stores, write a vector of pixels with each pixel repeated N times
+//		16bpp: 8 pixels, 32bpp: 4 pixels
 //
 
-void scale1x1_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*1; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x1_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	if ((swl == sp)&&(sp == dp)) memcpy_neon(dst, src, sp*sh);
-	else {
-		if (swl>dp) swl = dp;
-		for (; sh>0; sh--, src=(uint8_t*)src+sp, dst=(uint8_t*)dst+dp) memcpy_neon(dst, src, swl);
-	}
-}
-
-void scale1x2_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x2_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl128 = swl & ~127;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x128bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q15}	;"	// 128 bytes
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	cmp %0, lr		;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 8f			;"
-	"	tst %3, #64		;"
-	"	beq 4f			;"
-	"	vldmia %0!, {q8-q11}	;"	// 64 bytes
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"4:	tst %3, #32		;"
-	"	beq 5f			;"
-	"	vldmia %0!, {q12-q13}	;"	// 32 bytes
-	"	vstmia %1!, {q12-q13}	;"
-	"	vstmia r9!, {q12-q13}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"5:	tst %3, #16		;"
-	"	beq 6f			;"
-	"	vldmia %0!, {q14}	;"	// 16 bytes
-	"	vstmia %1!, {q14}	;"
-	"	vstmia r9!, {q14}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"6:	tst %3, #8		;"
-	"	beq 7f			;"
-	"	vldmia %0!, {d30}	;"	// 8 bytes
-	"	vstmia %1!, {d30}	;"
-	"	vstmia r9!, {d30}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"7:	ldr lr, [%0],#4		;"	// 4 bytes
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9]		;"
-	"8:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl128), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale1x3_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x3_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl128 = swl & ~127;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x128bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q15}	;"	// 128 bytes
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	cmp %0, lr		;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 8f			;"
-	"	tst %3, #64		;"
-	"	beq 4f			;"
-	"	vldmia %0!, {q8-q11}	;"	// 64 bytes
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	vstmia r10!, {q8-q11}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"4:	tst %3, #32		;"
-	"	beq 5f			;"
-	"	vldmia %0!, {q12-q13}	;"	// 32 bytes
-	"	vstmia %1!, {q12-q13}	;"
-	"	vstmia r9!, {q12-q13}	;"
-	"	vstmia r10!, {q12-q13}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"5:	tst %3, #16		;"
-	"	beq 6f			;"
-	"	vldmia %0!, {q14}	;"	// 16 bytes
-	"	vstmia %1!, {q14}	;"
-	"	vstmia r9!, {q14}	;"
-	"	vstmia r10!, {q14}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"6:	tst %3, #8		;"
-	"	beq 7f			;"
-	"	vldmia %0!, {d30}	;"	// 8 bytes
-	"	vstmia %1!, {d30}	;"
-	"	vstmia r9!, {d30}	;"
-	"	vstmia r10!, {d30}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"7:	ldr lr, [%0],#4		;"	// 4 bytes
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9]		;"
-	"	str lr, [r10]		;"
-	"8:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl128), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale1x4_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x4_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl128 = swl & ~127;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x128bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q15}	;"	// 128 bytes
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	vstmia r11!, {q8-q15}	;"
-	"	cmp %0, lr		;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 8f			;"
-	"	tst %3, #64		;"
-	"	beq 4f			;"
-	"	vldmia %0!, {q8-q11}	;"	// 64 bytes
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	vstmia r10!, {q8-q11}	;"
-	"	vstmia r11!, {q8-q11}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"4:	tst %3, #32		;"
-	"	beq 5f			;"
-	"	vldmia %0!, {q12-q13}	;"	// 32 bytes
-	"	vstmia %1!, {q12-q13}	;"
-	"	vstmia r9!, {q12-q13}	;"
-	"	vstmia r10!, {q12-q13}	;"
-	"	vstmia r11!, {q12-q13}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"5:	tst %3, #16		;"
-	"	beq 6f			;"
-	"	vldmia %0!, {q14}	;"	// 16 bytes
-	"	vstmia %1!, {q14}	;"
-	"	vstmia r9!, {q14}	;"
-	"	vstmia r10!, {q14}	;"
-	"	vstmia r11!, {q14}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"6:	tst %3, #8		;"
-	"	beq 7f			;"
-	"	vldmia %0!, {d30}	;"	// 8 bytes
-	"	vstmia %1!, {d30}	;"
-	"	vstmia r9!, {d30}	;"
-	"	vstmia r10!, {d30}	;"
-	"	vstmia r11!, {d30}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"7:	ldr lr, [%0],#4		;"	// 4 bytes
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9]		;"
-	"	str lr, [r10]		;"
-	"	str lr, [r11]		;"
-	"8:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl128), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale1x_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale1x1_n16, &scale1x2_n16, &scale1x3_n16, &scale1x4_n16 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
-void scale1x1_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*1; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x1_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	if ((swl == sp)&&(sp == dp)) memcpy_neon(dst, src, sp*sh);
-	else for (; sh>0; sh--, src=(uint8_t*)src+sp, dst=(uint8_t*)dst+dp) memcpy_neon(dst, src, swl);
-}
-
-void scale1x2_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x2_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl128 = swl & ~127;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x128bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q15}	;"	// 128 bytes
-	"	vstmia %1!, {q8-q15}	;"
-	"	cmp %0, lr		;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 8f			;"
-	"	tst %3, #64		;"
-	"	beq 4f			;"
-	"	vldmia %0!, {q8-q11}	;"	// 64 bytes
-	"	vstmia %1!, {q8-q11}	;"
-	"	cmp %0, r8		;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	beq 8f			;"
-	"4:	tst %3, #32		;"
-	"	beq 5f			;"
-	"	vldmia %0!, {q12-q13}	;"	// 32 bytes
-	"	vstmia %1!, {q12-q13}	;"
-	"	cmp %0, r8		;"
-	"	vstmia r9!, {q12-q13}	;"
-	"	beq 8f			;"
-	"5:	tst %3, #16		;"
-	"	beq 6f			;"
-	"	vldmia %0!, {q14}	;"	// 16 bytes
-	"	vstmia %1!, {q14}	;"
-	"	cmp %0, r8		;"
-	"	vstmia r9!, {q14}	;"
-	"	beq 8f			;"
-	"6:	tst %3, #8		;"
-	"	beq 7f			;"
-	"	vldmia %0!, {d30}	;"	// 8 bytes
-	"	vstmia %1!, {d30}	;"
-	"	cmp %0, r8		;"
-	"	vstmia r9!, {d30}	;"
-	"	beq 8f			;"
-	"7:	ldr lr, [%0],#4		;"	// 4 bytes
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9]		;"
-	"8:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl128), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale1x3_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x3_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl128 = swl & ~127;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x128bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q15}	;"	// 128 bytes
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	cmp %0, lr		;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 8f			;"
-	"	tst %3, #64		;"
-	"	beq 4f			;"
-	"	vldmia %0!, {q8-q11}	;"	// 64 bytes
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	vstmia r10!, {q8-q11}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"4:	tst %3, #32		;"
-	"	beq 5f			;"
-	"	vldmia %0!, {q12-q13}	;"	// 32 bytes
-	"	vstmia %1!, {q12-q13}	;"
-	"	vstmia r9!, {q12-q13}	;"
-	"	vstmia r10!, {q12-q13}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"5:	tst %3, #16		;"
-	"	beq 6f			;"
-	"	vldmia %0!, {q14}	;"	// 16 bytes
-	"	vstmia %1!, {q14}	;"
-	"	vstmia r9!, {q14}	;"
-	"	vstmia r10!, {q14}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"6:	tst %3, #8		;"
-	"	beq 7f			;"
-	"	vldmia %0!, {d30}	;"	// 8 bytes
-	"	vstmia %1!, {d30}	;"
-	"	vstmia r9!, {d30}	;"
-	"	vstmia r10!, {d30}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"7:	ldr lr, [%0],#4		;"	// 4 bytes
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9]		;"
-	"	str lr, [r10]		;"
-	"8:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl128), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+static inline void store8x1_n16(uint16_t* d, uint16x8_t p) { vst1q_u16(d, p); }
+static inline void store8x2_n16(uint16_t* d, uint16x8_t p) { vst2q_u16(d, (uint16x8x2_t){{ p, p }}); }
+static inline void store8x3_n16(uint16_t* d, uint16x8_t p) { vst3q_u16(d, (uint16x8x3_t){{ p, p, p }}); }
+static inline void store8x4_n16(uint16_t* d, uint16x8_t p) { vst4q_u16(d, (uint16x8x4_t){{ p, p, p, p }}); }
+
+#define DUP8_N16(p) \
+	uint16x4_t p0 = vdup_lane_u16(vget_low_u16(p), 0); \
+	uint16x4_t p1 = vdup_lane_u16(vget_low_u16(p), 1); \
+	uint16x4_t p2 = vdup_lane_u16(vget_low_u16(p), 2); \
+	uint16x4_t p3 = vdup_lane_u16(vget_low_u16(p), 3); \
+	uint16x4_t p4 = vdup_lane_u16(vget_high_u16(p), 0); \
+	uint16x4_t p5 = vdup_lane_u16(vget_high_u16(p), 1); \
+	uint16x4_t p6 = vdup_lane_u16(vget_high_u16(p), 2); \
+	uint16x4_t p7 = vdup_lane_u16(vget_high_u16(p), 3)
+
+static inline void store8x5_n16(uint16_t* d, uint16x8_t p) {
+	DUP8_N16(p);
+	vst1q_u16(d,    vcombine_u16(p0, vext_u16(p0, p1, 3)));					// 0000 0111
+	vst1q_u16(d+8,  vcombine_u16(vext_u16(p1, p2, 2), vext_u16(p2, p3, 1)));	// 1122 2223
+	vst1q_u16(d+16, vcombine_u16(p3, p4));									// 3333 4444
+	vst1q_u16(d+24, vcombine_u16(vext_u16(p4, p5, 3), vext_u16(p5, p6, 2)));	// 4555 5566
+	vst1q_u16(d+32, vcombine_u16(vext_u16(p6, p7, 1), p7));					// 6667 7777
+}
+static inline void store8x6_n16(uint16_t* d, uint16x8_t p) {
+	uint16x8x2_t p2 = vzipq_u16(p, p);										// 00112233 44556677
+	vst3q_u16(d,    (uint16x8x3_t){{ p2.val[0], p2.val[0], p2.val[0] }});
+	vst3q_u16(d+24, (uint16x8x3_t){{ p2.val[1], p2.val[1], p2.val[1] }});
+}
+static inline void store8x7_n16(uint16_t* d, uint16x8_t p) {
+	DUP8_N16(p);
+	vst1q_u16(d,    vcombine_u16(p0, vext_u16(p0, p1, 1)));					// 0000 0001
+	vst1q_u16(d+8,  vcombine_u16(p1, vext_u16(p1, p2, 2)));					// 1111 1122
+	vst1q_u16(d+16, vcombine_u16(p2, vext_u16(p2, p3, 3)));					// 2222 2333
+	vst1q_u16(d+24, vcombine_u16(p3, p4));									// 3333 4444
+	vst1q_u16(d+32, vcombine_u16(vext_u16(p4, p5, 1), p5));					// 4445 5555
+	vst1q_u16(d+40, vcombine_u16(vext_u16(p5, p6, 2), p6));					// 5566 6666
+	vst1q_u16(d+48, vcombine_u16(vext_u16(p6, p7, 3), p7));					// 6777 7777
+}
+static inline void store8x8_n16(uint16_t* d, uint16x8_t p) {
+	uint16x8x2_t p2 = vzipq_u16(p, p);
+	vst4q_u16(d,    (uint16x8x4_t){{ p2.val[0], p2.val[0], p2.val[0], p2.val[0] }});
+	vst4q_u16(d+32, (uint16x8x4_t){{ p2.val[1], p2.val[1], p2.val[1], p2.val[1] }});
+}
+
+static inline void store4x1_n32(uint32_t* d, uint32x4_t p) { vst1q_u32(d, p); }
+static inline void store4x2_n32(uint32_t* d, uint32x4_t p) { vst2q_u32(d, (uint32x4x2_t){{ p, p }}); }
+static inline void store4x3_n32(uint32_t* d, uint32x4_t p) { vst3q_u32(d, (uint32x4x3_t){{ p, p, p }}); }
+static inline void store4x4_n32(uint32_t* d, uint32x4_t p) { vst4q_u32(d, (uint32x4x4_t){{ p, p, p, p }}); }
+
+#define DUP4_N32(p) \
+	uint32x4_t p0 = vdupq_lane_u32(vget_low_u32(p), 0); \
+	uint32x4_t p1 = vdupq_lane_u32(vget_low_u32(p), 1); \
+	uint32x4_t p2 = vdupq_lane_u32(vget_high_u32(p), 0); \
+	uint32x4_t p3 = vdupq_lane_u32(vget_high_u32(p), 1)
+
+static inline void store4x5_n32(uint32_t* d, uint32x4_t p) {
+	DUP4_N32(p);
+	vst1q_u32(d,    p0);
+	vst1q_u32(d+4,  vextq_u32(p0, p1, 3));									// 0111
+	vst1q_u32(d+8,  vextq_u32(p1, p2, 2));									// 1122
+	vst1q_u32(d+12, vextq_u32(p2, p3, 1));									// 2223
+	vst1q_u32(d+16, p3);
+}
+static inline void store4x6_n32(uint32_t* d, uint32x4_t p) {
+	uint32x4x2_t p2 = vzipq_u32(p, p);										// 0011 2233
+	vst3q_u32(d,    (uint32x4x3_t){{ p2.val[0], p2.val[0], p2.val[0] }});
+	vst3q_u32(d+12, (uint32x4x3_t){{ p2.val[1], p2.val[1], p2.val[1] }});
+}
+static inline void store4x7_n32(uint32_t* d, uint32x4_t p) {
+	DUP4_N32(p);
+	vst1q_u32(d,    p0);
+	vst1q_u32(d+4,  vextq_u32(p0, p1, 1));									// 0001
+	vst1q_u32(d+8,  p1);
+	vst1q_u32(d+12, vextq_u32(p1, p2, 2));									// 1122
+	vst1q_u32(d+16, p2);
+	vst1q_u32(d+20, vextq_u32(p2, p3, 3));									// 2333
+	vst1q_u32(d+24, p3);
+}
+static inline void store4x8_n32(uint32_t* d, uint32x4_t p) {
+	uint32x4x2_t p2 = vzipq_u32(p, p);
+	vst4q_u32(d,    (uint32x4x4_t){{ p2.val[0], p2.val[0], p2.val[0], p2.val[0] }});
+	vst4q_u32(d+16, (uint32x4x4_t){{ p2.val[1], p2.val[1], p2.val[1], p2.val[1] }});
+}
+
+// RGB565 -> ARGB8888, same bit layout as CONVERT_16to32
+static inline uint32x4_t convert4_n16to32(uint16x4_t p) {
+	uint32x4_t w = vmovl_u16(p);
+	uint32x4_t r = vshlq_n_u32(vandq_u32(w, vdupq_n_u32(0xF800)), 8);
+	uint32x4_t g = vshlq_n_u32(vandq_u32(w, vdupq_n_u32(0x07E0)), 5);
+	uint32x4_t b = vshlq_n_u32(vandq_u32(w, vdupq_n_u32(0x001F)), 3);
+	return vorrq_u32(vorrq_u32(r, g), vorrq_u32(b, vdupq_n_u32(0xFF000000)));
 }
 
-void scale1x4_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw*sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale1x4_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl128 = swl & ~127;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x128bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q15}	;"	// 128 bytes
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	vstmia r11!, {q8-q15}	;"
-	"	cmp %0, lr		;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 8f			;"
-	"	tst %3, #64		;"
-	"	beq 4f			;"
-	"	vldmia %0!, {q8-q11}	;"	// 64 bytes
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	vstmia r10!, {q8-q11}	;"
-	"	vstmia r11!, {q8-q11}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"4:	tst %3, #32		;"
-	"	beq 5f			;"
-	"	vldmia %0!, {q12-q13}	;"	// 32 bytes
-	"	vstmia %1!, {q12-q13}	;"
-	"	vstmia r9!, {q12-q13}	;"
-	"	vstmia r10!, {q12-q13}	;"
-	"	vstmia r11!, {q12-q13}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"5:	tst %3, #16		;"
-	"	beq 6f			;"
-	"	vldmia %0!, {q14}	;"	// 16 bytes
-	"	vstmia %1!, {q14}	;"
-	"	vstmia r9!, {q14}	;"
-	"	vstmia r10!, {q14}	;"
-	"	vstmia r11!, {q14}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"6:	tst %3, #8		;"
-	"	beq 7f			;"
-	"	vldmia %0!, {d30}	;"	// 8 bytes
-	"	vstmia %1!, {d30}	;"
-	"	vstmia r9!, {d30}	;"
-	"	vstmia r10!, {d30}	;"
-	"	vstmia r11!, {d30}	;"
-	"	cmp %0, r8		;"
-	"	beq 8f			;"
-	"7:	ldr lr, [%0],#4		;"	// 4 bytes
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9]		;"
-	"	str lr, [r10]		;"
-	"	str lr, [r11]		;"
-	"8:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl128), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale1x_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale1x1_n32, &scale1x2_n32, &scale1x3_n32, &scale1x4_n32 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
-
-void scale2x1_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x1_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x64bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 32 pixels 64 bytes
-	"	vdup.16 d0, d23[3]	;"
-	"	vdup.16 d1, d23[2]	;"
-	"	vext.16 d31, d1,d0,#2	;"
-	"	vdup.16 d0, d23[1]	;"
-	"	vdup.16 d1, d23[0]	;"
-	"	vext.16 d30, d1,d0,#2	;"
-	"	vdup.16 d0, d22[3]	;"
-	"	vdup.16 d1, d22[2]	;"
-	"	vext.16 d29, d1,d0,#2	;"
-	"	vdup.16 d0, d22[1]	;"
-	"	vdup.16 d1, d22[0]	;"
-	"	vext.16 d28, d1,d0,#2	;"
-	"	vdup.16 d0, d21[3]	;"
-	"	vdup.16 d1, d21[2]	;"
-	"	vext.16 d27, d1,d0,#2	;"
-	"	vdup.16 d0, d21[1]	;"
-	"	vdup.16 d1, d21[0]	;"
-	"	vext.16 d26, d1,d0,#2	;"
-	"	vdup.16 d0, d20[3]	;"
-	"	vdup.16 d1, d20[2]	;"
-	"	vext.16 d25, d1,d0,#2	;"
-	"	vdup.16 d0, d20[1]	;"
-	"	vdup.16 d1, d20[0]	;"
-	"	vext.16 d24, d1,d0,#2	;"
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"	tst %3, #32		;"
-	"	beq 4f			;"
-	"	vldmia %0!,{q8-q9}	;"	// 16 pixels
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8-q11}	;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","lr","q0","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale2x2_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x2_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x64bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 32 pixels 64 bytes
-	"	vdup.16 d0, d23[3]	;"
-	"	vdup.16 d1, d23[2]	;"
-	"	vext.16 d31, d1,d0,#2	;"
-	"	vdup.16 d0, d23[1]	;"
-	"	vdup.16 d1, d23[0]	;"
-	"	vext.16 d30, d1,d0,#2	;"
-	"	vdup.16 d0, d22[3]	;"
-	"	vdup.16 d1, d22[2]	;"
-	"	vext.16 d29, d1,d0,#2	;"
-	"	vdup.16 d0, d22[1]	;"
-	"	vdup.16 d1, d22[0]	;"
-	"	vext.16 d28, d1,d0,#2	;"
-	"	vdup.16 d0, d21[3]	;"
-	"	vdup.16 d1, d21[2]	;"
-	"	vext.16 d27, d1,d0,#2	;"
-	"	vdup.16 d0, d21[1]	;"
-	"	vdup.16 d1, d21[0]	;"
-	"	vext.16 d26, d1,d0,#2	;"
-	"	vdup.16 d0, d20[3]	;"
-	"	vdup.16 d1, d20[2]	;"
-	"	vext.16 d25, d1,d0,#2	;"
-	"	vdup.16 d0, d20[1]	;"
-	"	vdup.16 d1, d20[0]	;"
-	"	vext.16 d24, d1,d0,#2	;"
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"	tst %3, #32		;"
-	"	beq 4f			;"
-	"	vldmia %0!,{q8-q9}	;"	// 16 pixels
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9],#4		;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q0","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale2x3_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x3_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x64bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 32 pixels 64 bytes
-	"	vdup.16 d0, d23[3]	;"
-	"	vdup.16 d1, d23[2]	;"
-	"	vext.16 d31, d1,d0,#2	;"
-	"	vdup.16 d0, d23[1]	;"
-	"	vdup.16 d1, d23[0]	;"
-	"	vext.16 d30, d1,d0,#2	;"
-	"	vdup.16 d0, d22[3]	;"
-	"	vdup.16 d1, d22[2]	;"
-	"	vext.16 d29, d1,d0,#2	;"
-	"	vdup.16 d0, d22[1]	;"
-	"	vdup.16 d1, d22[0]	;"
-	"	vext.16 d28, d1,d0,#2	;"
-	"	vdup.16 d0, d21[3]	;"
-	"	vdup.16 d1, d21[2]	;"
-	"	vext.16 d27, d1,d0,#2	;"
-	"	vdup.16 d0, d21[1]	;"
-	"	vdup.16 d1, d21[0]	;"
-	"	vext.16 d26, d1,d0,#2	;"
-	"	vdup.16 d0, d20[3]	;"
-	"	vdup.16 d1, d20[2]	;"
-	"	vext.16 d25, d1,d0,#2	;"
-	"	vdup.16 d0, d20[1]	;"
-	"	vdup.16 d1, d20[0]	;"
-	"	vext.16 d24, d1,d0,#2	;"
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"	tst %3, #32		;"
-	"	beq 4f			;"
-	"	vldmia %0!,{q8-q9}	;"	// 16 pixels
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	vstmia r10!, {q8-q11}	;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9],#4		;"
-	"	str lr, [r10],#4	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q0","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale2x4_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x3_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x64bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 32 pixels 64 bytes
-	"	vdup.16 d0, d23[3]	;"
-	"	vdup.16 d1, d23[2]	;"
-	"	vext.16 d31, d1,d0,#2	;"
-	"	vdup.16 d0, d23[1]	;"
-	"	vdup.16 d1, d23[0]	;"
-	"	vext.16 d30, d1,d0,#2	;"
-	"	vdup.16 d0, d22[3]	;"
-	"	vdup.16 d1, d22[2]	;"
-	"	vext.16 d29, d1,d0,#2	;"
-	"	vdup.16 d0, d22[1]	;"
-	"	vdup.16 d1, d22[0]	;"
-	"	vext.16 d28, d1,d0,#2	;"
-	"	vdup.16 d0, d21[3]	;"
-	"	vdup.16 d1, d21[2]	;"
-	"	vext.16 d27, d1,d0,#2	;"
-	"	vdup.16 d0, d21[1]	;"
-	"	vdup.16 d1, d21[0]	;"
-	"	vext.16 d26, d1,d0,#2	;"
-	"	vdup.16 d0, d20[3]	;"
-	"	vdup.16 d1, d20[2]	;"
-	"	vext.16 d25, d1,d0,#2	;"
-	"	vdup.16 d0, d20[1]	;"
-	"	vdup.16 d1, d20[0]	;"
-	"	vext.16 d24, d1,d0,#2	;"
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	vstmia r11!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"	tst %3, #32		;"
-	"	beq 4f			;"
-	"	vldmia %0!,{q8-q9}	;"	// 16 pixels
-	"	vdup.16 d0, d19[3]	;"
-	"	vdup.16 d1, d19[2]	;"
-	"	vext.16 d23, d1,d0,#2	;"
-	"	vdup.16 d0, d19[1]	;"
-	"	vdup.16 d1, d19[0]	;"
-	"	vext.16 d22, d1,d0,#2	;"
-	"	vdup.16 d0, d18[3]	;"
-	"	vdup.16 d1, d18[2]	;"
-	"	vext.16 d21, d1,d0,#2	;"
-	"	vdup.16 d0, d18[1]	;"
-	"	vdup.16 d1, d18[0]	;"
-	"	vext.16 d20, d1,d0,#2	;"
-	"	vdup.16 d0, d17[3]	;"
-	"	vdup.16 d1, d17[2]	;"
-	"	vext.16 d19, d1,d0,#2	;"
-	"	vdup.16 d0, d17[1]	;"
-	"	vdup.16 d1, d17[0]	;"
-	"	vext.16 d18, d1,d0,#2	;"
-	"	vdup.16 d0, d16[3]	;"
-	"	vdup.16 d1, d16[2]	;"
-	"	vext.16 d17, d1,d0,#2	;"
-	"	vdup.16 d0, d16[1]	;"
-	"	vdup.16 d1, d16[0]	;"
-	"	vext.16 d16, d1,d0,#2	;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8-q11}	;"
-	"	vstmia r9!, {q8-q11}	;"
-	"	vstmia r10!, {q8-q11}	;"
-	"	vstmia r11!, {q8-q11}	;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	str lr, [r9],#4		;"
-	"	str lr, [r10],#4	;"
-	"	str lr, [r11],#4	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q0","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
-
-void scale2x_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale2x1_n16, &scale2x2_n16, &scale2x3_n16, &scale2x4_n16 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
-
-void scale2x1_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x1_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x64bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 16 pixels 64 bytes
-	"	vdup.32 d31, d23[1]	;"
-	"	vdup.32 d30, d23[0]	;"
-	"	vdup.32 d29, d22[1]	;"
-	"	vdup.32 d28, d22[0]	;"
-	"	vdup.32 d27, d21[1]	;"
-	"	vdup.32 d26, d21[0]	;"
-	"	vdup.32 d25, d20[1]	;"
-	"	vdup.32 d24, d20[0]	;"
-	"	vdup.32 d23, d19[1]	;"
-	"	vdup.32 d22, d19[0]	;"
-	"	vdup.32 d21, d18[1]	;"
-	"	vdup.32 d20, d18[0]	;"
-	"	vdup.32 d19, d17[1]	;"
-	"	vdup.32 d18, d17[0]	;"
-	"	vdup.32 d17, d16[1]	;"
-	"	vdup.32 d16, d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+//
+//	NEON line kernels, the rest of a line that doesn't fill a vector is done in C
+//
 
-void scale2x2_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x2_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x64bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 16 pixels 64 bytes
-	"	vdup.32 d31, d23[1]	;"
-	"	vdup.32 d30, d23[0]	;"
-	"	vdup.32 d29, d22[1]	;"
-	"	vdup.32 d28, d22[0]	;"
-	"	vdup.32 d27, d21[1]	;"
-	"	vdup.32 d26, d21[0]	;"
-	"	vdup.32 d25, d20[1]	;"
-	"	vdup.32 d24, d20[0]	;"
-	"	vdup.32 d23, d19[1]	;"
-	"	vdup.32 d22, d19[0]	;"
-	"	vdup.32 d21, d18[1]	;"
-	"	vdup.32 d20, d18[0]	;"
-	"	vdup.32 d19, d17[1]	;"
-	"	vdup.32 d18, d17[0]	;"
-	"	vdup.32 d17, d16[1]	;"
-	"	vdup.32 d16, d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	vstmia r9!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+#define SCALER_LINE_N(X) \
+static inline void scale##X##x_n16line(uint16_t* __restrict s, uint16_t* __restrict d, uint32_t sw) { \
+	uint32_t x = 0; \
+	for (; x+8<=sw; x+=8, d+=8*X) store8x##X##_n16(d, vld1q_u16(s+x)); \
+	for (; x<sw; x++, d+=X) for (uint32_t i=0; i<X; i++) d[i] = s[x]; \
+} \
+static inline void scale##X##x_n32line(uint32_t* __restrict s, uint32_t* __restrict d, uint32_t sw) { \
+	uint32_t x = 0; \
+	for (; x+4<=sw; x+=4, d+=4*X) store4x##X##_n32(d, vld1q_u32(s+x)); \
+	for (; x<sw; x++, d+=X) for (uint32_t i=0; i<X; i++) d[i] = s[x]; \
+} \
+static inline void scale##X##x_n16to32line(uint16_t* __restrict s, uint32_t* __restrict d, uint32_t sw) { \
+	uint32_t x = 0; \
+	for (; x+8<=sw; x+=8, d+=8*X) { \
+		uint16x8_t p = vld1q_u16(s+x); \
+		store4x##X##_n32(d,     convert4_n16to32(vget_low_u16(p))); \
+		store4x##X##_n32(d+4*X, convert4_n16to32(vget_high_u16(p))); \
+	} \
+	for (; x<sw; x++, d+=X) { \
+		uint32_t pix = CONVERT_16to32(s[x]); \
+		for (uint32_t i=0; i<X; i++) d[i] = pix; \
+	} \
+}
+
+SCALER_LINE_N(1)
+SCALER_LINE_N(2)
+SCALER_LINE_N(3)
+SCALER_LINE_N(4)
+SCALER_LINE_N(5)
+SCALER_LINE_N(6)
+SCALER_LINE_N(7)
+SCALER_LINE_N(8)
 
-void scale2x3_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x3_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x64bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 16 pixels 64 bytes
-	"	vdup.32 d31, d23[1]	;"
-	"	vdup.32 d30, d23[0]	;"
-	"	vdup.32 d29, d22[1]	;"
-	"	vdup.32 d28, d22[0]	;"
-	"	vdup.32 d27, d21[1]	;"
-	"	vdup.32 d26, d21[0]	;"
-	"	vdup.32 d25, d20[1]	;"
-	"	vdup.32 d24, d20[0]	;"
-	"	vdup.32 d23, d19[1]	;"
-	"	vdup.32 d22, d19[0]	;"
-	"	vdup.32 d21, d18[1]	;"
-	"	vdup.32 d20, d18[0]	;"
-	"	vdup.32 d19, d17[1]	;"
-	"	vdup.32 d18, d17[0]	;"
-	"	vdup.32 d17, d16[1]	;"
-	"	vdup.32 d16, d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	vstmia r9!, {d16}	;"
-	"	vstmia r10!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+#endif
 
-void scale2x4_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*2; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale2x4_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl64 = swl & ~63;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl*2;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x64bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q11}	;"	// 16 pixels 64 bytes
-	"	vdup.32 d31, d23[1]	;"
-	"	vdup.32 d30, d23[0]	;"
-	"	vdup.32 d29, d22[1]	;"
-	"	vdup.32 d28, d22[0]	;"
-	"	vdup.32 d27, d21[1]	;"
-	"	vdup.32 d26, d21[0]	;"
-	"	vdup.32 d25, d20[1]	;"
-	"	vdup.32 d24, d20[0]	;"
-	"	vdup.32 d23, d19[1]	;"
-	"	vdup.32 d22, d19[0]	;"
-	"	vdup.32 d21, d18[1]	;"
-	"	vdup.32 d20, d18[0]	;"
-	"	vdup.32 d19, d17[1]	;"
-	"	vdup.32 d18, d17[0]	;"
-	"	vdup.32 d17, d16[1]	;"
-	"	vdup.32 d16, d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q15}	;"
-	"	vstmia r9!, {q8-q15}	;"
-	"	vstmia r10!, {q8-q15}	;"
-	"	vstmia r11!, {q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	vstmia r9!, {d16}	;"
-	"	vstmia r10!, {d16}	;"
-	"	vstmia r11!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl64), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+//
+//	row walkers and the fixed factor entry points
+//
 
-void scale2x_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale2x1_n32, &scale2x2_n32, &scale2x3_n32, &scale2x4_n32 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
+#define SCALER_ROWS(X, simd, fmt, src_t, dst_t) \
+__attribute__((noinline)) void scale##X##x_##simd##fmt(SCALER_ARGS, uint32_t ymul) { \
+	if (!sw||!sh||!ymul) return; \
+	uint32_t swl = sw*sizeof(src_t); \
+	uint32_t dwl = sw*sizeof(dst_t)*X; \
+	if (!sp) { sp = swl; } if (!dp) { dp = dwl; } \
+	if (dwl>dp) { sw = dp/(sizeof(dst_t)*X); dwl = sw*sizeof(dst_t)*X; } \
+	if ((X==1)&&(ymul==1)&&(sizeof(src_t)==sizeof(dst_t))&&(swl==sp)&&(sp==dp)) { COPY_##simd(dst, src, sp*sh); return; } \
+	for (; sh>0; sh--, src=(uint8_t*)src+sp) { \
+		scale##X##x_##simd##fmt##line((src_t*)src, (dst_t*)dst, sw); \
+		void* __restrict dstsrc = dst; dst = (uint8_t*)dst+dp; \
+		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) COPY_##simd(dst, dstsrc, dwl); \
+	} \
+} \
+void scale##X##x1_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 1); } \
+void scale##X##x2_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 2); } \
+void scale##X##x3_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 3); } \
+void scale##X##x4_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 4); } \
+void scale##X##x5_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 5); } \
+void scale##X##x6_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 6); } \
+void scale##X##x7_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 7); } \
+void scale##X##x8_##simd##fmt(SCALER_ARGS) { scale##X##x_##simd##fmt(src, dst, sw, sh, sp, dw, dh, dp, 8); }
+
+#define SCALER_FAMILY(simd, fmt, src_t, dst_t) \
+	SCALER_ROWS(1, simd, fmt, src_t, dst_t) SCALER_ROWS(2, simd, fmt, src_t, dst_t) \
+	SCALER_ROWS(3, simd, fmt, src_t, dst_t) SCALER_ROWS(4, simd, fmt, src_t, dst_t) \
+	SCALER_ROWS(5, simd, fmt, src_t, dst_t) SCALER_ROWS(6, simd, fmt, src_t, dst_t) \
+	SCALER_ROWS(7, simd, fmt, src_t, dst_t) SCALER_ROWS(8, simd, fmt, src_t, dst_t)
+
+SCALER_FAMILY(c, 16, uint16_t, uint16_t)
+SCALER_FAMILY(c, 32, uint32_t, uint32_t)
+SCALER_FAMILY(c, 16to32, uint16_t, uint32_t)
+#ifdef HAS_NEON
+SCALER_FAMILY(n, 16, uint16_t, uint16_t)
+SCALER_FAMILY(n, 32, uint32_t, uint32_t)
+SCALER_FAMILY(n, 16to32, uint16_t, uint32_t)
+#endif
 
-void scale3x1_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x1_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31, d19[3]	;"	//  FFFF
-	"	vdup.16 d30, d19[2]	;"	//  EEEE
-	"	vdup.16 d29, d19[1]	;"	//  DDDD
-	"	vdup.16 d28, d19[0]	;"	//  CCCC
-	"	vext.16 d27, d30,d31,#3	;"	// EFFF
-	"	vext.16 d26, d29,d30,#2	;"	// DDEE
-	"	vext.16 d25, d28,d29,#1	;"	// CCCD
-	"	vdup.16 d31, d18[3]	;"	//  BBBB
-	"	vdup.16 d30, d18[2]	;"	//  AAAA
-	"	vdup.16 d29, d18[1]	;"	//  9999
-	"	vdup.16 d28, d18[0]	;"	//  8888
-	"	vext.16 d24, d30,d31,#3	;"	// ABBB
-	"	vext.16 d23, d29,d30,#2	;"	// 99AA
-	"	vext.16 d22, d28,d29,#1	;"	// 8889
-	"	vdup.16 d31, d17[3]	;"	//  7777
-	"	vdup.16 d30, d17[2]	;"	//  6666
-	"	vdup.16 d29, d17[1]	;"	//  5555
-	"	vdup.16 d28, d17[0]	;"	//  4444
-	"	vext.16 d21, d30,d31,#3	;"	// 6777
-	"	vext.16 d20, d29,d30,#2	;"	// 5566
-	"	vext.16 d19, d28,d29,#1	;"	// 4445
-	"	vdup.16 d31, d16[3]	;"	//  3333
-	"	vdup.16 d30, d16[2]	;"	//  2222
-	"	vdup.16 d29, d16[1]	;"	//  1111
-	"	vdup.16 d28, d16[0]	;"	//  0000
-	"	vext.16 d18, d30,d31,#3	;"	// 2333
-	"	vext.16 d17, d29,d30,#2	;"	// 1122
-	"	vext.16 d16, d28,d29,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	strh lr, [%1],#2	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+//
+//	dispatch table, [simd][format][xmul-1][ymul-1]
+//
 
-void scale3x2_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x2_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31, d19[3]	;"	//  FFFF
-	"	vdup.16 d30, d19[2]	;"	//  EEEE
-	"	vdup.16 d29, d19[1]	;"	//  DDDD
-	"	vdup.16 d28, d19[0]	;"	//  CCCC
-	"	vext.16 d27, d30,d31,#3	;"	// EFFF
-	"	vext.16 d26, d29,d30,#2	;"	// DDEE
-	"	vext.16 d25, d28,d29,#1	;"	// CCCD
-	"	vdup.16 d31, d18[3]	;"	//  BBBB
-	"	vdup.16 d30, d18[2]	;"	//  AAAA
-	"	vdup.16 d29, d18[1]	;"	//  9999
-	"	vdup.16 d28, d18[0]	;"	//  8888
-	"	vext.16 d24, d30,d31,#3	;"	// ABBB
-	"	vext.16 d23, d29,d30,#2	;"	// 99AA
-	"	vext.16 d22, d28,d29,#1	;"	// 8889
-	"	vdup.16 d31, d17[3]	;"	//  7777
-	"	vdup.16 d30, d17[2]	;"	//  6666
-	"	vdup.16 d29, d17[1]	;"	//  5555
-	"	vdup.16 d28, d17[0]	;"	//  4444
-	"	vext.16 d21, d30,d31,#3	;"	// 6777
-	"	vext.16 d20, d29,d30,#2	;"	// 5566
-	"	vext.16 d19, d28,d29,#1	;"	// 4445
-	"	vdup.16 d31, d16[3]	;"	//  3333
-	"	vdup.16 d30, d16[2]	;"	//  2222
-	"	vdup.16 d29, d16[1]	;"	//  1111
-	"	vdup.16 d28, d16[0]	;"	//  0000
-	"	vext.16 d18, d30,d31,#3	;"	// 2333
-	"	vext.16 d17, d29,d30,#2	;"	// 1122
-	"	vext.16 d16, d28,d29,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q13}	;"
-	"	vstmia r9!, {q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	strh lr, [%1],#2	;"
-	"	str lr, [r9],#4		;"
-	"	strh lr, [r9],#2	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+#define SCALER_TABLE_ROW(X, simd, fmt) { \
+	scale##X##x1_##simd##fmt, scale##X##x2_##simd##fmt, scale##X##x3_##simd##fmt, scale##X##x4_##simd##fmt, \
+	scale##X##x5_##simd##fmt, scale##X##x6_##simd##fmt, scale##X##x7_##simd##fmt, scale##X##x8_##simd##fmt }
+#define SCALER_TABLE(simd, fmt) { \
+	SCALER_TABLE_ROW(1, simd, fmt), SCALER_TABLE_ROW(2, simd, fmt), SCALER_TABLE_ROW(3, simd, fmt), SCALER_TABLE_ROW(4, simd, fmt), \
+	SCALER_TABLE_ROW(5, simd, fmt), SCALER_TABLE_ROW(6, simd, fmt), SCALER_TABLE_ROW(7, simd, fmt), SCALER_TABLE_ROW(8, simd, fmt) }
+
+static const scaler_t scalers[SCALER_SIMD_COUNT][SCALER_FORMAT_COUNT][SCALER_MAX_MUL][SCALER_MAX_MUL] = {
+	[SCALER_SIMD_C] = {
+		[SCALER_FORMAT_16] = SCALER_TABLE(c, 16),
+		[SCALER_FORMAT_32] = SCALER_TABLE(c, 32),
+		[SCALER_FORMAT_16TO32] = SCALER_TABLE(c, 16to32),
+	},
+#ifdef HAS_NEON
+	[SCALER_SIMD_NEON] = {
+		[SCALER_FORMAT_16] = SCALER_TABLE(n, 16),
+		[SCALER_FORMAT_32] = SCALER_TABLE(n, 32),
+		[SCALER_FORMAT_16TO32] = SCALER_TABLE(n, 16to32),
+	},
+#endif
+};
 
-void scale3x3_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x3_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31, d19[3]	;"	//  FFFF
-	"	vdup.16 d30, d19[2]	;"	//  EEEE
-	"	vdup.16 d29, d19[1]	;"	//  DDDD
-	"	vdup.16 d28, d19[0]	;"	//  CCCC
-	"	vext.16 d27, d30,d31,#3	;"	// EFFF
-	"	vext.16 d26, d29,d30,#2	;"	// DDEE
-	"	vext.16 d25, d28,d29,#1	;"	// CCCD
-	"	vdup.16 d31, d18[3]	;"	//  BBBB
-	"	vdup.16 d30, d18[2]	;"	//  AAAA
-	"	vdup.16 d29, d18[1]	;"	//  9999
-	"	vdup.16 d28, d18[0]	;"	//  8888
-	"	vext.16 d24, d30,d31,#3	;"	// ABBB
-	"	vext.16 d23, d29,d30,#2	;"	// 99AA
-	"	vext.16 d22, d28,d29,#1	;"	// 8889
-	"	vdup.16 d31, d17[3]	;"	//  7777
-	"	vdup.16 d30, d17[2]	;"	//  6666
-	"	vdup.16 d29, d17[1]	;"	//  5555
-	"	vdup.16 d28, d17[0]	;"	//  4444
-	"	vext.16 d21, d30,d31,#3	;"	// 6777
-	"	vext.16 d20, d29,d30,#2	;"	// 5566
-	"	vext.16 d19, d28,d29,#1	;"	// 4445
-	"	vdup.16 d31, d16[3]	;"	//  3333
-	"	vdup.16 d30, d16[2]	;"	//  2222
-	"	vdup.16 d29, d16[1]	;"	//  1111
-	"	vdup.16 d28, d16[0]	;"	//  0000
-	"	vext.16 d18, d30,d31,#3	;"	// 2333
-	"	vext.16 d17, d29,d30,#2	;"	// 1122
-	"	vext.16 d16, d28,d29,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q13}	;"
-	"	vstmia r9!, {q8-q13}	;"
-	"	vstmia r10!, {q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	strh lr, [%1],#2	;"
-	"	str lr, [r9],#4		;"
-	"	strh lr, [r9],#2	;"
-	"	str lr, [r10],#4	;"
-	"	strh lr, [r10],#2	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+scaler_t scaler_get_simd(int simd, int format, uint32_t xmul, uint32_t ymul) {
+	if (simd<0||simd>=SCALER_SIMD_COUNT||format<0||format>=SCALER_FORMAT_COUNT) return NULL;
+	if (--xmul>=SCALER_MAX_MUL||--ymul>=SCALER_MAX_MUL) return NULL;
+	return scalers[simd][format][xmul][ymul];
 }
 
-void scale3x4_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x4_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!, {q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31, d19[3]	;"	//  FFFF
-	"	vdup.16 d30, d19[2]	;"	//  EEEE
-	"	vdup.16 d29, d19[1]	;"	//  DDDD
-	"	vdup.16 d28, d19[0]	;"	//  CCCC
-	"	vext.16 d27, d30,d31,#3	;"	// EFFF
-	"	vext.16 d26, d29,d30,#2	;"	// DDEE
-	"	vext.16 d25, d28,d29,#1	;"	// CCCD
-	"	vdup.16 d31, d18[3]	;"	//  BBBB
-	"	vdup.16 d30, d18[2]	;"	//  AAAA
-	"	vdup.16 d29, d18[1]	;"	//  9999
-	"	vdup.16 d28, d18[0]	;"	//  8888
-	"	vext.16 d24, d30,d31,#3	;"	// ABBB
-	"	vext.16 d23, d29,d30,#2	;"	// 99AA
-	"	vext.16 d22, d28,d29,#1	;"	// 8889
-	"	vdup.16 d31, d17[3]	;"	//  7777
-	"	vdup.16 d30, d17[2]	;"	//  6666
-	"	vdup.16 d29, d17[1]	;"	//  5555
-	"	vdup.16 d28, d17[0]	;"	//  4444
-	"	vext.16 d21, d30,d31,#3	;"	// 6777
-	"	vext.16 d20, d29,d30,#2	;"	// 5566
-	"	vext.16 d19, d28,d29,#1	;"	// 4445
-	"	vdup.16 d31, d16[3]	;"	//  3333
-	"	vdup.16 d30, d16[2]	;"	//  2222
-	"	vdup.16 d29, d16[1]	;"	//  1111
-	"	vdup.16 d28, d16[0]	;"	//  0000
-	"	vext.16 d18, d30,d31,#3	;"	// 2333
-	"	vext.16 d17, d29,d30,#2	;"	// 1122
-	"	vext.16 d16, d28,d29,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!, {q8-q13}	;"
-	"	vstmia r9!, {q8-q13}	;"
-	"	vstmia r10!, {q8-q13}	;"
-	"	vstmia r11!, {q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	orr lr, lr, lsl #16	;"
-	"	cmp %0, r8		;"
-	"	str lr, [%1],#4		;"
-	"	strh lr, [%1],#2	;"
-	"	str lr, [r9],#4		;"
-	"	strh lr, [r9],#2	;"
-	"	str lr, [r10],#4	;"
-	"	strh lr, [r10],#2	;"
-	"	str lr, [r11],#4	;"
-	"	strh lr, [r11],#2	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+scaler_t scaler_get(int format, uint32_t xmul, uint32_t ymul) {
+#ifdef HAS_NEON
+	return scaler_get_simd(SCALER_SIMD_NEON, format, xmul, ymul);
+#else
+	return scaler_get_simd(SCALER_SIMD_C, format, xmul, ymul);
+#endif
 }
 
-void scale3x_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale3x1_n16, &scale3x2_n16, &scale3x3_n16, &scale3x4_n16 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
+static void scaler_dispatch(int simd, int format, uint32_t xmul, uint32_t ymul, SCALER_ARGS) {
+	scaler_t func = scaler_get_simd(simd, format, xmul, ymul);
+	if (func) func(src, dst, sw, sh, sp, dw, dh, dp);
 }
 
-void scale3x1_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x1_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15, d19[1]	;"	//  7777
-	"	vdup.32 q14, d19[0]	;"	//  6666
-	"	vdup.32 q1, d18[1]	;"	//  5555
-	"	vdup.32 q0, d18[0]	;"	//  4444
-	"	vext.32 q13, q14,q15,#3	;"	// 6777
-	"	vext.32 q12, q1,q14,#2	;"	// 5566
-	"	vext.32 q11, q0,q1,#1	;"	// 4445
-	"	vdup.32 q15, d17[1]	;"	//  3333
-	"	vdup.32 q14, d17[0]	;"	//  2222
-	"	vdup.32 q1, d16[1]	;"	//  1111
-	"	vdup.32 q0, d16[0]	;"	//  0000
-	"	vext.32 q10, q14,q15,#3	;"	// 2333
-	"	vext.32 q9, q1,q14,#2	;"	// 1122
-	"	vext.32 q8, q0,q1,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	str lr, [%1],#4		;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+#ifdef HAS_NEON
+void scaler_n16(uint32_t xmul, uint32_t ymul, SCALER_ARGS) {
+	scaler_dispatch(SCALER_SIMD_NEON, SCALER_FORMAT_16, xmul, ymul, src, dst, sw, sh, sp, dw, dh, dp); }
+void scaler_n32(uint32_t xmul, uint32_t ymul, SCALER_ARGS) {
+	scaler_dispatch(SCALER_SIMD_NEON, SCALER_FORMAT_32, xmul, ymul, src, dst, sw, sh, sp, dw, dh, dp); }
+#endif
+void scaler_c16(uint32_t xmul, uint32_t ymul, SCALER_ARGS) {
+	scaler_dispatch(SCALER_SIMD_C, SCALER_FORMAT_16, xmul, ymul, src, dst, sw, sh, sp, dw, dh, dp); }
+void scaler_c32(uint32_t xmul, uint32_t ymul, SCALER_ARGS) {
+	scaler_dispatch(SCALER_SIMD_C, SCALER_FORMAT_32, xmul, ymul, src, dst, sw, sh, sp, dw, dh, dp); }
 
-void scale3x2_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x2_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15, d19[1]	;"	//  7777
-	"	vdup.32 q14, d19[0]	;"	//  6666
-	"	vdup.32 q1, d18[1]	;"	//  5555
-	"	vdup.32 q0, d18[0]	;"	//  4444
-	"	vext.32 q13, q14,q15,#3	;"	// 6777
-	"	vext.32 q12, q1,q14,#2	;"	// 5566
-	"	vext.32 q11, q0,q1,#1	;"	// 4445
-	"	vdup.32 q15, d17[1]	;"	//  3333
-	"	vdup.32 q14, d17[0]	;"	//  2222
-	"	vdup.32 q1, d16[1]	;"	//  1111
-	"	vdup.32 q0, d16[0]	;"	//  0000
-	"	vext.32 q10, q14,q15,#3	;"	// 2333
-	"	vext.32 q9, q1,q14,#2	;"	// 1122
-	"	vext.32 q8, q0,q1,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q13}	;"
-	"	vstmia r9!,{q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	str lr, [%1],#4		;"
-	"	vstmia r9!, {d16}	;"
-	"	str lr, [r9],#4		;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+//
+//	row band worker pool
+//	a submitted scaler is cut into horizontal bands that the workers (and the
+//	caller, once it joins) pick up one at a time, bands start on a row pattern
+//	boundary (sh/gcd(sh,dh) source rows, every row for integer factors) and are
+//	nudged so each band's first dst row starts on a cache line when the pitch
+//	allows it, that way two cores never write the same line
+//
 
-void scale3x3_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x3_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15, d19[1]	;"	//  7777
-	"	vdup.32 q14, d19[0]	;"	//  6666
-	"	vdup.32 q1, d18[1]	;"	//  5555
-	"	vdup.32 q0, d18[0]	;"	//  4444
-	"	vext.32 q13, q14,q15,#3	;"	// 6777
-	"	vext.32 q12, q1,q14,#2	;"	// 5566
-	"	vext.32 q11, q0,q1,#1	;"	// 4445
-	"	vdup.32 q15, d17[1]	;"	//  3333
-	"	vdup.32 q14, d17[0]	;"	//  2222
-	"	vdup.32 q1, d16[1]	;"	//  1111
-	"	vdup.32 q0, d16[0]	;"	//  0000
-	"	vext.32 q10, q14,q15,#3	;"	// 2333
-	"	vext.32 q9, q1,q14,#2	;"	// 1122
-	"	vext.32 q8, q0,q1,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q13}	;"
-	"	vstmia r9!,{q8-q13}	;"
-	"	vstmia r10!,{q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	str lr, [%1],#4		;"
-	"	vstmia r9!, {d16}	;"
-	"	str lr, [r9],#4		;"
-	"	vstmia r10!, {d16}	;"
-	"	str lr, [r10],#4	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+#define SCALER_MAX_THREADS 3		// workers, the joining thread makes the fourth core
+#define SCALER_MIN_BAND_BYTES (64*1024)	// smaller bands cost more to hand out than to scale
+#define SCALER_CACHE_LINE 64
+
+typedef struct {
+	void* src;
+	void* dst;
+	uint32_t sh;
+	uint32_t dh;
+} ScalerBand;
+
+static struct {
+	pthread_t threads[SCALER_MAX_THREADS];
+	int thread_count;
+	int quit;
+
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+
+	scaler_t scaler;
+	uint32_t sw, sp, dw, dp;
+	ScalerBand bands[SCALER_MAX_THREADS+1];
+	int band_count;
+	int next_band;
+	int pending;
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.work = PTHREAD_COND_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER,
+};
+
+// called with pool.lock held, runs one band unlocked. returns 0 once every band has been handed out
+static int scaler_runBand(void) {
+	if (pool.next_band>=pool.band_count) return 0;
+	ScalerBand* band = &pool.bands[pool.next_band++];
+	pthread_mutex_unlock(&pool.lock);
+	pool.scaler(band->src, band->dst, pool.sw, band->sh, pool.sp, pool.dw, band->dh, pool.dp);
+	pthread_mutex_lock(&pool.lock);
+	if (--pool.pending==0) pthread_cond_broadcast(&pool.done);
+	return 1;
+}
+
+static void* scaler_worker(void* arg) {
+	pthread_mutex_lock(&pool.lock);
+	while (!pool.quit) {
+		if (!scaler_runBand()) pthread_cond_wait(&pool.work, &pool.lock);
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return NULL;
 }
 
-void scale3x4_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*3; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale3x4_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl*3;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15, d19[1]	;"	//  7777
-	"	vdup.32 q14, d19[0]	;"	//  6666
-	"	vdup.32 q1, d18[1]	;"	//  5555
-	"	vdup.32 q0, d18[0]	;"	//  4444
-	"	vext.32 q13, q14,q15,#3	;"	// 6777
-	"	vext.32 q12, q1,q14,#2	;"	// 5566
-	"	vext.32 q11, q0,q1,#1	;"	// 4445
-	"	vdup.32 q15, d17[1]	;"	//  3333
-	"	vdup.32 q14, d17[0]	;"	//  2222
-	"	vdup.32 q1, d16[1]	;"	//  1111
-	"	vdup.32 q0, d16[0]	;"	//  0000
-	"	vext.32 q10, q14,q15,#3	;"	// 2333
-	"	vext.32 q9, q1,q14,#2	;"	// 1122
-	"	vext.32 q8, q0,q1,#1	;"	// 0001
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q13}	;"
-	"	vstmia r9!,{q8-q13}	;"
-	"	vstmia r10!,{q8-q13}	;"
-	"	vstmia r11!,{q8-q13}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	str lr, [%1],#4		;"
-	"	vstmia r9!, {d16}	;"
-	"	str lr, [r9],#4		;"
-	"	vstmia r10!, {d16}	;"
-	"	str lr, [r10],#4	;"
-	"	vstmia r11!, {d16}	;"
-	"	str lr, [r11],#4	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+static void scaler_startPool(void) {
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int count = cpus>1 ? cpus-1 : 0;
+	if (count>SCALER_MAX_THREADS) count = SCALER_MAX_THREADS;
 
-void scale3x_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale3x1_n32, &scale3x2_n32, &scale3x3_n32, &scale3x4_n32 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
+	pool.quit = 0;
+	for (int i=0; i<count; i++) {
+		if (pthread_create(&pool.threads[i], NULL, scaler_worker, NULL)) break;
+		pool.thread_count += 1;
+	}
+	if (!pool.thread_count) pool.thread_count = -1; // single core, don't try again
 }
 
-void scale4x1_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x1_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31,d19[3]	;"
-	"	vdup.16 d30,d19[2]	;"
-	"	vdup.16 d29,d19[1]	;"
-	"	vdup.16 d28,d19[0]	;"
-	"	vdup.16 d27,d18[3]	;"
-	"	vdup.16 d26,d18[2]	;"
-	"	vdup.16 d25,d18[1]	;"
-	"	vdup.16 d24,d18[0]	;"
-	"	vdup.16 d23,d17[3]	;"
-	"	vdup.16 d22,d17[2]	;"
-	"	vdup.16 d21,d17[1]	;"
-	"	vdup.16 d20,d17[0]	;"
-	"	vdup.16 d19,d16[3]	;"
-	"	vdup.16 d18,d16[2]	;"
-	"	vdup.16 d17,d16[1]	;"
-	"	vdup.16 d16,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	vdup.16 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+static uint32_t scaler_gcd(uint32_t a, uint32_t b) {
+	while (b) { uint32_t t = a%b; a = b; b = t; }
+	return a;
 }
 
-void scale4x2_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x2_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31,d19[3]	;"
-	"	vdup.16 d30,d19[2]	;"
-	"	vdup.16 d29,d19[1]	;"
-	"	vdup.16 d28,d19[0]	;"
-	"	vdup.16 d27,d18[3]	;"
-	"	vdup.16 d26,d18[2]	;"
-	"	vdup.16 d25,d18[1]	;"
-	"	vdup.16 d24,d18[0]	;"
-	"	vdup.16 d23,d17[3]	;"
-	"	vdup.16 d22,d17[2]	;"
-	"	vdup.16 d21,d17[1]	;"
-	"	vdup.16 d20,d17[0]	;"
-	"	vdup.16 d19,d16[3]	;"
-	"	vdup.16 d18,d16[2]	;"
-	"	vdup.16 d17,d16[1]	;"
-	"	vdup.16 d16,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	vstmia r9!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	vdup.16 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	vstmia r9!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+void scaler_submit(scaler_t scaler, SCALER_ARGS) {
+	scaler_join();
+	if (!scaler||!sh) return;
 
-void scale4x3_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x3_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31,d19[3]	;"
-	"	vdup.16 d30,d19[2]	;"
-	"	vdup.16 d29,d19[1]	;"
-	"	vdup.16 d28,d19[0]	;"
-	"	vdup.16 d27,d18[3]	;"
-	"	vdup.16 d26,d18[2]	;"
-	"	vdup.16 d25,d18[1]	;"
-	"	vdup.16 d24,d18[0]	;"
-	"	vdup.16 d23,d17[3]	;"
-	"	vdup.16 d22,d17[2]	;"
-	"	vdup.16 d21,d17[1]	;"
-	"	vdup.16 d20,d17[0]	;"
-	"	vdup.16 d19,d16[3]	;"
-	"	vdup.16 d18,d16[2]	;"
-	"	vdup.16 d17,d16[1]	;"
-	"	vdup.16 d16,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	vstmia r9!,{q8-q15}	;"
-	"	vstmia r10!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	vdup.16 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	vstmia r9!, {d16}	;"
-	"	vstmia r10!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+	if (!pool.thread_count) scaler_startPool();
 
-void scale4x4_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x4_c16(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr  = x32bytes offset
-	"	add r8, %0, %3		;"	// r8  = lineend offset
-	"	add r9, %1, %7		;"	// r9  = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 16 pixels 32 bytes
-	"	vdup.16 d31,d19[3]	;"
-	"	vdup.16 d30,d19[2]	;"
-	"	vdup.16 d29,d19[1]	;"
-	"	vdup.16 d28,d19[0]	;"
-	"	vdup.16 d27,d18[3]	;"
-	"	vdup.16 d26,d18[2]	;"
-	"	vdup.16 d25,d18[1]	;"
-	"	vdup.16 d24,d18[0]	;"
-	"	vdup.16 d23,d17[3]	;"
-	"	vdup.16 d22,d17[2]	;"
-	"	vdup.16 d21,d17[1]	;"
-	"	vdup.16 d20,d17[0]	;"
-	"	vdup.16 d19,d16[3]	;"
-	"	vdup.16 d18,d16[2]	;"
-	"	vdup.16 d17,d16[1]	;"
-	"	vdup.16 d16,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	vstmia r9!,{q8-q15}	;"
-	"	vstmia r10!,{q8-q15}	;"
-	"	vstmia r11!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldrh lr, [%0],#2	;"	// rest
-	"	vdup.16 d16, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {d16}	;"
-	"	vstmia r9!, {d16}	;"
-	"	vstmia r10!, {d16}	;"
-	"	vstmia r11!, {d16}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
-}
+	uint32_t count = pool.thread_count>0 ? pool.thread_count+1 : 1;
+	if (!sp||!dh||!dp) count = 1; // no way to place bands without the full geometry
+	if (count>1) {
+		uint32_t fit = (uint64_t)dh*dp/SCALER_MIN_BAND_BYTES;
+		if (count>fit) count = fit ? fit : 1;
+	}
 
-void scale4x_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale4x1_n16, &scale4x2_n16, &scale4x3_n16, &scale4x4_n16 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
+	uint32_t period = sh/scaler_gcd(sh, dh); // source rows per repeating row pattern
+	if (sh/period<count) count = sh/period;
+	if (count<=1) {
+		scaler(src, dst, sw, sh, sp, dw, dh, dp);
+		return;
+	}
 
-void scale4x1_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x1_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15,d19[1]	;"
-	"	vdup.32 q14,d19[0]	;"
-	"	vdup.32 q13,d18[1]	;"
-	"	vdup.32 q12,d18[0]	;"
-	"	vdup.32 q11,d17[1]	;"
-	"	vdup.32 q10,d17[0]	;"
-	"	vdup.32 q9,d16[1]	;"
-	"	vdup.32 q8,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 q8, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+	pthread_mutex_lock(&pool.lock);
+	pool.scaler = scaler;
+	pool.sw = sw; pool.sp = sp;
+	pool.dw = dw; pool.dp = dp;
+
+	uint32_t patterns = sh/period;
+	uint32_t start = 0;
+	pool.band_count = 0;
+	for (uint32_t i=0; i<count && start<sh; i++) {
+		uint32_t end = sh;
+		if (i+1<count) {
+			end = (uint32_t)((uint64_t)patterns*(i+1)/count)*period;
+			// a few patterns of slack is enough to land on a cache line when the pitch allows it at all
+			for (uint32_t tries=0, e=end; tries<8 && e<sh; tries++, e+=period) {
+				uintptr_t addr = (uintptr_t)dst + (uint64_t)e*dh/sh*dp;
+				if (addr%SCALER_CACHE_LINE==0) { end = e; break; }
+			}
+			if (end<=start) continue;
+		}
+		ScalerBand* band = &pool.bands[pool.band_count++];
+		band->src = (uint8_t*)src + (uint64_t)start*sp;
+		band->dst = (uint8_t*)dst + (uint64_t)start*dh/sh*dp;
+		band->sh = end-start;
+		band->dh = (uint64_t)end*dh/sh - (uint64_t)start*dh/sh;
+		start = end;
+	}
+	pool.next_band = 0;
+	pool.pending = pool.band_count;
+	pthread_cond_broadcast(&pool.work);
+	pthread_mutex_unlock(&pool.lock);
 }
 
-void scale4x2_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x2_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*2 - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15,d19[1]	;"
-	"	vdup.32 q14,d19[0]	;"
-	"	vdup.32 q13,d18[1]	;"
-	"	vdup.32 q12,d18[0]	;"
-	"	vdup.32 q11,d17[1]	;"
-	"	vdup.32 q10,d17[0]	;"
-	"	vdup.32 q9,d16[1]	;"
-	"	vdup.32 q8,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	vstmia r9!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 q8, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8}	;"
-	"	vstmia r9!, {q8}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+void scaler_join(void) {
+	pthread_mutex_lock(&pool.lock);
+	while (scaler_runBand()); // help out instead of sleeping
+	while (pool.pending) pthread_cond_wait(&pool.done, &pool.lock);
+	pthread_mutex_unlock(&pool.lock);
 }
 
-void scale4x3_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x3_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*3 - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15,d19[1]	;"
-	"	vdup.32 q14,d19[0]	;"
-	"	vdup.32 q13,d18[1]	;"
-	"	vdup.32 q12,d18[0]	;"
-	"	vdup.32 q11,d17[1]	;"
-	"	vdup.32 q10,d17[0]	;"
-	"	vdup.32 q9,d16[1]	;"
-	"	vdup.32 q8,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	vstmia r9!,{q8-q15}	;"
-	"	vstmia r10!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 q8, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8}	;"
-	"	vstmia r9!, {q8}	;"
-	"	vstmia r10!, {q8}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+void scaler_run(scaler_t scaler, SCALER_ARGS) {
+	scaler_submit(scaler, src, dst, sw, sh, sp, dw, dh, dp);
+	scaler_join();
 }
 
-void scale4x4_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	if (!sw||!sh) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	if (!sp) { sp = swl; } if (!dp) { dp = swl*4; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale4x4_c32(src,dst,sw,sh,sp,dw,dh,dp); return; }
-	uint32_t swl32 = swl & ~31;
-	uint32_t sadd = sp - swl;
-	uint32_t dadd = dp*4 - swl*4;
-	uint8_t* finofs = (uint8_t*)src + (sp*sh);
-	asm volatile (
-	"1:	add lr, %0, %2		;"	// lr = x32bytes offset
-	"	add r8, %0, %3		;"	// r8 = lineend offset
-	"	add r9, %1, %7		;"	// r9 = 2x line offset
-	"	add r10, r9, %7		;"	// r10 = 3x line offset
-	"	add r11, r10, %7	;"	// r11 = 4x line offset
-	"	cmp %0, lr		;"
-	"	beq 3f			;"
-	"2:	vldmia %0!,{q8-q9}	;"	// 8 pixels 32 bytes
-	"	vdup.32 q15,d19[1]	;"
-	"	vdup.32 q14,d19[0]	;"
-	"	vdup.32 q13,d18[1]	;"
-	"	vdup.32 q12,d18[0]	;"
-	"	vdup.32 q11,d17[1]	;"
-	"	vdup.32 q10,d17[0]	;"
-	"	vdup.32 q9,d16[1]	;"
-	"	vdup.32 q8,d16[0]	;"
-	"	cmp %0, lr		;"
-	"	vstmia %1!,{q8-q15}	;"
-	"	vstmia r9!,{q8-q15}	;"
-	"	vstmia r10!,{q8-q15}	;"
-	"	vstmia r11!,{q8-q15}	;"
-	"	bne 2b			;"
-	"3:	cmp %0, r8		;"
-	"	beq 5f			;"
-	"4:	ldr lr, [%0],#4		;"	// rest
-	"	vdup.32 q8, lr		;"
-	"	cmp %0, r8		;"
-	"	vstmia %1!, {q8}	;"
-	"	vstmia r9!, {q8}	;"
-	"	vstmia r10!, {q8}	;"
-	"	vstmia r11!, {q8}	;"
-	"	bne 4b			;"
-	"5:	add %0, %0, %4		;"
-	"	add %1, %1, %5		;"
-	"	cmp %0, %6		;"
-	"	bne 1b			"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl32), "r"(swl), "r"(sadd), "r"(dadd), "r"(finofs), "r"(dp)
-	: "r8","r9","r10","r11","lr","q8","q9","q10","q11","q12","q13","q14","q15","memory","cc"
-	);
+void scaler_quitPool(void) {
+	if (pool.thread_count<=0) {
+		pool.thread_count = 0;
+		return;
+	}
+	scaler_join();
+	pthread_mutex_lock(&pool.lock);
+	pool.quit = 1;
+	pthread_cond_broadcast(&pool.work);
+	pthread_mutex_unlock(&pool.lock);
+	for (int i=0; i<pool.thread_count; i++) pthread_join(pool.threads[i], NULL);
+	pool.thread_count = 0;
 }
 
-void scale4x_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	void (* const func[4])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t)
-		 = { &scale4x1_n32, &scale4x2_n32, &scale4x3_n32, &scale4x4_n32 };
-	if (--ymul < 4) func[ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
+//
+//	anti-aliased scaler for fractional ratios (scale_blend from picoarch)
+//	every dst pixel is a blend of two neighbouring src pixels, a row pattern of
+//	h_in src rows -> h_out dst rows (w_in/w_out across) repeats over the frame
+//	so the blend of each phase is worked out once in scaler_getAA:
+//		0 a	1 aaab	2 aabb	3 abbb	4 b
+//	a row is first blended vertically into blend_line (skipped for 0/4, those use
+//	the src row as is), then gathered into the left/right pixels of each dst pixel
+//	and blended horizontally, both passes work 8 pixels at a time on NEON
+//	the AA scalers keep one set of line buffers so they have to run whole, not in
+//	pool bands
+//
 
-void scale5x_n16line(void* src, void* dst, uint32_t swl) {
-	asm volatile (
-	"	bic r4, %2, #15		;"	// r4 = swl16
-	"	add r3, %0, %2		;"	// r3 = lineend offset
-	"	add r4, %0, r4		;"	// r4 = x16bytes offset
-	"	cmp %0, r4		;"
-	"	beq 2f			;"
-	"1:	vldmia %0!, {q8}	;"	// 8 pixels 16 bytes
-	"	vdup.16 d25, d17[3]	;"	//  7777
-	"	vdup.16 d27, d17[2]	;"	//  6666
-	"	vdup.16 d26, d17[1]	;"	//  5555
-	"	vdup.16 d21, d17[0]	;"	//  4444
-	"	vext.16 d24, d27,d25,#1	;"	// 6667
-	"	vext.16 d23, d26,d27,#2	;"	// 5566
-	"	vext.16 d22, d21,d26,#3	;"	// 4555
-	"	vdup.16 d20, d16[3]	;"	//  3333
-	"	vdup.16 d27, d16[2]	;"	//  2222
-	"	vdup.16 d26, d16[1]	;"	//  1111
-	"	vdup.16 d16, d16[0]	;"	//  0000
-	"	vext.16 d19, d27,d20,#1	;"	// 2223
-	"	vext.16 d18, d26,d27,#2	;"	// 1122
-	"	vext.16 d17, d16,d26,#3	;"	// 0111
-	"	cmp %0, r4		;"
-	"	vstmia %1!, {q8-q12}	;"
-	"	bne 1b			;"
-	"2:	cmp %0, r3		;"
-	"	beq 4f			;"
-	"3:	ldrh r4, [%0],#2	;"	// rest
-	"	orr r4, r4, lsl #16	;"
-	"	cmp %0, r3		;"
-	"	str r4, [%1],#4		;"
-	"	str r4, [%1],#4		;"
-	"	strh r4, [%1],#2	;"
-	"	bne 3b			;"
-	"4:				"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl)
-	: "r3","r4","q8","q9","q10","q11","q12","q13","memory","cc"
-	);
-}
+// per channel average rounding up, (a|b) - (a^b)/2 with the bits that would cross channels masked off
+#define AA_AVG16(a,b) ((uint16_t)(((a)|(b)) - ((((a)^(b))>>1)&0x7BEF)))
+#define AA_AVG32(a,b) ((uint32_t)(((a)|(b)) - ((((a)^(b))>>1)&0x7F7F7F7F)))
+
+#define AA_BLEND(AVG, a, b, code) ( \
+	(code)==0 ? (a) : (code)==4 ? (b) : \
+	(code)==1 ? AVG(AVG((a),(b)),(a)) : (code)==3 ? AVG(AVG((a),(b)),(b)) : AVG((a),(b)))
+
+static struct {
+	uint32_t sw, dw;
+	int w_in, w_out;
+	int h_in, h_out;
+	uint8_t* vcode;		// [h_out] blend between a src row and the next one per vertical phase
+	uint32_t* hidx;		// [dw] left src pixel of each dst pixel
+	uint8_t* hcode;		// [dw] blend between it and its right neighbour
+	void* blend_line;	// [sw] vertically blended src row
+	void* a_line;		// [dw] gathered left pixels
+	void* b_line;		// [dw] gathered right pixels
+} aa;
+
+static uint8_t aa_code(int d, int out, int bp0, int bp1) {
+	if (d>out-bp0) return 4;
+	if (d<=bp0) return 0;
+	if (d<=bp1) return 1;
+	if (d>out-bp1) return 3;
+	return 2;
+}
+
+// C line passes
+#define SCALER_AA_LINES_C(fmt, pix_t) \
+static void aa_c##fmt##vblend(pix_t* __restrict s, pix_t* __restrict n, pix_t* __restrict d, uint32_t sw, uint8_t code) { \
+	for (uint32_t x=0; x<sw; x++) d[x] = AA_BLEND(AA_AVG##fmt, s[x], n[x], code); \
+} \
+static void aa_c##fmt##hblend(pix_t* __restrict a, pix_t* __restrict b, pix_t* __restrict d, uint32_t dw) { \
+	for (uint32_t x=0; x<dw; x++) d[x] = AA_BLEND(AA_AVG##fmt, a[x], b[x], aa.hcode[x]); \
+}
+SCALER_AA_LINES_C(16, uint16_t)
+SCALER_AA_LINES_C(32, uint32_t)
 
-void scale5x_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	uint32_t dwl = swl*5;
-	if (!sp) { sp = swl; } if (!dp) { dp = dwl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale5x_c16(src,dst,sw,sh,sp,dw,dh,dp,ymul); return; }
-	void* __restrict dstsrc;
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		scale5x_n16line(src, dst, swl);
-		dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy_neon(dst, dstsrc, dwl);
+#ifdef HAS_NEON
+// NEON line passes, 8 pixels per step
+static inline uint16x8_t aa_avg16x8(uint16x8_t a, uint16x8_t b) {
+	uint16x8_t half = vandq_u16(vshrq_n_u16(veorq_u16(a, b), 1), vdupq_n_u16(0x7BEF));
+	return vsubq_u16(vorrq_u16(a, b), half);
+}
+static inline uint16x8_t aa_blend16x8(uint16x8_t a, uint16x8_t b, uint16x8_t code) {
+	uint16x8_t m = aa_avg16x8(a, b);
+	uint16x8_t out = vbslq_u16(vceqq_u16(code, vdupq_n_u16(1)), aa_avg16x8(m, a), a);
+	out = vbslq_u16(vceqq_u16(code, vdupq_n_u16(2)), m, out);
+	out = vbslq_u16(vceqq_u16(code, vdupq_n_u16(3)), aa_avg16x8(m, b), out);
+	return vbslq_u16(vceqq_u16(code, vdupq_n_u16(4)), b, out);
+}
+static inline uint32x4_t aa_avg32x4(uint32x4_t a, uint32x4_t b) {
+	return vreinterpretq_u32_u8(vrhaddq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b)));
+}
+static inline uint32x4_t aa_blend32x4(uint32x4_t a, uint32x4_t b, uint32x4_t code) {
+	uint32x4_t m = aa_avg32x4(a, b);
+	uint32x4_t out = vbslq_u32(vceqq_u32(code, vdupq_n_u32(1)), aa_avg32x4(m, a), a);
+	out = vbslq_u32(vceqq_u32(code, vdupq_n_u32(2)), m, out);
+	out = vbslq_u32(vceqq_u32(code, vdupq_n_u32(3)), aa_avg32x4(m, b), out);
+	return vbslq_u32(vceqq_u32(code, vdupq_n_u32(4)), b, out);
+}
+
+static void aa_n16vblend(uint16_t* __restrict s, uint16_t* __restrict n, uint16_t* __restrict d, uint32_t sw, uint8_t code) {
+	uint16x8_t c = vdupq_n_u16(code);
+	uint32_t x = 0;
+	for (; x+8<=sw; x+=8) vst1q_u16(d+x, aa_blend16x8(vld1q_u16(s+x), vld1q_u16(n+x), c));
+	for (; x<sw; x++) d[x] = AA_BLEND(AA_AVG16, s[x], n[x], code);
+}
+static void aa_n16hblend(uint16_t* __restrict a, uint16_t* __restrict b, uint16_t* __restrict d, uint32_t dw) {
+	uint32_t x = 0;
+	for (; x+8<=dw; x+=8) {
+		uint16x8_t c = vmovl_u8(vld1_u8(aa.hcode+x));
+		vst1q_u16(d+x, aa_blend16x8(vld1q_u16(a+x), vld1q_u16(b+x), c));
 	}
-}
-
-void scale5x1_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale5x2_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale5x3_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale5x4_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale5x5_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n16(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-
-void scale5x_n32line(void* src, void* dst, uint32_t swl) {
-	asm volatile (
-	"	bic r4, %2, #15		;"	// r4 = swl16
-	"	add r3, %0, %2		;"	// r3 = lineend offset
-	"	add r4, %0, r4		;"	// r4 = x16bytes offset
-	"	cmp %0, r4		;"
-	"	beq 2f			;"
-	"1:	vldmia %0!,{q8}		;"	// 4 pixels 16 bytes
-	"	vdup.32 q12, d17[1]	;"	// 3333
-	"	vdup.32 q14, d17[0]	;"	//  2222
-	"	vdup.32 q13, d16[1]	;"	//  1111
-	"	vdup.32 q8, d16[0]	;"	// 0000
-	"	vext.32 q11, q14,q12,#1	;"	// 2223
-	"	vext.32 q10, q13,q14,#2	;"	// 1122
-	"	vext.32 q9, q8,q13,#3	;"	// 0111
-	"	cmp %0, r4		;"
-	"	vstmia %1!,{q8-q12}	;"
-	"	bne 1b			;"
-	"2:	cmp %0, r3		;"
-	"	beq 4f			;"
-	"3:	ldr r4, [%0],#4		;"	// rest
-	"	vdup.32 q8, r4		;"
-	"	cmp %0, r3		;"
-	"	vstmia %1!, {q8}	;"
-	"	str r4, [%1],#4		;"
-	"	bne 3b			;"
-	"4:				"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl)
-	: "r3","r4","q8","q9","q10","q11","q12","q13","q14","memory","cc"
-	);
-}
-
-void scale5x_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	uint32_t dwl = swl*5;
-	if (!sp) { sp = swl; } if (!dp) { dp = dwl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale5x_c32(src,dst,sw,sh,sp,dw,dh,dp,ymul); return; }
-	void* __restrict dstsrc;
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		scale5x_n32line(src, dst, swl);
-		dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy_neon(dst, dstsrc, dwl);
+	for (; x<dw; x++) d[x] = AA_BLEND(AA_AVG16, a[x], b[x], aa.hcode[x]);
+}
+static void aa_n32vblend(uint32_t* __restrict s, uint32_t* __restrict n, uint32_t* __restrict d, uint32_t sw, uint8_t code) {
+	uint32x4_t c = vdupq_n_u32(code);
+	uint32_t x = 0;
+	for (; x+8<=sw; x+=8) {
+		vst1q_u32(d+x, aa_blend32x4(vld1q_u32(s+x), vld1q_u32(n+x), c));
+		vst1q_u32(d+x+4, aa_blend32x4(vld1q_u32(s+x+4), vld1q_u32(n+x+4), c));
 	}
-}
-
-void scale5x1_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale5x2_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale5x3_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale5x4_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale5x5_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale5x_n32(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-
-void scale6x_n16line(void* src, void* dst, uint32_t swl) {
-	asm volatile (
-	"	bic r4, %2, #15		;"	// r4 = swl16
-	"	add r3, %0, %2		;"	// r3 = lineend offset
-	"	add r4, %0, r4		;"	// r4 = x16bytes offset
-	"	cmp %0, r4		;"
-	"	beq 2f			;"
-	"1:	vldmia %0!, {q8}	;"	// 8 pixels 16 bytes
-	"	vdup.16 d27, d17[3]	;"	//  7777
-	"	vdup.16 d25, d17[2]	;"	//  6666
-	"	vdup.16 d24, d17[1]	;"	//  5555
-	"	vdup.16 d22, d17[0]	;"	//  4444
-	"	vext.16 d26, d25,d27,#2	;"	// 6677
-	"	vext.16 d23, d22,d24,#2	;"	// 4455
-	"	vdup.16 d21, d16[3]	;"	//  3333
-	"	vdup.16 d19, d16[2]	;"	//  2222
-	"	vdup.16 d18, d16[1]	;"	//  1111
-	"	vdup.16 d16, d16[0]	;"	//  0000
-	"	vext.16 d20, d19,d21,#2	;"	// 2233
-	"	vext.16 d17, d16,d18,#2	;"	// 0011
-	"	cmp %0, r4		;"
-	"	vstmia %1!, {q8-q13}	;"
-	"	bne 1b			;"
-	"2:	cmp %0, r3		;"
-	"	beq 4f			;"
-	"3:	ldrh r4, [%0],#2	;"	// rest
-	"	orr r4, r4, lsl #16	;"
-	"	vdup.32 d16, r4		;"
-	"	cmp %0, r3		;"
-	"	vstmia %1!, {d16}	;"
-	"	str r4, [%1],#4		;"
-	"	bne 3b			;"
-	"4:				"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl)
-	: "r3","r4","q8","q9","q10","q11","q12","q13","memory","cc"
-	);
-}
-
-void scale6x_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t swl = sw * sizeof(uint16_t);
-	uint32_t dwl = swl*6;
-	if (!sp) { sp = swl; } if (!dp) { dp = dwl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale6x_c16(src,dst,sw,sh,sp,dw,dh,dp,ymul); return; }
-	void* __restrict dstsrc;
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		scale6x_n16line(src, dst, swl);
-		dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy_neon(dst, dstsrc, dwl);
+	for (; x<sw; x++) d[x] = AA_BLEND(AA_AVG32, s[x], n[x], code);
+}
+static void aa_n32hblend(uint32_t* __restrict a, uint32_t* __restrict b, uint32_t* __restrict d, uint32_t dw) {
+	uint32_t x = 0;
+	for (; x+8<=dw; x+=8) {
+		uint16x8_t c = vmovl_u8(vld1_u8(aa.hcode+x));
+		vst1q_u32(d+x, aa_blend32x4(vld1q_u32(a+x), vld1q_u32(b+x), vmovl_u16(vget_low_u16(c))));
+		vst1q_u32(d+x+4, aa_blend32x4(vld1q_u32(a+x+4), vld1q_u32(b+x+4), vmovl_u16(vget_high_u16(c))));
 	}
+	for (; x<dw; x++) d[x] = AA_BLEND(AA_AVG32, a[x], b[x], aa.hcode[x]);
 }
+#endif
 
-void scale6x1_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n16(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale6x2_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n16(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale6x3_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n16(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale6x4_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n16(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale6x5_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n16(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-void scale6x6_n16(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n16(src, dst, sw, sh, sp, dw, dh, dp, 6); }
-
-void scale6x_n32line(void* src, void* dst, uint32_t swl) {
-	asm volatile (
-	"	bic r4, %2, #15		;"	// r4 = swl16
-	"	add r3, %0, %2		;"	// r3 = lineend offset
-	"	add r4, %0, r4		;"	// r4 = x16bytes offset
-	"	cmp %0, r4		;"
-	"	beq 2f			;"
-	"1:	vldmia %0!,{q8}		;"	// 4 pixels 16 bytes
-	"	vdup.32 q13, d17[1]	;"	// 3333
-	"	vdup.32 q11, d17[0]	;"	// 2222
-	"	vdup.32 q10, d16[1]	;"	// 1111
-	"	vdup.32 q8, d16[0]	;"	// 0000
-	"	vext.32 q12, q11,q13,#2	;"	// 2233
-	"	vext.32 q9, q8,q10,#2	;"	// 0011
-	"	cmp %0, r4		;"
-	"	vstmia %1!,{q8-q13}	;"
-	"	bne 1b			;"
-	"2:	cmp %0, r3		;"
-	"	beq 4f			;"
-	"3:	ldr r4, [%0],#4		;"	// rest
-	"	vdup.32 q8, r4		;"
-	"	vmov d18, d16		;"
-	"	cmp %0, r3		;"
-	"	vstmia %1!, {d16-d18}	;"
-	"	bne 3b			;"
-	"4:				"
-	: "+r"(src), "+r"(dst)
-	: "r"(swl)
-	: "r3","r4","q8","q9","q10","q11","q12","q13","memory","cc"
-	);
+// row walker, rows that land on the same src row and blend as the one above are copied
+#define SCALER_AA(simd, fmt, pix_t) \
+static void scaleAA_##simd##fmt(SCALER_ARGS) { \
+	if (!aa.hidx||!sh) return; \
+	if (!sw||sw>aa.sw) sw = aa.sw; \
+	uint32_t dwl = aa.dw; \
+	if (!sp) sp = sw*sizeof(pix_t); \
+	if (!dp) dp = dwl*sizeof(pix_t); \
+	if (dwl*sizeof(pix_t)>dp) dwl = dp/sizeof(pix_t); \
+	pix_t* a = (pix_t*)aa.a_line; \
+	pix_t* b = (pix_t*)aa.b_line; \
+	void* prev = NULL; \
+	int prev_code = -1; \
+	int dy = 0; \
+	for (uint32_t y=0; y<sh; y++, src=(uint8_t*)src+sp) { \
+		pix_t* s = (pix_t*)src; \
+		pix_t* n = y+1<sh ? (pix_t*)((uint8_t*)src+sp) : s; \
+		for (; dy<aa.h_out; dy+=aa.h_in, dst=(uint8_t*)dst+dp) { \
+			int code = aa.vcode[dy]; \
+			if (prev && code==prev_code) { memcpy(dst, prev, dwl*sizeof(pix_t)); continue; } \
+			pix_t* line = s; \
+			if (code==4) line = n; \
+			else if (code) { line = (pix_t*)aa.blend_line; aa_##simd##fmt##vblend(s, n, line, sw, code); } \
+			for (uint32_t x=0; x<dwl; x++) { \
+				uint32_t i = aa.hidx[x]; \
+				a[x] = line[i]; \
+				b[x] = line[i+1<sw ? i+1 : i]; \
+			} \
+			aa_##simd##fmt##hblend(a, b, (pix_t*)dst, dwl); \
+			prev = dst; \
+			prev_code = code; \
+		} \
+		dy -= aa.h_out; \
+		prev = NULL; \
+	} \
+}
+SCALER_AA(c, 16, uint16_t)
+SCALER_AA(c, 32, uint32_t)
+#ifdef HAS_NEON
+SCALER_AA(n, 16, uint16_t)
+SCALER_AA(n, 32, uint32_t)
+#endif
+
+void scaler_freeAA(void) {
+	free(aa.vcode);
+	free(aa.hidx);
+	free(aa.hcode);
+	free(aa.blend_line);
+	free(aa.a_line);
+	free(aa.b_line);
+	memset(&aa, 0, sizeof(aa));
 }
 
-void scale6x_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp, uint32_t ymul) {
-	if (!sw||!sh||!ymul) return;
-	uint32_t swl = sw * sizeof(uint32_t);
-	uint32_t dwl = swl*6;
-	if (!sp) { sp = swl; } if (!dp) { dp = dwl; }
-	if ( ((uintptr_t)src&3)||((uintptr_t)dst&3)||(sp&3)||(dp&3) ) { scale6x_c32(src,dst,sw,sh,sp,dw,dh,dp,ymul); return; }
-	void* __restrict dstsrc;
-	for (; sh>0; sh--, src=(uint8_t*)src+sp) {
-		scale6x_n32line(src, dst, swl);
-		dstsrc = dst; dst = (uint8_t*)dst+dp;
-		for (uint32_t i=ymul-1; i>0; i--, dst=(uint8_t*)dst+dp) memcpy_neon(dst, dstsrc, dwl);
+scaler_t scaler_getAA_simd(int simd, int format, uint32_t sw, uint32_t sh, uint32_t dw, uint32_t dh) {
+	scaler_t func = NULL;
+	if (format==SCALER_FORMAT_16) func = simd==SCALER_SIMD_C ? scaleAA_c16 : NULL;
+	if (format==SCALER_FORMAT_32) func = simd==SCALER_SIMD_C ? scaleAA_c32 : NULL;
+#ifdef HAS_NEON
+	if (simd==SCALER_SIMD_NEON) func = format==SCALER_FORMAT_16 ? scaleAA_n16 : format==SCALER_FORMAT_32 ? scaleAA_n32 : NULL;
+#endif
+	if (!func||!sw||!sh||!dw||!dh) return NULL;
+
+	scaler_freeAA();
+
+	uint32_t gcd_w = scaler_gcd(sw, dw);
+	aa.w_in = sw/gcd_w;
+	aa.w_out = dw/gcd_w;
+	uint32_t gcd_h = scaler_gcd(sh, dh);
+	aa.h_in = sh/gcd_h;
+	aa.h_out = dh/gcd_h;
+
+	// round(out/5) when shrinking, round(out/2.5) when growing (ties can't happen). TODO: these values are really only good for the nano...
+	int grow = sw<=dw;
+	int w_bp0 = grow ? (aa.w_out*4+5)/10 : (aa.w_out*2+5)/10;
+	int h_bp0 = grow ? (aa.h_out*4+5)/10 : (aa.h_out*2+5)/10;
+
+	aa.sw = sw;
+	aa.dw = dw;
+	aa.vcode = malloc(aa.h_out);
+	aa.hidx = malloc(dw*sizeof(uint32_t));
+	aa.hcode = malloc(dw);
+	aa.blend_line = malloc(sw*sizeof(uint32_t));
+	aa.a_line = malloc(dw*sizeof(uint32_t));
+	aa.b_line = malloc(dw*sizeof(uint32_t));
+	if (!aa.vcode||!aa.hidx||!aa.hcode||!aa.blend_line||!aa.a_line||!aa.b_line) {
+		scaler_freeAA();
+		return NULL;
 	}
-}
 
-void scale6x1_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n32(src, dst, sw, sh, sp, dw, dh, dp, 1); }
-void scale6x2_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n32(src, dst, sw, sh, sp, dw, dh, dp, 2); }
-void scale6x3_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n32(src, dst, sw, sh, sp, dw, dh, dp, 3); }
-void scale6x4_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n32(src, dst, sw, sh, sp, dw, dh, dp, 4); }
-void scale6x5_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n32(src, dst, sw, sh, sp, dw, dh, dp, 5); }
-void scale6x6_n32(void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	scale6x_n32(src, dst, sw, sh, sp, dw, dh, dp, 6); }
-
-void scaler_n16(uint32_t xmul, uint32_t ymul, void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	void (* const func[6][8])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) = {
-			{ &scale1x1_n16, &scale1x2_n16, &scale1x3_n16, &scale1x4_n16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale2x1_n16, &scale2x2_n16, &scale2x3_n16, &scale2x4_n16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale3x1_n16, &scale3x2_n16, &scale3x3_n16, &scale3x4_n16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale4x1_n16, &scale4x2_n16, &scale4x3_n16, &scale4x4_n16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale5x1_n16, &scale5x2_n16, &scale5x3_n16, &scale5x4_n16, &scale5x5_n16, &dummy, &dummy, &dummy },
-			{ &scale6x1_n16, &scale6x2_n16, &scale6x3_n16, &scale6x4_n16, &scale6x5_n16, &scale6x6_n16, &dummy, &dummy }
-		   };
-	if ((--xmul < 6)&&(--ymul < 6)) func[xmul][ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
+	for (int dy=0; dy<aa.h_out; dy++) aa.vcode[dy] = aa_code(dy, aa.h_out, h_bp0, aa.h_out>>1);
 
-void scaler_n32(uint32_t xmul, uint32_t ymul, void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	void (* const func[6][8])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) = {
-			{ &scale1x1_n32, &scale1x2_n32, &scale1x3_n32, &scale1x4_n32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale2x1_n32, &scale2x2_n32, &scale2x3_n32, &scale2x4_n32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale3x1_n32, &scale3x2_n32, &scale3x3_n32, &scale3x4_n32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale4x1_n32, &scale4x2_n32, &scale4x3_n32, &scale4x4_n32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale5x1_n32, &scale5x2_n32, &scale5x3_n32, &scale5x4_n32, &scale5x5_n32, &dummy, &dummy, &dummy },
-			{ &scale6x1_n32, &scale6x2_n32, &scale6x3_n32, &scale6x4_n32, &scale6x5_n32, &scale6x6_n32, &dummy, &dummy }
-		   };
-	if ((--xmul < 6)&&(--ymul < 6)) func[xmul][ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
+	// same walk the scaler used to do per pixel, dw is a whole number of patterns
+	uint32_t x = 0;
+	int dx = 0;
+	for (uint32_t col=0; col<sw && x<dw; col++) {
+		for (; dx<aa.w_out && x<dw; dx+=aa.w_in, x++) {
+			aa.hidx[x] = col;
+			aa.hcode[x] = aa_code(dx, aa.w_out, w_bp0, aa.w_out>>1);
+		}
+		dx -= aa.w_out;
+	}
+	return func;
 }
 
+scaler_t scaler_getAA(int format, uint32_t sw, uint32_t sh, uint32_t dw, uint32_t dh) {
+#ifdef HAS_NEON
+	return scaler_getAA_simd(SCALER_SIMD_NEON, format, sw, sh, dw, dh);
+#else
+	return scaler_getAA_simd(SCALER_SIMD_C, format, sw, sh, dw, dh);
 #endif
-
-void scaler_c16(uint32_t xmul, uint32_t ymul, void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	void (* const func[6][8])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) = {
-			{ &scale1x1_c16, &scale1x2_c16, &scale1x3_c16, &scale1x4_c16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale2x1_c16, &scale2x2_c16, &scale2x3_c16, &scale2x4_c16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale3x1_c16, &scale3x2_c16, &scale3x3_c16, &scale3x4_c16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale4x1_c16, &scale4x2_c16, &scale4x3_c16, &scale4x4_c16, &dummy, &dummy, &dummy, &dummy },
-			{ &scale5x1_c16, &scale5x2_c16, &scale5x3_c16, &scale5x4_c16, &scale5x5_c16, &dummy, &dummy, &dummy },
-			{ &scale6x1_c16, &scale6x2_c16, &scale6x3_c16, &scale6x4_c16, &scale6x5_c16, &scale6x6_c16, &dummy, &dummy }
-		   };
-	if ((--xmul < 6)&&(--ymul < 6)) func[xmul][ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
-}
-
-void scaler_c32(uint32_t xmul, uint32_t ymul, void* __restrict src, void* __restrict dst, uint32_t sw, uint32_t sh, uint32_t sp, uint32_t dw, uint32_t dh, uint32_t dp) {
-	void (* const func[6][8])(void* __restrict, void* __restrict, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t) = {
-			{ &scale1x1_c32, &scale1x2_c32, &scale1x3_c32, &scale1x4_c32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale2x1_c32, &scale2x2_c32, &scale2x3_c32, &scale2x4_c32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale3x1_c32, &scale3x2_c32, &scale3x3_c32, &scale3x4_c32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale4x1_c32, &scale4x2_c32, &scale4x3_c32, &scale4x4_c32, &dummy, &dummy, &dummy, &dummy },
-			{ &scale5x1_c32, &scale5x2_c32, &scale5x3_c32, &scale5x4_c32, &scale5x5_c32, &dummy, &dummy, &dummy },
-			{ &scale6x1_c32, &scale6x2_c32, &scale6x3_c32, &scale6x4_c32, &scale6x5_c32, &scale6x6_c32, &dummy, &dummy }
-		   };
-	if ((--xmul < 6)&&(--ymul < 6)) func[xmul][ymul](src, dst, sw, sh, sp, dw, dh, dp);
-	return;
 }
 
 
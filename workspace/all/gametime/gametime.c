@@ -73,6 +73,7 @@ int _renderText(const char *text, TTF_Font *font, SDL_Color color, SDL_Rect *rec
             SDL_BlitSurface(textSurface, NULL, screen, &(SDL_Rect){rect->w - textSurface->w, rect->y, rect->w, rect->h});
         else
             SDL_BlitSurface(textSurface, NULL, screen, rect);
+        GFX_markScreen(screen);
         SDL_FreeSurface(textSurface);
     }
     return text_width;
@@ -147,6 +148,7 @@ void renderRoundedRectangle(SDL_Rect rect, Uint32 color, int radius) {
     fillRect.w = rect.w;
     fillRect.h = rect.h - 2 * radius;
     SDL_FillRect(screen, &fillRect, color);
+    GFX_markScreen(screen);
 
     // Draw the corner circles
     _drawFilledCircle(screen, rect.x + radius, rect.y + radius, radius, color);                         // Top-left
@@ -235,6 +237,7 @@ void renderList(int count, int start, int end, int selected)
                 SCALE1(IMG_MAX_HEIGHT)
             };
             SDL_BlitSurface(romImage, NULL, screen, &rectRomImage);
+            GFX_markScreen(screen);
         }
         else {
             SDL_Rect rectRomImage = {
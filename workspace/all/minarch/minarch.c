@@ -24,6 +24,7 @@
 #include "api.h"
 #include "utils.h"
 #include "scaler.h"
+#include "blit.h"
 #include <dirent.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL.h>
@@ -1149,6 +1150,11 @@ static char *onoff_labels[] = {
 		"Off",
 		"On",
 		NULL};
+static char *debug_labels[] = {
+		"Off",
+		"On",
+		"GPU Timings",
+		NULL};
 static char *scaling_labels[] = {
 		"Native",
 		"Aspect",
@@ -1735,12 +1741,12 @@ static struct Config
 										 [FE_OPT_DEBUG] = {
 												 .key = "minarch_debug_hud",
 												 .name = "Debug HUD",
-												 .desc = "Show frames per second, cpu load,\nresolution, and scaler information.",
+												 .desc = "Show frames per second, cpu load,\nresolution, and scaler information.\nGPU Timings shows time spent per shader pass.",
 												 .default_value = 0,
 												 .value = 0,
-												 .count = 2,
-												 .values = onoff_labels,
-												 .labels = onoff_labels,
+												 .count = 3,
+												 .values = debug_labels,
+												 .labels = debug_labels,
 										 },
 										 [FE_OPT_MAXFF] = {
 												 .key = "minarch_max_ff_speed",
@@ -2115,6 +2121,7 @@ static void Config_syncFrontend(char *key, int value)
 	else if (exactMatch(key, config.frontend.options[FE_OPT_DEBUG].key))
 	{
 		show_debug = value;
+		GFX_enableGPUTimers(show_debug == 2);
 		i = FE_OPT_DEBUG;
 	}
 	else if (exactMatch(key, config.frontend.options[FE_OPT_MAXFF].key))
@@ -4175,7 +4182,10 @@ static void MSG_init(void)
 static int MSG_blitChar(int n, int x, int y)
 {
 	if (n != DIGIT_SPACE)
+	{
 		SDL_BlitSurface(digits, &(SDL_Rect){n * SCALE1(DIGIT_WIDTH), 0, SCALE2(DIGIT_WIDTH, DIGIT_HEIGHT)}, screen, &(SDL_Rect){x, y});
+		GFX_markScreen(screen);
+	}
 	return x + SCALE1(DIGIT_WIDTH + DIGIT_TRACKING);
 }
 static int MSG_blitInt(int num, int x, int y)
@@ -4468,32 +4478,101 @@ static const char *bitmap_font[] = {
 				"1   1"
 				"1   1"
 				"1   1",
+		['p'] =
+				"     "
+				"     "
+				"1111 "
+				"1   1"
+				"1   1"
+				"1111 "
+				"1    "
+				"1    "
+				"1    ",
+		['s'] =
+				"     "
+				"     "
+				" 1111"
+				"1    "
+				"1    "
+				" 111 "
+				"    1"
+				"    1"
+				"1111 ",
+		['o'] =
+				"     "
+				"     "
+				" 111 "
+				"1   1"
+				"1   1"
+				"1   1"
+				"1   1"
+				"1   1"
+				" 111 ",
+		['u'] =
+				"     "
+				"     "
+				"1   1"
+				"1   1"
+				"1   1"
+				"1   1"
+				"1   1"
+				"1   1"
+				" 1111",
+		['t'] =
+				"     "
+				" 1   "
+				" 1   "
+				"1111 "
+				" 1   "
+				" 1   "
+				" 1   "
+				" 1   "
+				"  11 ",
+		['f'] =
+				"     "
+				"  11 "
+				" 1   "
+				" 1   "
+				"1111 "
+				" 1   "
+				" 1   "
+				" 1   "
+				" 1   ",
+		['v'] =
+				"     "
+				"     "
+				"1   1"
+				"1   1"
+				"1   1"
+				" 1 1 "
+				" 1 1 "
+				"  1  "
+				"  1  ",
+		['l'] =
+				"     "
+				" 11  "
+				"  1  "
+				"  1  "
+				"  1  "
+				"  1  "
+				"  1  "
+				"  1  "
+				" 111 ",
 
 };
 
 void drawRect(int x, int y, int w, int h, uint32_t c, uint32_t *data, int stride)
 {
-	for (int _x = x; _x < x + w; _x++)
-	{
-		data[_x + y * stride] = c;
-		data[_x + (y + h - 1) * stride] = c;
-	}
-	for (int _y = y; _y < y + h; _y++)
-	{
-		data[x + _y * stride] = c;
-		data[x + w - 1 + _y * stride] = c;
-	}
+	int pitch = stride * sizeof(uint32_t);
+	BLIT_fill32(data + x + y * stride, pitch, w, 1, c);
+	BLIT_fill32(data + x + (y + h - 1) * stride, pitch, w, 1, c);
+	BLIT_fill32(data + x + y * stride, pitch, 1, h, c);
+	BLIT_fill32(data + x + w - 1 + y * stride, pitch, 1, h, c);
 }
 
 void fillRect(int x, int y, int w, int h, uint32_t c, uint32_t *data, int stride)
 {
-	for (int _y = y; _y < y + h; _y++)
-	{
-		for (int _x = x; _x < x + w; _x++)
-		{
-			data[_x + _y * stride] = c;
-		}
-	}
+	BLIT_fill32(data + x + y * stride, stride * sizeof(uint32_t), w, h, c);
 }
 
 static void blitBitmapText(char *text, int ox, int oy, uint32_t *data, int stride, int width, int height)
@@ -4528,6 +4607,11 @@ static void blitBitmapText(char *text, int ox, int oy, uint32_t *data, int strid
 		for (int i = 0; i < len; i++)
 		{
 			const char *c = bitmap_font[(unsigned char)text[i]];
+			if (!c)
+			{ // no glyph, leave a blank cell
+				row += CHAR_WIDTH + LETTERSPACING;
+				continue;
+			}
 			for (int x = 0; x < CHAR_WIDTH; x++)
 			{
 				if (c[y * CHAR_WIDTH + x] == '1')
@@ -5065,6 +5149,32 @@ void applyCircleReveal(uint32_t **data, size_t pitch, unsigned width, unsigned h
 	*data = temp_buffer;
 }
 
+// writes the gpu pass timings gathered by the debug hud next to the core config
+static void exportGPUTimings(void)
+{
+	GPU_PassTiming timings[MAXSHADERS + 3];
+	int count = GFX_getGPUPassTimings(timings, MAXSHADERS + 3);
+	if (!count)
+		return;
+
+	char path[MAX_PATH];
+	sprintf(path, "%s/gpu_timings.csv", core.config_dir);
+	FILE *file = fopen(path, "w");
+	if (!file)
+	{
+		LOG_error("Unable to write gpu timings to %s\n", path);
+		return;
+	}
+
+	fprintf(file, "pass,avg_ms,p95_ms,samples\n");
+	for (int i = 0; i < count; i++)
+	{
+		fprintf(file, "%s,%.3f,%.3f,%i\n", timings[i].name, timings[i].avg_ms, timings[i].p95_ms, timings[i].samples);
+		LOG_info("gpu pass %s: avg %.3fms p95 %.3fms (%i samples)\n", timings[i].name, timings[i].avg_ms, timings[i].p95_ms, timings[i].samples);
+	}
+	fclose(file);
+}
+
 // Performance monitoring for adaptive frame skipping
 static struct
 {
@@ -5161,6 +5271,8 @@ static void video_refresh_callback_main(const void *data, unsigned width, unsign
 	// Optimized debug rendering - only update every 30 frames to reduce overhead
 	static int debug_frame_counter = 0;
 	static char cached_debug_text[6][250] = {0}; // Cache debug strings
+	static char cached_gpu_text[MAXSHADERS + 3][32] = {0};
+	static int cached_gpu_lines = 0;
 
 	if (show_debug && !isnan(currentratio) && !isnan(currentfps) && !isnan(currentreqfps) && !isnan(currentbufferms) &&
 			currentbuffersize >= 0 && currentbufferfree >= 0 && SDL_GetTicks() > 5000)
@@ -5181,21 +5293,39 @@ static void video_refresh_callback_main(const void *data, unsigned width, unsign
 			PLAT_getCPUTemp();
 			sprintf(cached_debug_text[4], "%.01f/%.01f/%.0f%%/%ihz/%ic", currentfps, currentreqfps, currentcpuse, currentcpuspeed, currentcputemp);
 			sprintf(cached_debug_text[5], "%i/%ix%i/%ix%i/%ix%i", currentshaderpass, currentshadersrcw, currentshadersrch, currentshadertexw, currentshadertexh, currentshaderdstw, currentshaderdsth);
+
+			if (show_debug == 2)
+			{
+				// avg/p95 in ms per pass
+				GPU_PassTiming timings[MAXSHADERS + 3];
+				cached_gpu_lines = GFX_getGPUPassTimings(timings, MAXSHADERS + 3);
+				for (int i = 0; i < cached_gpu_lines; i++)
+					sprintf(cached_gpu_text[i], "%s %.02f/%.02fms", timings[i].name, timings[i].avg_ms, timings[i].p95_ms);
+			}
 		}
 		debug_frame_counter++;
 
 		int x = 2 + renderer.src_x;
 		int y = 2 + renderer.src_y;
 
-		blitBitmapText(cached_debug_text[0], x, y, (uint32_t *)data, pitch / 4, width, height);
-		blitBitmapText(cached_debug_text[1], x, y + 14, (uint32_t *)data, pitch / 4, width, height);
-		blitBitmapText(cached_debug_text[2], -x, y, (uint32_t *)data, pitch / 4, width, height);
-		blitBitmapText(cached_debug_text[3], -x, -y, (uint32_t *)data, pitch / 4, width, height);
-		blitBitmapText(cached_debug_text[4], x, -y, (uint32_t *)data, pitch / 4, width, height);
-		blitBitmapText(cached_debug_text[5], x, -y - 14, (uint32_t *)data, pitch / 4, width, height);
+		if (show_debug == 2)
+		{
+			for (int i = 0; i < cached_gpu_lines; i++)
+				blitBitmapText(cached_gpu_text[i], x, y + i * 14, (uint32_t *)data, pitch / 4, width, height);
+			blitBitmapText(cached_debug_text[4], x, -y, (uint32_t *)data, pitch / 4, width, height);
+		}
+		else
+		{
+			blitBitmapText(cached_debug_text[0], x, y, (uint32_t *)data, pitch / 4, width, height);
+			blitBitmapText(cached_debug_text[1], x, y + 14, (uint32_t *)data, pitch / 4, width, height);
+			blitBitmapText(cached_debug_text[2], -x, y, (uint32_t *)data, pitch / 4, width, height);
+			blitBitmapText(cached_debug_text[3], -x, -y, (uint32_t *)data, pitch / 4, width, height);
+			blitBitmapText(cached_debug_text[4], x, -y, (uint32_t *)data, pitch / 4, width, height);
+			blitBitmapText(cached_debug_text[5], x, -y - 14, (uint32_t *)data, pitch / 4, width, height);
 
-		double buffer_fill = (double)(currentbuffersize - currentbufferfree) / (double)currentbuffersize;
-		drawGauge(x, y + 30, buffer_fill, width / 2, 8, (uint32_t *)data, pitch / 4);
+			double buffer_fill = (double)(currentbuffersize - currentbufferfree) / (double)currentbuffersize;
+			drawGauge(x, y + 30, buffer_fill, width / 2, 8, (uint32_t *)data, pitch / 4);
+		}
 	}
 
 	static int frame_counter = 0;
@@ -5277,85 +5407,18 @@ static void video_refresh_callback(const void *data, unsigned width, unsigned he
 		}
 	}
 
-	// Ambient lighting processing (only when not fast forwarding)
+	// Ambient lighting processing (only when not fast forwarding), sampled and pushed to the leds on its own thread
 	if (!fast_forward && ambient_mode != 0)
 	{
-		GFX_setAmbientColor(data, width, height, pitch, ambient_mode);
-		LEDS_updateLeds();
+		GFX_setAmbientColor(data, width, height, pitch, fmt == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2, ambient_mode);
 	}
 
-	// Fast path for RGBA8888 format (no conversion needed)
+	// libretro frames to the R,G,B,A byte order the renderer uploads, both honour the core's pitch
 	if (fmt == RETRO_PIXEL_FORMAT_XRGB8888)
-	{
-		// Optimized XRGB8888 to RGBA8888 conversion using SIMD-friendly approach
-		const uint32_t *__restrict src = (const uint32_t *__restrict)data;
-		uint32_t *__restrict dst = activeBuffer;
-
-		// Process in chunks for better cache locality
-		const size_t totalPixels = width * height;
-		const size_t chunkSize = 64; // Cache-friendly chunk size
-
-		for (size_t i = 0; i < totalPixels; i += chunkSize)
-		{
-			const size_t endIdx = (i + chunkSize < totalPixels) ? i + chunkSize : totalPixels;
-
-			// Prefetch next chunk
-			if (endIdx < totalPixels)
-			{
-				__builtin_prefetch(&src[endIdx], 0, 3);
-			}
-
-			for (size_t j = i; j < endIdx; ++j)
-			{
-				const uint32_t pixel = src[j];
-				// Optimized bit manipulation
-				dst[j] = (pixel & 0x00FFFFFF) | 0xFF000000;
-			}
-		}
-		data = activeBuffer;
-	}
+		BLIT_convertXRGB8888toABGR8888(data, pitch, activeBuffer, width * sizeof(Uint32), width, height);
 	else
-	{
-		// Optimized RGB565 to RGBA8888 conversion
-		const uint16_t *__restrict srcData = (const uint16_t *__restrict)data;
-		uint32_t *__restrict dstData = activeBuffer;
-		const unsigned srcPitchInPixels = pitch / sizeof(uint16_t);
-
-		// Use lookup tables for color conversion (initialized once)
-		static uint8_t r5to8[32], g6to8[64], b5to8[32];
-		static int lut_initialized = 0;
-
-		if (!lut_initialized)
-		{
-			for (int i = 0; i < 32; i++)
-			{
-				r5to8[i] = (i << 3) | (i >> 2);
-				b5to8[i] = (i << 3) | (i >> 2);
-			}
-			for (int i = 0; i < 64; i++)
-			{
-				g6to8[i] = (i << 2) | (i >> 4);
-			}
-			lut_initialized = 1;
-		}
-
-		for (unsigned y = 0; y < height; ++y)
-		{
-			const uint16_t *__restrict srcRow = &srcData[y * srcPitchInPixels];
-			uint32_t *__restrict dstRow = &dstData[y * width];
-
-			for (unsigned x = 0; x < width; ++x)
-			{
-				const uint16_t pixel = srcRow[x];
-				const uint8_t r = r5to8[(pixel >> 11) & 0x1F];
-				const uint8_t g = g6to8[(pixel >> 5) & 0x3F];
-				const uint8_t b = b5to8[pixel & 0x1F];
-
-				dstRow[x] = 0xFF000000 | (b << 16) | (g << 8) | r;
-			}
-		}
-		data = activeBuffer;
-	}
+		BLIT_convert565toABGR8888(data, pitch, activeBuffer, width * sizeof(Uint32), width, height);
+	data = activeBuffer;
 
 	pitch = width * sizeof(Uint32);
 	lastframe = data;
@@ -5654,6 +5717,7 @@ void Menu_init(void)
 	SDL_SetSurfaceBlendMode(menu.overlay, SDL_BLENDMODE_BLEND);
 	Uint32 color = SDL_MapRGBA(menu.overlay->format, 0, 0, 0, 0);
 	SDL_FillRect(screen, NULL, color);
+	GFX_markScreen(screen);
 
 	char emu_name[256];
 	getEmuName(game.path, emu_name);
@@ -6816,6 +6880,7 @@ static int Menu_options(MenuList *list)
 				}
 				text = TTF_RenderUTF8_Blended(font.small, item->name, text_color);
 				SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){ox + SCALE1(OPTION_PADDING), oy + SCALE1((j * BUTTON_SIZE) + 1)});
+				GFX_markScreen(screen);
 				SDL_FreeSurface(text);
 			}
 		}
@@ -6846,6 +6911,7 @@ static int Menu_options(MenuList *list)
 					// This is a navigation item, used to displayed a specific category
 					text = TTF_RenderUTF8_Blended(font.small, ">", COLOR_WHITE); // always white
 					SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){ox + mw - text->w - SCALE1(OPTION_PADDING), oy + SCALE1((j * BUTTON_SIZE) + 3)});
+					GFX_markScreen(screen);
 					SDL_FreeSurface(text);
 				}
 				else
@@ -6862,6 +6928,7 @@ static int Menu_options(MenuList *list)
 							if (text)
 							{
 								SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){ox + mw - text->w - SCALE1(OPTION_PADDING), oy + SCALE1((j * BUTTON_SIZE) + 3)});
+								GFX_markScreen(screen);
 								SDL_FreeSurface(text);
 							}
 						}
@@ -6883,6 +6950,7 @@ static int Menu_options(MenuList *list)
 				}
 				text = TTF_RenderUTF8_Blended(font.small, item->name, text_color);
 				SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){ox + SCALE1(OPTION_PADDING), oy + SCALE1((j * BUTTON_SIZE) + 1)});
+				GFX_markScreen(screen);
 				SDL_FreeSurface(text);
 			}
 		}
@@ -6953,6 +7021,7 @@ static int Menu_options(MenuList *list)
 				}
 				text = TTF_RenderUTF8_Blended(font.small, item->name, text_color);
 				SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){ox + SCALE1(OPTION_PADDING), oy + SCALE1((j * BUTTON_SIZE) + 1)});
+				GFX_markScreen(screen);
 				SDL_FreeSurface(text);
 
 				if (await_input && j == selected_row)
@@ -6968,6 +7037,7 @@ static int Menu_options(MenuList *list)
 					{
 						text = TTF_RenderUTF8_Blended(font.tiny, item->values[item->value], COLOR_WHITE); // always white
 						SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){ox + mw - text->w - SCALE1(OPTION_PADDING), oy + SCALE1((j * BUTTON_SIZE) + 3)});
+						GFX_markScreen(screen);
 						SDL_FreeSurface(text);
 					}
 				}
@@ -7362,14 +7432,8 @@ static void Menu_loop(void)
 	free(pixels);
 
 	menu.bitmap = converted;
-	SDL_Surface *backing = SDL_CreateRGBSurfaceWithFormat(0, DEVICE_WIDTH, DEVICE_HEIGHT, 32, SDL_PIXELFORMAT_RGBA8888);
-
-	SDL_Rect dst = {
-			0,
-			0,
-			screen->w,
-			screen->h};
-	SDL_BlitScaled(menu.bitmap, NULL, backing, &dst);
+	// blurred and darkened once on the gpu, each redraw is then a single copy
+	GFX_setMenuBackdrop(menu.bitmap, 0.4f);
 
 	int restore_w = screen->w;
 	int restore_h = screen->h;
@@ -7540,6 +7604,7 @@ static void Menu_loop(void)
 				{
 					int old_scaling = screen_scaling;
 					int old_scale_factor = screen_scale_factor;
+					GFX_clearLayers(3);
 					Menu_options(&options_menu);
 					if (screen_scaling != old_scaling || screen_scale_factor != old_scale_factor)
 					{
@@ -7549,8 +7614,6 @@ static void Menu_loop(void)
 						restore_h = screen->h;
 						restore_p = screen->pitch;
 						screen = GFX_resize(DEVICE_WIDTH, DEVICE_HEIGHT, DEVICE_PITCH);
-						SDL_Rect dst = {0, 0, DEVICE_WIDTH, DEVICE_HEIGHT};
-						SDL_BlitScaled(menu.bitmap, NULL, backing, &dst);
 					}
 					dirty = 1;
 				}
@@ -7571,7 +7634,9 @@ static void Menu_loop(void)
 		{
 			GFX_clear(screen);
 
-			GFX_drawOnLayer(menu.bitmap, 0, 0, DEVICE_WIDTH, DEVICE_HEIGHT, 0.4f, 1, 0);
+			GFX_drawMenuBackdrop(0);
+			// text goes through the glyph atlas onto the layer above the pills
+			GFX_clearLayers(3);
 
 			int ox, oy;
 			int ow = GFX_blitHardwareGroup(screen, show_setting);
@@ -7581,11 +7646,8 @@ static void Menu_loop(void)
 			int text_width = GFX_truncateText(font.large, rom_name, display_name, max_width, SCALE1(BUTTON_PADDING * 2));
 			max_width = MIN(max_width, text_width);
 
-			SDL_Surface *text;
-			text = TTF_RenderUTF8_Blended(font.large, display_name, uintToColour(THEME_COLOR6_255));
 			GFX_blitPillLight(ASSET_WHITE_PILL, screen, &(SDL_Rect){SCALE1(PADDING), SCALE1(PADDING), max_width, SCALE1(PILL_SIZE)});
-			SDL_BlitSurface(text, &(SDL_Rect){0, 0, max_width - SCALE1(BUTTON_PADDING * 2), text->h}, screen, &(SDL_Rect){SCALE1(PADDING + BUTTON_PADDING), SCALE1(PADDING + 4)});
-			SDL_FreeSurface(text);
+			GFX_drawTextOnLayer(font.large, display_name, uintToColour(THEME_COLOR6_255), SCALE1(PADDING + BUTTON_PADDING), SCALE1(PADDING + 4), max_width - SCALE1(BUTTON_PADDING * 2), 3);
 
 			if (show_setting && !GetHDMI())
 				GFX_blitHardwareHints(screen, show_setting);
@@ -7608,9 +7670,9 @@ static void Menu_loop(void)
 					if (menu.total_discs > 1 && i == ITEM_CONT)
 					{
 						GFX_blitPillDark(ASSET_WHITE_PILL, screen, &(SDL_Rect){SCALE1(PADDING), SCALE1(oy + PADDING), screen->w - SCALE1(PADDING * 2), SCALE1(PILL_SIZE)});
-						text = TTF_RenderUTF8_Blended(font.large, disc_name, text_color);
-						SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){screen->w - SCALE1(PADDING + BUTTON_PADDING) - text->w, SCALE1(oy + PADDING + 4)});
-						SDL_FreeSurface(text);
+						int dw;
+						TTF_SizeUTF8(font.large, disc_name, &dw, NULL);
+						GFX_drawTextOnLayer(font.large, disc_name, text_color, screen->w - SCALE1(PADDING + BUTTON_PADDING) - dw, SCALE1(oy + PADDING + 4), 0, 3);
 					}
 
 					TTF_SizeUTF8(font.large, item, &ow, NULL);
@@ -7621,9 +7683,7 @@ static void Menu_loop(void)
 				}
 
 				// text
-				text = TTF_RenderUTF8_Blended(font.large, item, text_color);
-				SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){SCALE1(PADDING + BUTTON_PADDING), SCALE1(oy + PADDING + (i * PILL_SIZE) + 4)});
-				SDL_FreeSurface(text);
+				GFX_drawTextOnLayer(font.large, item, text_color, SCALE1(PADDING + BUTTON_PADDING), SCALE1(oy + PADDING + (i * PILL_SIZE) + 4), 0, 3);
 			}
 
 			// slot preview
@@ -7659,12 +7719,14 @@ static void Menu_loop(void)
 					SDL_FillRect(screen, &preview_rect, SDL_MapRGBA(screen->format, 0, 0, 0, 255));
 					SDL_BlitScaled(bmp, NULL, preview, NULL);
 					SDL_BlitSurface(preview, NULL, screen, &(SDL_Rect){ox, oy});
+					GFX_markScreen(screen);
 					SDL_FreeSurface(bmp);
 				}
 				else
 				{
 					SDL_Rect preview_rect = {ox, oy, hw, hh};
 					SDL_FillRect(screen, &preview_rect, SDL_MapRGBA(screen->format, 0, 0, 0, 255));
+					GFX_markScreen(screen);
 					if (menu.save_exists)
 						GFX_blitMessage(font.large, "No Preview", screen, &preview_rect);
 					else
@@ -7696,6 +7758,7 @@ static void Menu_loop(void)
 	SDL_FreeSurface(preview);
 	if (menu.bitmap)
 		SDL_FreeSurface(menu.bitmap);
+	GFX_freeMenuBackdrop();
 	PAD_reset();
 
 	GFX_clearAll();
@@ -7736,7 +7799,6 @@ static void Menu_loop(void)
 	else if (exists(NOUI_PATH))
 		PWR_powerOff(); // TODO: won't work with threaded core, only check this once per launch
 
-	SDL_FreeSurface(backing);
 	PWR_disableAutosleep();
 }
 
@@ -8007,6 +8069,9 @@ int main(int argc, char *argv[])
 	if (rgbaData)
 		free(rgbaData);
 
+	if (show_debug == 2)
+		exportGPUTimings();
+
 	Menu_quit();
 	QuitSettings();
 
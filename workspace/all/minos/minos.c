@@ -9,10 +9,17 @@
 #include <libgen.h> // For dirname()
 #include "defines.h"
 #include "api.h"
+#include "blit.h"
 #include "utils.h"
 #include "config.h"
 #include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <pthread.h>
+#include <time.h>
 
 ///////////////////////////////////////
 // Compiler Optimizations
@@ -68,12 +75,16 @@ typedef struct IntArray
 	int items[INT_ARRAY_MAX];
 } IntArray;
 
+typedef struct LibraryIndex LibraryIndex;
+
 typedef struct Directory
 {
 	char *path;
 	char *name;
 	Array *entries;
 	IntArray *alphas;
+	LibraryIndex *index; // set when entries point into a mapped index file
+	Array *sources;			 // folders the entries were read from, NULL if they don't come from folders
 	// rendering
 	int selected;
 	int start;
@@ -171,6 +182,519 @@ static void cleanupMemoryPools(void)
 	pthread_mutex_destroy(&directory_pool.mutex);
 }
 
+///////////////////////////////////////
+// Wakeups
+///////////////////////////////////////
+
+// When nothing on screen is moving the main loop sleeps in Wakeup_wait() until there's
+// input, a finished task or a library change, or until the next thing it draws is due
+// (see nextWakeup()). Other threads post a wakeup when they leave work for the UI thread,
+// only one is in flight between two Wakeup_ack() calls.
+
+static struct
+{
+	Uint32 event;
+	volatile int pending;
+} wakeup = {.event = (Uint32)-1};
+
+static void Wakeup_init(void)
+{
+	wakeup.event = SDL_RegisterEvents(1);
+	if (wakeup.event == (Uint32)-1)
+		LOG_warn("wakeup: no user event left, idle waits run to their timeout\n");
+}
+
+// thread safe, PAD_poll() throws the event away, it only has to get SDL_WaitEvent* to return
+static void Wakeup_post(void)
+{
+	if (wakeup.event == (Uint32)-1 || __sync_lock_test_and_set(&wakeup.pending, 1))
+		return;
+	SDL_Event event = {.type = wakeup.event};
+	SDL_PushEvent(&event);
+}
+
+// call after PAD_poll() and before picking up what other threads left
+static void Wakeup_ack(void)
+{
+	__sync_lock_release(&wakeup.pending);
+}
+
+// blocks for up to timeout ms, returns early on input or a Wakeup_post()
+static void Wakeup_wait(int timeout)
+{
+	if (timeout <= 0 || wakeup.pending)
+		return;
+	SDL_WaitEventTimeout(NULL, timeout);
+}
+
+// ms until the wall clock gets to the next minute
+static int msToNextMinute(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (60 - ts.tv_sec % 60) * 1000 - ts.tv_nsec / 1000000;
+}
+
+///////////////////////////////////////
+// Task Scheduler
+///////////////////////////////////////
+
+// One pool of workers for everything minos does off the UI thread: art decodes, state
+// previews, folder probes, library index writes and prefetches. Tasks run highest priority first and in order
+// within a priority, prefetches always leave a worker free for what's on screen.
+// A task tied to a CancelToken is dropped once the token moves on, before it runs or
+// after, in which case its drop callback gets the result instead of done. done callbacks
+// run on the UI thread from Scheduler_deliver(), a task without run goes straight there.
+
+#define SCHED_THREADS 3
+#define TASK_POOL_SIZE 32
+
+enum
+{
+	TASK_URGENT,	 // animation steps
+	TASK_VISIBLE,	 // what's on screen now
+	TASK_NORMAL,	 // what the UI thread is waiting on
+	TASK_PREFETCH, // what might be on screen next
+	TASK_PRIORITIES,
+};
+
+typedef struct CancelToken
+{
+	volatile int generation;
+} CancelToken;
+
+typedef struct TaskGroup
+{
+	int pending; // guarded by sched.lock
+} TaskGroup;
+
+typedef struct Task Task;
+typedef void (*TaskFunc)(Task *task);
+
+struct Task
+{
+	TaskFunc run;	 // on a worker
+	TaskFunc done; // on the UI thread
+	TaskFunc drop; // whenever done doesn't get to run, frees arg and result
+	void *arg;
+	void *result;
+	char path[MAX_PATH];
+	int variant; // for art tasks, the ArtLoader settings picked on the UI thread
+	CancelToken *token;
+	int generation;
+	TaskGroup *group;
+	Task *next;
+};
+
+static struct
+{
+	pthread_mutex_t lock;
+	pthread_cond_t wake; // a task was queued
+	pthread_cond_t idle; // a group task finished
+	Task *head[TASK_PRIORITIES];
+	Task *tail[TASK_PRIORITIES];
+	Task *done_head;
+	Task *done_tail;
+	pthread_t threads[SCHED_THREADS];
+	int started;
+	int busy;
+	int quitting;
+} sched = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER, .idle = PTHREAD_COND_INITIALIZER};
+
+static MemoryPool task_pool = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static Task *Task_new(TaskFunc run, TaskFunc done, void *arg)
+{
+	Task *task = poolAlloc(&task_pool);
+	if (!task)
+		return NULL;
+	*task = (Task){.run = run, .done = done, .arg = arg};
+	return task;
+}
+
+static int Task_isStale(Task *task)
+{
+	return task->token && task->token->generation != task->generation;
+}
+
+// call with sched.lock held
+static void finishGroupTask(Task *task)
+{
+	if (task->group && --task->group->pending == 0)
+		pthread_cond_broadcast(&sched.idle);
+}
+
+// call with sched.lock held
+static void pushDone(Task *task)
+{
+	task->next = NULL;
+	if (sched.done_tail)
+		sched.done_tail->next = task;
+	else
+		sched.done_head = task;
+	sched.done_tail = task;
+}
+
+// call with sched.lock held, takes the first task worth running or NULL.
+// stale tasks found on the way are moved to stale for dropping once unlocked
+static Task *takeTask(int allow_prefetch, TaskGroup *group, Task **stale)
+{
+	for (int priority = 0; priority < TASK_PRIORITIES; priority++)
+	{
+		if (priority == TASK_PREFETCH && !allow_prefetch)
+			break;
+		Task *prev = NULL;
+		Task *task = sched.head[priority];
+		while (task)
+		{
+			Task *next = task->next;
+			int is_stale = Task_isStale(task);
+			if (is_stale || !group || task->group == group)
+			{
+				if (prev)
+					prev->next = next;
+				else
+					sched.head[priority] = next;
+				if (sched.tail[priority] == task)
+					sched.tail[priority] = prev;
+				if (!is_stale)
+					return task;
+				finishGroupTask(task);
+				task->next = *stale;
+				*stale = task;
+			}
+			else
+				prev = task;
+			task = next;
+		}
+	}
+	return NULL;
+}
+
+static void dropTasks(Task *task)
+{
+	while (task)
+	{
+		Task *next = task->next;
+		if (task->drop)
+			task->drop(task);
+		poolFree(&task_pool, task);
+		task = next;
+	}
+}
+
+// runs task on the calling thread and hands it on to the UI thread or frees it
+static void runTask(Task *task)
+{
+	if (task->run && !Task_isStale(task))
+		task->run(task);
+
+	int deliver = task->done && !Task_isStale(task);
+	pthread_mutex_lock(&sched.lock);
+	finishGroupTask(task);
+	if (deliver)
+		pushDone(task);
+	pthread_mutex_unlock(&sched.lock);
+	if (deliver)
+		Wakeup_post();
+	else
+	{
+		task->next = NULL;
+		dropTasks(task);
+	}
+}
+
+static void *schedulerThread(void *arg)
+{
+	pthread_mutex_lock(&sched.lock);
+	while (!sched.quitting)
+	{
+		Task *stale = NULL;
+		Task *task = takeTask(sched.busy < SCHED_THREADS - 1, NULL, &stale);
+		if (stale)
+		{
+			pthread_mutex_unlock(&sched.lock);
+			dropTasks(stale);
+			pthread_mutex_lock(&sched.lock);
+		}
+		if (!task)
+		{
+			if (!stale)
+				pthread_cond_wait(&sched.wake, &sched.lock);
+			continue;
+		}
+		sched.busy++;
+		pthread_mutex_unlock(&sched.lock);
+		runTask(task);
+		pthread_mutex_lock(&sched.lock);
+		sched.busy--;
+	}
+	pthread_mutex_unlock(&sched.lock);
+	return NULL;
+}
+
+// queues task at priority, tied to token's current generation if there's a token
+static void Scheduler_submit(Task *task, int priority, CancelToken *token)
+{
+	if (!task)
+		return;
+	task->token = token;
+	task->generation = token ? token->generation : 0;
+	task->next = NULL;
+
+	pthread_mutex_lock(&sched.lock);
+	if (task->group)
+		task->group->pending++;
+	if (!task->run)
+	{
+		pushDone(task);
+		pthread_mutex_unlock(&sched.lock);
+		Wakeup_post();
+		return;
+	}
+	if (sched.tail[priority])
+		sched.tail[priority]->next = task;
+	else
+		sched.head[priority] = task;
+	sched.tail[priority] = task;
+	pthread_cond_signal(&sched.wake);
+	pthread_mutex_unlock(&sched.lock);
+}
+
+// drops everything tied to token, queued tasks right away and running ones when they finish
+static void Scheduler_cancel(CancelToken *token)
+{
+	pthread_mutex_lock(&sched.lock);
+	token->generation++;
+	pthread_cond_signal(&sched.wake); // a worker sweeps the queued ones out
+	pthread_mutex_unlock(&sched.lock);
+}
+
+// waits for group's tasks, running the ones no worker has got to yet on the calling thread
+static void Scheduler_wait(TaskGroup *group)
+{
+	pthread_mutex_lock(&sched.lock);
+	while (group->pending)
+	{
+		Task *stale = NULL;
+		Task *task = takeTask(1, group, &stale);
+		if (task || stale)
+		{
+			pthread_mutex_unlock(&sched.lock);
+			dropTasks(stale);
+			if (task)
+				runTask(task);
+			pthread_mutex_lock(&sched.lock);
+			continue;
+		}
+		pthread_cond_wait(&sched.idle, &sched.lock);
+	}
+	pthread_mutex_unlock(&sched.lock);
+}
+
+// runs the done callbacks of finished tasks, call from the UI thread.
+// returns how many were delivered
+static int Scheduler_deliver(void)
+{
+	pthread_mutex_lock(&sched.lock);
+	Task *task = sched.done_head;
+	sched.done_head = sched.done_tail = NULL;
+	pthread_mutex_unlock(&sched.lock);
+
+	int delivered = 0;
+	while (task)
+	{
+		Task *next = task->next;
+		if (Task_isStale(task))
+		{
+			task->next = NULL;
+			dropTasks(task);
+		}
+		else
+		{
+			task->done(task);
+			poolFree(&task_pool, task);
+			delivered++;
+		}
+		task = next;
+	}
+	return delivered;
+}
+
+static void Scheduler_init(void)
+{
+	initMemoryPool(&task_pool, TASK_POOL_SIZE, sizeof(Task));
+	for (int i = 0; i < SCHED_THREADS; i++)
+	{
+		if (pthread_create(&sched.threads[sched.started], NULL, schedulerThread, NULL) == 0)
+			sched.started++;
+	}
+	if (sched.started < SCHED_THREADS)
+		LOG_warn("scheduler: only %i of %i workers started\n", sched.started, SCHED_THREADS);
+}
+
+static void Scheduler_quit(void)
+{
+	pthread_mutex_lock(&sched.lock);
+	sched.quitting = 1;
+	pthread_cond_broadcast(&sched.wake);
+	pthread_mutex_unlock(&sched.lock);
+	for (int i = 0; i < sched.started; i++)
+		pthread_join(sched.threads[i], NULL);
+	sched.started = 0;
+
+	// nobody's waiting on what's left
+	for (int priority = 0; priority < TASK_PRIORITIES; priority++)
+	{
+		dropTasks(sched.head[priority]);
+		sched.head[priority] = sched.tail[priority] = NULL;
+	}
+	dropTasks(sched.done_head);
+	sched.done_head = sched.done_tail = NULL;
+
+	for (int i = 0; i < task_pool.count; i++)
+		free(task_pool.available[i]);
+	free(task_pool.available);
+	task_pool.available = NULL;
+	task_pool.count = task_pool.capacity = 0;
+}
+
+///////////////////////////////////////
+// Tweens
+///////////////////////////////////////
+
+// Animations that run inside the main loop instead of blocking it. A tween moves up to
+// TWEEN_VALUES numbers from where they are to a target over duration ms of the frame clock,
+// Tweens_update() eases them once per pass and hands them to the tween's step callback.
+// Tween_to() on a running tween retargets it from its current values, so fast input bends
+// an animation instead of queueing behind it. UI thread only, and callbacks may only start,
+// retarget or stop their own tween.
+
+#define TWEEN_VALUES 4
+
+typedef float (*Easing)(float t);
+
+static float easeLinear(float t)
+{
+	return t;
+}
+static float easeOutCubic(float t)
+{
+	float u = 1.0f - t;
+	return 1.0f - u * u * u;
+}
+static float easeInOutQuad(float t)
+{
+	float u = 1.0f - t;
+	return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * u * u;
+}
+
+typedef struct Tween Tween;
+typedef void (*TweenCallback)(Tween *tween);
+struct Tween
+{
+	float from[TWEEN_VALUES];
+	float to[TWEEN_VALUES];
+	float value[TWEEN_VALUES]; // where it is now, set these before the first Tween_to()
+	Uint32 start;
+	int duration;
+	Easing ease;
+	TweenCallback step;		// every pass while running, the last one with running already 0
+	TweenCallback finish; // once it got to its target, by running out or Tween_finish()
+	void *arg;
+	int running;
+	Tween *next;
+};
+
+static Tween *tweens = NULL; // running ones
+
+static void unlinkTween(Tween *tween)
+{
+	for (Tween **link = &tweens; *link; link = &(*link)->next)
+	{
+		if (*link == tween)
+		{
+			*link = tween->next;
+			break;
+		}
+	}
+	tween->next = NULL;
+	tween->running = 0;
+}
+
+// animates value to to over duration ms, from wherever it is if it's already running
+static void Tween_to(Tween *tween, const float *to, int duration, Easing ease)
+{
+	memcpy(tween->from, tween->value, sizeof(tween->from));
+	memcpy(tween->to, to, sizeof(tween->to));
+	tween->start = SDL_GetTicks();
+	tween->duration = duration;
+	tween->ease = ease ? ease : easeLinear;
+	if (!tween->running)
+	{
+		tween->running = 1;
+		tween->next = tweens;
+		tweens = tween;
+	}
+}
+
+// stops where it is, no more callbacks
+static void Tween_cancel(Tween *tween)
+{
+	if (tween->running)
+		unlinkTween(tween);
+}
+
+// jumps to the target and runs the last step and finish now
+static void Tween_finish(Tween *tween)
+{
+	if (!tween->running)
+		return;
+	unlinkTween(tween);
+	memcpy(tween->value, tween->to, sizeof(tween->value));
+	if (tween->step)
+		tween->step(tween);
+	if (tween->finish)
+		tween->finish(tween);
+}
+
+// steps every running tween to now, returns how many are still running
+static int Tweens_update(Uint32 now)
+{
+	int running = 0;
+	Tween **link = &tweens;
+	while (*link)
+	{
+		Tween *tween = *link;
+		float t = 1.0f;
+		if (tween->duration > 0 && now - tween->start < (Uint32)tween->duration)
+			t = (float)(now - tween->start) / tween->duration;
+
+		float k = tween->ease(t);
+		for (int i = 0; i < TWEEN_VALUES; i++)
+			tween->value[i] = tween->from[i] + (tween->to[i] - tween->from[i]) * k;
+
+		int done = t >= 1.0f;
+		if (done)
+		{
+			*link = tween->next;
+			tween->next = NULL;
+			tween->running = 0;
+		}
+		else
+		{
+			link = &tween->next;
+			running++;
+		}
+
+		if (tween->step)
+			tween->step(tween);
+		if (done && tween->finish)
+			tween->finish(tween);
+	}
+	return running;
+}
+
 ///////////////////////////////////////
 // Array Implementation
 ///////////////////////////////////////
@@ -570,80 +1094,443 @@ static void Directory_index(Directory *self)
 		Hash_free(map); // Free the map at the end
 }
 
-static Array *getRoot(void);
-static Array *getRecents(void);
-static Array *getCollection(char *path);
-static Array *getDiscs(char *path);
-static Array *getEntries(char *path);
+///////////////////////////////////////
+// Library Index
+///////////////////////////////////////
 
-static Directory *Directory_new(char *path, int selected)
+// A folder's sorted, aliased and indexed entries are written to LIBRARY_INDEX_PATH once
+// and mapped back in on the next visit instead of reading the folder, sorting it and
+// parsing map.txt again. Each index is keyed by the mtime and size of every folder it
+// was read from (all the collated ones for a console folder) and of the map.txt that
+// applied, a changed key only rebuilds that one folder's index.
+//
+// file layout, offsets into strings for every string:
+//	LibraryIndexHeader
+//	LibraryIndexKey[key_count]
+//	LibraryIndexEntry[entry_count]
+//	int32_t alphas[alpha_count]
+//	char strings[strings_size]
+
+#define LIBRARY_INDEX_MAGIC 0x5844494d // "MIDX"
+#define LIBRARY_INDEX_VERSION 1
+#define LIBRARY_INDEX_NONE 0xffffffff
+#define LIBRARY_INDEX_SETTLE 2 // seconds, FAT mtimes are only 2s apart so a folder this fresh isn't indexed
+
+typedef struct LibraryIndexHeader
 {
-	char display_name[256];
-	getDisplayName(path, display_name);
+	uint32_t magic;
+	uint32_t version;
+	uint32_t path;
+	uint32_t key_count;
+	uint32_t entry_count;
+	uint32_t alpha_count;
+	uint32_t strings_size;
+	uint32_t reserved;
+} LibraryIndexHeader;
+
+typedef struct LibraryIndexKey
+{
+	int64_t mtime;
+	int64_t size; // -1 if the path didn't exist
+	uint32_t path;
+	uint32_t reserved;
+} LibraryIndexKey;
 
-	Directory *self = poolAlloc(&directory_pool);
-	self->path = pooledStrdup(path);
-	self->name = pooledStrdup(display_name);
-	if (exactMatch(path, SDCARD_PATH))
-	{
-		self->entries = getRoot();
-	}
-	else if (exactMatch(path, FAUX_RECENT_PATH))
-	{
-		self->entries = getRecents();
-	}
-	else if (!exactMatch(path, COLLECTIONS_PATH) && prefixMatch(COLLECTIONS_PATH, path) && suffixMatch(".txt", path))
+typedef struct LibraryIndexEntry
+{
+	uint32_t path;
+	uint32_t name;
+	uint32_t unique;
+	int32_t type;
+	int32_t alpha;
+} LibraryIndexEntry;
+
+struct LibraryIndex
+{
+	void *map;
+	size_t size;
+	Entry *entries; // one block, the strings are in the map
+};
+
+// 64 bit FNV-1a, names the cache files
+static uint64_t hashPath(const char *path)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (const unsigned char *s = (const unsigned char *)path; *s; s++)
 	{
-		self->entries = getCollection(path);
+		hash ^= *s;
+		hash *= 1099511628211ull;
 	}
-	else if (suffixMatch(".m3u", path))
+	return hash;
+}
+
+static void getLibraryIndexPath(const char *dir_path, char *index_path)
+{
+	sprintf(index_path, "%s/%016llx.idx", LIBRARY_INDEX_PATH, (unsigned long long)hashPath(dir_path));
+}
+
+static void getLibraryIndexKey(const char *path, LibraryIndexKey *key)
+{
+	struct stat st;
+	if (stat(path, &st) == 0)
 	{
-		self->entries = getDiscs(path);
+		key->mtime = st.st_mtime;
+		key->size = st.st_size;
 	}
 	else
 	{
-		self->entries = getEntries(path);
+		key->mtime = 0;
+		key->size = -1;
 	}
-	self->alphas = IntArray_new();
-	self->selected = selected;
-	Directory_index(self);
-	return self;
-}
-static void Directory_free(Directory *self)
-{
-	pooledStrfree(self->path);
-	pooledStrfree(self->name);
-	EntryArray_free(self->entries);
-	IntArray_free(self->alphas);
-	poolFree(&directory_pool, self);
 }
 
-static void DirectoryArray_pop(Array *self)
+static void getMapPath(const char *dir_path, char *map_path)
 {
-	Directory_free(Array_pop(self));
+	int is_collection = prefixMatch(COLLECTIONS_PATH, dir_path);
+	sprintf(map_path, "%s/map.txt", is_collection ? COLLECTIONS_PATH : dir_path);
 }
-static void DirectoryArray_free(Array *self)
+
+// maps dir_path's index and points self's entries into it, 0 if there's no index or it's stale
+static int LibraryIndex_load(Directory *self)
 {
-	for (int i = 0; i < self->count; i++)
+	char index_path[MAX_PATH];
+	getLibraryIndexPath(self->path, index_path);
+
+	int fd = open(index_path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LibraryIndexHeader))
 	{
-		Directory_free(self->items[i]);
+		close(fd);
+		return 0;
 	}
-	Array_free(self);
-}
+	size_t size = st.st_size;
+	void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
 
-///////////////////////////////////////
+	// sizes are checked first so everything after can be trusted to be inside the map
+	const LibraryIndexHeader *header = map;
+	if (header->magic != LIBRARY_INDEX_MAGIC || header->version != LIBRARY_INDEX_VERSION ||
+			header->alpha_count > INT_ARRAY_MAX || header->strings_size == 0 ||
+			sizeof(LibraryIndexHeader) + (uint64_t)header->key_count * sizeof(LibraryIndexKey) +
+							(uint64_t)header->entry_count * sizeof(LibraryIndexEntry) +
+							(uint64_t)header->alpha_count * sizeof(int32_t) + header->strings_size !=
+					size)
+		goto stale;
+
+	const LibraryIndexKey *keys = (const LibraryIndexKey *)(header + 1);
+	const LibraryIndexEntry *items = (const LibraryIndexEntry *)(keys + header->key_count);
+	const int32_t *alphas = (const int32_t *)(items + header->entry_count);
+	const char *strings = (const char *)(alphas + header->alpha_count);
+	if (strings[header->strings_size - 1] != '\0' || header->path >= header->strings_size ||
+			!exactMatch(strings + header->path, self->path))
+		goto stale;
+
+	for (uint32_t i = 0; i < header->key_count; i++)
+	{
+		if (keys[i].path >= header->strings_size)
+			goto stale;
+		LibraryIndexKey key;
+		getLibraryIndexKey(strings + keys[i].path, &key);
+		if (key.mtime != keys[i].mtime || key.size != keys[i].size)
+			goto stale;
+	}
+	for (uint32_t i = 0; i < header->entry_count; i++)
+	{
+		if (items[i].path >= header->strings_size || items[i].name >= header->strings_size ||
+				(items[i].unique != LIBRARY_INDEX_NONE && items[i].unique >= header->strings_size))
+			goto stale;
+	}
 
-typedef struct Recent
-{
-	char *path; // NOTE: this is without the SDCARD_PATH prefix!
-	char *alias;
-	int available;
-} Recent;
-// yiiikes
-static char *recent_alias = NULL;
+	LibraryIndex *index = malloc(sizeof(LibraryIndex));
+	index->map = map;
+	index->size = size;
+	index->entries = malloc(sizeof(Entry) * (header->entry_count ? header->entry_count : 1));
 
-static int hasEmu(char *emu_name);
-static Recent *Recent_new(char *path, char *alias)
+	Array *entries = Array_new();
+	if (header->entry_count > entries->capacity)
+	{
+		entries->capacity = header->entry_count;
+		entries->items = realloc(entries->items, sizeof(void *) * entries->capacity);
+	}
+	for (uint32_t i = 0; i < header->entry_count; i++)
+	{
+		Entry *entry = &index->entries[i];
+		entry->path = (char *)strings + items[i].path;
+		entry->name = (char *)strings + items[i].name;
+		entry->unique = items[i].unique == LIBRARY_INDEX_NONE ? NULL : (char *)strings + items[i].unique;
+		entry->type = items[i].type;
+		entry->alpha = items[i].alpha;
+		entries->items[i] = entry;
+	}
+	entries->count = header->entry_count;
+
+	for (uint32_t i = 0; i < header->alpha_count; i++)
+		IntArray_push(self->alphas, alphas[i]);
+	// the last key is always map.txt
+	self->sources = Array_new();
+	for (uint32_t i = 0; i + 1 < header->key_count; i++)
+		Array_push(self->sources, pooledStrdup(strings + keys[i].path));
+	self->entries = entries;
+	self->index = index;
+	return 1;
+
+stale:
+	munmap(map, size);
+	return 0;
+}
+
+static void LibraryIndex_free(LibraryIndex *self)
+{
+	free(self->entries);
+	munmap(self->map, self->size);
+	free(self);
+}
+
+typedef struct LibraryIndexStrings
+{
+	char *data;
+	uint32_t size;
+	uint32_t capacity;
+} LibraryIndexStrings;
+
+static uint32_t LibraryIndexStrings_add(LibraryIndexStrings *self, const char *str)
+{
+	if (!str)
+		return LIBRARY_INDEX_NONE;
+	uint32_t len = strlen(str) + 1;
+	if (self->size + len > self->capacity)
+	{
+		while (self->size + len > self->capacity)
+			self->capacity = self->capacity ? self->capacity * 2 : 4096;
+		self->data = realloc(self->data, self->capacity);
+	}
+	memcpy(self->data + self->size, str, len);
+	self->size += len;
+	return self->size - len;
+}
+
+// everything a library index file holds, copied out of a Directory so it can be
+// written on a worker while the UI moves on
+typedef struct LibraryIndexWrite
+{
+	char path[MAX_PATH];
+	LibraryIndexHeader header;
+	LibraryIndexKey *keys;
+	LibraryIndexEntry *items;
+	int32_t alphas[INT_ARRAY_MAX];
+	LibraryIndexStrings strings;
+} LibraryIndexWrite;
+
+// one writer at a time, two saves of the same folder would share the tmp file
+static pthread_mutex_t library_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// on a worker, the keys were taken when the entries were read so a folder that changes
+// before this runs leaves an index that's already stale
+static void writeLibraryIndex(Task *task)
+{
+	LibraryIndexWrite *self = task->arg;
+	LibraryIndexHeader *header = &self->header;
+
+	// written next to the real one and renamed over it so a reader never maps half a file
+	char index_path[MAX_PATH];
+	char tmp_path[MAX_PATH];
+	getLibraryIndexPath(self->path, index_path);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+
+	pthread_mutex_lock(&library_index_lock);
+	mkdir(LIBRARY_INDEX_PATH, 0755);
+	FILE *file = fopen(tmp_path, "wb");
+	if (!file)
+	{
+		pthread_mutex_unlock(&library_index_lock);
+		LOG_warn("Unable to write library index for %s\n", self->path);
+		return;
+	}
+	int ok = fwrite(header, sizeof(LibraryIndexHeader), 1, file) == 1 &&
+					 fwrite(self->keys, sizeof(LibraryIndexKey), header->key_count, file) == header->key_count &&
+					 fwrite(self->items, sizeof(LibraryIndexEntry), header->entry_count, file) == header->entry_count &&
+					 fwrite(self->alphas, sizeof(int32_t), header->alpha_count, file) == header->alpha_count &&
+					 fwrite(self->strings.data, 1, self->strings.size, file) == self->strings.size;
+	ok = fclose(file) == 0 && ok;
+	if (!ok || rename(tmp_path, index_path) != 0)
+		unlink(tmp_path);
+	pthread_mutex_unlock(&library_index_lock);
+}
+
+static void freeLibraryIndexWrite(Task *task)
+{
+	LibraryIndexWrite *self = task->arg;
+	free(self->strings.data);
+	free(self->items);
+	free(self->keys);
+	free(self);
+}
+
+// copies self's entries out and writes them in the background, sources are the folders
+// they were read from. nothing waits on the file, the next visit just rescans without it
+static void LibraryIndex_save(Directory *self, Array *sources)
+{
+	char map_path[256];
+	getMapPath(self->path, map_path);
+
+	// keyed here, right after the scan, a folder still being copied to isn't indexed at all
+	int key_count = sources->count + 1;
+	LibraryIndexKey *keys = calloc(key_count, sizeof(LibraryIndexKey));
+	time_t now = time(NULL);
+	for (int i = 0; i < key_count; i++)
+	{
+		getLibraryIndexKey(i < sources->count ? sources->items[i] : map_path, &keys[i]);
+		if (keys[i].size >= 0 && now - keys[i].mtime <= LIBRARY_INDEX_SETTLE && keys[i].mtime - now <= LIBRARY_INDEX_SETTLE)
+		{
+			free(keys);
+			return;
+		}
+	}
+
+	LibraryIndexWrite *index = calloc(1, sizeof(LibraryIndexWrite));
+	index->keys = keys;
+	index->items = calloc(self->entries->count ? self->entries->count : 1, sizeof(LibraryIndexEntry));
+	snprintf(index->path, sizeof(index->path), "%s", self->path);
+
+	for (int i = 0; i < key_count; i++)
+		keys[i].path = LibraryIndexStrings_add(&index->strings, i < sources->count ? sources->items[i] : map_path);
+
+	for (int i = 0; i < self->entries->count; i++)
+	{
+		Entry *entry = self->entries->items[i];
+		LibraryIndexEntry *item = &index->items[i];
+		item->path = LibraryIndexStrings_add(&index->strings, entry->path);
+		item->name = LibraryIndexStrings_add(&index->strings, entry->name);
+		item->unique = LibraryIndexStrings_add(&index->strings, entry->unique);
+		item->type = entry->type;
+		item->alpha = entry->alpha;
+	}
+	for (int i = 0; i < self->alphas->count; i++)
+		index->alphas[i] = self->alphas->items[i];
+
+	index->header = (LibraryIndexHeader){
+			.magic = LIBRARY_INDEX_MAGIC,
+			.version = LIBRARY_INDEX_VERSION,
+			.key_count = key_count,
+			.entry_count = self->entries->count,
+			.alpha_count = self->alphas->count,
+	};
+	index->header.path = LibraryIndexStrings_add(&index->strings, self->path);
+	index->header.strings_size = index->strings.size;
+
+	Task *task = Task_new(writeLibraryIndex, NULL, index);
+	if (task)
+	{
+		task->drop = freeLibraryIndexWrite;
+		Scheduler_submit(task, TASK_PREFETCH, NULL);
+	}
+	else
+	{
+		Task inline_task = {.arg = index};
+		writeLibraryIndex(&inline_task);
+		freeLibraryIndexWrite(&inline_task);
+	}
+}
+
+static Array *getRoot(void);
+static Array *getRecents(void);
+static Array *getCollection(char *path);
+static Array *getDiscs(char *path);
+static Array *getEntries(char *path, Array *sources);
+
+static Directory *Directory_new(char *path, int selected)
+{
+	char display_name[256];
+	getDisplayName(path, display_name);
+
+	Directory *self = poolAlloc(&directory_pool);
+	self->path = pooledStrdup(path);
+	self->name = pooledStrdup(display_name);
+	self->alphas = IntArray_new();
+	self->index = NULL;
+	self->sources = NULL;
+	self->selected = selected;
+
+	if (exactMatch(path, SDCARD_PATH))
+	{
+		self->entries = getRoot();
+	}
+	else if (exactMatch(path, FAUX_RECENT_PATH))
+	{
+		self->entries = getRecents();
+	}
+	else if (!exactMatch(path, COLLECTIONS_PATH) && prefixMatch(COLLECTIONS_PATH, path) && suffixMatch(".txt", path))
+	{
+		self->entries = getCollection(path);
+	}
+	else if (suffixMatch(".m3u", path))
+	{
+		self->entries = getDiscs(path);
+	}
+	else if (LibraryIndex_load(self))
+	{
+		return self; // already sorted, aliased and indexed
+	}
+	else
+	{
+		self->sources = Array_new();
+		self->entries = getEntries(path, self->sources);
+	}
+	Directory_index(self);
+
+	if (self->sources)
+		LibraryIndex_save(self, self->sources);
+	return self;
+}
+static void Directory_free(Directory *self)
+{
+	pooledStrfree(self->path);
+	pooledStrfree(self->name);
+	if (self->index)
+	{
+		Array_free(self->entries); // the entries live in the index
+		LibraryIndex_free(self->index);
+	}
+	else
+	{
+		EntryArray_free(self->entries);
+	}
+	if (self->sources)
+		StringArray_free(self->sources);
+	IntArray_free(self->alphas);
+	poolFree(&directory_pool, self);
+}
+
+static void DirectoryArray_pop(Array *self)
+{
+	Directory_free(Array_pop(self));
+}
+static void DirectoryArray_free(Array *self)
+{
+	for (int i = 0; i < self->count; i++)
+	{
+		Directory_free(self->items[i]);
+	}
+	Array_free(self);
+}
+
+///////////////////////////////////////
+
+typedef struct Recent
+{
+	char *path; // NOTE: this is without the SDCARD_PATH prefix!
+	char *alias;
+	int available;
+} Recent;
+// yiiikes
+static char *recent_alias = NULL;
+
+static int hasEmu(char *emu_name);
+static Recent *Recent_new(char *path, char *alias)
 {
 	Recent *self = malloc(sizeof(Recent));
 
@@ -944,12 +1831,166 @@ static int hasRoms(char *dir_name)
 	// if (!has) printf("No roms for %s!\n", dir_name);
 	return has;
 }
+// hasRoms() results for the root view, one line per system folder with the folder's mtime
+// and size when it was probed. a folder that still matches skips the pak lookups and the
+// readdir, the rest are probed by a few workers at once. the whole cache is dropped when
+// either Emus folder changes since that's what hasEmu() looks in
+#define SYSTEM_CACHE_PATH LIBRARY_INDEX_PATH "/systems.txt"
+#define SYSTEM_PROBE_TASKS 3 // helping the calling thread
+
+typedef struct SystemProbe
+{
+	char *name;
+	int has;
+	int cached;
+	int64_t mtime;
+	int64_t size;
+} SystemProbe;
+
+typedef struct SystemProbeList
+{
+	SystemProbe *items;
+	int count;
+	int next; // next item to probe, shared by the probe tasks
+} SystemProbeList;
+
+static void getEmusKey(char *key)
+{
+	LibraryIndexKey paks, sdcard;
+	getLibraryIndexKey(PAKS_PATH "/Emus", &paks);
+	getLibraryIndexKey(SDCARD_PATH "/Emus/" PLATFORM, &sdcard);
+	sprintf(key, "%lld %lld %lld %lld", (long long)paks.mtime, (long long)paks.size, (long long)sdcard.mtime, (long long)sdcard.size);
+}
+
+static void runSystemProbes(SystemProbeList *list)
+{
+	int i;
+	while ((i = __sync_fetch_and_add(&list->next, 1)) < list->count)
+	{
+		SystemProbe *probe = &list->items[i];
+		if (!probe->cached)
+			probe->has = hasRoms(probe->name);
+	}
+}
+
+static void probeSystemsTask(Task *task)
+{
+	runSystemProbes(task->arg);
+}
+
+static void probeSystems(SystemProbeList *list)
+{
+	char emus_key[128];
+	getEmusKey(emus_key);
+
+	int misses = 0;
+	for (int i = 0; i < list->count; i++)
+	{
+		SystemProbe *probe = &list->items[i];
+		char rom_path[256];
+		snprintf(rom_path, sizeof(rom_path), "%s/%s", ROMS_PATH, probe->name);
+		LibraryIndexKey key;
+		getLibraryIndexKey(rom_path, &key);
+		probe->mtime = key.mtime;
+		probe->size = key.size;
+		probe->cached = 0;
+	}
+
+	FILE *file = fopen(SYSTEM_CACHE_PATH, "r");
+	if (file)
+	{
+		char line[512];
+		if (!fgets(line, sizeof(line), file))
+			line[0] = '\0';
+		trimTrailingNewlines(line);
+		if (exactMatch(line, emus_key))
+		{
+			while (fgets(line, sizeof(line), file))
+			{
+				trimTrailingNewlines(line);
+				long long mtime, size;
+				int has, name_at;
+				if (sscanf(line, "%lld\t%lld\t%d\t%n", &mtime, &size, &has, &name_at) != 3)
+					continue;
+				for (int i = 0; i < list->count; i++)
+				{
+					SystemProbe *probe = &list->items[i];
+					if (!probe->cached && probe->mtime == mtime && probe->size == size && exactMatch(probe->name, line + name_at))
+					{
+						probe->has = has;
+						probe->cached = 1;
+						break;
+					}
+				}
+			}
+		}
+		fclose(file);
+	}
+	for (int i = 0; i < list->count; i++)
+		misses += !list->items[i].cached;
+	if (!misses)
+		return;
+
+	// each probe is a couple of stats and a readdir, mostly waiting on the card
+	TaskGroup group = {0};
+	list->next = 0;
+	for (int i = 0; i < SYSTEM_PROBE_TASKS && i < misses - 1; i++)
+	{
+		Task *task = Task_new(probeSystemsTask, NULL, list);
+		if (!task)
+			break;
+		task->group = &group;
+		Scheduler_submit(task, TASK_NORMAL, NULL);
+	}
+	runSystemProbes(list);
+	Scheduler_wait(&group);
+
+	mkdir(LIBRARY_INDEX_PATH, 0755);
+	file = fopen(SYSTEM_CACHE_PATH, "w");
+	if (!file)
+		return;
+	fprintf(file, "%s\n", emus_key);
+	time_t now = time(NULL);
+	for (int i = 0; i < list->count; i++)
+	{
+		SystemProbe *probe = &list->items[i];
+		// same as the library index, a folder changed this recently might change again unnoticed
+		if (now - probe->mtime <= LIBRARY_INDEX_SETTLE && probe->mtime - now <= LIBRARY_INDEX_SETTLE)
+			continue;
+		fprintf(file, "%lld\t%lld\t%d\t%s\n", (long long)probe->mtime, (long long)probe->size, probe->has, probe->name);
+	}
+	fclose(file);
+}
+
+typedef struct RootExtras
+{
+	int show_recents;
+	int has_recents;
+	int has_collections;
+} RootExtras;
+
+static void probeRootExtras(Task *task)
+{
+	RootExtras *extras = task->arg;
+	extras->has_recents = extras->show_recents && hasRecents();
+	extras->has_collections = hasCollections();
+}
+
 static Array *getRoot(void)
 {
 	Array *root = Array_new();
 
-	if (CFG_getShowRecents() && hasRecents())
-		Array_push(root, Entry_new(FAUX_RECENT_PATH, ENTRY_DIR));
+	// recents and collections are looked at while the systems are probed
+	RootExtras extras = {.show_recents = CFG_getShowRecents()};
+	TaskGroup extras_group = {0};
+	Task *extras_task = Task_new(probeRootExtras, NULL, &extras);
+	if (extras_task)
+	{
+		extras_task->group = &extras_group;
+		Scheduler_submit(extras_task, TASK_NORMAL, NULL);
+	}
+	else
+		probeRootExtras(&(Task){.arg = &extras});
 
 	Array *entries = Array_new();
 	DIR *dh = opendir(ROMS_PATH);
@@ -960,18 +2001,33 @@ static Array *getRoot(void)
 		snprintf(full_path, sizeof(full_path), "%s/", ROMS_PATH);
 		char *tmp = full_path + strlen(full_path);
 
-		Array *emus = Array_new();
+		SystemProbeList systems = {0};
+		int capacity = 0;
 		while ((dp = readdir(dh)) != NULL)
 		{
 			if (hide(dp->d_name))
 				continue;
-			if (hasRoms(dp->d_name))
+			if (systems.count == capacity)
 			{
-				strcpy(tmp, dp->d_name);
-				Array_push(emus, Entry_new(full_path, ENTRY_DIR));
+				capacity = capacity ? capacity * 2 : 64;
+				systems.items = realloc(systems.items, sizeof(SystemProbe) * capacity);
 			}
+			systems.items[systems.count++] = (SystemProbe){.name = strdup(dp->d_name)};
 		}
 		closedir(dh); // Ensure directory is closed immediately after use
+		probeSystems(&systems);
+
+		Array *emus = Array_new();
+		for (int i = 0; i < systems.count; i++)
+		{
+			if (systems.items[i].has)
+			{
+				strcpy(tmp, systems.items[i].name);
+				Array_push(emus, Entry_new(full_path, ENTRY_DIR));
+			}
+			free(systems.items[i].name);
+		}
+		free(systems.items);
 
 		EntryArray_sort(emus);
 		Entry *prev_entry = NULL;
@@ -1037,8 +2093,12 @@ static Array *getRoot(void)
 		}
 	}
 
+	Scheduler_wait(&extras_group);
+	if (extras.has_recents)
+		Array_push(root, Entry_new(FAUX_RECENT_PATH, ENTRY_DIR));
+
 	// Handle collections
-	if (hasCollections())
+	if (extras.has_collections)
 	{
 		if (entries->count)
 		{
@@ -1228,6 +2288,16 @@ static int getFirstDisc(char *m3u_path, char *disc_path)
 	return found;
 }
 
+static int getEntryType(char *full_path, char *name, int is_dir)
+{
+	if (is_dir)
+	{
+		// TODO: this should make sure launch.sh exists
+		return suffixMatch(".pak", name) ? ENTRY_PAK : ENTRY_DIR;
+	}
+	return prefixMatch(COLLECTIONS_PATH, full_path) ? ENTRY_DIR : ENTRY_ROM; // :shrug:
+}
+
 static void addEntries(Array *entries, char *path)
 {
 	DIR *dh = opendir(path);
@@ -1243,31 +2313,7 @@ static void addEntries(Array *entries, char *path)
 			if (hide(dp->d_name))
 				continue;
 			strcpy(tmp, dp->d_name);
-			int is_dir = dp->d_type == DT_DIR;
-			int type;
-			if (is_dir)
-			{
-				// TODO: this should make sure launch.sh exists
-				if (suffixMatch(".pak", dp->d_name))
-				{
-					type = ENTRY_PAK;
-				}
-				else
-				{
-					type = ENTRY_DIR;
-				}
-			}
-			else
-			{
-				if (prefixMatch(COLLECTIONS_PATH, full_path))
-				{
-					type = ENTRY_DIR; // :shrug:
-				}
-				else
-				{
-					type = ENTRY_ROM;
-				}
-			}
+			int type = getEntryType(full_path, dp->d_name, dp->d_type == DT_DIR);
 			Array_push(entries, Entry_new(full_path, type));
 		}
 		closedir(dh);
@@ -1285,7 +2331,7 @@ static int isConsoleDir(char *path)
 	return exactMatch(parent_dir, ROMS_PATH);
 }
 
-static Array *getEntries(char *path)
+static Array *getEntries(char *path, Array *sources)
 {
 	Array *entries = Array_new();
 
@@ -1306,6 +2352,7 @@ static Array *getEntries(char *path)
 			char full_path[256];
 			sprintf(full_path, "%s/", ROMS_PATH);
 			tmp = full_path + strlen(full_path);
+			Array_push(sources, pooledStrdup(ROMS_PATH)); // new collated folders show up here
 			// while loop so we can collate paths, see above
 			while ((dp = readdir(dh)) != NULL)
 			{
@@ -1318,12 +2365,16 @@ static Array *getEntries(char *path)
 				if (!prefixMatch(collated_path, full_path))
 					continue;
 				addEntries(entries, full_path);
+				Array_push(sources, pooledStrdup(full_path));
 			}
 			closedir(dh);
 		}
 	}
 	else
+	{
 		addEntries(entries, path); // just a subfolder
+		Array_push(sources, pooledStrdup(path));
+	}
 
 	EntryArray_sort(entries);
 	return entries;
@@ -1514,16 +2565,15 @@ static void cleanupStringPool(void)
 
 ///////////////////////////////////////
 
-static void readyResumePath(char *rom_path, int type)
+// the auto resume state and preview paths for a rom, 0 if it isn't one that can have them
+static int getResumePaths(char *rom_path, int type, char *slot, char *preview)
 {
 	char *tmp;
-	can_resume = 0;
-	has_preview = 0;
 	char path[256];
 	strcpy(path, rom_path);
 
 	if (!prefixMatch(ROMS_PATH, path))
-		return;
+		return 0;
 
 	char auto_path[256];
 	if (type == ENTRY_DIR)
@@ -1533,7 +2583,7 @@ static void readyResumePath(char *rom_path, int type)
 			tmp = strrchr(auto_path, '.') + 1; // extension
 			strcpy(tmp, "m3u");								 // replace with m3u
 			if (!exists(auto_path))
-				return; // no m3u
+				return 0; // no m3u
 		}
 		strcpy(path, auto_path); // cue or m3u if one exists
 	}
@@ -1555,8 +2605,16 @@ static void readyResumePath(char *rom_path, int type)
 	tmp = strrchr(path, '/') + 1;
 	strcpy(rom_file, tmp);
 
-	sprintf(slot_path, "%s/.minos/%s/%s.txt", SHARED_USERDATA_PATH, emu_name, rom_file);			// /.userdata/.minos/<EMU>/<romname>.ext.txt
-	sprintf(preview_path, "%s/.minos/%s/%s.0.bmp", SHARED_USERDATA_PATH, emu_name, rom_file); // /.userdata/.minos/<EMU>/<romname>.ext.0.bmp
+	sprintf(slot, "%s/.minos/%s/%s.txt", SHARED_USERDATA_PATH, emu_name, rom_file);			// /.userdata/.minos/<EMU>/<romname>.ext.txt
+	sprintf(preview, "%s/.minos/%s/%s.0.bmp", SHARED_USERDATA_PATH, emu_name, rom_file); // /.userdata/.minos/<EMU>/<romname>.ext.0.bmp
+	return 1;
+}
+static void readyResumePath(char *rom_path, int type)
+{
+	can_resume = 0;
+	has_preview = 0;
+	if (!getResumePaths(rom_path, type, slot_path, preview_path))
+		return;
 
 	can_resume = exists(slot_path);
 	has_preview = exists(preview_path);
@@ -1694,6 +2752,7 @@ static void openRom(char *path, char *last)
 	sprintf(cmd, "'%s' '%s'", escapeSingleQuotes(emu_path), sd_path);
 	queueNext(cmd);
 }
+static void Watcher_sync(void);
 static void openDirectory(char *path, int auto_launch)
 {
 	char auto_path[256];
@@ -1736,6 +2795,7 @@ static void openDirectory(char *path, int auto_launch)
 	top->end = end ? end : ((top->entries->count < MAIN_ROW_COUNT) ? top->entries->count : MAIN_ROW_COUNT);
 
 	Array_push(stack, top);
+	Watcher_sync();
 }
 static void closeDirectory(void)
 {
@@ -1746,23 +2806,516 @@ static void closeDirectory(void)
 	restore_depth = stack->count;
 	top = stack->items[stack->count - 1];
 	restore_relative = top->selected;
+	Watcher_sync();
 }
 
-static void Entry_open(Entry *self)
-{
-	recent_alias = self->name; // yiiikes
-	if (self->type == ENTRY_ROM)
-	{
-		startgame = 1;
-		char *last = NULL;
-		if (prefixMatch(COLLECTIONS_PATH, top->path))
-		{
-			char *tmp;
-			char filename[256];
+///////////////////////////////////////
+// Library Watcher
+///////////////////////////////////////
 
-			tmp = strrchr(self->path, '/');
-			if (tmp)
-				strcpy(filename, tmp + 1);
+// A thread blocks on inotify for ROMS_PATH, its system folders, COLLECTIONS_PATH and
+// the folders behind every open Directory, and queues what changed. The main loop
+// picks the queue up once per frame in Watcher_update and patches the open
+// Directories in place, a full reload only happens for map.txt, collection files
+// and the root view when a system appears or disappears.
+
+#define WATCH_MAX 256
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE)
+
+enum
+{
+	WATCH_ADDED,
+	WATCH_REMOVED,
+	WATCH_CHANGED,	// contents of an existing file
+	WATCH_OVERFLOW, // events were dropped, everything has to be reloaded
+};
+
+typedef struct WatchEvent
+{
+	char *dir;
+	char *name;
+	int type;
+	int is_dir;
+} WatchEvent;
+
+typedef struct Watch
+{
+	int wd;
+	char *path;
+	int pinned; // ROMS_PATH, COLLECTIONS_PATH and the system folders stay watched
+} Watch;
+
+static struct
+{
+	int fd;
+	int wake; // eventfd that gets the thread out of poll() to quit
+	int running;
+	pthread_t thread;
+	pthread_mutex_t lock; // guards watches and events
+	Watch watches[WATCH_MAX];
+	int count;
+	Array *events; // WatchEvent
+} watcher = {.fd = -1, .wake = -1, .lock = PTHREAD_MUTEX_INITIALIZER};
+
+// call with watcher.lock held
+static void addWatch(const char *path, int pinned)
+{
+	for (int i = 0; i < watcher.count; i++)
+	{
+		if (exactMatch(watcher.watches[i].path, path))
+		{
+			watcher.watches[i].pinned |= pinned;
+			return;
+		}
+	}
+	if (watcher.count == WATCH_MAX)
+		return;
+
+	int wd = inotify_add_watch(watcher.fd, path, WATCH_MASK);
+	if (wd < 0)
+		return;
+	Watch *watch = &watcher.watches[watcher.count++];
+	watch->wd = wd;
+	watch->path = strdup(path);
+	watch->pinned = pinned;
+}
+
+// call with watcher.lock held
+static void dropWatch(int i, int remove)
+{
+	if (remove)
+		inotify_rm_watch(watcher.fd, watcher.watches[i].wd);
+	free(watcher.watches[i].path);
+	watcher.watches[i] = watcher.watches[--watcher.count];
+}
+
+static void addSystemWatches(void)
+{
+	DIR *dh = opendir(ROMS_PATH);
+	if (!dh)
+		return;
+	char full_path[256];
+	struct dirent *dp;
+	while ((dp = readdir(dh)) != NULL)
+	{
+		if (hide(dp->d_name) || dp->d_type != DT_DIR)
+			continue;
+		snprintf(full_path, sizeof(full_path), "%s/%s", ROMS_PATH, dp->d_name);
+		addWatch(full_path, 1);
+	}
+	closedir(dh);
+}
+
+static void pushWatchEvent(const char *dir, const char *name, int type, int is_dir)
+{
+	WatchEvent *event = malloc(sizeof(WatchEvent));
+	event->dir = dir ? strdup(dir) : NULL;
+	event->name = name ? strdup(name) : NULL;
+	event->type = type;
+	event->is_dir = is_dir;
+	Array_push(watcher.events, event);
+}
+
+static void *watchThread(void *arg)
+{
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd pfds[2] = {{.fd = watcher.fd, .events = POLLIN}, {.fd = watcher.wake, .events = POLLIN}};
+	while (watcher.running)
+	{
+		if (poll(pfds, 2, -1) <= 0 || !watcher.running)
+			continue;
+		ssize_t len = read(watcher.fd, buffer, sizeof(buffer));
+		if (len <= 0)
+			continue;
+
+		pthread_mutex_lock(&watcher.lock);
+		for (char *ptr = buffer; ptr < buffer + len;)
+		{
+			struct inotify_event *ev = (struct inotify_event *)ptr;
+			ptr += sizeof(struct inotify_event) + ev->len;
+
+			if (ev->mask & IN_Q_OVERFLOW)
+			{
+				pushWatchEvent(NULL, NULL, WATCH_OVERFLOW, 0);
+				continue;
+			}
+
+			int i = 0;
+			while (i < watcher.count && watcher.watches[i].wd != ev->wd)
+				i++;
+			if (i == watcher.count)
+				continue;
+			if (ev->mask & IN_IGNORED)
+			{ // folder is gone, the kernel already dropped the watch
+				dropWatch(i, 0);
+				continue;
+			}
+			if (!ev->len)
+				continue;
+
+			char *dir = watcher.watches[i].path;
+			int is_dir = (ev->mask & IN_ISDIR) != 0;
+			if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+			{
+				pushWatchEvent(dir, ev->name, WATCH_ADDED, is_dir);
+				if (is_dir && exactMatch(dir, ROMS_PATH) && !hide(ev->name))
+				{
+					char full_path[256];
+					snprintf(full_path, sizeof(full_path), "%s/%s", ROMS_PATH, ev->name);
+					addWatch(full_path, 1);
+				}
+			}
+			else if (ev->mask & (IN_DELETE | IN_MOVED_FROM))
+			{
+				pushWatchEvent(dir, ev->name, WATCH_REMOVED, is_dir);
+			}
+			else if (ev->mask & IN_CLOSE_WRITE)
+			{
+				// only text files change what's listed, roms being copied in are already there
+				if (exactMatch(ev->name, "map.txt") || exactMatch(dir, COLLECTIONS_PATH))
+					pushWatchEvent(dir, ev->name, WATCH_CHANGED, 0);
+			}
+		}
+		int queued = watcher.events->count;
+		pthread_mutex_unlock(&watcher.lock);
+		if (queued)
+			Wakeup_post();
+	}
+	return NULL;
+}
+
+static void Watcher_init(void)
+{
+	watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watcher.fd < 0)
+	{
+		LOG_warn("Unable to watch the library, changes will show after a restart\n");
+		return;
+	}
+	watcher.wake = eventfd(0, EFD_CLOEXEC);
+	watcher.events = Array_new();
+
+	pthread_mutex_lock(&watcher.lock);
+	addWatch(ROMS_PATH, 1);
+	addWatch(COLLECTIONS_PATH, 1);
+	addSystemWatches();
+	pthread_mutex_unlock(&watcher.lock);
+	Watcher_sync();
+
+	watcher.running = 1;
+	if (pthread_create(&watcher.thread, NULL, watchThread, NULL) != 0)
+		watcher.running = 0;
+}
+
+static void Watcher_quit(void)
+{
+	if (watcher.fd < 0)
+		return;
+	if (watcher.running)
+	{
+		watcher.running = 0;
+		eventfd_write(watcher.wake, 1);
+		pthread_join(watcher.thread, NULL);
+	}
+	while (watcher.count)
+		dropWatch(0, 1);
+	close(watcher.fd);
+	close(watcher.wake);
+	watcher.fd = -1;
+	watcher.wake = -1;
+
+	for (int i = 0; i < watcher.events->count; i++)
+	{
+		WatchEvent *event = watcher.events->items[i];
+		free(event->dir);
+		free(event->name);
+		free(event);
+	}
+	Array_free(watcher.events);
+}
+
+// watches the folders behind the open Directories and stops watching the ones left
+static void Watcher_sync(void)
+{
+	if (watcher.fd < 0)
+		return;
+
+	pthread_mutex_lock(&watcher.lock);
+	for (int i = watcher.count - 1; i >= 0; i--)
+	{
+		if (watcher.watches[i].pinned)
+			continue;
+		int used = 0;
+		for (int j = 0; j < stack->count && !used; j++)
+		{
+			Directory *dir = stack->items[j];
+			used = dir->sources && StringArray_indexOf(dir->sources, watcher.watches[i].path) != -1;
+		}
+		if (!used)
+			dropWatch(i, 1);
+	}
+	for (int j = 0; j < stack->count; j++)
+	{
+		Directory *dir = stack->items[j];
+		for (int i = 0; dir->sources && i < dir->sources->count; i++)
+			addWatch(dir->sources->items[i], 0);
+	}
+	pthread_mutex_unlock(&watcher.lock);
+}
+
+static void Directory_select(Directory *self, int selected)
+{
+	int count = self->entries->count;
+	if (selected >= count)
+		selected = count - 1;
+	if (selected < 0)
+		selected = 0;
+	self->selected = selected;
+	if (selected < self->start || selected >= self->end || self->end > count)
+	{
+		self->start = selected;
+		self->end = self->start + MAIN_ROW_COUNT;
+		if (self->end > count)
+		{
+			self->end = count;
+			self->start = MAX(0, self->end - MAIN_ROW_COUNT);
+		}
+	}
+	if (self->end - self->start < MAIN_ROW_COUNT)
+		self->end = MIN(count, self->start + MAIN_ROW_COUNT);
+}
+
+// copies the entries out of the mapped index so they can be changed
+static void Directory_detach(Directory *self)
+{
+	if (!self->index)
+		return;
+	for (int i = 0; i < self->entries->count; i++)
+	{
+		Entry *mapped = self->entries->items[i];
+		Entry *entry = poolAlloc(&entry_pool);
+		entry->path = pooledStrdup(mapped->path);
+		entry->name = pooledStrdup(mapped->name);
+		entry->unique = pooledStrdup(mapped->unique);
+		entry->type = mapped->type;
+		entry->alpha = mapped->alpha;
+		self->entries->items[i] = entry;
+	}
+	LibraryIndex_free(self->index);
+	self->index = NULL;
+}
+
+// sorts and reindexes after entries were added or removed, keeping the selected entry
+static void Directory_refresh(Directory *self, char *selected_path)
+{
+	for (int i = 0; i < self->entries->count; i++)
+	{
+		Entry *entry = self->entries->items[i];
+		if (entry->unique)
+			pooledStrfree(entry->unique);
+		entry->unique = NULL;
+		entry->alpha = 0;
+	}
+	if (!exactMatch(self->path, SDCARD_PATH))
+		EntryArray_sort(self->entries);
+	self->alphas->count = 0;
+	Directory_index(self);
+
+	int selected = selected_path ? EntryArray_indexOf(self->entries, selected_path) : -1;
+	Directory_select(self, selected == -1 ? self->selected : selected);
+}
+
+// reads the folder again and swaps the result in
+static void Directory_reload(Directory *self, char *selected_path)
+{
+	if (exactMatch(self->path, SDCARD_PATH))
+	{ // getRoot() refills recents
+		RecentArray_free(recents);
+		recents = Array_new();
+	}
+	Directory *fresh = Directory_new(self->path, 0);
+
+	Directory old = *self;
+	self->entries = fresh->entries;
+	self->alphas = fresh->alphas;
+	self->index = fresh->index;
+	self->sources = fresh->sources;
+	fresh->path = old.path;
+	fresh->name = old.name;
+	fresh->entries = old.entries;
+	fresh->alphas = old.alphas;
+	fresh->index = old.index;
+	fresh->sources = old.sources;
+	Directory_free(fresh);
+
+	int selected = selected_path ? EntryArray_indexOf(self->entries, selected_path) : -1;
+	Directory_select(self, selected == -1 ? self->selected : selected);
+}
+
+enum
+{
+	WATCH_NONE,
+	WATCH_PATCH,
+	WATCH_RELOAD,
+};
+
+// what event means for dir, adding or removing its entry where it can be patched. probed
+// collects the system folders the root view already looked at for this batch of events
+static int applyWatchEvent(Directory *dir, WatchEvent *event, Array *probed)
+{
+	if (event->type == WATCH_OVERFLOW)
+		return WATCH_RELOAD;
+
+	char full_path[512];
+	snprintf(full_path, sizeof(full_path), "%s/%s", event->dir, event->name);
+
+	if (exactMatch(dir->path, SDCARD_PATH))
+	{
+		if (exactMatch(event->dir, ROMS_PATH) || exactMatch(event->dir, COLLECTIONS_PATH))
+			return event->type == WATCH_CHANGED && !exactMatch(event->name, "map.txt") ? WATCH_NONE : WATCH_RELOAD;
+
+		// a system folder only matters when it gains its first or loses its last rom
+		char parent[256];
+		strcpy(parent, event->dir);
+		char *tmp = strrchr(parent, '/');
+		if (!tmp || event->type == WATCH_CHANGED)
+			return WATCH_NONE;
+		tmp[0] = '\0';
+		if (!exactMatch(parent, ROMS_PATH))
+			return WATCH_NONE;
+		// copying a few hundred roms in is a few hundred events for the same folder, and
+		// hasRoms() is a readdir on the UI thread, so each folder is only probed once
+		if (StringArray_indexOf(probed, event->dir) != -1)
+			return WATCH_NONE;
+		Array_push(probed, pooledStrdup(event->dir));
+		char display_name[256];
+		getDisplayName(event->dir, display_name);
+		int listed = 0;
+		for (int i = 0; i < dir->entries->count && !listed; i++)
+		{
+			Entry *entry = dir->entries->items[i];
+			listed = exactMatch(entry->path, event->dir) || exactMatch(entry->name, display_name);
+		}
+		return listed != hasRoms(tmp + 1) ? WATCH_RELOAD : WATCH_NONE;
+	}
+
+	// a collection is a file, its folder is COLLECTIONS_PATH
+	if (exactMatch(dir->path, full_path))
+		return WATCH_RELOAD;
+
+	if (!dir->sources || StringArray_indexOf(dir->sources, event->dir) == -1)
+		return WATCH_NONE;
+
+	if (exactMatch(event->name, "map.txt"))
+		return WATCH_RELOAD;
+
+	if (exactMatch(event->dir, ROMS_PATH) && !exactMatch(dir->path, ROMS_PATH))
+	{ // a console folder's sibling, which may collate into it
+		if (!event->is_dir)
+			return WATCH_NONE;
+		char collated_path[256];
+		strcpy(collated_path, dir->path);
+		char *tmp = strrchr(collated_path, '(');
+		if (tmp)
+			tmp[1] = '\0';
+		return prefixMatch(collated_path, full_path) ? WATCH_RELOAD : WATCH_NONE;
+	}
+
+	if (event->type == WATCH_CHANGED || hide(event->name))
+		return WATCH_NONE;
+
+	int i = EntryArray_indexOf(dir->entries, full_path);
+	if (event->type == WATCH_ADDED)
+	{
+		if (i != -1)
+			return WATCH_NONE;
+		Directory_detach(dir);
+		Array_push(dir->entries, Entry_new(full_path, getEntryType(full_path, event->name, event->is_dir)));
+	}
+	else
+	{
+		if (i == -1)
+			return WATCH_NONE;
+		Directory_detach(dir);
+		Entry *entry = dir->entries->items[i];
+		Array_remove(dir->entries, entry);
+		Entry_free(entry);
+	}
+	return WATCH_PATCH;
+}
+
+// applies what changed on disk to the open Directories, 1 if anything did
+static int Watcher_update(void)
+{
+	if (watcher.fd < 0)
+		return 0;
+
+	pthread_mutex_lock(&watcher.lock);
+	if (watcher.events->count == 0)
+	{
+		pthread_mutex_unlock(&watcher.lock);
+		return 0;
+	}
+	Array *events = watcher.events;
+	watcher.events = Array_new();
+	pthread_mutex_unlock(&watcher.lock);
+
+	int changed = 0;
+	for (int j = 0; j < stack->count; j++)
+	{
+		Directory *dir = stack->items[j];
+		int action = WATCH_NONE;
+		char *selected_path = NULL;
+		if (dir->selected >= 0 && dir->selected < dir->entries->count)
+			selected_path = pooledStrdup(((Entry *)dir->entries->items[dir->selected])->path);
+
+		Array *probed = Array_new();
+		for (int i = 0; i < events->count && action != WATCH_RELOAD; i++)
+		{
+			int result = applyWatchEvent(dir, events->items[i], probed);
+			if (result > action)
+				action = result;
+		}
+		StringArray_free(probed);
+
+		if (action == WATCH_RELOAD)
+			Directory_reload(dir, selected_path);
+		else if (action == WATCH_PATCH)
+			Directory_refresh(dir, selected_path);
+		if (selected_path)
+			pooledStrfree(selected_path);
+		changed |= action != WATCH_NONE;
+	}
+
+	for (int i = 0; i < events->count; i++)
+	{
+		WatchEvent *event = events->items[i];
+		free(event->dir);
+		free(event->name);
+		free(event);
+	}
+	Array_free(events);
+
+	if (changed)
+		Watcher_sync();
+	return changed;
+}
+
+static void Entry_open(Entry *self)
+{
+	recent_alias = self->name; // yiiikes
+	if (self->type == ENTRY_ROM)
+	{
+		startgame = 1;
+		char *last = NULL;
+		if (prefixMatch(COLLECTIONS_PATH, top->path))
+		{
+			char *tmp;
+			char filename[256];
+
+			tmp = strrchr(self->path, '/');
+			if (tmp)
+				strcpy(filename, tmp + 1);
 
 			char last_path[256];
 			sprintf(last_path, "%s/%s", top->path, filename);
@@ -1900,15 +3453,6 @@ static int remember_selection = 0;
 
 ///////////////////////////////////////
 
-typedef void (*BackgroundLoadedCallback)(SDL_Surface *surface);
-
-typedef struct
-{
-	char imagePath[MAX_PATH];
-	BackgroundLoadedCallback callback;
-	void *userData;
-} LoadBackgroundTask;
-
 typedef struct finishedTask
 {
 	int startX;
@@ -1936,42 +3480,21 @@ typedef struct AnimTask
 	int targetTextY;
 	int move_w;
 	int move_h;
-	int frames;
+	int duration; // ms, 0 to jump straight there
 	AnimTaskCallback callback;
 	void *userData;
 	char *entry_name;
 	SDL_Rect dst;
 } AnimTask;
 
-typedef struct TaskNode
-{
-	LoadBackgroundTask *task;
-	struct TaskNode *next;
-} TaskNode;
-typedef struct AnimTaskNode
-{
-	AnimTask *task;
-	struct AnimTaskNode *next;
-} AnimTaskNode;
-
-static TaskNode *taskBGQueueHead = NULL;
-static TaskNode *taskBGQueueTail = NULL;
-static TaskNode *taskThumbQueueHead = NULL;
-static TaskNode *taskThumbQueueTail = NULL;
-static AnimTaskNode *animTaskQueueHead = NULL;
-static AnimTaskNode *animTtaskQueueTail = NULL;
-static SDL_mutex *bgqueueMutex = NULL;
-static SDL_mutex *thumbqueueMutex = NULL;
-static SDL_mutex *animqueueMutex = NULL;
-static SDL_cond *bgqueueCond = NULL;
-static SDL_cond *thumbqueueCond = NULL;
-static SDL_cond *animqueueCond = NULL;
-
 static SDL_mutex *bgMutex = NULL;
 static SDL_mutex *thumbMutex = NULL;
 static SDL_mutex *animMutex = NULL;
-static SDL_mutex *frameMutex = NULL;
-static SDL_cond *flipCond = NULL;
+
+static CancelToken bgToken;				// the background being loaded
+static CancelToken thumbToken;		// the game art being loaded
+static CancelToken prefetchToken; // art around the selection
+static CancelToken previewToken;	// the switcher preview being loaded
 
 static SDL_Surface *folderbgbmp = NULL;
 static SDL_Surface *thumbbmp = NULL;
@@ -1984,203 +3507,874 @@ int animationDraw = 1;
 int needDraw = 1;
 int folderbgchanged = 0;
 int thumbchanged = 0;
+int previewchanged = 0;
+static int preview_animdir = 0; // the slide to play once the switcher preview is in
 
-// queue a new image load task :D
-#define MAX_QUEUE_SIZE 1
+///////////////////////////////////////
+// Text Cache
+///////////////////////////////////////
+
+// Names measured, truncated and rendered for the list, the switcher title and the
+// selection pill, keyed by font and its size, colour, text and width. Least recently used
+// go first once over TEXT_CACHE_BUDGET, so holding a direction through a long list only
+// rasterizes the row that scrolls in. UI thread only, like the TTF calls it stands in for.
 
-int currentBGQueueSize = 0;
-int currentThumbQueueSize = 0;
-int currentAnimQueueSize = 0;
+#define TEXT_CACHE_SIZE 256
+#define TEXT_CACHE_BUDGET (4 * 1024 * 1024)
+
+enum
+{
+	TEXT_WIDTH,
+	TEXT_TRUNCATED,
+	TEXT_RENDERED,
+};
+
+typedef struct TextEntry
+{
+	int kind;
+	TTF_Font *font;
+	int font_height; // a reloaded font can come back at the same address
+	uint32_t colour;
+	int max_width;
+	uint64_t hash;
+	char *text;
+	char *fitted;					// TEXT_TRUNCATED
+	int width;						// TEXT_WIDTH and TEXT_TRUNCATED
+	SDL_Surface *surface; // TEXT_RENDERED
+	size_t bytes;
+	uint32_t last_used;
+} TextEntry;
+
+static struct
+{
+	TextEntry entries[TEXT_CACHE_SIZE];
+	size_t bytes;
+	uint32_t tick;
+} texts;
+
+static void dropTextEntry(TextEntry *entry)
+{
+	free(entry->text);
+	free(entry->fitted);
+	SDL_FreeSurface(entry->surface);
+	texts.bytes -= entry->bytes;
+	memset(entry, 0, sizeof(TextEntry));
+}
+
+static TextEntry *findText(int kind, TTF_Font *font, uint32_t colour, int max_width, const char *text, uint64_t hash)
+{
+	int font_height = TTF_FontHeight(font);
+	for (int i = 0; i < TEXT_CACHE_SIZE; i++)
+	{
+		TextEntry *entry = &texts.entries[i];
+		if (entry->text && entry->hash == hash && entry->kind == kind && entry->font == font &&
+				entry->font_height == font_height && entry->colour == colour && entry->max_width == max_width &&
+				exactMatch(entry->text, text))
+		{
+			entry->last_used = ++texts.tick;
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+// an empty slot for bytes more, evicting until there's room
+static TextEntry *addText(int kind, TTF_Font *font, uint32_t colour, int max_width, const char *text, uint64_t hash, size_t bytes)
+{
+	bytes += sizeof(TextEntry) + strlen(text) + 1;
+	for (;;)
+	{
+		TextEntry *slot = NULL;
+		TextEntry *oldest = NULL;
+		for (int i = 0; i < TEXT_CACHE_SIZE; i++)
+		{
+			TextEntry *entry = &texts.entries[i];
+			if (!entry->text)
+			{
+				if (!slot)
+					slot = entry;
+			}
+			else if (!oldest || entry->last_used < oldest->last_used)
+				oldest = entry;
+		}
+		if (slot && (texts.bytes + bytes <= TEXT_CACHE_BUDGET || !oldest))
+		{
+			slot->kind = kind;
+			slot->font = font;
+			slot->font_height = TTF_FontHeight(font);
+			slot->colour = colour;
+			slot->max_width = max_width;
+			slot->hash = hash;
+			slot->text = strdup(text);
+			slot->bytes = bytes;
+			slot->last_used = ++texts.tick;
+			texts.bytes += bytes;
+			return slot;
+		}
+		dropTextEntry(oldest);
+	}
+}
+
+static int getTextWidth(TTF_Font *font, const char *text)
+{
+	uint64_t hash = hashPath(text);
+	TextEntry *entry = findText(TEXT_WIDTH, font, 0, 0, text, hash);
+	if (entry)
+		return entry->width;
+
+	int width = 0;
+	TTF_SizeUTF8(font, text, &width, NULL);
+	entry = addText(TEXT_WIDTH, font, 0, 0, text, hash, 0);
+	entry->width = width;
+	return width;
+}
+
+// same as GFX_getTextWidth()
+static int TextCache_getTextWidth(TTF_Font *font, const char *in_name, char *out_name, int max_width, int padding)
+{
+	strcpy(out_name, in_name);
+	return getTextWidth(font, in_name) + padding;
+}
+
+// same as GFX_truncateText()
+static int TextCache_truncateText(TTF_Font *font, const char *in_name, char *out_name, int max_width, int padding)
+{
+	// only the room left after padding changes the result
+	int room = max_width - padding;
+	uint64_t hash = hashPath(in_name);
+	TextEntry *entry = findText(TEXT_TRUNCATED, font, 0, room, in_name, hash);
+	if (entry)
+	{
+		strcpy(out_name, entry->fitted);
+		return entry->width + padding;
+	}
+
+	int width = GFX_truncateText(font, in_name, out_name, max_width, padding);
+	entry = addText(TEXT_TRUNCATED, font, 0, room, in_name, hash, strlen(out_name) + 1);
+	entry->fitted = strdup(out_name);
+	entry->width = width - padding;
+	return width;
+}
+
+// text as TTF_RenderUTF8_Blended() would render it, hand it back with TextCache_release()
+static SDL_Surface *TextCache_render(TTF_Font *font, const char *text, SDL_Color color)
+{
+	uint32_t colour = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
+	uint64_t hash = hashPath(text);
+	TextEntry *entry = findText(TEXT_RENDERED, font, colour, 0, text, hash);
+	if (!entry)
+	{
+		SDL_Surface *surface = TTF_RenderUTF8_Blended(font, text, color);
+		if (!surface)
+			return NULL;
+		entry = addText(TEXT_RENDERED, font, colour, 0, text, hash, (size_t)surface->pitch * surface->h);
+		entry->surface = surface;
+	}
+	entry->surface->refcount++;
+	return entry->surface;
+}
+
+static void TextCache_release(SDL_Surface *surface)
+{
+	SDL_FreeSurface(surface);
+}
+
+static void TextCache_quit(void)
+{
+	for (int i = 0; i < TEXT_CACHE_SIZE; i++)
+	{
+		if (texts.entries[i].text)
+			dropTextEntry(&texts.entries[i]);
+	}
+}
+
+///////////////////////////////////////
+// Decoded Art Cache
+///////////////////////////////////////
+
+// Backgrounds and thumbnails stay decoded after they've been shown, least recently used
+// first out once they go over ART_CACHE_BUDGET. Surfaces are shared by reference count,
+// a surface the UI still holds survives its eviction until the UI lets go of it.
+// prefetchArt() queues the art around the selection at prefetch priority so scrolling
+// onto an entry finds its art already here.
+
+#define ART_CACHE_SIZE 64
+#define ART_CACHE_BUDGET (32 * 1024 * 1024)
+#define ART_PREFETCH_RADIUS 3 // entries either side of the selection
+
+// variant is whatever settings the loader needs (sizes and such), decided by the caller
+// since loaders run on the scheduler threads
+typedef SDL_Surface *(*ArtLoader)(const char *path, int variant);
+
+typedef struct ArtEntry
+{
+	char path[MAX_PATH];
+	ArtLoader loader;
+	int variant; // loader settings the surface was made with
+	int64_t mtime;
+	int64_t size;
+	SDL_Surface *surface;
+	size_t bytes;
+	uint32_t last_used;
+} ArtEntry;
+
+static struct
+{
+	pthread_mutex_t lock; // guards the entries and every refcount change
+	ArtEntry entries[ART_CACHE_SIZE];
+	size_t bytes;
+	uint32_t tick;
+} art = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+// call with art.lock held
+static void dropArtEntry(ArtEntry *entry)
+{
+	SDL_FreeSurface(entry->surface);
+	art.bytes -= entry->bytes;
+	memset(entry, 0, sizeof(ArtEntry));
+}
+
+// call with art.lock held, a reference to the cached surface for path as st describes it
+// or NULL, an entry that's out of date is dropped
+static SDL_Surface *findArt(const char *path, ArtLoader loader, int variant, struct stat *st)
+{
+	for (int i = 0; i < ART_CACHE_SIZE; i++)
+	{
+		ArtEntry *entry = &art.entries[i];
+		if (!entry->surface || entry->loader != loader || !exactMatch(entry->path, path))
+			continue;
+		if (entry->variant != variant || entry->mtime != st->st_mtime || entry->size != st->st_size)
+		{
+			dropArtEntry(entry); // changed on disk or made for other settings
+			return NULL;
+		}
+		entry->last_used = ++art.tick;
+		entry->surface->refcount++;
+		return entry->surface;
+	}
+	return NULL;
+}
+
+// a reference to path's surface as made by loader, loading it on a miss. NULL if there's
+// no such image. hand it back with ArtCache_release()
+static SDL_Surface *ArtCache_get(const char *path, ArtLoader loader, int variant)
+{
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return NULL;
+
+	pthread_mutex_lock(&art.lock);
+	SDL_Surface *surface = findArt(path, loader, variant, &st);
+	pthread_mutex_unlock(&art.lock);
+	if (surface)
+		return surface;
+
+	surface = loader(path, variant);
+	if (!surface)
+		return NULL;
+	GFX_markSurface(surface); // never changes after this
+	size_t bytes = (size_t)surface->pitch * surface->h;
+	if (bytes > ART_CACHE_BUDGET / 2)
+		return surface; // too big to be worth keeping
+
+	pthread_mutex_lock(&art.lock);
+	for (;;)
+	{
+		ArtEntry *slot = NULL;
+		ArtEntry *oldest = NULL;
+		for (int i = 0; i < ART_CACHE_SIZE; i++)
+		{
+			ArtEntry *entry = &art.entries[i];
+			if (!entry->surface)
+			{
+				if (!slot)
+					slot = entry;
+				continue;
+			}
+			if (!oldest || entry->last_used < oldest->last_used)
+				oldest = entry;
+		}
+		if (slot && art.bytes + bytes <= ART_CACHE_BUDGET)
+		{
+			snprintf(slot->path, sizeof(slot->path), "%s", path);
+			slot->loader = loader;
+			slot->variant = variant;
+			slot->mtime = st.st_mtime;
+			slot->size = st.st_size;
+			slot->surface = surface;
+			slot->bytes = bytes;
+			slot->last_used = ++art.tick;
+			art.bytes += bytes;
+			surface->refcount++; // the cache's own
+			break;
+		}
+		if (!oldest)
+			break;
+		dropArtEntry(oldest);
+	}
+	pthread_mutex_unlock(&art.lock);
+	return surface;
+}
+
+// ArtCache_get without the loading, NULL on a miss
+static SDL_Surface *ArtCache_peek(const char *path, ArtLoader loader, int variant)
+{
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return NULL;
+
+	pthread_mutex_lock(&art.lock);
+	SDL_Surface *surface = findArt(path, loader, variant, &st);
+	pthread_mutex_unlock(&art.lock);
+	return surface;
+}
+
+static void ArtCache_release(SDL_Surface *surface)
+{
+	if (!surface)
+		return;
+	pthread_mutex_lock(&art.lock);
+	SDL_FreeSurface(surface);
+	pthread_mutex_unlock(&art.lock);
+}
+
+// another reference to a surface from ArtCache_get, also let go of with ArtCache_release
+static void ArtCache_retain(SDL_Surface *surface)
+{
+	if (!surface)
+		return;
+	pthread_mutex_lock(&art.lock);
+	surface->refcount++;
+	pthread_mutex_unlock(&art.lock);
+}
+
+static void ArtCache_quit(void)
+{
+	pthread_mutex_lock(&art.lock);
+	for (int i = 0; i < ART_CACHE_SIZE; i++)
+	{
+		if (art.entries[i].surface)
+			dropArtEntry(&art.entries[i]);
+	}
+	pthread_mutex_unlock(&art.lock);
+}
+
+static SDL_Surface *loadBackground(const char *path, int variant)
+{
+	SDL_Surface *image = IMG_Load(path);
+	if (!image)
+		return NULL;
+	SDL_Surface *imageRGBA = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA8888, 0);
+	SDL_FreeSurface(image);
+	return imageRGBA;
+}
+
+static void loadBackgroundTask(Task *task)
+{
+	task->result = ArtCache_get(task->path, loadBackground, task->variant);
+}
+
+static void prefetchBackgroundTask(Task *task)
+{
+	ArtCache_release(ArtCache_get(task->path, loadBackground, task->variant));
+}
+
+static void releaseArtTask(Task *task)
+{
+	ArtCache_release(task->result);
+}
+
+///////////////////////////////////////
+// Thumbnail Cache
+///////////////////////////////////////
+
+// Game art is decoded, resized to the size it's drawn at and corner masked once, then
+// appended to a pack per .media folder under THUMB_CACHE_PATH. Every append also adds
+// the name's hash and the record's offset to the pack's index, so a lookup searches the
+// index in memory and only touches the pack for the record it's after. The newest record
+// for a name wins so a changed image just appends another, once the records superseded
+// that way are over 1/THUMB_PACK_STALE of the pack it's rewritten with only the live
+// ones. A pack made for a different art size or corner radius starts over.
+//
+// file layout:
+//	.thb	ThumbPackHeader { ThumbRecord, name padded to 4 bytes, RGBA8888 pixels, padded to 8 bytes } ...
+//	.thi	ThumbPackHeader { ThumbIndexEntry } ...
+
+#define THUMB_CACHE_PATH LIBRARY_INDEX_PATH "/thumbs"
+#define THUMB_CACHE_MAGIC 0x424d4854 // "THMB"
+#define THUMB_CACHE_VERSION 2
+#define THUMB_PACK_STALE 4
+#define THUMB_RECORD_SIZE(name_len, w, h) ((sizeof(ThumbRecord) + (uint64_t)(name_len) + (uint64_t)(w) * (h) * 4 + 7) & ~7ull)
+
+typedef struct ThumbPackHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int32_t max_w;
+	int32_t max_h;
+	int32_t radius;
+	uint32_t reserved;
+} ThumbPackHeader;
+
+typedef struct ThumbRecord
+{
+	uint32_t name_len; // with the terminator and padding
+	int32_t w;
+	int32_t h;
+	uint32_t reserved;
+	int64_t mtime; // of the source image
+	int64_t size;
+} ThumbRecord;
+
+typedef struct ThumbIndexEntry
+{
+	uint64_t name_hash;
+	uint64_t offset; // of the ThumbRecord in the pack
+} ThumbIndexEntry;
+
+static struct
+{
+	pthread_mutex_t lock; // guards the loaded pack and the appends, never held while decoding
+	char pack_path[MAX_PATH]; // what's loaded
+	void *map;
+	size_t size;
+	ThumbIndexEntry *index; // oldest first
+	int count;
+	int capacity;
+	uint64_t stale; // bytes of superseded records in the pack
+} thumbs = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static void getThumbIndexPath(const char *pack_path, char *index_path)
+{
+	snprintf(index_path, MAX_PATH, "%s", pack_path);
+	index_path[strlen(index_path) - 1] = 'i'; // .thb -> .thi
+}
+
+static void unloadThumbPack(void)
+{
+	if (thumbs.map)
+		munmap(thumbs.map, thumbs.size);
+	free(thumbs.index);
+	thumbs.map = NULL;
+	thumbs.size = 0;
+	thumbs.index = NULL;
+	thumbs.count = 0;
+	thumbs.capacity = 0;
+	thumbs.stale = 0;
+	thumbs.pack_path[0] = '\0';
+}
+
+// remaps the loaded pack at its current size after an append
+static int remapThumbPack(void)
+{
+	struct stat st;
+	if (stat(thumbs.pack_path, &st) != 0)
+		return 0;
+	if (thumbs.map && thumbs.size == (size_t)st.st_size)
+		return 1;
+	if (thumbs.map)
+		munmap(thumbs.map, thumbs.size);
+	thumbs.map = NULL;
+	thumbs.size = 0;
+
+	int fd = open(thumbs.pack_path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+	thumbs.map = map;
+	thumbs.size = st.st_size;
+	return 1;
+}
+
+// the record at offset in the loaded pack, NULL if it runs past the end
+static const ThumbRecord *getThumbRecord(uint64_t offset, uint64_t *record_size)
+{
+	if (offset < sizeof(ThumbPackHeader) || (offset & 7) || offset > thumbs.size || thumbs.size - offset < sizeof(ThumbRecord))
+		return NULL;
+	const ThumbRecord *record = (const ThumbRecord *)((const char *)thumbs.map + offset);
+	uint64_t size = THUMB_RECORD_SIZE(record->name_len, record->w, record->h);
+	if (record->w <= 0 || record->h <= 0 || record->name_len == 0 || size > thumbs.size - offset)
+		return NULL;
+	*record_size = size;
+	return record;
+}
 
-void enqueueBGTask(LoadBackgroundTask *task)
+// whether a later index entry has the same name, the record then only takes up space
+static int isThumbSuperseded(int i)
 {
-	SDL_LockMutex(bgqueueMutex);
-	TaskNode *node = (TaskNode *)malloc(sizeof(TaskNode));
-	node->task = task;
-	node->next = NULL;
+	for (int j = i + 1; j < thumbs.count; j++)
+	{
+		if (thumbs.index[j].name_hash == thumbs.index[i].name_hash)
+			return 1;
+	}
+	return 0;
+}
 
-	// If queue is full, drop the oldest task (head)
-	if (currentBGQueueSize >= MAX_QUEUE_SIZE)
+// call with thumbs.lock held, loads pack_path and its index unless they're loaded
+// already. 0 if there's no pack made for want
+static int loadThumbPack(const char *pack_path, const ThumbPackHeader *want)
+{
+	if (thumbs.map && exactMatch(thumbs.pack_path, pack_path))
+		return memcmp(thumbs.map, want, sizeof(ThumbPackHeader)) == 0;
+
+	unloadThumbPack();
+	char index_path[MAX_PATH];
+	getThumbIndexPath(pack_path, index_path);
+	FILE *file = fopen(index_path, "rb");
+	if (!file)
+		return 0;
+	ThumbPackHeader header;
+	struct stat st;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(&header, want, sizeof(header)) != 0 || fstat(fileno(file), &st) != 0)
 	{
-		TaskNode *oldNode = taskBGQueueHead;
-		if (oldNode)
-		{
-			taskBGQueueHead = oldNode->next;
-			if (!taskBGQueueHead)
-			{
-				taskBGQueueTail = NULL;
-			}
-			if (oldNode->task)
-			{
-				free(oldNode->task); // Only if task was malloc'd
-			}
-			free(oldNode);
-			currentBGQueueSize--;
-		}
+		fclose(file);
+		return 0;
+	}
+	int count = (st.st_size - sizeof(header)) / sizeof(ThumbIndexEntry); // a torn last entry is left out
+	int capacity = MAX(count, 1);
+	thumbs.index = malloc(capacity * sizeof(ThumbIndexEntry));
+	if (!thumbs.index || fread(thumbs.index, sizeof(ThumbIndexEntry), count, file) != (size_t)count)
+	{
+		fclose(file);
+		unloadThumbPack();
+		return 0;
 	}
+	fclose(file);
+	thumbs.count = count;
+	thumbs.capacity = capacity;
 
-	// Enqueue the new task
-	if (taskBGQueueTail)
+	snprintf(thumbs.pack_path, sizeof(thumbs.pack_path), "%s", pack_path);
+	if (!remapThumbPack() || thumbs.size < sizeof(ThumbPackHeader) || memcmp(thumbs.map, want, sizeof(ThumbPackHeader)) != 0)
 	{
-		taskBGQueueTail->next = node;
-		taskBGQueueTail = node;
+		unloadThumbPack();
+		return 0;
 	}
-	else
+	for (int i = 0; i < thumbs.count; i++)
 	{
-		taskBGQueueHead = taskBGQueueTail = node;
+		uint64_t record_size;
+		if (getThumbRecord(thumbs.index[i].offset, &record_size) && isThumbSuperseded(i))
+			thumbs.stale += record_size;
 	}
+	return 1;
+}
 
-	currentBGQueueSize++;
-	SDL_CondSignal(bgqueueCond);
-	SDL_UnlockMutex(bgqueueMutex);
+// call with thumbs.lock held, the newest record for name in the loaded pack
+static const ThumbRecord *findThumbRecord(const char *name, uint64_t *record_size)
+{
+	uint64_t name_hash = hashPath(name);
+	for (int i = thumbs.count - 1; i >= 0; i--)
+	{
+		if (thumbs.index[i].name_hash != name_hash)
+			continue;
+		const ThumbRecord *record = getThumbRecord(thumbs.index[i].offset, record_size);
+		if (!record)
+			continue;
+		const char *record_name = (const char *)(record + 1);
+		if (record_name[record->name_len - 1] == '\0' && exactMatch(record_name, name))
+			return record;
+	}
+	return NULL;
 }
-void enqueueThumbTask(LoadBackgroundTask *task)
+
+// call with thumbs.lock held
+static SDL_Surface *findThumb(const char *pack_path, const ThumbPackHeader *want, const char *name, const struct stat *source)
 {
-	SDL_LockMutex(thumbqueueMutex);
-	TaskNode *node = (TaskNode *)malloc(sizeof(TaskNode));
-	node->task = task;
-	node->next = NULL;
+	if (!loadThumbPack(pack_path, want))
+		return NULL;
+	uint64_t record_size;
+	const ThumbRecord *found = findThumbRecord(name, &record_size);
+	if (!found || found->mtime != source->st_mtime || found->size != source->st_size)
+		return NULL;
+
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, found->w, found->h, 32, SDL_PIXELFORMAT_RGBA8888);
+	if (!surface)
+		return NULL;
+	const uint8_t *pixels = (const uint8_t *)(found + 1) + found->name_len;
+	for (int y = 0; y < found->h; y++)
+		memcpy((uint8_t *)surface->pixels + y * surface->pitch, pixels + y * found->w * 4, found->w * 4);
+	return surface;
+}
 
-	// If queue is full, drop the oldest task (head)
-	if (currentThumbQueueSize >= MAX_QUEUE_SIZE)
+// call with thumbs.lock held, writes an empty pack and index for want and loads them
+static int startThumbPack(const char *pack_path, const ThumbPackHeader *want)
+{
+	unloadThumbPack();
+	char index_path[MAX_PATH];
+	getThumbIndexPath(pack_path, index_path);
+	// the index goes first, a pack without one is never looked at
+	unlink(index_path);
+	int ok = 0;
+	int fd = open(pack_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd >= 0)
 	{
-		TaskNode *oldNode = taskThumbQueueHead;
-		if (oldNode)
-		{
-			taskThumbQueueHead = oldNode->next;
-			if (!taskThumbQueueHead)
-			{
-				taskThumbQueueTail = NULL;
-			}
-			if (oldNode->task)
-			{
-				free(oldNode->task); // Only if task was malloc'd
-			}
-			free(oldNode);
-			currentThumbQueueSize--;
-		}
+		ok = write(fd, want, sizeof(ThumbPackHeader)) == sizeof(ThumbPackHeader);
+		ok = close(fd) == 0 && ok;
 	}
+	fd = ok ? open(index_path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+	if (fd < 0)
+		return 0;
+	ok = write(fd, want, sizeof(ThumbPackHeader)) == sizeof(ThumbPackHeader);
+	ok = close(fd) == 0 && ok;
+	return ok && loadThumbPack(pack_path, want);
+}
 
-	// Enqueue the new task
-	if (taskThumbQueueTail)
+// call with thumbs.lock held, rewrites the loaded pack with only the newest record for
+// each name. written next to the real files and renamed over them like the library index
+static void compactThumbPack(void)
+{
+	char pack_path[MAX_PATH];
+	char index_path[MAX_PATH];
+	char pack_tmp[MAX_PATH];
+	char index_tmp[MAX_PATH];
+	snprintf(pack_path, sizeof(pack_path), "%s", thumbs.pack_path);
+	getThumbIndexPath(pack_path, index_path);
+	snprintf(pack_tmp, sizeof(pack_tmp), "%s.tmp", pack_path);
+	snprintf(index_tmp, sizeof(index_tmp), "%s.tmp", index_path);
+
+	FILE *pack = fopen(pack_tmp, "wb");
+	FILE *index = fopen(index_tmp, "wb");
+	int ok = pack && index &&
+					 fwrite(thumbs.map, sizeof(ThumbPackHeader), 1, pack) == 1 &&
+					 fwrite(thumbs.map, sizeof(ThumbPackHeader), 1, index) == 1;
+	uint64_t offset = sizeof(ThumbPackHeader);
+	for (int i = 0; ok && i < thumbs.count; i++)
 	{
-		taskThumbQueueTail->next = node;
-		taskThumbQueueTail = node;
+		uint64_t record_size;
+		const ThumbRecord *record = getThumbRecord(thumbs.index[i].offset, &record_size);
+		if (!record || isThumbSuperseded(i))
+			continue;
+		ThumbIndexEntry entry = {.name_hash = thumbs.index[i].name_hash, .offset = offset};
+		ok = fwrite(record, record_size, 1, pack) == 1 && fwrite(&entry, sizeof(entry), 1, index) == 1;
+		offset += record_size;
 	}
-	else
+	if (pack)
+		ok = fclose(pack) == 0 && ok;
+	if (index)
+		ok = fclose(index) == 0 && ok;
+
+	unloadThumbPack();
+	// a crash between the renames leaves an index that doesn't fit the pack, its
+	// lookups then miss on the name check and the art is just made again
+	if (!ok || rename(pack_tmp, pack_path) != 0 || rename(index_tmp, index_path) != 0)
 	{
-		taskThumbQueueHead = taskThumbQueueTail = node;
+		LOG_warn("Unable to compact thumbnail cache %s\n", pack_path);
+		unlink(pack_tmp);
+		unlink(index_tmp);
 	}
-
-	currentThumbQueueSize++;
-	SDL_CondSignal(thumbqueueCond);
-	SDL_UnlockMutex(thumbqueueMutex);
 }
 
-// Worker threadd
-int BGLoadWorker(void *unused)
+// call with thumbs.lock held
+static void storeThumb(const char *pack_path, const ThumbPackHeader *want, const char *name, const struct stat *source, SDL_Surface *surface)
 {
-	while (true)
-	{
-		SDL_LockMutex(bgqueueMutex);
-		while (!taskBGQueueHead)
-		{
-			SDL_CondWait(bgqueueCond, bgqueueMutex);
-		}
-		TaskNode *node = taskBGQueueHead;
-		taskBGQueueHead = node->next;
-		if (!taskBGQueueHead)
-			taskBGQueueTail = NULL;
-		SDL_UnlockMutex(bgqueueMutex);
-		// Reduced delay for better responsiveness
-		SDL_Delay(10);
-		LoadBackgroundTask *task = node->task;
-		free(node);
+	mkdir(LIBRARY_INDEX_PATH, 0755);
+	mkdir(THUMB_CACHE_PATH, 0755);
+	// a pack for another size or radius is useless now, start it over
+	if (!loadThumbPack(pack_path, want) && !startThumbPack(pack_path, want))
+		return;
 
-		SDL_Surface *result = NULL;
-		if (access(task->imagePath, F_OK) == 0)
-		{
-			SDL_Surface *image = IMG_Load(task->imagePath);
-			if (image)
-			{
-				SDL_Surface *imageRGBA = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA8888, 0);
-				SDL_FreeSurface(image);
-				result = imageRGBA;
-			}
-		}
+	uint64_t superseded = 0;
+	const ThumbRecord *old = findThumbRecord(name, &superseded);
+	if (old && old->mtime == source->st_mtime && old->size == source->st_size)
+		return; // another worker made it meanwhile
+	if (!old)
+		superseded = 0;
+
+	uint32_t name_len = (strlen(name) + 1 + 3) & ~3;
+	ThumbRecord record = {
+			.name_len = name_len,
+			.w = surface->w,
+			.h = surface->h,
+			.mtime = source->st_mtime,
+			.size = source->st_size,
+	};
+	size_t row = surface->w * 4;
+	size_t size = THUMB_RECORD_SIZE(name_len, surface->w, surface->h);
+	uint8_t *data = calloc(1, size);
+	if (!data)
+		return;
+	memcpy(data, &record, sizeof(record));
+	memcpy(data + sizeof(record), name, strlen(name));
+	uint8_t *pixels = data + sizeof(record) + name_len;
+	for (int y = 0; y < surface->h; y++)
+		memcpy(pixels + y * row, (uint8_t *)surface->pixels + y * surface->pitch, row);
+
+	// the record is written whole before the index points at it, an append torn by a
+	// crash is never indexed and goes with the next compaction
+	char index_path[MAX_PATH];
+	getThumbIndexPath(pack_path, index_path);
+	ThumbIndexEntry entry = {.name_hash = hashPath(name)};
+	int ok = 0;
+	int fd = open(pack_path, O_WRONLY);
+	if (fd >= 0)
+	{
+		off_t offset = lseek(fd, 0, SEEK_END);
+		entry.offset = offset;
+		ok = offset >= 0 && pwrite(fd, data, size, offset) == (ssize_t)size;
+		close(fd);
+	}
+	free(data);
+	fd = ok ? open(index_path, O_WRONLY | O_APPEND) : -1;
+	ok = fd >= 0 && write(fd, &entry, sizeof(entry)) == sizeof(entry);
+	if (fd >= 0)
+		close(fd);
+	if (!ok)
+	{
+		LOG_warn("Unable to cache thumbnail %s\n", name);
+		unloadThumbPack(); // whatever made it on disk is read back next time
+		return;
+	}
 
-		if (task->callback)
+	if (thumbs.count == thumbs.capacity)
+	{
+		ThumbIndexEntry *index = realloc(thumbs.index, thumbs.capacity * 2 * sizeof(ThumbIndexEntry));
+		if (!index)
 		{
-			task->callback(result);
+			unloadThumbPack();
+			return;
 		}
-		free(task);
-		SDL_LockMutex(bgqueueMutex);
-		currentBGQueueSize--;
-		SDL_UnlockMutex(bgqueueMutex);
+		thumbs.index = index;
+		thumbs.capacity *= 2;
 	}
-	return 0;
+	thumbs.index[thumbs.count++] = entry;
+	thumbs.stale += superseded;
+	if (!remapThumbPack())
+	{
+		unloadThumbPack();
+		return;
+	}
+	if (thumbs.stale * THUMB_PACK_STALE > thumbs.size)
+		compactThumbPack();
 }
-int ThumbLoadWorker(void *unused)
+
+static SDL_Surface *makeThumb(const char *image_path, int max_w, int max_h, int radius)
 {
-	while (true)
-	{
-		SDL_LockMutex(thumbqueueMutex);
-		while (!taskThumbQueueHead)
-		{
-			SDL_CondWait(thumbqueueCond, thumbqueueMutex);
-		}
-		TaskNode *node = taskThumbQueueHead;
-		taskThumbQueueHead = node->next;
-		if (!taskThumbQueueHead)
-			taskThumbQueueTail = NULL;
-		SDL_UnlockMutex(thumbqueueMutex);
-		// Reduced delay for better responsiveness
-		SDL_Delay(10);
-		LoadBackgroundTask *task = node->task;
-		free(node);
+	SDL_Surface *image = IMG_Load(image_path);
+	if (!image)
+		return NULL;
+	SDL_Surface *rgba = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA8888, 0);
+	SDL_FreeSurface(image);
+	if (!rgba)
+		return NULL;
 
-		SDL_Surface *result = NULL;
-		if (access(task->imagePath, F_OK) == 0)
-		{
-			SDL_Surface *image = IMG_Load(task->imagePath);
-			if (image)
-			{
-				SDL_Surface *imageRGBA = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA8888, 0);
-				SDL_FreeSurface(image);
-				result = imageRGBA;
-			}
-		}
+	// fit inside max_w x max_h, same as the draw code
+	double aspect_ratio = (double)rgba->h / rgba->w;
+	int new_w = max_w;
+	int new_h = (int)(new_w * aspect_ratio);
+	if (new_h > max_h)
+	{
+		new_h = max_h;
+		new_w = (int)(new_h / aspect_ratio);
+	}
+	if (new_w <= 0 || new_h <= 0)
+	{
+		SDL_FreeSurface(rgba);
+		return NULL;
+	}
 
-		if (task->callback)
-		{
-			task->callback(result);
-		}
-		free(task);
-		SDL_LockMutex(thumbqueueMutex);
-		currentThumbQueueSize--;
-		SDL_UnlockMutex(thumbqueueMutex);
+	SDL_Surface *thumb = SDL_CreateRGBSurfaceWithFormat(0, new_w, new_h, 32, SDL_PIXELFORMAT_RGBA8888);
+	if (thumb && BLIT_resizeArea32(rgba->pixels, rgba->pitch, rgba->w, rgba->h, thumb->pixels, thumb->pitch, new_w, new_h, 0) != 0)
+	{
+		SDL_FreeSurface(thumb);
+		thumb = NULL;
 	}
-	return 0;
+	SDL_FreeSurface(rgba);
+	if (thumb)
+		GFX_ApplyRoundedCorners_RGBA8888(thumb, NULL, radius);
+	return thumb;
+}
+
+// what a thumbnail depends on besides the image, the size it's fit into and its corner
+// radius packed into the art cache variant. worked out on the UI thread, the loader only
+// sees the variant
+#define THUMB_VARIANT_W(variant) (((uint32_t)(variant) >> 20) & 0xFFF)
+#define THUMB_VARIANT_H(variant) (((uint32_t)(variant) >> 8) & 0xFFF)
+#define THUMB_VARIANT_RADIUS(variant) ((uint32_t)(variant) & 0xFF)
+static int getThumbVariant(void)
+{
+	uint32_t max_w = (uint32_t)(screen->w * CFG_getGameArtWidth());
+	uint32_t max_h = (uint32_t)(screen->h * 0.6);
+	uint32_t radius = SCALE1(CFG_getThumbnailRadius());
+	max_w = MIN(max_w, 0xFFF);
+	max_h = MIN(max_h, 0xFFF);
+	radius = MIN(radius, 0xFF);
+	return (int)(max_w << 20 | max_h << 8 | radius);
+}
+
+// game art at the size and with the corners it's drawn with, from the cache when it can be
+static SDL_Surface *loadThumbnail(const char *image_path, int variant)
+{
+	struct stat source;
+	if (stat(image_path, &source) != 0)
+		return NULL;
+
+	ThumbPackHeader want = {
+			.magic = THUMB_CACHE_MAGIC,
+			.version = THUMB_CACHE_VERSION,
+			.max_w = THUMB_VARIANT_W(variant),
+			.max_h = THUMB_VARIANT_H(variant),
+			.radius = THUMB_VARIANT_RADIUS(variant),
+	};
+	if (want.max_w <= 0 || want.max_h <= 0)
+		return NULL;
+
+	char media_path[MAX_PATH];
+	snprintf(media_path, sizeof(media_path), "%s", image_path);
+	char *tmp = strrchr(media_path, '/');
+	if (!tmp)
+		return NULL;
+	tmp[0] = '\0';
+	const char *name = tmp + 1;
+	char pack_path[MAX_PATH];
+	sprintf(pack_path, "%s/%016llx.thb", THUMB_CACHE_PATH, (unsigned long long)hashPath(media_path));
+
+	pthread_mutex_lock(&thumbs.lock);
+	SDL_Surface *surface = findThumb(pack_path, &want, name, &source);
+	pthread_mutex_unlock(&thumbs.lock);
+	if (surface)
+		return surface;
+
+	// decoded without the lock, a visible thumbnail mustn't wait behind a prefetch's decode
+	surface = makeThumb(image_path, want.max_w, want.max_h, want.radius);
+	if (!surface)
+		return NULL;
+	pthread_mutex_lock(&thumbs.lock);
+	storeThumb(pack_path, &want, name, &source, surface);
+	pthread_mutex_unlock(&thumbs.lock);
+	return surface;
+}
+
+static void loadThumbTask(Task *task)
+{
+	task->result = ArtCache_get(task->path, loadThumbnail, task->variant);
 }
 
-void startLoadFolderBackground(const char *imagePath, int type, BackgroundLoadedCallback callback, void *userData)
+static void prefetchThumbTask(Task *task)
 {
-	LoadBackgroundTask *task = malloc(sizeof(LoadBackgroundTask));
+	ArtCache_release(ArtCache_get(task->path, loadThumbnail, task->variant));
+}
+
+// queues path to be handed to done as a surface, or NULL, dropping what's still queued
+// or loading for the previous call with the same token
+static void startLoadArt(const char *path, int variant, TaskFunc run, TaskFunc done, CancelToken *token)
+{
+	Scheduler_cancel(token);
+	Task *task = Task_new(run, done, NULL);
 	if (!task)
 		return;
-
-	snprintf(task->imagePath, sizeof(task->imagePath), "%s", imagePath);
-	task->callback = callback;
-	task->userData = userData;
-	enqueueBGTask(task);
+	snprintf(task->path, sizeof(task->path), "%s", path);
+	task->variant = variant;
+	task->drop = releaseArtTask;
+	Scheduler_submit(task, TASK_VISIBLE, token);
 }
 
 void onBackgroundLoaded(SDL_Surface *surface)
 {
 	SDL_LockMutex(bgMutex);
 	folderbgchanged = 1;
-	if (folderbgbmp)
-		SDL_FreeSurface(folderbgbmp);
+	ArtCache_release(folderbgbmp);
 	if (!surface)
 	{
 		folderbgbmp = NULL;
@@ -2192,23 +4386,166 @@ void onBackgroundLoaded(SDL_Surface *surface)
 	SDL_UnlockMutex(bgMutex);
 }
 
-void startLoadThumb(const char *thumbpath, BackgroundLoadedCallback callback, void *userData)
+static void backgroundLoaded(Task *task)
 {
-	LoadBackgroundTask *task = malloc(sizeof(LoadBackgroundTask));
+	onBackgroundLoaded(task->result);
+}
+
+void startLoadFolderBackground(const char *imagePath)
+{
+	startLoadArt(imagePath, 0, loadBackgroundTask, backgroundLoaded, &bgToken);
+}
+
+static void prefetch(const char *path, int variant, TaskFunc run)
+{
+	Task *task = Task_new(run, NULL, NULL);
 	if (!task)
 		return;
+	snprintf(task->path, sizeof(task->path), "%s", path);
+	task->variant = variant;
+	Scheduler_submit(task, TASK_PREFETCH, &prefetchToken);
+}
+
+// queues the art of the entries around the selection nearest first,
+// dropping whatever was still queued for the previous selection
+static void prefetchArt(Directory *top)
+{
+	static Directory *last_top = NULL;
+	static int last_selected = -1;
+	if (top == last_top && top->selected == last_selected)
+		return; // redrawn without moving
+	last_top = top;
+	last_selected = top->selected;
+
+	int count = top->entries->count;
+	int use_thumbs = CFG_getShowGameArt();
+	int use_bgs = CFG_getRomsUseFolderBackground();
+	int thumb_variant = getThumbVariant();
+
+	Scheduler_cancel(&prefetchToken);
+	for (int d = 1; d <= ART_PREFETCH_RADIUS; d++)
+	{
+		for (int side = 1; side >= -1; side -= 2)
+		{
+			int i = top->selected + d * side;
+			if (i < 0 || i >= count)
+				continue;
+			Entry *entry = top->entries->items[i];
+			char path[MAX_PATH];
+
+			if (use_thumbs)
+			{
+				char dir[MAX_PATH];
+				snprintf(dir, sizeof(dir), "%s", entry->path);
+				char *name = strrchr(dir, '/');
+				if (!name)
+					continue;
+				*name++ = '\0';
+				char *dot = strrchr(name, '.');
+				if (dot)
+					*dot = '\0';
+				snprintf(path, sizeof(path), "%s/.media/%s.png", dir, name);
+				prefetch(path, thumb_variant, prefetchThumbTask);
+			}
+			// roms share their folder's bglist.png, only folders bring a new background
+			if (use_bgs && entry->type == ENTRY_DIR)
+			{
+				snprintf(path, sizeof(path), "%s/.media/bg.png", entry->path);
+				prefetch(path, 0, prefetchBackgroundTask);
+			}
+		}
+	}
+}
+
+// queues the state previews either side of the switcher's selection
+static void prefetchPreviews(void)
+{
+	// redraws of the same selection keep what's already queued, unless something else
+	// cancelled the prefetches since
+	static Recent *last_window[3];
+	static int last_generation = -1;
+	Recent *window[3];
+	for (int side = -1; side <= 1; side++)
+		window[side + 1] = recents->items[(switcher_selected + side + recents->count) % recents->count];
+	if (last_generation == prefetchToken.generation && !memcmp(window, last_window, sizeof(window)))
+		return;
+
+	Scheduler_cancel(&prefetchToken);
+	memcpy(last_window, window, sizeof(window));
+	last_generation = prefetchToken.generation;
+	for (int side = 1; side >= -1; side -= 2)
+	{
+		int i = (switcher_selected + side + recents->count) % recents->count;
+		if (i == switcher_selected)
+			continue;
+		Entry *entry = entryFromRecent(recents->items[i]);
+		if (!entry)
+			continue;
+		char slot[256];
+		char preview[256];
+		if (getResumePaths(entry->path, entry->type, slot, preview))
+			prefetch(preview, 0, prefetchBackgroundTask);
+		Entry_free(entry);
+	}
+}
+
+// the last preview loaded in the background, in case the art cache didn't keep it
+static SDL_Surface *previewbmp = NULL;
+static char previewbmp_path[MAX_PATH];
+
+static void previewLoaded(Task *task)
+{
+	ArtCache_release(previewbmp);
+	previewbmp = task->result;
+	snprintf(previewbmp_path, sizeof(previewbmp_path), "%s", task->path);
+	if (previewbmp)
+		previewchanged = 1;
+}
+
+// the switcher preview for path if it's decoded, NULL otherwise
+static SDL_Surface *peekPreview(const char *path)
+{
+	SDL_Surface *surface = ArtCache_peek(path, loadBackground, 0);
+	if (!surface && previewbmp && exactMatch(previewbmp_path, path))
+	{
+		surface = previewbmp;
+		ArtCache_retain(surface);
+	}
+	return surface;
+}
+
+// decodes the switcher preview on a worker, previewchanged is set once it's ready
+static void startLoadPreview(const char *path)
+{
+	startLoadArt(path, 0, loadBackgroundTask, previewLoaded, &previewToken);
+}
+
+static void loadPreviewTask(Task *task)
+{
+	SDL_Surface **surface = task->arg;
+	*surface = ArtCache_get(task->path, loadBackground, 0);
+}
 
-	snprintf(task->imagePath, sizeof(task->imagePath), "%s", thumbpath);
-	task->callback = callback;
-	task->userData = userData;
-	enqueueThumbTask(task);
+// the switcher preview for the transitions into the switcher, which can't start without it
+static SDL_Surface *loadPreview(const char *path)
+{
+	SDL_Surface *surface = NULL;
+	TaskGroup group = {0};
+	Task *task = Task_new(loadPreviewTask, NULL, &surface);
+	if (!task)
+		return ArtCache_get(path, loadBackground, 0);
+	snprintf(task->path, sizeof(task->path), "%s", path);
+	task->group = &group;
+	Scheduler_submit(task, TASK_VISIBLE, NULL);
+	Scheduler_wait(&group);
+	return surface;
 }
+
 void onThumbLoaded(SDL_Surface *surface)
 {
 	SDL_LockMutex(thumbMutex);
 	thumbchanged = 1;
-	if (thumbbmp)
-		SDL_FreeSurface(thumbbmp);
+	ArtCache_release(thumbbmp);
 	if (!surface)
 	{
 		thumbbmp = NULL;
@@ -2216,31 +4553,25 @@ void onThumbLoaded(SDL_Surface *surface)
 		return;
 	}
 
-	thumbbmp = surface;
-	int img_w = thumbbmp->w;
-	int img_h = thumbbmp->h;
-	double aspect_ratio = (double)img_h / img_w;
-	int max_w = (int)(screen->w * CFG_getGameArtWidth());
-	int max_h = (int)(screen->h * 0.6);
-	int new_w = max_w;
-	int new_h = (int)(new_w * aspect_ratio);
-
-	if (new_h > max_h)
-	{
-		new_h = max_h;
-		new_w = (int)(new_h / aspect_ratio);
-	}
-	GFX_ApplyRoundedCorners_RGBA8888(
-			thumbbmp,
-			&(SDL_Rect){0, 0, thumbbmp->w, thumbbmp->h},
-			SCALE1((float)CFG_getThumbnailRadius() * ((float)img_w / (float)new_w)));
+	thumbbmp = surface; // already sized and corner masked by loadThumbnail()
 	needDraw = 1;
 	SDL_UnlockMutex(thumbMutex);
 }
 
+static void thumbLoaded(Task *task)
+{
+	onThumbLoaded(task->result);
+}
+
+void startLoadThumb(const char *thumbpath)
+{
+	startLoadArt(thumbpath, getThumbVariant(), loadThumbTask, thumbLoaded, &thumbToken);
+}
+
 SDL_Rect pillRect;
-SDL_Surface *globalpill;
-SDL_Surface *globalText;
+int pillW = 0;
+char pillText[256] = "";
+int pillTextW = 0;
 int pilltargetY = 0;
 int pilltargetTextY = 0;
 void animcallback(finishedTask *task)
@@ -2252,163 +4583,138 @@ void animcallback(finishedTask *task)
 	{
 		pilltargetY = task->targetY;
 		pilltargetTextY = task->targetTextY;
-		SDL_Color text_color = uintToColour(THEME_COLOR5_255);
-		SDL_Surface *tmp = TTF_RenderUTF8_Blended(font.large, task->entry_name, text_color);
-
-		SDL_Surface *converted = SDL_ConvertSurfaceFormat(tmp, SDL_PIXELFORMAT_RGBA8888, 0);
-		SDL_FreeSurface(tmp); // tmp no longer needed
-
-		SDL_Rect crop_rect = {0, 0, task->move_w - SCALE1(BUTTON_PADDING * 2), converted->h};
-		SDL_Surface *cropped = SDL_CreateRGBSurfaceWithFormat(
-				0, crop_rect.w, crop_rect.h, 32, SDL_PIXELFORMAT_RGBA8888);
-		if (!cropped)
-		{
-			SDL_FreeSurface(converted);
-		}
-
-		SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
-		SDL_BlitSurface(converted, &crop_rect, cropped, NULL);
-		SDL_FreeSurface(converted);
-
-		globalText = cropped;
+		strncpy(pillText, task->entry_name, sizeof(pillText) - 1);
+		pillTextW = task->move_w - SCALE1(BUTTON_PADDING * 2);
 	}
 	needDraw = 1;
 	SDL_UnlockMutex(animMutex);
 	animationDraw = 1;
 }
-bool frameReady = true;
-int pillanimdone = 0;
 
-int animWorker(void *unused)
+// the selection goes straight to the layers as atlas quads and glyphs,
+// nothing is rendered into a surface and uploaded for it
+static void drawSelectionPill(void)
 {
-	while (true)
-	{
-		SDL_LockMutex(animqueueMutex);
-		while (!animTaskQueueHead)
-		{
-			SDL_CondWait(animqueueCond, animqueueMutex);
-		}
-		AnimTaskNode *node = animTaskQueueHead;
-		animTaskQueueHead = node->next;
-		if (!animTaskQueueHead)
-			animTtaskQueueTail = NULL;
-		SDL_UnlockMutex(animqueueMutex);
-
-		AnimTask *task = node->task;
-		finishedTask *finaltask = (finishedTask *)malloc(sizeof(finishedTask));
-		int total_frames = task->frames;
-		if (task->targetY > task->startY + SCALE1(PILL_SIZE) || task->targetY < task->startY - SCALE1(PILL_SIZE))
-		{
-			total_frames = 0;
-		}
-
-		for (int frame = 0; frame <= total_frames; frame++)
-		{
-			float t = (float)frame / total_frames;
-			if (t > 1.0f)
-				t = 1.0f;
+	if (pillW > 0)
+		GFX_drawPillOnLayer(ASSET_WHITE_PILL, &(SDL_Rect){pillRect.x, pillRect.y, pillW, SCALE1(PILL_SIZE)}, THEME_COLOR1_255, 2);
+}
+static void drawSelectionText(void)
+{
+	if (pillText[0] && pillTextW > 0)
+		GFX_drawTextOnLayer(font.large, pillText, uintToColour(THEME_COLOR5_255), SCALE1(PADDING + BUTTON_PADDING), pilltargetTextY, pillTextW, 4);
+}
+int pillanimdone = 0;
 
-			int current_x = task->startX + (int)((task->targetX - task->startX) * t);
-			int current_y = task->startY + (int)((task->targetY - task->startY) * t);
+#define PILL_ANIM_MS 50
 
-			SDL_Rect moveDst = {current_x, current_y, task->move_w, task->move_h};
-			finaltask->dst = moveDst;
-			finaltask->entry_name = task->entry_name;
-			finaltask->move_w = task->move_w;
-			finaltask->move_h = task->move_h;
-			finaltask->targetY = task->targetY;
-			finaltask->targetTextY = task->targetTextY;
-			finaltask->move_y = SCALE1(PADDING + task->targetY + 4);
-			finaltask->done = 0;
-			if (frame >= total_frames)
-				finaltask->done = 1;
-			task->callback(finaltask);
-			SDL_LockMutex(frameMutex);
-			while (!frameReady)
-			{
-				SDL_CondWait(flipCond, frameMutex);
-			}
-			frameReady = false;
-			SDL_UnlockMutex(frameMutex);
-		}
-		SDL_LockMutex(animqueueMutex);
-		currentAnimQueueSize--;
-		SDL_UnlockMutex(animqueueMutex);
+static AnimTask pillTask; // where the pill is headed, what stepPill reports to
+static char pillName[256]; // outlives the Entry the name came from
+static Tween pillTween;
 
-		SDL_LockMutex(animMutex);
+static void stepPill(Tween *tween)
+{
+	AnimTask *task = tween->arg;
+	finishedTask finaltask = {0};
+	finaltask.dst = (SDL_Rect){(int)tween->value[0], (int)tween->value[1], task->move_w, task->move_h};
+	finaltask.entry_name = task->entry_name;
+	finaltask.move_w = task->move_w;
+	finaltask.move_h = task->move_h;
+	finaltask.targetY = task->targetY;
+	finaltask.targetTextY = task->targetTextY;
+	finaltask.move_y = SCALE1(PADDING + task->targetY + 4);
+	finaltask.done = !tween->running;
+	task->callback(&finaltask);
+
+	if (finaltask.done)
 		pillanimdone = 1;
-		free(finaltask);
-		SDL_UnlockMutex(animMutex);
-	}
 }
 
-void enqueueanmimtask(AnimTask *task)
+// moves the pill to a new selection, from wherever it is if it's still moving to the last one
+int animPill(AnimTask *task)
 {
-	AnimTaskNode *node = (AnimTaskNode *)malloc(sizeof(AnimTaskNode));
-	node->task = task;
-	node->next = NULL;
-
-	SDL_LockMutex(animqueueMutex);
+	int from_x = pillTween.running ? (int)pillTween.value[0] : task->startX;
+	int from_y = pillTween.running ? (int)pillTween.value[1] : task->startY;
+	int duration = task->duration;
+	// more than a row away means a page or wrap, no point sliding across the list
+	if (task->targetY > from_y + SCALE1(PILL_SIZE) || task->targetY < from_y - SCALE1(PILL_SIZE))
+		duration = 0;
+
+	pillTask = *task;
+	pillTask.callback = animcallback;
+	snprintf(pillName, sizeof(pillName), "%s", task->entry_name ? task->entry_name : "");
+	pillTask.entry_name = pillName;
+	pillTween.arg = &pillTask;
+	pillTween.step = stepPill;
+	pillTween.value[0] = from_x;
+	pillTween.value[1] = from_y;
 	pillanimdone = 0;
-	// If queue is full, drop the oldest task (head)
-	if (currentAnimQueueSize >= 1)
-	{
-		AnimTaskNode *oldNode = animTaskQueueHead;
-		if (oldNode)
-		{
-			animTaskQueueHead = oldNode->next;
-			if (!animTaskQueueHead)
-			{
-				animTtaskQueueTail = NULL;
-			}
-			if (oldNode->task)
-			{
-				free(oldNode->task); // Only if task was malloc'd
-			}
-			free(oldNode);
-			currentAnimQueueSize--;
-		}
-	}
+	Tween_to(&pillTween, (float[TWEEN_VALUES]){task->targetX, task->targetY}, duration, easeOutCubic);
+	return 0;
+}
 
-	// Enqueue the new task
-	if (animTtaskQueueTail)
-	{
-		animTtaskQueueTail->next = node;
-		animTtaskQueueTail = node;
-	}
-	else
+// a captured screen or image animated over the UI without holding up the main loop.
+// move slides from value[0],value[1] at value[2] opacity, fade covers the screen at
+// value[3] opacity on top of it. a full redraw finishes the running one first
+static struct
+{
+	Tween tween;
+	SDL_Surface *move;
+	SDL_Surface *fade;
+	int w;
+	int h;
+	int layer;
+	int clear; // clears layer when done, otherwise the last frame stays
+} transition;
+
+static void stepTransition(Tween *tween)
+{
+	GFX_clearLayers(transition.layer);
+	if (transition.move)
+		GFX_drawOnLayerOpacity(transition.move, (int)tween->value[0], (int)tween->value[1], transition.w, transition.h, (int)tween->value[2], transition.layer);
+	if (transition.fade)
+		GFX_drawOnLayerOpacity(transition.fade, 0, 0, screen->w, screen->h, (int)tween->value[3], transition.layer);
+	needDraw = 1;
+}
+
+static void finishTransition(Tween *tween)
+{
+	if (transition.clear)
 	{
-		animTaskQueueHead = animTtaskQueueTail = node;
+		GFX_clearLayers(transition.layer);
+		needDraw = 1;
 	}
-
-	currentAnimQueueSize++;
-	SDL_CondSignal(animqueueCond);
-	SDL_UnlockMutex(animqueueMutex);
+	// either can be shared with the art cache
+	ArtCache_release(transition.move);
+	ArtCache_release(transition.fade);
+	transition.move = NULL;
+	transition.fade = NULL;
 }
 
-int animPill(AnimTask *task)
+// takes over move and fade, either can be NULL. the first frame is drawn right away
+// so it goes out with the flip that follows
+static void startTransition(SDL_Surface *move, SDL_Surface *fade, int w, int h, const float *from, const float *to, int duration, Easing ease, int layer, int clear)
 {
-	task->callback = animcallback;
-	enqueueanmimtask(task);
-	return 0;
+	Tween_finish(&transition.tween);
+	transition.move = move;
+	transition.fade = fade;
+	transition.w = w;
+	transition.h = h;
+	transition.layer = layer;
+	transition.clear = clear;
+	transition.tween.step = stepTransition;
+	transition.tween.finish = finishTransition;
+	memcpy(transition.tween.value, from, sizeof(transition.tween.value));
+	Tween_to(&transition.tween, to, duration, ease);
+	stepTransition(&transition.tween);
 }
+
 void initImageLoaderPool()
 {
-	thumbqueueMutex = SDL_CreateMutex();
-	bgqueueMutex = SDL_CreateMutex();
-	bgqueueCond = SDL_CreateCond();
-	thumbqueueCond = SDL_CreateCond();
 	bgMutex = SDL_CreateMutex();
 	thumbMutex = SDL_CreateMutex();
 	animMutex = SDL_CreateMutex();
-	animqueueMutex = SDL_CreateMutex();
-	animqueueCond = SDL_CreateCond();
-	frameMutex = SDL_CreateMutex();
-	flipCond = SDL_CreateCond();
 
-	SDL_CreateThread(BGLoadWorker, "BGLoadWorker", NULL);
-	SDL_CreateThread(ThumbLoadWorker, "ThumbLoadWorker", NULL);
-	SDL_CreateThread(animWorker, "animWorker", NULL);
+	Scheduler_init();
 }
 ///////////////////////////////////////
 
@@ -2422,6 +4728,42 @@ enum
 };
 static int lastScreen = SCREEN_OFF;
 
+#define IDLE_POLL_MS 17			// held buttons and the settings overlay still get polled every frame
+#define STATUS_POLL_MS 1000 // longest idle wait, wifi, hdmi and autosleep are looked at this often
+#define SCROLL_IDLE_MS 30000 // a long name stops scrolling after this long without input
+
+// 1 when something the status bar shows changed since the last call
+static int statusChanged(void)
+{
+	static int minute = -1;
+	static int charge = -1;
+	static int charging = -1;
+
+	int now_minute = CFG_getShowClock() ? (int)(time(NULL) / 60) : -1;
+	int now_charge = PWR_getBattery();
+	int now_charging = PWR_isCharging();
+	int changed = now_minute != minute || now_charge != charge || now_charging != charging;
+	minute = now_minute;
+	charge = now_charge;
+	charging = now_charging;
+	return changed;
+}
+
+// how long the main loop can sleep when nothing is moving on screen
+static int nextWakeup(int show_setting)
+{
+	if (show_setting || PAD_anyPressed())
+		return IDLE_POLL_MS;
+	int timeout = STATUS_POLL_MS;
+	if (CFG_getShowClock())
+	{
+		int clock = msToNextMinute();
+		if (clock < timeout)
+			timeout = clock;
+	}
+	return timeout;
+}
+
 int main(int argc, char *argv[])
 {
 	// Initialize memory pools and string pool for optimization
@@ -2453,9 +4795,11 @@ int main(int argc, char *argv[])
 	SDL_Surface *version = NULL;
 	SDL_Surface *preview = NULL;
 
+	Wakeup_init();
 	// start my threaded image loader :D
 	initImageLoaderPool();
 	Menu_init();
+	Watcher_init();
 	// LOG_info("- menu init: %lu\n", SDL_GetTicks() - main_begin);
 
 	show_switcher = exists(GAME_SWITCHER_PERSIST_PATH);
@@ -2494,18 +4838,12 @@ int main(int argc, char *argv[])
 
 	SDL_Surface *blackBG = SDL_CreateRGBSurfaceWithFormat(0, screen->w, screen->h, 32, SDL_PIXELFORMAT_RGBA8888);
 	SDL_FillRect(blackBG, NULL, SDL_MapRGBA(screen->format, 0, 0, 0, 255));
+	GFX_markSurface(blackBG);
 
 	static int readytoscroll = 0;
 
 	pthread_t cpucheckthread;
 	pthread_create(&cpucheckthread, NULL, PLAT_cpu_monitor, NULL);
-	SDL_LockMutex(animMutex);
-	globalpill = SDL_CreateRGBSurfaceWithFormat(
-			SDL_SWSURFACE, screen->w, SCALE1(PILL_SIZE), FIXED_DEPTH, SDL_PIXELFORMAT_RGBA8888);
-	globalText = SDL_CreateRGBSurfaceWithFormat(
-			SDL_SWSURFACE, screen->w, SCALE1(PILL_SIZE), FIXED_DEPTH, SDL_PIXELFORMAT_RGBA8888);
-	static int globallpillW = 0;
-	SDL_UnlockMutex(animMutex);
 
 	// Main loop start
 	while (!quit)
@@ -2515,11 +4853,42 @@ int main(int argc, char *argv[])
 		unsigned long now = SDL_GetTicks();
 
 		PAD_poll();
+		Wakeup_ack();
+
+		// a long name scrolls until the launcher has been left alone for a while
+		static unsigned long last_input_at = 0;
+		int was_idle = now - last_input_at >= SCROLL_IDLE_MS;
+		if (PAD_anyPressed() || PAD_anyJustReleased() || last_input_at == 0)
+			last_input_at = now;
+		int scroll_idle = now - last_input_at >= SCROLL_IDLE_MS;
+		if (is_scrolling && scroll_idle != was_idle)
+		{
+			if (scroll_idle)
+				animationDraw = 1; // puts the name back at rest once
+			else
+				dirty = 1; // and starts it over
+		}
+
+		// files added, removed or renamed since the last frame
+		if (Watcher_update())
+			dirty = 1;
+
+		// loaded art, then where the running animations are this frame,
+		// both set needDraw themselves
+		Scheduler_deliver();
+		Tweens_update(now);
+		if (previewchanged)
+		{
+			previewchanged = 0;
+			dirty = 1; // the switcher was drawn without its preview
+		}
 
 		int selected = top->selected;
 		int total = top->entries->count;
 
 		PWR_update(&dirty, &show_setting, NULL, NULL);
+		if (statusChanged())
+			dirty = 1;
 
 		int is_online = PLAT_isOnline();
 		if (was_online != is_online)
@@ -2767,6 +5136,7 @@ int main(int argc, char *argv[])
 
 		if (dirty)
 		{
+			Tween_finish(&transition.tween);
 			SDL_Surface *tmpOldScreen = NULL;
 			SDL_Surface *switchetsur = NULL;
 			// NOTE:22 This causes slowdown when CFG_getMenuTransitions is set to false because animationdirection turns > 0 somewhere but is never set back to 0 and so this code runs on every action, will fix later
@@ -2775,6 +5145,7 @@ int main(int argc, char *argv[])
 				if (tmpOldScreen)
 					SDL_FreeSurface(tmpOldScreen);
 				tmpOldScreen = GFX_captureRendererToSurface();
+				GFX_markSurface(tmpOldScreen);
 				SDL_SetSurfaceBlendMode(tmpOldScreen, SDL_BLENDMODE_BLEND);
 			}
 
@@ -2897,6 +5268,7 @@ int main(int argc, char *argv[])
 					SDL_FreeSurface(osver_txt);
 				}
 				SDL_BlitSurface(version, NULL, screen, &(SDL_Rect){(screen->w - version->w) / 2, (screen->h - version->h) / 2});
+				GFX_markScreen(screen);
 
 				// buttons (duped and trimmed from below)
 				if (show_setting && !GetHDMI())
@@ -2911,6 +5283,7 @@ int main(int argc, char *argv[])
 				pilltargetY = +screen->w;
 				animationdirection = 0;
 				SDL_Surface *tmpsur = GFX_captureRendererToSurface();
+				GFX_markSurface(tmpsur);
 				GFX_clearLayers(0);
 				GFX_clear(screen);
 				GFX_flipHidden();
@@ -2954,15 +5327,16 @@ int main(int argc, char *argv[])
 						int max_width = screen->w - SCALE1(PADDING * 2) - ow;
 
 						char display_name[256];
-						int text_width = GFX_truncateText(font.large, selectedEntry->name, display_name, max_width, SCALE1(BUTTON_PADDING * 2));
+						int text_width = TextCache_truncateText(font.large, selectedEntry->name, display_name, max_width, SCALE1(BUTTON_PADDING * 2));
 						max_width = MIN(max_width, text_width);
 
 						SDL_Surface *text;
 						SDL_Color textColor = uintToColour(THEME_COLOR6_255);
-						text = TTF_RenderUTF8_Blended(font.large, display_name, textColor);
+						text = TextCache_render(font.large, display_name, textColor);
 						GFX_blitPillLight(ASSET_WHITE_PILL, screen, &(SDL_Rect){SCALE1(PADDING), SCALE1(PADDING), max_width, SCALE1(PILL_SIZE)});
-						SDL_BlitSurface(text, &(SDL_Rect){0, 0, max_width - SCALE1(BUTTON_PADDING * 2), text->h}, screen, &(SDL_Rect){SCALE1(PADDING + BUTTON_PADDING), SCALE1(PADDING + 4)});
-						SDL_FreeSurface(text);
+						if (text)
+							SDL_BlitSurface(text, &(SDL_Rect){0, 0, max_width - SCALE1(BUTTON_PADDING * 2), text->h}, screen, &(SDL_Rect){SCALE1(PADDING + BUTTON_PADDING), SCALE1(PADDING + 4)});
+						TextCache_release(text);
 					}
 
 					if (can_resume)
@@ -2972,17 +5346,25 @@ int main(int argc, char *argv[])
 
 					GFX_blitButtonGroup((char *[]){"Y", "REMOVE", "A", "RESUME", NULL}, 1, screen, 1);
 
+					prefetchPreviews();
+					// a preview still loading for an earlier selection would redraw over this one
+					Scheduler_cancel(&previewToken);
+					int animdir = gsanimdir ? gsanimdir : preview_animdir;
+					preview_animdir = 0;
 					if (has_preview)
 					{
-						// lotta memory churn here
-
-						SDL_Surface *bmp = IMG_Load(preview_path);
-						SDL_Surface *raw_preview = SDL_ConvertSurfaceFormat(bmp, SDL_PIXELFORMAT_RGBA8888, 0);
-						if (raw_preview)
+						// usually already decoded by prefetchPreviews() for the previous selection,
+						// paging onto one that isn't draws without it and again once it's in
+						SDL_Surface *bmp = peekPreview(preview_path);
+						if (!bmp && lastScreen == SCREEN_GAMESWITCHER)
 						{
-							SDL_FreeSurface(bmp);
-							bmp = raw_preview;
+							startLoadPreview(preview_path);
+							preview_animdir = animdir;
+							GFX_flipHidden();
+							GFX_drawOnLayer(blackBG, 0, 0, screen->w, screen->h, 1.0f, 0, 1);
 						}
+						else if (!bmp)
+							bmp = loadPreview(preview_path);
 						if (bmp)
 						{
 							int aw = screen->w;
@@ -3020,6 +5402,7 @@ int main(int argc, char *argv[])
 								GFX_drawOnLayer(bmp, ax, ay, aw, ah, 1.0f, 0, 1);
 								GFX_flipHidden();
 								SDL_Surface *tmpNewScreen = GFX_captureRendererToSurface();
+								GFX_markSurface(tmpNewScreen);
 								GFX_clearLayers(0);
 								folderbgchanged = 1;
 								GFX_drawOnLayer(tmpOldScreen, 0, 0, screen->w, screen->h, 1.0f, 0, 0);
@@ -3030,14 +5413,17 @@ int main(int argc, char *argv[])
 							{
 								GFX_flipHidden();
 								GFX_drawOnLayer(blackBG, 0, 0, screen->w, screen->h, 1.0f, 0, 1);
-								if (gsanimdir == 1)
-									GFX_animateSurface(bmp, ax + screen->w, ay, ax, ay, aw, ah, CFG_getMenuTransitions() ? 80 : 20, 0, 255, 0);
-								else if (gsanimdir == 2)
-									GFX_animateSurface(bmp, ax - screen->w, ay, ax, ay, aw, ah, CFG_getMenuTransitions() ? 80 : 20, 0, 255, 0);
-
-								GFX_drawOnLayer(bmp, ax, ay, aw, ah, 1.0f, 0, 1);
+								if (animdir)
+								{
+									// slides in on layer 2 and stays there, another press picks it up from wherever it got to
+									int from_x = animdir == 1 ? ax + screen->w : ax - screen->w;
+									ArtCache_retain(bmp);
+									startTransition(bmp, NULL, aw, ah, (float[TWEEN_VALUES]){from_x, ay, 0, 0}, (float[TWEEN_VALUES]){ax, ay, 255, 0}, CFG_getMenuTransitions() ? 80 : 20, easeOutCubic, 2, 0);
+								}
+								else
+									GFX_drawOnLayer(bmp, ax, ay, aw, ah, 1.0f, 0, 1);
 							}
-							SDL_FreeSurface(bmp); // Free after rendering
+							ArtCache_release(bmp);
 						}
 					}
 					else
@@ -3045,6 +5431,7 @@ int main(int argc, char *argv[])
 						SDL_Rect preview_rect = {ox, oy, hw, hh};
 						SDL_Surface *tmpsur = SDL_CreateRGBSurfaceWithFormat(0, screen->w, screen->h, 32, SDL_PIXELFORMAT_RGBA8888);
 						SDL_FillRect(tmpsur, &preview_rect, SDL_MapRGBA(screen->format, 0, 0, 0, 255));
+						GFX_markSurface(tmpsur);
 						if (lastScreen == SCREEN_GAME)
 						{
 							GFX_animateSurfaceOpacityAndScale(tmpsur, screen->w / 2, screen->h / 2, screen->w * 4, screen->h * 4, screen->w, screen->h, 255, 0, CFG_getMenuTransitions() ? 150 : 20, 1);
@@ -3056,10 +5443,12 @@ int main(int argc, char *argv[])
 						else if (lastScreen == SCREEN_GAMESWITCHER)
 						{
 							GFX_flipHidden();
-							if (gsanimdir == 1)
-								GFX_animateSurface(tmpsur, 0 + screen->w, 0, 0, 0, screen->w, screen->h, CFG_getMenuTransitions() ? 80 : 20, 0, 255, 0);
-							else if (gsanimdir == 2)
-								GFX_animateSurface(tmpsur, 0 - screen->w, 0, 0, 0, screen->w, screen->h, CFG_getMenuTransitions() ? 80 : 20, 0, 255, 0);
+							if (gsanimdir)
+							{
+								int from_x = gsanimdir == 1 ? screen->w : 0 - screen->w;
+								startTransition(tmpsur, NULL, screen->w, screen->h, (float[TWEEN_VALUES]){from_x, 0, 0, 0}, (float[TWEEN_VALUES]){0, 0, 255, 0}, CFG_getMenuTransitions() ? 80 : 20, easeOutCubic, 2, 0);
+								tmpsur = NULL;
+							}
 						}
 						SDL_FreeSurface(tmpsur);
 						GFX_blitMessage(font.large, "No Preview", screen, &preview_rect);
@@ -3080,6 +5469,7 @@ int main(int argc, char *argv[])
 				if (switchetsur)
 					SDL_FreeSurface(switchetsur);
 				switchetsur = GFX_captureRendererToSurface();
+				GFX_markSurface(switchetsur);
 				lastScreen = SCREEN_GAMESWITCHER;
 			}
 			else
@@ -3103,13 +5493,13 @@ int main(int argc, char *argv[])
 						{
 							snprintf(tmppath, sizeof(tmppath), SDCARD_PATH "/bg.png", folderBgPath);
 						}
-						startLoadFolderBackground(tmppath, entry->type, onBackgroundLoaded, NULL);
+						startLoadFolderBackground(tmppath);
 					}
 				}
 				else if (strcmp(SDCARD_PATH "/bg.png", folderBgPath) != 0)
 				{
 					strncpy(folderBgPath, SDCARD_PATH "/bg.png", sizeof(folderBgPath) - 1);
-					startLoadFolderBackground(SDCARD_PATH "/bg.png", entry->type, onBackgroundLoaded, NULL);
+					startLoadFolderBackground(SDCARD_PATH "/bg.png");
 				}
 
 				// load game thumbnails
@@ -3121,7 +5511,7 @@ int main(int argc, char *argv[])
 						snprintf(thumbpath, sizeof(thumbpath), "%s/.media/%s.png", rompath, res_copy);
 						had_thumb = 0;
 
-						startLoadThumb(thumbpath, onThumbLoaded, NULL);
+						startLoadThumb(thumbpath);
 						int max_w = (int)(screen->w - (screen->w * CFG_getGameArtWidth()));
 						int max_h = (int)(screen->h * 0.6);
 						int new_w = max_w;
@@ -3135,6 +5525,9 @@ int main(int argc, char *argv[])
 					}
 				}
 
+				if (total > 0)
+					prefetchArt(top);
+
 				// buttons
 				if (show_setting && !GetHDMI())
 					GFX_blitHardwareHints(screen, show_setting);
@@ -3188,7 +5581,7 @@ int main(int argc, char *argv[])
 						}
 
 						char display_name[256];
-						int text_width = GFX_getTextWidth(font.large, entry_unique ? entry_unique : entry_name, display_name, available_width, SCALE1(BUTTON_PADDING * 2));
+						int text_width = TextCache_getTextWidth(font.large, entry_unique ? entry_unique : entry_name, display_name, available_width, SCALE1(BUTTON_PADDING * 2));
 
 						int max_width = MIN(available_width, text_width);
 
@@ -3199,41 +5592,37 @@ int main(int argc, char *argv[])
 							text_color = uintToColour(THEME_COLOR5_255);
 							notext = 1;
 						}
-						SDL_Surface *text = TTF_RenderUTF8_Blended(font.large, entry_name, text_color);
-						SDL_Surface *text_unique = TTF_RenderUTF8_Blended(font.large, display_name, COLOR_DARK_TEXT);
+						SDL_Surface *text = TextCache_render(font.large, entry_name, text_color);
+						SDL_Surface *text_unique = TextCache_render(font.large, display_name, COLOR_DARK_TEXT);
 						if (j == selected_row)
 						{
 
 							is_scrolling = GFX_resetScrollText(font.large, display_name, max_width - SCALE1(BUTTON_PADDING * 2));
 							SDL_LockMutex(animMutex);
-							if (globalpill)
-								SDL_FreeSurface(globalpill);
-							globalpill = SDL_CreateRGBSurfaceWithFormat(
-									SDL_SWSURFACE, max_width, SCALE1(PILL_SIZE), FIXED_DEPTH, SDL_PIXELFORMAT_RGBA8888);
-							GFX_blitPillDark(ASSET_WHITE_PILL, globalpill, &(SDL_Rect){0, 0, max_width, SCALE1(PILL_SIZE)});
-							globallpillW = max_width;
+							pillW = max_width;
 							SDL_UnlockMutex(animMutex);
-							AnimTask *task = malloc(sizeof(AnimTask));
-							task->startX = SCALE1(BUTTON_MARGIN);
-							task->startY = SCALE1(previousY + PADDING);
-							task->targetX = SCALE1(BUTTON_MARGIN);
-							task->targetY = SCALE1(targetY + PADDING);
-							task->targetTextY = SCALE1(PADDING + targetY + 4);
+							AnimTask task = {0};
+							task.startX = SCALE1(BUTTON_MARGIN);
+							task.startY = SCALE1(previousY + PADDING);
+							task.targetX = SCALE1(BUTTON_MARGIN);
+							task.targetY = SCALE1(targetY + PADDING);
+							task.targetTextY = SCALE1(PADDING + targetY + 4);
 							pilltargetTextY = +screen->w;
-							task->move_w = max_width;
-							task->move_h = SCALE1(PILL_SIZE);
-							task->frames = CFG_getMenuAnimations() ? 3 : 0;
-							task->entry_name = notext ? " " : entry_name;
-							animPill(task);
+							task.move_w = max_width;
+							task.move_h = SCALE1(PILL_SIZE);
+							task.duration = CFG_getMenuAnimations() ? PILL_ANIM_MS : 0;
+							task.entry_name = notext ? " " : entry_name;
+							animPill(&task);
 						}
 						SDL_Rect text_rect = {0, 0, max_width - SCALE1(BUTTON_PADDING * 2), text->h};
 						SDL_Rect dest_rect = {SCALE1(BUTTON_MARGIN + BUTTON_PADDING), SCALE1(PADDING + (j * PILL_SIZE) + 4)};
 
 						SDL_BlitSurface(text_unique, &text_rect, screen, &dest_rect);
 						SDL_BlitSurface(text, &text_rect, screen, &dest_rect);
+						GFX_markScreen(screen);
 
-						SDL_FreeSurface(text_unique); // Free after use
-						SDL_FreeSurface(text);				// Free after use
+						TextCache_release(text_unique);
+						TextCache_release(text);
 					}
 					if (lastScreen == SCREEN_GAMESWITCHER)
 					{
@@ -3250,7 +5639,8 @@ int main(int argc, char *argv[])
 					}
 					if (lastScreen == SCREEN_OFF)
 					{
-						GFX_animateSurfaceOpacity(blackBG, 0, 0, screen->w, screen->h, 255, 0, CFG_getMenuTransitions() ? 200 : 20, 3);
+						blackBG->refcount++; // kept for later, the transition only lets go of its reference
+						startTransition(NULL, blackBG, 0, 0, (float[TWEEN_VALUES]){0, 0, 0, 255}, (float[TWEEN_VALUES]){0, 0, 0, 0}, CFG_getMenuTransitions() ? 200 : 20, easeLinear, 5, 1);
 					}
 
 					remember_selection = selected_row;
@@ -3271,14 +5661,14 @@ int main(int argc, char *argv[])
 				GFX_clearLayers(2);
 				GFX_flipHidden();
 				SDL_Surface *tmpNewScreen = GFX_captureRendererToSurface();
+				GFX_markSurface(tmpNewScreen);
 				SDL_SetSurfaceBlendMode(tmpNewScreen, SDL_BLENDMODE_BLEND);
 				GFX_clearLayers(3);
-				if (animationdirection == 1)
-					GFX_animateAndFadeSurface(tmpOldScreen, 0, 0, 0 - FIXED_WIDTH, 0, FIXED_WIDTH, FIXED_HEIGHT, 200, tmpNewScreen, 1, 0, FIXED_WIDTH, FIXED_HEIGHT, 0, 255, 3);
-				if (animationdirection == 2)
-					GFX_animateAndFadeSurface(tmpOldScreen, 0, 0, 0 + FIXED_WIDTH, 0, FIXED_WIDTH, FIXED_HEIGHT, 200, tmpNewScreen, 1, 0, FIXED_WIDTH, FIXED_HEIGHT, 0, 255, 3);
-				GFX_clearLayers(3);
-				SDL_FreeSurface(tmpNewScreen);
+				// the old screen slides out while the new one fades in over the real one on the top layer,
+				// input keeps going meanwhile and the next redraw cuts it short
+				int to_x = animationdirection == 1 ? 0 - FIXED_WIDTH : FIXED_WIDTH;
+				startTransition(tmpOldScreen, tmpNewScreen, FIXED_WIDTH, FIXED_HEIGHT, (float[TWEEN_VALUES]){0, 0, 255, 0}, (float[TWEEN_VALUES]){to_x, 0, 255, 255}, 200, easeInOutQuad, 5, 1);
+				tmpOldScreen = NULL;
 				animationdirection = 0;
 			}
 			else
@@ -3332,8 +5722,7 @@ int main(int argc, char *argv[])
 				GFX_clearLayers(4);
 
 				SDL_LockMutex(animMutex);
-				GFX_drawOnLayer(globalpill, pillRect.x, pillRect.y, globallpillW, globalpill->h, 1.0f, 0, 2);
-				// GFX_drawOnLayer(globalText, SCALE1(PADDING+BUTTON_PADDING), pilltargetTextY, globalText->w, globalText->h, 1.0f, 0, 4);
+				drawSelectionPill();
 				SDL_UnlockMutex(animMutex);
 			}
 			if (!startgame) // dont flip if game gonna start
@@ -3342,7 +5731,7 @@ int main(int argc, char *argv[])
 			dirty = 0;
 			readytoscroll = 0;
 		}
-		else if (animationDraw || folderbgchanged || thumbchanged || is_scrolling)
+		else if (animationDraw || folderbgchanged || thumbchanged || (is_scrolling && !scroll_idle))
 		{
 			// honestly this whole thing is here only for the scrolling text, I set it now to run this at 30fps which is enough for scrolling text, should move this to seperate animation function eventually
 			Uint32 now = SDL_GetTicks();
@@ -3395,11 +5784,11 @@ int main(int argc, char *argv[])
 			if (animationDraw)
 			{
 				GFX_clearLayers(2);
-				GFX_drawOnLayer(globalpill, pillRect.x, pillRect.y, globallpillW, globalpill->h, 1.0f, 0, 2);
+				drawSelectionPill();
 				animationDraw = 0;
 			}
 			SDL_UnlockMutex(animMutex);
-			if (!show_switcher && !show_version && is_scrolling && pillanimdone && currentAnimQueueSize < 1)
+			if (!show_switcher && !show_version && is_scrolling && !scroll_idle && pillanimdone)
 			{
 
 				int ow = GFX_blitHardwareGroup(screen, show_setting);
@@ -3418,7 +5807,7 @@ int main(int argc, char *argv[])
 
 				SDL_Color text_color = uintToColour(THEME_COLOR5_255);
 
-				int text_width = GFX_getTextWidth(font.large, entry_text, cached_display_name, available_width, SCALE1(BUTTON_PADDING * 2));
+				int text_width = TextCache_getTextWidth(font.large, entry_text, cached_display_name, available_width, SCALE1(BUTTON_PADDING * 2));
 				int max_width = MIN(available_width, text_width);
 
 				GFX_clearLayers(4);
@@ -3436,23 +5825,25 @@ int main(int argc, char *argv[])
 				GFX_clearLayers(2);
 				GFX_clearLayers(4);
 				SDL_LockMutex(animMutex);
-				GFX_drawOnLayer(globalpill, pillRect.x, pillRect.y, globallpillW, globalpill->h, 1.0f, 0, 2);
-				GFX_drawOnLayer(globalText, SCALE1(PADDING + BUTTON_PADDING), pilltargetTextY, globalText->w, globalText->h, 1.0f, 0, 4);
+				drawSelectionPill();
+				drawSelectionText();
 				SDL_UnlockMutex(animMutex);
 				PLAT_GPU_Flip();
 			}
+			else if (needDraw)
+			{
+				PLAT_GPU_Flip(); // a transition over the switcher
+				needDraw = 0;
+			}
 			else
 			{
-				SDL_Delay(100);
+				Wakeup_wait(100);
 			}
 			dirty = 0;
 		}
 		else
 		{
 			// want to draw only if needed
-			SDL_LockMutex(bgqueueMutex);
-			SDL_LockMutex(thumbqueueMutex);
-			SDL_LockMutex(animqueueMutex);
 			if (needDraw)
 			{
 				PLAT_GPU_Flip();
@@ -3460,18 +5851,11 @@ int main(int argc, char *argv[])
 			}
 			else
 			{
-				SDL_Delay(17);
+				// nothing moving, sleep until input, finished work or the next clock/status change
+				Wakeup_wait(nextWakeup(show_setting));
 			}
-			SDL_UnlockMutex(bgqueueMutex);
-			SDL_UnlockMutex(thumbqueueMutex);
-			SDL_UnlockMutex(animqueueMutex);
 		}
 
-		SDL_LockMutex(frameMutex);
-		frameReady = true;
-		SDL_CondSignal(flipCond);
-		SDL_UnlockMutex(frameMutex);
-
 		// handle HDMI change
 		static int had_hdmi = -1;
 		int has_hdmi = GetHDMI();
@@ -3488,16 +5872,23 @@ int main(int argc, char *argv[])
 			quit = 1;
 		}
 	}
+	// anything still animating lets go of its surfaces
+	Tween_cancel(&pillTween);
+	Tween_finish(&transition.tween);
 	if (blackBG)
 		SDL_FreeSurface(blackBG);
 	if (version)
 		SDL_FreeSurface(version);
 	if (preview)
 		SDL_FreeSurface(preview);
-	if (folderbgbmp)
-		SDL_FreeSurface(folderbgbmp);
-	if (thumbbmp)
-		SDL_FreeSurface(thumbbmp);
+	Scheduler_quit();
+	TextCache_quit();
+	ArtCache_release(folderbgbmp);
+	ArtCache_release(thumbbmp);
+	ArtCache_release(previewbmp);
+	ArtCache_quit();
+
+	Watcher_quit();
 
 	// Why need to do this?
 	// Menu_quit();
@@ -237,6 +237,7 @@ int main(int argc , char* argv[]) {
 				
 				SDL_Surface* text = TTF_RenderUTF8_Blended(font.tiny, "QUIT", COLOR_LIGHT_TEXT);
 				SDL_BlitSurface(text, NULL, screen, &(SDL_Rect){x,y+(SCALE1(BUTTON_SIZE)-text->h)/2});
+				GFX_markScreen(screen);
 				SDL_FreeSurface(text);
 			}
 			
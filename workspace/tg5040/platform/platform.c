@@ -19,6 +19,7 @@
 #include "utils.h"
 
 #include "scaler.h"
+#include "ktx.h"
 #include <time.h>
 #include <pthread.h>
 
@@ -98,6 +99,9 @@ static struct VID_Context
 	SDL_Texture *target;
 	SDL_Texture *effect;
 	SDL_Texture *overlay;
+	SDL_Texture *scaled; // the software scaled frame, see flipScaled
+	int scaled_w;
+	int scaled_h;
 	SDL_Surface *screen;
 	SDL_GLContext gl_context;
 
@@ -474,6 +478,253 @@ void PLAT_initShaders()
 	LOG_info("default shaders loaded, %i\n\n", g_shader_default);
 }
 
+///////////////////////////////
+// GPU pass timing, only active while the debug hud asks for it.
+// Uses GL_EXT_disjoint_timer_query when the driver exposes it, results are read
+// back a few frames later so we never stall the pipeline. Without the extension
+// we fall back to fences after each pass, which does stall, so its only a rough guide.
+
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+#ifndef GL_QUERY_RESULT_EXT
+#define GL_QUERY_RESULT_EXT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE_EXT
+#define GL_QUERY_RESULT_AVAILABLE_EXT 0x8867
+#endif
+
+enum
+{
+	GPU_PASS_OUTPUT = MAXSHADERS,
+	GPU_PASS_EFFECT,
+	GPU_PASS_OVERLAY,
+	GPU_PASS_COUNT,
+};
+
+#define GPU_TIMER_FRAMES 4		// query sets in flight before reading them back
+#define GPU_TIMER_WINDOW 120	// same window as the cpu monitor rolling averages
+
+typedef void (*gpu_genqueries_t)(GLsizei n, GLuint *ids);
+typedef void (*gpu_deletequeries_t)(GLsizei n, const GLuint *ids);
+typedef void (*gpu_beginquery_t)(GLenum target, GLuint id);
+typedef void (*gpu_endquery_t)(GLenum target);
+typedef void (*gpu_getqueryobjectuiv_t)(GLuint id, GLenum pname, GLuint *params);
+typedef void (*gpu_getqueryobjectui64v_t)(GLuint id, GLenum pname, GLuint64 *params);
+
+static const char *gpu_composite_names[] = {"out", "fx", "ovl"};
+
+static struct GPU_Timers
+{
+	int enabled;
+	int initialized;
+	int has_queries;
+
+	gpu_genqueries_t genQueries;
+	gpu_deletequeries_t deleteQueries;
+	gpu_beginquery_t beginQuery;
+	gpu_endquery_t endQuery;
+	gpu_getqueryobjectuiv_t getQueryObjectuiv;
+	gpu_getqueryobjectui64v_t getQueryObjectui64v;
+
+	GLuint queries[GPU_TIMER_FRAMES][GPU_PASS_COUNT];
+	int pending[GPU_TIMER_FRAMES][GPU_PASS_COUNT];
+	int slot;
+	int active; // pass with an open query or fence, -1 when none
+
+	GLsync fences[GPU_PASS_COUNT];
+	GLsync start_fence;
+
+	float samples[GPU_PASS_COUNT][GPU_TIMER_WINDOW];
+	int sample_index[GPU_PASS_COUNT];
+	int sample_count[GPU_PASS_COUNT];
+} gputimer = {.active = -1};
+
+static void gpuTimerInit(void)
+{
+	gputimer.initialized = 1;
+
+	const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+	if (extensions && strstr(extensions, "GL_EXT_disjoint_timer_query"))
+	{
+		gputimer.genQueries = (gpu_genqueries_t)SDL_GL_GetProcAddress("glGenQueriesEXT");
+		gputimer.deleteQueries = (gpu_deletequeries_t)SDL_GL_GetProcAddress("glDeleteQueriesEXT");
+		gputimer.beginQuery = (gpu_beginquery_t)SDL_GL_GetProcAddress("glBeginQueryEXT");
+		gputimer.endQuery = (gpu_endquery_t)SDL_GL_GetProcAddress("glEndQueryEXT");
+		gputimer.getQueryObjectuiv = (gpu_getqueryobjectuiv_t)SDL_GL_GetProcAddress("glGetQueryObjectuivEXT");
+		gputimer.getQueryObjectui64v = (gpu_getqueryobjectui64v_t)SDL_GL_GetProcAddress("glGetQueryObjectui64vEXT");
+
+		gputimer.has_queries = gputimer.genQueries && gputimer.deleteQueries && gputimer.beginQuery &&
+													 gputimer.endQuery && gputimer.getQueryObjectuiv && gputimer.getQueryObjectui64v;
+	}
+
+	if (gputimer.has_queries)
+		gputimer.genQueries(GPU_TIMER_FRAMES * GPU_PASS_COUNT, &gputimer.queries[0][0]);
+
+	LOG_info("GPU pass timing using %s\n", gputimer.has_queries ? "GL_EXT_disjoint_timer_query" : "fences");
+}
+
+static void gpuTimerAddSample(int pass, float ms)
+{
+	gputimer.samples[pass][gputimer.sample_index[pass]] = ms;
+	gputimer.sample_index[pass] = (gputimer.sample_index[pass] + 1) % GPU_TIMER_WINDOW;
+	if (gputimer.sample_count[pass] < GPU_TIMER_WINDOW)
+		gputimer.sample_count[pass]++;
+}
+
+static void gpuTimerBeginFrame(void)
+{
+	if (!gputimer.enabled)
+		return;
+	if (!gputimer.initialized)
+		gpuTimerInit();
+
+	if (gputimer.has_queries)
+	{
+		// the slot we are about to reuse was submitted GPU_TIMER_FRAMES ago, collect whatever finished
+		gputimer.slot = (gputimer.slot + 1) % GPU_TIMER_FRAMES;
+
+		GLint disjoint = 0;
+		glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+		for (int i = 0; i < GPU_PASS_COUNT; i++)
+		{
+			if (!gputimer.pending[gputimer.slot][i])
+				continue;
+
+			GLuint query = gputimer.queries[gputimer.slot][i];
+			GLuint available = 0;
+			gputimer.getQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+			if (available && !disjoint)
+			{
+				GLuint64 elapsed = 0;
+				gputimer.getQueryObjectui64v(query, GL_QUERY_RESULT_EXT, &elapsed);
+				gpuTimerAddSample(i, elapsed / 1000000.0f);
+			}
+			gputimer.pending[gputimer.slot][i] = 0;
+		}
+	}
+	else
+	{
+		gputimer.start_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+static void gpuTimerBegin(int pass)
+{
+	if (!gputimer.enabled || !gputimer.initialized)
+		return;
+
+	if (gputimer.has_queries)
+		gputimer.beginQuery(GL_TIME_ELAPSED_EXT, gputimer.queries[gputimer.slot][pass]);
+	gputimer.active = pass;
+}
+
+static void gpuTimerEnd(void)
+{
+	if (gputimer.active < 0)
+		return;
+
+	if (gputimer.has_queries)
+	{
+		gputimer.endQuery(GL_TIME_ELAPSED_EXT);
+		gputimer.pending[gputimer.slot][gputimer.active] = 1;
+	}
+	else
+	{
+		gputimer.fences[gputimer.active] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	gputimer.active = -1;
+}
+
+static void gpuTimerEndFrame(void)
+{
+	if (!gputimer.enabled || !gputimer.initialized || gputimer.has_queries || !gputimer.start_fence)
+		return;
+
+	// passes are submitted in order so waiting on each fence in turn gives the time between them
+	glClientWaitSync(gputimer.start_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+	glDeleteSync(gputimer.start_fence);
+	gputimer.start_fence = 0;
+
+	Uint64 last = SDL_GetPerformanceCounter();
+	for (int i = 0; i < GPU_PASS_COUNT; i++)
+	{
+		if (!gputimer.fences[i])
+			continue;
+		glClientWaitSync(gputimer.fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+		glDeleteSync(gputimer.fences[i]);
+		gputimer.fences[i] = 0;
+
+		Uint64 now = SDL_GetPerformanceCounter();
+		gpuTimerAddSample(i, (now - last) * 1000.0f / SDL_GetPerformanceFrequency());
+		last = now;
+	}
+}
+
+static int compareFloats(const void *a, const void *b)
+{
+	float fa = *(const float *)a;
+	float fb = *(const float *)b;
+	return (fa > fb) - (fa < fb);
+}
+
+void PLAT_enableGPUTimers(int enable)
+{
+	if (gputimer.enabled == enable)
+		return;
+	gputimer.enabled = enable;
+
+	for (int i = 0; i < GPU_PASS_COUNT; i++)
+	{
+		if (gputimer.fences[i])
+			glDeleteSync(gputimer.fences[i]);
+		gputimer.fences[i] = 0;
+	}
+	if (gputimer.start_fence)
+		glDeleteSync(gputimer.start_fence);
+	gputimer.start_fence = 0;
+
+	// start from a clean window so old samples dont skew the numbers
+	memset(gputimer.pending, 0, sizeof(gputimer.pending));
+	memset(gputimer.sample_index, 0, sizeof(gputimer.sample_index));
+	memset(gputimer.sample_count, 0, sizeof(gputimer.sample_count));
+}
+
+int PLAT_getGPUPassTimings(GPU_PassTiming *timings, int max)
+{
+	int count = 0;
+	float sorted[GPU_TIMER_WINDOW];
+
+	for (int i = 0; i < GPU_PASS_COUNT && count < max; i++)
+	{
+		int n = gputimer.sample_count[i];
+		if (n == 0)
+			continue;
+
+		float sum = 0;
+		for (int j = 0; j < n; j++)
+		{
+			sorted[j] = gputimer.samples[i][j];
+			sum += sorted[j];
+		}
+		qsort(sorted, n, sizeof(float), compareFloats);
+
+		GPU_PassTiming *timing = &timings[count++];
+		if (i < MAXSHADERS)
+			snprintf(timing->name, sizeof(timing->name), "p%i", i + 1);
+		else
+			snprintf(timing->name, sizeof(timing->name), "%s", gpu_composite_names[i - MAXSHADERS]);
+		timing->avg_ms = sum / n;
+		timing->p95_ms = sorted[(n * 95 - 1) / 100];
+		timing->samples = n;
+	}
+	return count;
+}
+
 SDL_Surface *PLAT_initVideo(void)
 {
 	// TrimUI Brick device hardcoded
@@ -517,6 +768,8 @@ SDL_Surface *PLAT_initVideo(void)
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
 	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
 	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
+	// asking for a driver turns SDL's command batching off, the layer draws want it back on
+	SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
 	SDL_SetHint(SDL_HINT_FRAMEBUFFER_ACCELERATION, "1");
 
 	// SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
@@ -811,10 +1064,254 @@ static void clearVideo(void)
 	}
 }
 
+///////////////////////////////
+
+// textures for the surfaces passed to PLAT_drawOnLayer and the PLAT_animate* helpers.
+// released textures go back to a pool bucketed by their exact size (the layers are
+// sampled with linear filtering, so a padded texture would bleed its unused border
+// into the edges). only surfaces marked with PLAT_markSurface are remembered, by their
+// serial, which is never reused, so a freed and reallocated surface at the same address
+// can't hit a stale texture. whoever writes to a marked surface has to mark it again,
+// unmarked ones are uploaded on every draw like before the cache. surfaces that aren't
+// RGBA8888 are converted for the upload rather than copied into the texture as is
+#define SURFACE_TEXTURE_POOL_SIZE 4
+#define SURFACE_TEXTURE_CACHE_SIZE 6
+
+typedef struct SurfaceTexture
+{
+	SDL_Texture *texture;
+	int w;
+	int h;
+	Uint32 format;		// source surface format, cache entries only
+	uintptr_t serial; // cache entries only, 0 for an unmarked surface's upload which never matches
+	uint32_t last_used;
+} SurfaceTexture;
+
+static struct
+{
+	SurfaceTexture pool[SURFACE_TEXTURE_POOL_SIZE];		// free textures waiting for reuse
+	SurfaceTexture cache[SURFACE_TEXTURE_CACHE_SIZE]; // textures holding a surface's pixels
+	uint32_t tick;
+} surftex;
+
+static uintptr_t surface_serial = 0;
+
+void PLAT_markSurface(SDL_Surface *surface)
+{
+	if (surface)
+		surface->userdata = (void *)__sync_add_and_fetch(&surface_serial, 1);
+}
+
+static void resetTextureState(SDL_Texture *texture)
+{
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	SDL_SetTextureAlphaMod(texture, 255);
+	SDL_SetTextureColorMod(texture, 255, 255, 255);
+}
+
+static SDL_Texture *acquireTexture(int w, int h)
+{
+	for (int i = 0; i < SURFACE_TEXTURE_POOL_SIZE; i++)
+	{
+		SurfaceTexture *entry = &surftex.pool[i];
+		if (entry->texture && entry->w == w && entry->h == h)
+		{
+			SDL_Texture *texture = entry->texture;
+			entry->texture = NULL;
+			return texture;
+		}
+	}
+
+	SDL_Texture *texture = SDL_CreateTexture(vid.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+	if (!texture)
+		LOG_error("Failed to create %ix%i texture: %s\n", w, h, SDL_GetError());
+	return texture;
+}
+
+static void releaseTexture(SDL_Texture *texture, int w, int h)
+{
+	// take an empty slot, otherwise replace the longest idle texture
+	SurfaceTexture *slot = &surftex.pool[0];
+	for (int i = 0; i < SURFACE_TEXTURE_POOL_SIZE; i++)
+	{
+		SurfaceTexture *entry = &surftex.pool[i];
+		if (!entry->texture)
+		{
+			slot = entry;
+			break;
+		}
+		if (entry->last_used < slot->last_used)
+			slot = entry;
+	}
+	if (slot->texture)
+		SDL_DestroyTexture(slot->texture);
+
+	slot->texture = texture;
+	slot->w = w;
+	slot->h = h;
+	slot->last_used = ++surftex.tick;
+}
+
+// returns a texture holding surface's pixels, owned by the cache and valid until the
+// next SURFACE_TEXTURE_CACHE_SIZE surfaces have been requested
+static SDL_Texture *getSurfaceTexture(SDL_Surface *surface)
+{
+	Uint32 format = surface->format->format;
+	uintptr_t serial = (uintptr_t)surface->userdata;
+
+	SurfaceTexture *slot = &surftex.cache[0];
+	for (int i = 0; i < SURFACE_TEXTURE_CACHE_SIZE; i++)
+	{
+		SurfaceTexture *entry = &surftex.cache[i];
+		if (serial && entry->texture && entry->serial == serial && entry->w == surface->w && entry->h == surface->h &&
+				entry->format == format)
+		{
+			entry->last_used = ++surftex.tick;
+			resetTextureState(entry->texture);
+			return entry->texture;
+		}
+		if (!slot->texture)
+			continue;
+		if (!entry->texture || entry->last_used < slot->last_used)
+			slot = entry;
+	}
+
+	if (slot->texture)
+	{
+		releaseTexture(slot->texture, slot->w, slot->h);
+		slot->texture = NULL;
+	}
+
+	SDL_Texture *texture = acquireTexture(surface->w, surface->h);
+	if (!texture)
+		return NULL;
+
+	if (format == SDL_PIXELFORMAT_RGBA8888)
+	{
+		SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch);
+	}
+	else
+	{
+		SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0);
+		if (!converted)
+		{
+			LOG_error("Failed to convert surface for upload: %s\n", SDL_GetError());
+			releaseTexture(texture, surface->w, surface->h);
+			return NULL;
+		}
+		SDL_UpdateTexture(texture, NULL, converted->pixels, converted->pitch);
+		SDL_FreeSurface(converted);
+	}
+	resetTextureState(texture);
+
+	slot->texture = texture;
+	slot->w = surface->w;
+	slot->h = surface->h;
+	slot->format = format;
+	slot->serial = serial;
+	slot->last_used = ++surftex.tick;
+	return texture;
+}
+
+static void freeSurfaceTextures(void)
+{
+	for (int i = 0; i < SURFACE_TEXTURE_POOL_SIZE; i++)
+	{
+		if (surftex.pool[i].texture)
+			SDL_DestroyTexture(surftex.pool[i].texture);
+	}
+	for (int i = 0; i < SURFACE_TEXTURE_CACHE_SIZE; i++)
+	{
+		if (surftex.cache[i].texture)
+			SDL_DestroyTexture(surftex.cache[i].texture);
+	}
+	memset(&surftex, 0, sizeof(surftex));
+}
+
+///////////////////////////////
+
+// what the compositing layers currently hold so a flip can leave out the ones that are
+// fully transparent (copying those blends nothing) and skip re-uploading vid.screen
+// when nothing wrote to it. the upload is the expensive part of a launcher flip, the
+// renderer has to swizzle every pixel of the RGBA8888 surface on the cpu first.
+// vid.screen counts as written once PLAT_markScreen says so (the GFX_blit* helpers do
+// it for their dst), clearing it only does if it had something on it, so a flip where
+// the caller just cleared and drew to the layers leaves the upload out
+static struct
+{
+	int empty[6];			// target_layer1-5 cleared and not drawn to since, index 0 unused
+	int screen_valid; // stream_layer1 holds the pixels of vid.screen
+	int screen_dirty; // vid.screen was written since
+	int screen_blank; // vid.screen cleared and not drawn to since
+} layers;
+static void flipScreen(void);
+
+static SDL_Texture *layerTexture(int layer)
+{
+	switch (layer)
+	{
+	case 2:
+		return vid.target_layer2;
+	case 3:
+		return vid.target_layer3;
+	case 4:
+		return vid.target_layer4;
+	case 5:
+		return vid.target_layer5;
+	default:
+		return vid.target_layer1;
+	}
+}
+
+// sets target as the render target and remembers the layer now has content
+static void drawToLayer(SDL_Texture *target)
+{
+	SDL_SetRenderTarget(vid.renderer, target);
+	for (int i = 1; i <= 5; i++)
+	{
+		if (layerTexture(i) == target)
+			layers.empty[i] = 0;
+	}
+}
+
+static void uploadScreen(void)
+{
+	if (layers.screen_valid && !layers.screen_dirty)
+		return;
+
+	SDL_UpdateTexture(vid.stream_layer1, NULL, vid.screen->pixels, vid.screen->pitch);
+	layers.screen_valid = 1;
+	layers.screen_dirty = 0;
+}
+
+// back to front, leaving out layers with nothing in them. the back buffer is always
+// cleared first so a skipped layer can't let the previous present show through
+static void compositeLayers(void)
+{
+	SDL_RenderClear(vid.renderer);
+	if (!layers.empty[1])
+		SDL_RenderCopy(vid.renderer, vid.target_layer1, NULL, NULL);
+	if (!layers.empty[2])
+		SDL_RenderCopy(vid.renderer, vid.target_layer2, NULL, NULL);
+	SDL_RenderCopy(vid.renderer, vid.stream_layer1, NULL, NULL);
+	if (!layers.empty[3])
+		SDL_RenderCopy(vid.renderer, vid.target_layer3, NULL, NULL);
+	if (!layers.empty[4])
+		SDL_RenderCopy(vid.renderer, vid.target_layer4, NULL, NULL);
+	if (!layers.empty[5])
+		SDL_RenderCopy(vid.renderer, vid.target_layer5, NULL, NULL);
+}
+
+static void freeGlyphAtlases(void);
+static void freeScrollStrip(void);
+static void freeAssetAtlas(void);
 void PLAT_quitVideo(void)
 {
 	clearVideo();
+	scaler_quitPool();
 
+	if (gputimer.has_queries)
+		gputimer.deleteQueries(GPU_TIMER_FRAMES * GPU_PASS_COUNT, &gputimer.queries[0][0]);
 	glFinish();
 	SDL_GL_DeleteContext(vid.gl_context);
 	SDL_FreeSurface(vid.screen);
@@ -825,6 +1322,8 @@ void PLAT_quitVideo(void)
 		SDL_DestroyTexture(vid.effect);
 	if (vid.overlay)
 		SDL_DestroyTexture(vid.overlay);
+	if (vid.scaled)
+		SDL_DestroyTexture(vid.scaled);
 	if (vid.target_layer3)
 		SDL_DestroyTexture(vid.target_layer3);
 	if (vid.target_layer1)
@@ -837,6 +1336,11 @@ void PLAT_quitVideo(void)
 		SDL_DestroyTexture(vid.target_layer5);
 	if (overlay_path)
 		free(overlay_path);
+	freeSurfaceTextures();
+	freeGlyphAtlases();
+	freeScrollStrip();
+	freeAssetAtlas();
+	PLAT_freeMenuBackdrop();
 	SDL_DestroyTexture(vid.stream_layer1);
 	SDL_DestroyRenderer(vid.renderer);
 	SDL_DestroyWindow(vid.window);
@@ -849,6 +1353,18 @@ void PLAT_clearVideo(SDL_Surface *screen)
 {
 	// SDL_FillRect(screen, NULL, 0); // TODO: revisit
 	SDL_FillRect(screen, NULL, SDL_transparentBlack);
+	if (screen == vid.screen && !layers.screen_blank)
+	{
+		layers.screen_dirty = 1;
+		layers.screen_blank = 1;
+	}
+}
+void PLAT_markScreen(SDL_Surface *screen)
+{
+	if (screen != vid.screen)
+		return;
+	layers.screen_dirty = 1;
+	layers.screen_blank = 0;
 }
 void PLAT_clearAll(void)
 {
@@ -904,6 +1420,7 @@ static void resizeVideo(int w, int h, int p)
 	vid.width = w;
 	vid.height = h;
 	vid.pitch = p;
+	layers.screen_valid = 0;
 
 	reloadShaderTextures = 1;
 }
@@ -965,6 +1482,23 @@ static void rgb565_to_rgb888(uint32_t rgb565, uint8_t *r, uint8_t *g, uint8_t *b
 }
 static char *effect_path;
 static int effectUpdated = 0;
+
+// the prepare thread sleeps until something it has to load changes
+static SDL_mutex *prepare_mutex = NULL;
+static SDL_cond *prepare_cond = NULL;
+static int prepare_pending = 1;
+static void wakePrepareThread(void)
+{
+	if (!prepare_mutex)
+	{
+		prepare_pending = 1; // thread not started yet, it checks everything on its first pass
+		return;
+	}
+	SDL_LockMutex(prepare_mutex);
+	prepare_pending = 1;
+	SDL_CondSignal(prepare_cond);
+	SDL_UnlockMutex(prepare_mutex);
+}
 static void updateEffect(void)
 {
 	if (effect.next_scale == effect.scale && effect.next_type == effect.type && effect.next_color == effect.color)
@@ -1074,27 +1608,39 @@ void PLAT_setOverlay(const char *filename, const char *tag)
 		SDL_DestroyTexture(vid.overlay);
 		vid.overlay = NULL;
 	}
-	overlay_path = NULL;
-	overlayUpdated = 1;
 
+	char *path;
 	if (!filename || strcmp(filename, "") == 0)
 	{
-		overlay_path = strdup("");
+		path = strdup("");
 		printf("Skipping overlay update.\n");
-		return;
 	}
-
-	size_t path_len = strlen(OVERLAYS_FOLDER) + strlen(tag) + strlen(filename) + 4; // +3 for slashes and null-terminator
-	overlay_path = malloc(path_len);
-
-	if (!overlay_path)
+	else
 	{
-		perror("malloc failed");
-		return;
+		size_t path_len = strlen(OVERLAYS_FOLDER) + strlen(tag) + strlen(filename) + 4; // +3 for slashes and null-terminator
+		path = malloc(path_len);
+		if (!path)
+		{
+			perror("malloc failed");
+			return;
+		}
+		snprintf(path, path_len, "%s/%s/%s", OVERLAYS_FOLDER, tag, filename);
+		printf("Overlay path set to: %s\n", path);
 	}
 
-	snprintf(overlay_path, path_len, "%s/%s/%s", OVERLAYS_FOLDER, tag, filename);
-	printf("Overlay path set to: %s\n", overlay_path);
+	// the prepare thread copies the path under the same lock, it must never see the flag
+	// without the path it belongs to
+	SDL_mutex *lock = prepare_mutex; // NULL until the thread is started
+	if (lock)
+		SDL_LockMutex(lock);
+	char *old_path = overlay_path;
+	overlay_path = path;
+	overlayUpdated = 1;
+	if (lock)
+		SDL_UnlockMutex(lock);
+	free(old_path);
+
+	wakePrepareThread();
 }
 
 void applyRoundedCorners(SDL_Surface *surface, SDL_Rect *rect, int radius)
@@ -1132,30 +1678,13 @@ void applyRoundedCorners(SDL_Surface *surface, SDL_Rect *rect, int radius)
 
 void PLAT_clearLayers(int layer)
 {
-	if (layer == 0 || layer == 1)
-	{
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer1);
-		SDL_RenderClear(vid.renderer);
-	}
-	if (layer == 0 || layer == 2)
-	{
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer2);
-		SDL_RenderClear(vid.renderer);
-	}
-	if (layer == 0 || layer == 3)
+	for (int i = 1; i <= 5; i++)
 	{
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer3);
-		SDL_RenderClear(vid.renderer);
-	}
-	if (layer == 0 || layer == 4)
-	{
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer4);
-		SDL_RenderClear(vid.renderer);
-	}
-	if (layer == 0 || layer == 5)
-	{
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer5);
+		if (layer != 0 && layer != i)
+			continue;
+		SDL_SetRenderTarget(vid.renderer, layerTexture(i));
 		SDL_RenderClear(vid.renderer);
+		layers.empty[i] = 1;
 	}
 
 	SDL_SetRenderTarget(vid.renderer, NULL);
@@ -1165,39 +1694,11 @@ void PLAT_drawOnLayer(SDL_Surface *inputSurface, int x, int y, int w, int h, flo
 	if (!inputSurface || !vid.target_layer1 || !vid.renderer)
 		return;
 
-	SDL_Texture *tempTexture = SDL_CreateTexture(vid.renderer,
-																							 SDL_PIXELFORMAT_RGBA8888,
-																							 SDL_TEXTUREACCESS_TARGET,
-																							 inputSurface->w, inputSurface->h);
-
+	SDL_Texture *tempTexture = getSurfaceTexture(inputSurface);
 	if (!tempTexture)
-	{
-		printf("Failed to create temporary texture: %s\n", SDL_GetError());
 		return;
-	}
 
-	SDL_UpdateTexture(tempTexture, NULL, inputSurface->pixels, inputSurface->pitch);
-	switch (layer)
-	{
-	case 1:
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer1);
-		break;
-	case 2:
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer2);
-		break;
-	case 3:
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer3);
-		break;
-	case 4:
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer4);
-		break;
-	case 5:
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer5);
-		break;
-	default:
-		SDL_SetRenderTarget(vid.renderer, vid.target_layer1);
-		break;
-	}
+	drawToLayer(layerTexture(layer));
 
 	// Adjust brightness
 	Uint8 r = 255, g = 255, b = 255;
@@ -1232,7 +1733,407 @@ void PLAT_drawOnLayer(SDL_Surface *inputSurface, int x, int y, int w, int h, flo
 
 	SDL_RenderCopy(vid.renderer, tempTexture, &srcRect, &dstRect);
 	SDL_SetRenderTarget(vid.renderer, NULL);
-	SDL_DestroyTexture(tempTexture);
+}
+void PLAT_drawOnLayerOpacity(SDL_Surface *inputSurface, int x, int y, int w, int h, int opacity, int layer)
+{
+	if (!inputSurface || !vid.target_layer1 || !vid.renderer)
+		return;
+
+	SDL_Texture *tempTexture = getSurfaceTexture(inputSurface);
+	if (!tempTexture)
+		return;
+
+	if (opacity < 0)
+		opacity = 0;
+	if (opacity > 255)
+		opacity = 255;
+
+	drawToLayer(layerTexture(layer));
+	SDL_SetTextureAlphaMod(tempTexture, opacity);
+	SDL_RenderCopy(vid.renderer, tempTexture, NULL, &(SDL_Rect){x, y, w, h});
+	SDL_SetRenderTarget(vid.renderer, NULL);
+}
+
+///////////////////////////////
+
+// in-game menu backdrop. the captured frame is uploaded once, blurred by halving it a few
+// times with linear filtering and scaling it back up, darkened with a color mod and kept
+// as a texture, so a menu redraw only copies it into a layer
+#define BACKDROP_BLUR_PASSES 3 // each halves the size, 3 is roughly an 8px blur
+
+static struct
+{
+	SDL_Texture *texture;
+	int w;
+	int h;
+} backdrop;
+
+void PLAT_freeMenuBackdrop(void)
+{
+	if (backdrop.texture)
+		SDL_DestroyTexture(backdrop.texture);
+	backdrop.texture = NULL;
+}
+
+void PLAT_setMenuBackdrop(SDL_Surface *frame, float brightness)
+{
+	PLAT_freeMenuBackdrop();
+	if (!frame || !vid.renderer)
+		return;
+
+	SDL_Texture *source = SDL_CreateTextureFromSurface(vid.renderer, frame);
+	if (!source)
+	{
+		LOG_error("Failed to upload menu backdrop: %s\n", SDL_GetError());
+		return;
+	}
+	// the frame is opaque, and the fresh targets are uninitialized so nothing may blend into them
+	SDL_SetTextureBlendMode(source, SDL_BLENDMODE_NONE);
+
+	SDL_Texture *steps[BACKDROP_BLUR_PASSES] = {0};
+	SDL_Texture *last = source;
+	int w = frame->w;
+	int h = frame->h;
+	for (int i = 0; i < BACKDROP_BLUR_PASSES && w > 1 && h > 1; i++)
+	{
+		w /= 2;
+		h /= 2;
+		steps[i] = SDL_CreateTexture(vid.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+		if (!steps[i])
+			break;
+		SDL_SetTextureBlendMode(steps[i], SDL_BLENDMODE_NONE);
+		SDL_SetRenderTarget(vid.renderer, steps[i]);
+		SDL_RenderCopy(vid.renderer, last, NULL, NULL);
+		last = steps[i];
+	}
+
+	backdrop.w = device_width;
+	backdrop.h = device_height;
+	backdrop.texture = SDL_CreateTexture(vid.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, backdrop.w, backdrop.h);
+	if (backdrop.texture)
+	{
+		Uint8 c = brightness >= 1.0f ? 255 : (Uint8)(255 * brightness);
+		SDL_SetTextureColorMod(last, c, c, c);
+		SDL_SetRenderTarget(vid.renderer, backdrop.texture);
+		SDL_RenderCopy(vid.renderer, last, NULL, NULL);
+		SDL_SetTextureColorMod(last, 255, 255, 255);
+	}
+	SDL_SetRenderTarget(vid.renderer, NULL);
+
+	for (int i = 0; i < BACKDROP_BLUR_PASSES; i++)
+	{
+		if (steps[i])
+			SDL_DestroyTexture(steps[i]);
+	}
+	SDL_DestroyTexture(source);
+}
+
+void PLAT_drawMenuBackdrop(int layer)
+{
+	if (!backdrop.texture)
+		return;
+
+	drawToLayer(layerTexture(layer));
+	SDL_RenderCopy(vid.renderer, backdrop.texture, NULL, NULL);
+	SDL_SetRenderTarget(vid.renderer, NULL);
+}
+
+///////////////////////////////
+
+// glyph atlases for PLAT_drawTextOnLayer. each glyph is rendered white once per font and
+// kept in a texture, a string is then one batched copy per glyph with the color applied
+// as a color mod instead of a TTF render, a surface blit and a screen upload. an atlas
+// that fills up just starts over, so do the least recently used font's
+#define GLYPH_ATLAS_SIZE 512
+#define GLYPH_ATLAS_FONTS 4
+#define GLYPH_ATLAS_GLYPHS 512
+
+typedef struct
+{
+	Uint16 ch;
+	SDL_Rect rect;
+	int minx;
+	int advance;
+} Glyph;
+
+typedef struct
+{
+	TTF_Font *font;
+	SDL_Texture *texture;
+	int pen_x;
+	int pen_y;
+	int row_h;
+	int count;
+	short ascii[128]; // index into glyphs, -1 if not there yet
+	Glyph glyphs[GLYPH_ATLAS_GLYPHS];
+	uint32_t last_used;
+} GlyphAtlas;
+
+static struct
+{
+	GlyphAtlas atlases[GLYPH_ATLAS_FONTS];
+	uint32_t tick;
+} glyphs;
+
+static void resetGlyphAtlas(GlyphAtlas *atlas)
+{
+	atlas->pen_x = 1;
+	atlas->pen_y = 1;
+	atlas->row_h = 0;
+	atlas->count = 0;
+	memset(atlas->ascii, -1, sizeof(atlas->ascii));
+}
+
+static GlyphAtlas *getGlyphAtlas(TTF_Font *font)
+{
+	GlyphAtlas *slot = &glyphs.atlases[0];
+	for (int i = 0; i < GLYPH_ATLAS_FONTS; i++)
+	{
+		GlyphAtlas *atlas = &glyphs.atlases[i];
+		if (atlas->font == font && atlas->texture)
+		{
+			atlas->last_used = ++glyphs.tick;
+			return atlas;
+		}
+		if (atlas->last_used < slot->last_used)
+			slot = atlas;
+	}
+
+	if (!slot->texture)
+	{
+		slot->texture = SDL_CreateTexture(vid.renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE);
+		if (!slot->texture)
+		{
+			LOG_error("Failed to create glyph atlas: %s\n", SDL_GetError());
+			return NULL;
+		}
+		// linear filtering samples the gaps between glyphs, they have to be transparent
+		void *clear = calloc(GLYPH_ATLAS_SIZE * GLYPH_ATLAS_SIZE, 4);
+		if (clear)
+		{
+			SDL_UpdateTexture(slot->texture, NULL, clear, GLYPH_ATLAS_SIZE * 4);
+			free(clear);
+		}
+		// the layers hold straight alpha, so the glyph color is written as is and only
+		// the coverage accumulates, regular blending would darken the edges twice
+		SDL_SetTextureBlendMode(slot->texture, SDL_ComposeCustomBlendMode(
+			SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ZERO, SDL_BLENDOPERATION_ADD,
+			SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD));
+	}
+	slot->font = font;
+	slot->last_used = ++glyphs.tick;
+	resetGlyphAtlas(slot);
+	return slot;
+}
+
+static Glyph *getGlyph(GlyphAtlas *atlas, Uint16 ch)
+{
+	if (ch < 128)
+	{
+		if (atlas->ascii[ch] >= 0)
+			return &atlas->glyphs[atlas->ascii[ch]];
+	}
+	else
+	{
+		for (int i = 0; i < atlas->count; i++)
+		{
+			if (atlas->glyphs[i].ch == ch)
+				return &atlas->glyphs[i];
+		}
+	}
+
+	int minx, maxx, miny, maxy, advance;
+	if (TTF_GlyphMetrics(atlas->font, ch, &minx, &maxx, &miny, &maxy, &advance) != 0)
+		return NULL;
+
+	SDL_Surface *surface = TTF_RenderGlyph_Blended(atlas->font, ch, (SDL_Color){255, 255, 255, 255});
+	if (!surface)
+		return NULL;
+	if (surface->format->format != SDL_PIXELFORMAT_ARGB8888)
+	{
+		SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(surface);
+		if (!converted)
+			return NULL;
+		surface = converted;
+	}
+
+	// next row, or start over when the atlas is full
+	if (atlas->pen_x + surface->w + 1 > GLYPH_ATLAS_SIZE)
+	{
+		atlas->pen_x = 1;
+		atlas->pen_y += atlas->row_h + 1;
+		atlas->row_h = 0;
+	}
+	if (atlas->pen_y + surface->h + 1 > GLYPH_ATLAS_SIZE || atlas->count == GLYPH_ATLAS_GLYPHS)
+		resetGlyphAtlas(atlas);
+	if (surface->w + 2 > GLYPH_ATLAS_SIZE || surface->h + 2 > GLYPH_ATLAS_SIZE)
+	{
+		SDL_FreeSurface(surface);
+		return NULL;
+	}
+
+	Glyph *glyph = &atlas->glyphs[atlas->count];
+	glyph->ch = ch;
+	glyph->rect = (SDL_Rect){atlas->pen_x, atlas->pen_y, surface->w, surface->h};
+	glyph->minx = minx;
+	glyph->advance = advance;
+	SDL_UpdateTexture(atlas->texture, &glyph->rect, surface->pixels, surface->pitch);
+	SDL_FreeSurface(surface);
+
+	atlas->pen_x += glyph->rect.w + 1;
+	if (glyph->rect.h > atlas->row_h)
+		atlas->row_h = glyph->rect.h;
+	if (ch < 128)
+		atlas->ascii[ch] = atlas->count;
+	atlas->count++;
+	return glyph;
+}
+
+// next codepoint of a UTF-8 string, anything outside the BMP or malformed becomes '?'
+static Uint16 nextCodepoint(const char **text)
+{
+	const unsigned char *s = (const unsigned char *)*text;
+	Uint32 c = *s++;
+	int extra = 0;
+	if (c >= 0xF0)
+	{
+		c &= 0x07;
+		extra = 3;
+	}
+	else if (c >= 0xE0)
+	{
+		c &= 0x0F;
+		extra = 2;
+	}
+	else if (c >= 0xC0)
+	{
+		c &= 0x1F;
+		extra = 1;
+	}
+	else if (c >= 0x80)
+	{
+		c = '?';
+	}
+	for (; extra > 0 && (*s & 0xC0) == 0x80; extra--)
+		c = (c << 6) | (*s++ & 0x3F);
+	*text = (const char *)s;
+	return extra || c > 0xFFFF ? '?' : c;
+}
+
+int PLAT_drawTextOnLayer(TTF_Font *font, const char *text, SDL_Color color, int x, int y, int max_width, int layer)
+{
+	if (!font || !text || !vid.renderer)
+		return 0;
+
+	GlyphAtlas *atlas = getGlyphAtlas(font);
+	if (!atlas)
+		return 0;
+
+	drawToLayer(layerTexture(layer));
+	SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+	SDL_SetTextureAlphaMod(atlas->texture, color.a);
+
+	int pen = 0;
+	Uint16 prev = 0;
+	while (*text)
+	{
+		Uint16 ch = nextCodepoint(&text);
+		if (prev)
+			pen += TTF_GetFontKerningSizeGlyphs(font, prev, ch);
+		prev = ch;
+
+		Glyph *glyph = getGlyph(atlas, ch);
+		if (!glyph)
+			continue;
+
+		SDL_Rect src = glyph->rect;
+		SDL_Rect dst = {x + pen + MIN(0, glyph->minx), y, src.w, src.h};
+		if (max_width > 0 && dst.x + dst.w > x + max_width)
+		{
+			src.w = dst.w = x + max_width - dst.x;
+			if (src.w > 0)
+				SDL_RenderCopy(vid.renderer, atlas->texture, &src, &dst);
+			pen = max_width;
+			break;
+		}
+		SDL_RenderCopy(vid.renderer, atlas->texture, &src, &dst);
+		pen += glyph->advance;
+	}
+
+	SDL_SetRenderTarget(vid.renderer, NULL);
+	return pen;
+}
+
+// the UI assets as one texture so pills and icons drawn into a layer are quads from it,
+// batched by SDL into a draw call or two rather than blitted and uploaded
+static SDL_Texture *asset_atlas = NULL;
+
+void PLAT_setAssetAtlas(SDL_Surface *assets)
+{
+	freeAssetAtlas();
+	if (!assets || !vid.renderer)
+		return;
+	asset_atlas = SDL_CreateTextureFromSurface(vid.renderer, assets);
+	if (!asset_atlas)
+	{
+		LOG_warn("asset atlas: %s\n", SDL_GetError());
+		return;
+	}
+	SDL_SetTextureBlendMode(asset_atlas, SDL_BLENDMODE_BLEND);
+}
+
+static void freeAssetAtlas(void)
+{
+	if (asset_atlas)
+		SDL_DestroyTexture(asset_atlas);
+	asset_atlas = NULL;
+}
+
+void PLAT_drawAtlasOnLayer(SDL_Rect *src_rect, SDL_Rect *dst_rect, uint32_t rgb, int layer)
+{
+	if (!asset_atlas)
+		return;
+
+	drawToLayer(layerTexture(layer));
+	SDL_SetTextureColorMod(asset_atlas, (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+	SDL_RenderCopy(vid.renderer, asset_atlas, src_rect, dst_rect);
+	SDL_SetRenderTarget(vid.renderer, NULL);
+}
+
+void PLAT_drawPillOnLayer(SDL_Rect *cap_rect, SDL_Rect *dst_rect, uint32_t rgb, int layer)
+{
+	if (!asset_atlas)
+		return;
+
+	int x = dst_rect->x;
+	int y = dst_rect->y;
+	int h = dst_rect->h;
+	int r = h / 2;
+	int w = MAX(dst_rect->w, h) - h;
+	int half = cap_rect->w / 2;
+
+	drawToLayer(layerTexture(layer));
+	Uint8 cr = (rgb >> 16) & 0xFF, cg = (rgb >> 8) & 0xFF, cb = rgb & 0xFF;
+	SDL_SetTextureColorMod(asset_atlas, cr, cg, cb);
+	SDL_RenderCopy(vid.renderer, asset_atlas, &(SDL_Rect){cap_rect->x, cap_rect->y, half, cap_rect->h}, &(SDL_Rect){x, y, r, h});
+	SDL_RenderCopy(vid.renderer, asset_atlas, &(SDL_Rect){cap_rect->x + half, cap_rect->y, half, cap_rect->h}, &(SDL_Rect){x + r + w, y, r, h});
+	if (w > 0)
+	{
+		SDL_SetRenderDrawColor(vid.renderer, cr, cg, cb, 255);
+		SDL_RenderFillRect(vid.renderer, &(SDL_Rect){x + r, y, w, h});
+	}
+	SDL_SetRenderTarget(vid.renderer, NULL);
+}
+
+static void freeGlyphAtlases(void)
+{
+	for (int i = 0; i < GLYPH_ATLAS_FONTS; i++)
+	{
+		if (glyphs.atlases[i].texture)
+			SDL_DestroyTexture(glyphs.atlases[i].texture);
+	}
+	memset(&glyphs, 0, sizeof(glyphs));
 }
 
 void PLAT_animateSurface(
@@ -1248,18 +2149,10 @@ void PLAT_animateSurface(
 	if (!inputSurface || !vid.target_layer2 || !vid.renderer)
 		return;
 
-	SDL_Texture *tempTexture = SDL_CreateTexture(vid.renderer,
-																							 SDL_PIXELFORMAT_RGBA8888,
-																							 SDL_TEXTUREACCESS_TARGET,
-																							 inputSurface->w, inputSurface->h);
-
+	SDL_Texture *tempTexture = getSurfaceTexture(inputSurface);
 	if (!tempTexture)
-	{
-		printf("Failed to create temporary texture: %s\n", SDL_GetError());
 		return;
-	}
 
-	SDL_UpdateTexture(tempTexture, NULL, inputSurface->pixels, inputSurface->pitch);
 	SDL_SetTextureBlendMode(tempTexture, SDL_BLENDMODE_BLEND); // Enable blending for opacity
 
 	const int fps = 60;
@@ -1284,9 +2177,9 @@ void PLAT_animateSurface(
 		SDL_SetTextureAlphaMod(tempTexture, current_opacity);
 
 		if (layer == 0)
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer2);
+			drawToLayer(vid.target_layer2);
 		else
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer4);
+			drawToLayer(vid.target_layer4);
 
 		SDL_SetRenderDrawColor(vid.renderer, 0, 0, 0, 0);
 		SDL_RenderClear(vid.renderer);
@@ -1298,12 +2191,76 @@ void PLAT_animateSurface(
 		SDL_SetRenderTarget(vid.renderer, NULL);
 		PLAT_GPU_Flip();
 	}
-
-	SDL_DestroyTexture(tempTexture);
 }
 
 static int text_offset = 0;
 
+// the scrolling name as a texture with two copies side by side, kept until the name,
+// font or colour changes instead of being rasterized and uploaded every frame
+static struct
+{
+	SDL_Texture *texture;
+	TTF_Font *font;
+	SDL_Color color;
+	uint32_t background;
+	char *text;
+	int single_width;
+	int single_height;
+	int padding;
+} scroll_strip;
+
+static void freeScrollStrip(void)
+{
+	if (scroll_strip.texture)
+		SDL_DestroyTexture(scroll_strip.texture);
+	free(scroll_strip.text);
+	memset(&scroll_strip, 0, sizeof(scroll_strip));
+}
+
+static SDL_Texture *getScrollStrip(TTF_Font *font, const char *in_name, SDL_Color color, int padding)
+{
+	if (scroll_strip.texture && scroll_strip.font == font && scroll_strip.padding == padding && scroll_strip.background == THEME_COLOR1 &&
+			!memcmp(&scroll_strip.color, &color, sizeof(color)) && !strcmp(scroll_strip.text, in_name))
+		return scroll_strip.texture;
+	freeScrollStrip();
+
+	SDL_Surface *singleSur = TTF_RenderUTF8_Blended(font, in_name, color);
+	if (!singleSur)
+		return NULL;
+
+	int single_width = singleSur->w;
+	int single_height = singleSur->h;
+
+	// Create a surface to hold two copies side by side with padding
+	SDL_Surface *text_surface = SDL_CreateRGBSurfaceWithFormat(0,
+																														 single_width * 2 + padding, single_height, 32, SDL_PIXELFORMAT_RGBA8888);
+
+	SDL_FillRect(text_surface, NULL, THEME_COLOR1);
+	SDL_BlitSurface(singleSur, NULL, text_surface, NULL);
+
+	SDL_Rect second = {single_width + padding, 0, single_width, single_height};
+	SDL_BlitSurface(singleSur, NULL, text_surface, &second);
+	SDL_FreeSurface(singleSur);
+
+	SDL_Texture *texture = SDL_CreateTextureFromSurface(vid.renderer, text_surface);
+	SDL_FreeSurface(text_surface);
+	if (!texture)
+		return NULL;
+
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	SDL_SetTextureAlphaMod(texture, color.a);
+
+	scroll_strip.texture = texture;
+	scroll_strip.font = font;
+	scroll_strip.color = color;
+	scroll_strip.background = THEME_COLOR1;
+	scroll_strip.text = strdup(in_name);
+	scroll_strip.single_width = single_width;
+	scroll_strip.single_height = single_height;
+	scroll_strip.padding = padding;
+	return texture;
+}
+
 int PLAT_resetScrollText(TTF_Font *font, const char *in_name, int max_width)
 {
 	int text_width, text_height;
@@ -1338,36 +2295,14 @@ void PLAT_scrollTextTexture(
 		transparency = 1.0f;
 	color.a = (Uint8)(transparency * 255);
 
-	// Render the original text only once
-	SDL_Surface *singleSur = TTF_RenderUTF8_Blended(font, in_name, color);
-	if (!singleSur)
-		return;
-
-	int single_width = singleSur->w;
-	int single_height = singleSur->h;
-
-	// Create a surface to hold two copies side by side with padding
-	SDL_Surface *text_surface = SDL_CreateRGBSurfaceWithFormat(0,
-																														 single_width * 2 + padding, single_height, 32, SDL_PIXELFORMAT_RGBA8888);
-
-	SDL_FillRect(text_surface, NULL, THEME_COLOR1);
-	SDL_BlitSurface(singleSur, NULL, text_surface, NULL);
-
-	SDL_Rect second = {single_width + padding, 0, single_width, single_height};
-	SDL_BlitSurface(singleSur, NULL, text_surface, &second);
-	SDL_FreeSurface(singleSur);
-
-	SDL_Texture *full_text_texture = SDL_CreateTextureFromSurface(vid.renderer, text_surface);
-	int full_text_width = text_surface->w;
-	SDL_FreeSurface(text_surface);
-
+	SDL_Texture *full_text_texture = getScrollStrip(font, in_name, color, padding);
 	if (!full_text_texture)
 		return;
 
-	SDL_SetTextureBlendMode(full_text_texture, SDL_BLENDMODE_BLEND);
-	SDL_SetTextureAlphaMod(full_text_texture, color.a);
+	int single_width = scroll_strip.single_width;
+	int single_height = scroll_strip.single_height;
 
-	SDL_SetRenderTarget(vid.renderer, vid.target_layer4);
+	drawToLayer(vid.target_layer4);
 
 	SDL_Rect src_rect = {text_offset, 0, w, single_height};
 	SDL_Rect dst_rect = {x, y, w, single_height};
@@ -1375,7 +2310,6 @@ void PLAT_scrollTextTexture(
 	SDL_RenderCopy(vid.renderer, full_text_texture, &src_rect, &dst_rect);
 
 	SDL_SetRenderTarget(vid.renderer, NULL);
-	SDL_DestroyTexture(full_text_texture);
 
 	// Scroll only if text is wider than clip width
 	if (single_width > w)
@@ -1402,13 +2336,7 @@ void PLAT_scrollTextTexture(
 // super fast without update_texture to draw screen
 void PLAT_GPU_Flip()
 {
-	SDL_RenderClear(vid.renderer);
-	SDL_RenderCopy(vid.renderer, vid.target_layer1, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer2, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.stream_layer1, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer3, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer4, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer5, NULL, NULL);
+	compositeLayers();
 	SDL_RenderPresent(vid.renderer);
 }
 
@@ -1431,36 +2359,24 @@ void PLAT_animateAndRevealSurfaces(
 	if (!inputMoveSurface || !inputRevealSurface || !vid.renderer || !vid.target_layer2)
 		return;
 
-	SDL_Texture *moveTexture = SDL_CreateTexture(vid.renderer,
-																							 SDL_PIXELFORMAT_RGBA8888,
-																							 SDL_TEXTUREACCESS_TARGET,
-																							 inputMoveSurface->w, inputMoveSurface->h);
+	SDL_Texture *moveTexture = getSurfaceTexture(inputMoveSurface);
 	if (!moveTexture)
-	{
-		printf("Failed to create move texture: %s\n", SDL_GetError());
 		return;
-	}
-	SDL_UpdateTexture(moveTexture, NULL, inputMoveSurface->pixels, inputMoveSurface->pitch);
 	SDL_SetTextureBlendMode(moveTexture, SDL_BLENDMODE_BLEND);
 
 	SDL_Surface *formatted = SDL_CreateRGBSurfaceWithFormat(0, inputRevealSurface->w, inputRevealSurface->h, 32, SDL_PIXELFORMAT_RGBA8888);
 	if (!formatted)
 	{
-		SDL_DestroyTexture(moveTexture);
 		printf("Failed to create formatted surface for reveal: %s\n", SDL_GetError());
 		return;
 	}
 	SDL_FillRect(formatted, NULL, SDL_MapRGBA(formatted->format, 0, 0, 0, 0));
 	SDL_SetSurfaceBlendMode(inputRevealSurface, SDL_BLENDMODE_BLEND);
 	SDL_BlitSurface(inputRevealSurface, &(SDL_Rect){0, 0, reveal_w, reveal_h}, formatted, &(SDL_Rect){0, 0, reveal_w, reveal_h});
-	SDL_Texture *revealTexture = SDL_CreateTextureFromSurface(vid.renderer, formatted);
+	SDL_Texture *revealTexture = getSurfaceTexture(formatted);
 	SDL_FreeSurface(formatted);
 	if (!revealTexture)
-	{
-		SDL_DestroyTexture(moveTexture);
-		printf("Failed to create reveal texture: %s\n", SDL_GetError());
 		return;
-	}
 	SDL_SetTextureBlendMode(revealTexture, SDL_BLENDMODE_BLEND);
 	SDL_SetTextureAlphaMod(revealTexture, reveal_opacity);
 
@@ -1508,22 +2424,22 @@ void PLAT_animateAndRevealSurfaces(
 		SDL_Rect revealSrc = {reveal_src_x, reveal_src_y, reveal_draw_w, reveal_draw_h};
 		SDL_Rect revealDst = {reveal_x + reveal_src_x, reveal_y + reveal_src_y, reveal_draw_w, reveal_draw_h};
 
-		SDL_SetRenderTarget(vid.renderer, (layer1 == 0) ? vid.target_layer3 : vid.target_layer4);
+		drawToLayer((layer1 == 0) ? vid.target_layer3 : vid.target_layer4);
 		SDL_SetRenderDrawBlendMode(vid.renderer, SDL_BLENDMODE_NONE);
 		SDL_SetRenderDrawColor(vid.renderer, 0, 0, 0, 0);
 		SDL_RenderClear(vid.renderer);
 		SDL_SetRenderDrawBlendMode(vid.renderer, SDL_BLENDMODE_BLEND);
-		SDL_SetRenderTarget(vid.renderer, (2 == 0) ? vid.target_layer3 : vid.target_layer4);
+		drawToLayer((2 == 0) ? vid.target_layer3 : vid.target_layer4);
 		SDL_SetRenderDrawBlendMode(vid.renderer, SDL_BLENDMODE_NONE);
 		SDL_SetRenderDrawColor(vid.renderer, 0, 0, 0, 0);
 		SDL_RenderClear(vid.renderer);
 		SDL_SetRenderDrawBlendMode(vid.renderer, SDL_BLENDMODE_BLEND);
 
-		SDL_SetRenderTarget(vid.renderer, (layer1 == 0) ? vid.target_layer3 : vid.target_layer4);
+		drawToLayer((layer1 == 0) ? vid.target_layer3 : vid.target_layer4);
 		SDL_Rect moveDst = {current_x, current_y, move_w, move_h};
 		SDL_RenderCopy(vid.renderer, moveTexture, NULL, &moveDst);
 
-		SDL_SetRenderTarget(vid.renderer, (layer2 == 0) ? vid.target_layer3 : vid.target_layer4);
+		drawToLayer((layer2 == 0) ? vid.target_layer3 : vid.target_layer4);
 
 		if (reveal_draw_w > 0 && reveal_draw_h > 0)
 			SDL_RenderCopy(vid.renderer, revealTexture, &revealSrc, &revealDst);
@@ -1532,8 +2448,6 @@ void PLAT_animateAndRevealSurfaces(
 		PLAT_GPU_Flip();
 	}
 
-	SDL_DestroyTexture(moveTexture);
-	SDL_DestroyTexture(revealTexture);
 }
 
 void PLAT_animateSurfaceOpacity(
@@ -1546,18 +2460,10 @@ void PLAT_animateSurfaceOpacity(
 	if (!inputSurface)
 		return;
 
-	SDL_Texture *tempTexture = SDL_CreateTexture(vid.renderer,
-																							 SDL_PIXELFORMAT_RGBA8888,
-																							 SDL_TEXTUREACCESS_TARGET,
-																							 inputSurface->w, inputSurface->h);
-
+	SDL_Texture *tempTexture = getSurfaceTexture(inputSurface);
 	if (!tempTexture)
-	{
-		printf("Failed to create temporary texture: %s\n", SDL_GetError());
 		return;
-	}
 
-	SDL_UpdateTexture(tempTexture, NULL, inputSurface->pixels, inputSurface->pitch);
 	SDL_SetTextureBlendMode(tempTexture, SDL_BLENDMODE_BLEND);
 
 	const int fps = 60;
@@ -1566,10 +2472,7 @@ void PLAT_animateSurfaceOpacity(
 
 	SDL_Texture *target_layer = (layer == 0) ? vid.target_layer2 : vid.target_layer4;
 	if (!target_layer)
-	{
-		SDL_DestroyTexture(tempTexture);
 		return;
-	}
 
 	for (int frame = 0; frame <= total_frames; ++frame)
 	{
@@ -1582,7 +2485,7 @@ void PLAT_animateSurfaceOpacity(
 			current_opacity = 255;
 
 		SDL_SetTextureAlphaMod(tempTexture, current_opacity);
-		SDL_SetRenderTarget(vid.renderer, target_layer);
+		drawToLayer(target_layer);
 		SDL_SetRenderDrawColor(vid.renderer, 0, 0, 0, 0);
 		SDL_RenderClear(vid.renderer);
 
@@ -1590,12 +2493,10 @@ void PLAT_animateSurfaceOpacity(
 		SDL_RenderCopy(vid.renderer, tempTexture, NULL, &dstRect);
 
 		SDL_SetRenderTarget(vid.renderer, NULL);
-		// blit to 0 for normal draw
+		// blit to 0 for normal draw, only the layers changed
 		vid.blit = 0;
-		PLAT_flip(vid.screen, 0);
+		flipScreen();
 	}
-
-	SDL_DestroyTexture(tempTexture);
 }
 void PLAT_animateSurfaceOpacityAndScale(
 		SDL_Surface *inputSurface,
@@ -1609,18 +2510,10 @@ void PLAT_animateSurfaceOpacityAndScale(
 	if (!inputSurface || !vid.renderer)
 		return;
 
-	SDL_Texture *tempTexture = SDL_CreateTexture(vid.renderer,
-																							 SDL_PIXELFORMAT_RGBA8888,
-																							 SDL_TEXTUREACCESS_TARGET,
-																							 inputSurface->w, inputSurface->h);
-
+	SDL_Texture *tempTexture = getSurfaceTexture(inputSurface);
 	if (!tempTexture)
-	{
-		printf("Failed to create temporary texture: %s\n", SDL_GetError());
 		return;
-	}
 
-	SDL_UpdateTexture(tempTexture, NULL, inputSurface->pixels, inputSurface->pitch);
 	SDL_SetTextureBlendMode(tempTexture, SDL_BLENDMODE_BLEND);
 
 	const int fps = 60;
@@ -1629,10 +2522,7 @@ void PLAT_animateSurfaceOpacityAndScale(
 
 	SDL_Texture *target_layer = (layer == 0) ? vid.target_layer2 : vid.target_layer4;
 	if (!target_layer)
-	{
-		SDL_DestroyTexture(tempTexture);
 		return;
-	}
 
 	for (int frame = 0; frame <= total_frames; ++frame)
 	{
@@ -1650,7 +2540,7 @@ void PLAT_animateSurfaceOpacityAndScale(
 
 		SDL_SetTextureAlphaMod(tempTexture, current_opacity);
 
-		SDL_SetRenderTarget(vid.renderer, target_layer);
+		drawToLayer(target_layer);
 		SDL_SetRenderDrawColor(vid.renderer, 0, 0, 0, 0);
 		SDL_RenderClear(vid.renderer);
 
@@ -1665,8 +2555,6 @@ void PLAT_animateSurfaceOpacityAndScale(
 		SDL_SetRenderTarget(vid.renderer, NULL);
 		PLAT_GPU_Flip();
 	}
-
-	SDL_DestroyTexture(tempTexture);
 }
 
 SDL_Surface *PLAT_captureRendererToSurface()
@@ -1719,29 +2607,16 @@ void PLAT_animateAndFadeSurface(
 	if (!inputSurface || !vid.renderer)
 		return;
 
-	SDL_Texture *moveTexture = SDL_CreateTexture(vid.renderer,
-																							 SDL_PIXELFORMAT_RGBA8888,
-																							 SDL_TEXTUREACCESS_TARGET,
-																							 inputSurface->w, inputSurface->h);
-
+	SDL_Texture *moveTexture = getSurfaceTexture(inputSurface);
 	if (!moveTexture)
-	{
-		printf("Failed to create move texture: %s\n", SDL_GetError());
 		return;
-	}
-
-	SDL_UpdateTexture(moveTexture, NULL, inputSurface->pixels, inputSurface->pitch);
 
 	SDL_Texture *fadeTexture = NULL;
 	if (fadeSurface)
 	{
-		fadeTexture = SDL_CreateTextureFromSurface(vid.renderer, fadeSurface);
+		fadeTexture = getSurfaceTexture(fadeSurface);
 		if (!fadeTexture)
-		{
-			printf("Failed to create fade texture: %s\n", SDL_GetError());
-			SDL_DestroyTexture(moveTexture);
 			return;
-		}
 		SDL_SetTextureBlendMode(fadeTexture, SDL_BLENDMODE_BLEND);
 	}
 
@@ -1765,27 +2640,7 @@ void PLAT_animateAndFadeSurface(
 		if (current_opacity > 255)
 			current_opacity = 255;
 
-		switch (layer)
-		{
-		case 1:
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer1);
-			break;
-		case 2:
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer2);
-			break;
-		case 3:
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer3);
-			break;
-		case 4:
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer4);
-			break;
-		case 5:
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer5);
-			break;
-		default:
-			SDL_SetRenderTarget(vid.renderer, vid.target_layer1);
-			break;
-		}
+		drawToLayer(layerTexture(layer));
 		SDL_SetRenderDrawColor(vid.renderer, 0, 0, 0, 0);
 		SDL_RenderClear(vid.renderer);
 
@@ -1803,10 +2658,6 @@ void PLAT_animateAndFadeSurface(
 		SDL_SetRenderTarget(vid.renderer, NULL);
 		PLAT_GPU_Flip();
 	}
-
-	SDL_DestroyTexture(moveTexture);
-	if (fadeTexture)
-		SDL_DestroyTexture(fadeTexture);
 }
 
 void PLAT_present()
@@ -1815,11 +2666,19 @@ void PLAT_present()
 }
 void PLAT_setEffect(int next_type)
 {
-	effect.next_type = next_type;
+	if (effect.next_type != next_type)
+	{
+		effect.next_type = next_type;
+		wakePrepareThread();
+	}
 }
 void PLAT_setEffectColor(int next_color)
 {
-	effect.next_color = next_color;
+	if (effect.next_color != next_color)
+	{
+		effect.next_color = next_color;
+		wakePrepareThread();
+	}
 }
 void PLAT_vsync(int remaining)
 {
@@ -1830,8 +2689,15 @@ void PLAT_vsync(int remaining)
 scaler_t PLAT_getScaler(GFX_Renderer *renderer)
 {
 	// LOG_info("getScaler for scale: %i\n", renderer->scale);
-	effect.next_scale = renderer->scale;
-	return scale1x1_c16;
+	if (effect.next_scale != renderer->scale)
+	{
+		effect.next_scale = renderer->scale;
+		wakePrepareThread();
+	}
+
+	// frames reach the blit path as RGBA8888, video_refresh_callback converts them
+	scaler_t scaler = scaler_get(SCALER_FORMAT_32, renderer->scale, renderer->scale);
+	return scaler ? scaler : scale1x1_c32;
 }
 
 void setRectToAspectRatio(SDL_Rect *dst_rect)
@@ -1865,38 +2731,72 @@ void PLAT_clearShaders()
 	vid.blit = NULL;
 }
 
+// the launcher side of PLAT_flip, vid.screen is only uploaded if something wrote to it
+static void flipScreen(void)
+{
+	resizeVideo(device_width, device_height, FIXED_PITCH); // !!!???
+	uploadScreen();
+	compositeLayers();
+	SDL_RenderPresent(vid.renderer);
+}
+
 void PLAT_flipHidden()
 {
-	SDL_RenderClear(vid.renderer);
 	resizeVideo(device_width, device_height, FIXED_PITCH); // !!!???
-	SDL_UpdateTexture(vid.stream_layer1, NULL, vid.screen->pixels, vid.screen->pitch);
-	SDL_RenderCopy(vid.renderer, vid.target_layer1, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer2, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.stream_layer1, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer3, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer4, NULL, NULL);
-	SDL_RenderCopy(vid.renderer, vid.target_layer5, NULL, NULL);
+	uploadScreen();
+	compositeLayers();
 	//  SDL_RenderPresent(vid.renderer); // no present want to flip  hidden
 }
 
+// integer scaling on the cpu with the renderer's own scaler, split across the scaler pool
+// and written straight into a streaming texture the size of the scaled frame so the copy
+// to the screen is 1:1. returns 0 if the frame has to go the texture scaling way instead
+static int flipScaled(void)
+{
+	GFX_Renderer *renderer = vid.blit;
+	if (!renderer->blit || renderer->aspect != 0 || renderer->scale < 2 || renderer->scale > SCALER_MAX_MUL)
+		return 0;
+
+	int w = renderer->src_w * renderer->scale;
+	int h = renderer->src_h * renderer->scale;
+	if (!vid.scaled || vid.scaled_w != w || vid.scaled_h != h)
+	{
+		if (vid.scaled)
+			SDL_DestroyTexture(vid.scaled);
+		vid.scaled = SDL_CreateTexture(vid.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+		vid.scaled_w = w;
+		vid.scaled_h = h;
+	}
+
+	void *pixels;
+	int pitch;
+	if (!vid.scaled || SDL_LockTexture(vid.scaled, NULL, &pixels, &pitch) != 0)
+		return 0;
+	void *src = (uint8_t *)renderer->src + renderer->src_y * renderer->src_p + renderer->src_x * 4; // RGBA8888
+	scaler_run((scaler_t)renderer->blit, src, pixels, renderer->src_w, renderer->src_h, renderer->src_p, w, h, pitch);
+	SDL_UnlockTexture(vid.scaled);
+
+	SDL_Rect dst_rect;
+	setRectToAspectRatio(&dst_rect);
+	SDL_RenderCopy(vid.renderer, vid.scaled, NULL, &dst_rect);
+	SDL_RenderPresent(vid.renderer);
+	return 1;
+}
+
 void PLAT_flip(SDL_Surface *IGNORED, int ignored)
 {
-	// dont think we need this here tbh
-	// SDL_RenderClear(vid.renderer);
 	if (!vid.blit)
 	{
-		resizeVideo(device_width, device_height, FIXED_PITCH); // !!!???
-		SDL_UpdateTexture(vid.stream_layer1, NULL, vid.screen->pixels, vid.screen->pitch);
-		SDL_RenderCopy(vid.renderer, vid.target_layer1, NULL, NULL);
-		SDL_RenderCopy(vid.renderer, vid.target_layer2, NULL, NULL);
-		SDL_RenderCopy(vid.renderer, vid.stream_layer1, NULL, NULL);
-		SDL_RenderCopy(vid.renderer, vid.target_layer3, NULL, NULL);
-		SDL_RenderCopy(vid.renderer, vid.target_layer4, NULL, NULL);
-		SDL_RenderCopy(vid.renderer, vid.target_layer5, NULL, NULL);
-		SDL_RenderPresent(vid.renderer);
+		flipScreen();
+		return;
+	}
+	if (flipScaled())
+	{
+		vid.blit = NULL;
 		return;
 	}
 	SDL_UpdateTexture(vid.stream_layer1, NULL, vid.blit->src, vid.blit->src_p);
+	layers.screen_valid = 0;
 
 	SDL_Texture *target = vid.stream_layer1;
 	int x = vid.blit->src_x;
@@ -2080,86 +2980,256 @@ void runShaderPass(GLuint src_texture, GLuint shader_program, GLuint *target_tex
 	last_program = shader_program;
 }
 
+// decoded effect/overlay images, so switching back and forth doesnt hit the sd card again
+#define FRAME_IMAGE_CACHE_SIZE 4
+
+typedef struct FrameImage
+{
+	char path[MAX_PATH];
+	int compressed; // ktx holds the image instead of surface
+	SDL_Surface *surface;
+	KTX_Image ktx;
+	uint32_t last_used;
+} FrameImage;
+
+static FrameImage frame_images[FRAME_IMAGE_CACHE_SIZE];
+static uint32_t frame_image_clock = 0;
+
+// handed from the prepare thread to the render thread under prepare_mutex. only the
+// prepare thread sets the images and the ready flags, only the render thread clears the
+// flags, and an image stays put (getFrameImage won't evict it) while it's published here
 typedef struct
 {
-	SDL_Surface *loaded_effect;
-	SDL_Surface *loaded_overlay;
+	FrameImage *effect;
+	FrameImage *overlay;
 	int effect_ready;
 	int overlay_ready;
 } FramePreparation;
 
 static FramePreparation frame_prep = {0};
+static int compressed_textures = 1; // cleared if the driver refuses ETC2 uploads
+
+#define FRAME_IMAGE_KTX_PATH USERDATA_PATH "/.ktx"
+#define FRAME_IMAGE_FAILED_MAX 16
+
+// sources that couldn't be transcoded or stored this session, loaded as png from then on.
+// only touched by the prepare thread
+static char *ktx_failed[FRAME_IMAGE_FAILED_MAX];
+static int ktx_failed_count = 0;
+
+static int hasKtxFailed(const char *path)
+{
+	for (int i = 0; i < ktx_failed_count; i++)
+	{
+		if (exactMatch(ktx_failed[i], path))
+			return 1;
+	}
+	return 0;
+}
+
+static void setKtxFailed(const char *path)
+{
+	if (ktx_failed_count < FRAME_IMAGE_FAILED_MAX)
+		ktx_failed[ktx_failed_count++] = strdup(path);
+}
+
+// effects and overlays are uploaded as ETC2 when possible, the png is transcoded once and
+// the result kept in the userdata cache (RES_PATH may be read-only) so later loads skip both
+// decode and encode
+static int loadCompressedImage(const char *path, KTX_Image *ktx)
+{
+	if (hasKtxFailed(path))
+		return -1;
+
+	char ktx_path[MAX_PATH];
+	if (!KTX_getCachePath(FRAME_IMAGE_KTX_PATH, path, ktx_path, sizeof(ktx_path)))
+		return -1;
+	if (KTX_load(ktx_path, ktx) == 0)
+		return 0;
+
+	SDL_Surface *tmp = IMG_Load(path);
+	if (!tmp)
+		return -1;
+	SDL_Surface *rgba = SDL_ConvertSurfaceFormat(tmp, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(tmp);
+	if (!rgba)
+		return -1;
+
+	int result = KTX_encodeRGBA8(rgba->pixels, rgba->w, rgba->h, rgba->pitch, ktx);
+	SDL_FreeSurface(rgba);
+	if (result != 0)
+	{
+		setKtxFailed(path);
+		return -1;
+	}
+
+	mkdir(FRAME_IMAGE_KTX_PATH, 0755);
+	if (KTX_save(ktx_path, ktx) != 0)
+	{
+		// use this transcode, but a png is cheaper to load than to transcode again
+		LOG_warn("Unable to store %s, loading %s as png from now on\n", ktx_path, path);
+		setKtxFailed(path);
+		return 0;
+	}
+
+	KTX_removeStale(ktx_path);
+	LOG_info("Transcoded %s to ETC2\n", path);
+	return 0;
+}
+
+static void freeFrameImage(FrameImage *image)
+{
+	if (image->surface)
+		SDL_FreeSurface(image->surface);
+	KTX_free(&image->ktx);
+	memset(image, 0, sizeof(*image));
+}
+
+// returns the cached image for path, loading it into the least recently used free slot if needed
+static FrameImage *getFrameImage(const char *path)
+{
+	if (!path || !path[0])
+		return NULL;
+
+	int compressed = compressed_textures;
+	FrameImage *slot = NULL;
+	for (int i = 0; i < FRAME_IMAGE_CACHE_SIZE; i++)
+	{
+		FrameImage *image = &frame_images[i];
+		if (image->path[0] && image->compressed == compressed && exactMatch(image->path, path))
+		{
+			image->last_used = ++frame_image_clock;
+			return image;
+		}
+
+		// never evict what the render thread may still be uploading or showing
+		if (image == frame_prep.effect || image == frame_prep.overlay)
+			continue;
+		if (!slot || !image->path[0] || (slot->path[0] && image->last_used < slot->last_used))
+			slot = image;
+	}
+	if (!slot)
+		return NULL;
+
+	freeFrameImage(slot);
+	if (compressed)
+	{
+		if (loadCompressedImage(path, &slot->ktx) != 0)
+			compressed = 0;
+	}
+	if (!compressed)
+	{
+		SDL_Surface *tmp = IMG_Load(path);
+		if (!tmp)
+			return NULL;
+		slot->surface = SDL_ConvertSurfaceFormat(tmp, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(tmp);
+		if (!slot->surface)
+			return NULL;
+	}
+
+	snprintf(slot->path, sizeof(slot->path), "%s", path);
+	slot->compressed = compressed_textures; // a failed transcode is cached as the png so we dont retry every time
+	slot->last_used = ++frame_image_clock;
+	return slot;
+}
 
 int prepareFrameThread(void *data)
 {
 	while (1)
 	{
+		SDL_LockMutex(prepare_mutex);
+		while (!prepare_pending)
+			SDL_CondWait(prepare_cond, prepare_mutex);
+		prepare_pending = 0;
+
 		updateEffect();
 
-		if (effectUpdated)
-		{
-			if (effect_path)
-			{
-				SDL_Surface *tmp = IMG_Load(effect_path);
-				if (tmp)
-				{
-					frame_prep.loaded_effect = SDL_ConvertSurfaceFormat(tmp, SDL_PIXELFORMAT_RGBA32, 0);
-					SDL_FreeSurface(tmp);
-				}
-				else
-				{
-					frame_prep.loaded_effect = 0;
-				}
-			}
-			else
-			{
-				frame_prep.loaded_effect = 0;
-			}
+		// wait for the render thread to pick up the previous image before replacing it,
+		// it wakes us again once it has
+		int load_effect = effectUpdated && !frame_prep.effect_ready;
+		int clear_effect = !load_effect && effect.type == EFFECT_NONE && frame_prep.effect && !frame_prep.effect_ready;
+		int load_overlay = overlayUpdated && !frame_prep.overlay_ready;
+		char path[MAX_PATH];
+		snprintf(path, sizeof(path), "%s", overlay_path ? overlay_path : "");
+		if (load_effect)
 			effectUpdated = 0;
-			frame_prep.effect_ready = 1;
-		}
-		if (effect.type == EFFECT_NONE && frame_prep.loaded_effect != 0)
+		if (load_overlay)
+			overlayUpdated = 0;
+		SDL_UnlockMutex(prepare_mutex);
+
+		// loaded without the lock, and each published before the next load so that one
+		// can't evict it
+		if (load_effect || clear_effect)
 		{
-			frame_prep.loaded_effect = 0;
+			FrameImage *image = load_effect ? getFrameImage(effect_path) : NULL;
+			SDL_LockMutex(prepare_mutex);
+			frame_prep.effect = image;
 			frame_prep.effect_ready = 1;
+			SDL_UnlockMutex(prepare_mutex);
 		}
-
-		if (overlayUpdated)
+		if (load_overlay)
 		{
-
-			if (overlay_path)
-			{
-				SDL_Surface *tmp = IMG_Load(overlay_path);
-				if (tmp)
-				{
-					frame_prep.loaded_overlay = SDL_ConvertSurfaceFormat(tmp, SDL_PIXELFORMAT_RGBA32, 0);
-					SDL_FreeSurface(tmp);
-				}
-				else
-				{
-					frame_prep.loaded_overlay = 0;
-				}
-			}
-			else
-			{
-				frame_prep.loaded_overlay = 0;
-			}
+			FrameImage *image = getFrameImage(path);
+			SDL_LockMutex(prepare_mutex);
+			frame_prep.overlay = image;
 			frame_prep.overlay_ready = 1;
-			overlayUpdated = 0;
+			SDL_UnlockMutex(prepare_mutex);
 		}
-
-		SDL_Delay(50); // Reduced delay for better responsiveness
 	}
 	return 0;
 }
 
+// uploads whichever form of the image the prepare thread produced, returns 0 if there was nothing to upload
+static int uploadFrameImage(GLuint *tex, FrameImage *image, int *w, int *h, int *reload)
+{
+	if (!image)
+		return 0;
+
+	if (!*tex)
+		glGenTextures(1, tex);
+	glBindTexture(GL_TEXTURE_2D, *tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	if (image->ktx.data)
+	{
+		KTX_Image *ktx = &image->ktx;
+		while (glGetError() != GL_NO_ERROR)
+			;
+		glCompressedTexImage2D(GL_TEXTURE_2D, 0, ktx->format, ktx->width, ktx->height, 0, ktx->size, ktx->data);
+		*w = ktx->width;
+		*h = ktx->height;
+
+		if (glGetError() != GL_NO_ERROR)
+		{
+			LOG_warn("ETC2 upload failed, falling back to uncompressed textures\n");
+			compressed_textures = 0;
+			*reload = 1;
+			return 0;
+		}
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->surface->w, image->surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->surface->pixels);
+		*w = image->surface->w;
+		*h = image->surface->h;
+	}
+	return 1;
+}
+
 static SDL_Thread *prepare_thread = NULL;
 
 void PLAT_GL_Swap()
 {
+	SDL_RenderFlush(vid.renderer); // anything batched for the layers goes out before the raw GL
 
 	if (prepare_thread == NULL)
 	{
+		prepare_mutex = SDL_CreateMutex();
+		prepare_cond = SDL_CreateCond();
 		prepare_thread = SDL_CreateThread(prepareFrameThread, "PrepareFrameThread", NULL);
 
 		if (prepare_thread == NULL)
@@ -2184,6 +3254,7 @@ void PLAT_GL_Swap()
 	}
 
 	SDL_GL_MakeCurrent(vid.window, vid.gl_context);
+	gpuTimerBeginFrame();
 
 	static GLuint effect_tex = 0;
 	static int effect_w = 0, effect_h = 0;
@@ -2191,22 +3262,15 @@ void PLAT_GL_Swap()
 	static int overlay_w = 0, overlay_h = 0;
 	static int overlayload = 0;
 
-	if (frame_prep.effect_ready)
+	// the images stay valid until the flags are cleared below, so they're uploaded unlocked
+	SDL_LockMutex(prepare_mutex);
+	FramePreparation prep = frame_prep;
+	SDL_UnlockMutex(prepare_mutex);
+	int effect_reload = 0;
+	int overlay_reload = 0;
+	if (prep.effect_ready)
 	{
-		if (frame_prep.loaded_effect)
-		{
-			if (!effect_tex)
-				glGenTextures(1, &effect_tex);
-			glBindTexture(GL_TEXTURE_2D, effect_tex);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_prep.loaded_effect->w, frame_prep.loaded_effect->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, frame_prep.loaded_effect->pixels);
-			effect_w = frame_prep.loaded_effect->w;
-			effect_h = frame_prep.loaded_effect->h;
-		}
-		else
+		if (!uploadFrameImage(&effect_tex, prep.effect, &effect_w, &effect_h, &effect_reload))
 		{
 			if (effect_tex)
 			{
@@ -2214,25 +3278,11 @@ void PLAT_GL_Swap()
 			}
 			effect_tex = 0;
 		}
-		frame_prep.effect_ready = 0;
 	}
 
-	if (frame_prep.overlay_ready)
+	if (prep.overlay_ready)
 	{
-		if (frame_prep.loaded_overlay)
-		{
-			if (!overlay_tex)
-				glGenTextures(1, &overlay_tex);
-			glBindTexture(GL_TEXTURE_2D, overlay_tex);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_prep.loaded_overlay->w, frame_prep.loaded_overlay->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, frame_prep.loaded_overlay->pixels);
-			overlay_w = frame_prep.loaded_overlay->w;
-			overlay_h = frame_prep.loaded_overlay->h;
-		}
-		else
+		if (!uploadFrameImage(&overlay_tex, prep.overlay, &overlay_w, &overlay_h, &overlay_reload))
 		{
 			if (overlay_tex)
 			{
@@ -2240,7 +3290,19 @@ void PLAT_GL_Swap()
 			}
 			overlay_tex = 0;
 		}
-		frame_prep.overlay_ready = 0;
+	}
+	if (prep.effect_ready || prep.overlay_ready)
+	{
+		// it holds back newer images until we took these
+		SDL_LockMutex(prepare_mutex);
+		if (prep.effect_ready)
+			frame_prep.effect_ready = 0;
+		if (prep.overlay_ready)
+			frame_prep.overlay_ready = 0;
+		effectUpdated |= effect_reload;
+		overlayUpdated |= overlay_reload;
+		SDL_UnlockMutex(prepare_mutex);
+		wakePrepareThread();
 	}
 
 	static GLuint src_texture = 0;
@@ -2276,10 +3338,12 @@ void PLAT_GL_Swap()
 
 	if (nrofshaders < 1)
 	{
+		gpuTimerBegin(GPU_PASS_OUTPUT);
 		runShaderPass(src_texture, g_shader_default, NULL, dst_rect.x, dst_rect.y,
 									dst_rect.w, dst_rect.h,
 									&(Shader){.srcw = vid.blit->src_w, .srch = vid.blit->src_h, .texw = vid.blit->src_w, .texh = vid.blit->src_h},
 									0, GL_NONE);
+		gpuTimerEnd();
 	}
 
 	last_w = vid.blit->src_w;
@@ -2334,6 +3398,7 @@ void PLAT_GL_Swap()
 		}
 		shaderinfocount++;
 
+		gpuTimerBegin(i);
 		if (shaders[i]->shader_p)
 		{
 			runShaderPass(
@@ -2356,6 +3421,7 @@ void PLAT_GL_Swap()
 					0,
 					(i == nrofshaders - 1) ? finalScaleFilter : shaders[i + 1]->filter);
 		}
+		gpuTimerEnd();
 
 		last_w = dst_w;
 		last_h = dst_h;
@@ -2363,6 +3429,7 @@ void PLAT_GL_Swap()
 
 	if (nrofshaders > 0)
 	{
+		gpuTimerBegin(GPU_PASS_OUTPUT);
 		runShaderPass(
 				shaders[nrofshaders - 1]->texture,
 				g_shader_default,
@@ -2370,10 +3437,12 @@ void PLAT_GL_Swap()
 				dst_rect.x, dst_rect.y, dst_rect.w, dst_rect.h,
 				&(Shader){.srcw = last_w, .srch = last_h, .texw = last_w, .texh = last_h},
 				0, GL_NONE);
+		gpuTimerEnd();
 	}
 
 	if (effect_tex)
 	{
+		gpuTimerBegin(GPU_PASS_EFFECT);
 		runShaderPass(
 				effect_tex,
 				g_shader_overlay,
@@ -2381,10 +3450,12 @@ void PLAT_GL_Swap()
 				dst_rect.x, dst_rect.y, effect_w, effect_h,
 				&(Shader){.srcw = effect_w, .srch = effect_h, .texw = effect_w, .texh = effect_h},
 				1, GL_NONE);
+		gpuTimerEnd();
 	}
 
 	if (overlay_tex)
 	{
+		gpuTimerBegin(GPU_PASS_OVERLAY);
 		runShaderPass(
 				overlay_tex,
 				g_shader_overlay,
@@ -2392,8 +3463,10 @@ void PLAT_GL_Swap()
 				0, 0, device_width, device_height,
 				&(Shader){.srcw = vid.blit->src_w, .srch = vid.blit->src_h, .texw = overlay_w, .texh = overlay_h},
 				1, GL_NONE);
+		gpuTimerEnd();
 	}
 
+	gpuTimerEndFrame();
 	SDL_GL_SwapWindow(vid.window);
 	frame_count++;
 	reloadShaderTextures = 0;
@@ -2585,6 +3658,7 @@ double get_process_cpu_time_sec()
 static pthread_mutex_t currentcpuinfo;
 // a roling average for the display values of about 2 frames, otherwise they are unreadable jumping too fast up and down and stuff to read
 #define ROLLING_WINDOW 120
+#define IDLE_CPU_USAGE 10
 
 volatile int useAutoCpu = 1;
 void *PLAT_cpu_monitor(void *arg)
@@ -2600,6 +3674,7 @@ void *PLAT_cpu_monitor(void *arg)
 	const int cpu_frequencies[] = {408, 450, 500, 550, 600, 650, 700, 750, 800, 850, 900, 950, 1000, 1050, 1100, 1150, 1200, 1250, 1300, 1350, 1400, 1450, 1500, 1550, 1600, 1650, 1700, 1750, 1800, 1850, 1900, 1950, 2000};
 	const int num_freqs = sizeof(cpu_frequencies) / sizeof(cpu_frequencies[0]);
 	int current_index = 5;
+	int applied_index = -1;
 
 	double cpu_usage_history[ROLLING_WINDOW] = {0};
 	double cpu_speed_history[ROLLING_WINDOW] = {0};
@@ -2642,7 +3717,11 @@ void *PLAT_cpu_monitor(void *arg)
 				current_index--;
 			}
 
-			PLAT_setCustomCPUSpeed(cpu_frequencies[current_index] * 1000);
+			if (current_index != applied_index)
+			{
+				PLAT_setCustomCPUSpeed(cpu_frequencies[current_index] * 1000);
+				applied_index = current_index;
+			}
 
 			cpu_usage_history[history_index] = cpu_usage;
 			cpu_speed_history[history_index] = cpu_frequencies[current_index];
@@ -2668,7 +3747,11 @@ void *PLAT_cpu_monitor(void *arg)
 			prev_real_time = curr_real_time;
 			prev_cpu_time = curr_cpu_time;
 			// Optimized CPU monitoring interval - balance between accuracy and overhead
-			usleep(20000);
+			// an idle launcher sitting at the lowest clock gets checked less often
+			if (current_index == 0 && cpu_usage < IDLE_CPU_USAGE)
+				usleep(250000);
+			else
+				usleep(20000);
 		}
 		else
 		{
@@ -2971,131 +4054,257 @@ void PLAT_initLeds(LightSettings *lights)
 	LOG_info("lights setup\n");
 }
 
-#define LED_PATH1 "/sys/class/led_anim/max_scale"
-#define LED_PATH2 "/sys/class/led_anim/max_scale_lr"
-#define LED_PATH3 "/sys/class/led_anim/max_scale_f1f2"
+// PLAT_setLed* only record what each led should show, a writer thread diffs that against
+// what was last written and writes just the changed sysfs files, at most once per
+// LED_FLUSH_INTERVAL and through fds that stay open. ambient mode and the battery monitor
+// can call them as often as they like without touching sysfs
 
-void PLAT_setLedInbrightness(LightSettings *led)
+#define LED_SYSFS_PATH "/sys/class/led_anim/"
+#define LED_FLUSH_INTERVAL 50 // ms
+
+// also the write order, the effect goes last because writing it applies the rest
+enum
 {
-	char filepath[256];
-	FILE *file;
-	// TrimUI Brick LED configuration hardcoded
-	if (strcmp(led->filename, "m") == 0)
-	{
-		snprintf(filepath, sizeof(filepath), LED_PATH1);
-	}
-	else if (strcmp(led->filename, "f1") == 0)
-	{
-		snprintf(filepath, sizeof(filepath), LED_PATH3);
+	LED_FILE_SCALE, // brightness and inbrightness share max_scale_*
+	LED_FILE_CYCLES,
+	LED_FILE_DURATION,
+	LED_FILE_RGB,
+	LED_FILE_EFFECT,
+	LED_FILE_COUNT,
+};
+
+typedef struct
+{
+	int fd; // -1 until opened, -2 if there's nothing to open
+	int wanted;
+	int written;
+	int has_written;
+	int pending;	 // requested since the last flush
+	int retrigger; // write even if unchanged, restarts a finite animation
+} LedFile;
+
+typedef struct
+{
+	char filename[32];
+	LedFile files[LED_FILE_COUNT];
+} LedSlot;
+
+typedef struct
+{
+	LedSlot *slot;
+	int file;
+	int value;
+} LedWrite;
+
+static struct LED_Context
+{
+	pthread_mutex_t lock; // slots and requests
+	pthread_mutex_t io;		// fds, one flush at a time
+	pthread_cond_t wake;
+	pthread_t pt;
+	int started;
+	int dirty;
+	int slot_count;
+	LedSlot slots[MAX_LIGHTS + 1];
+} leds = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.io = PTHREAD_MUTEX_INITIALIZER,
+		.wake = PTHREAD_COND_INITIALIZER,
+};
+
+static int LED_getPath(const char *filename, int file, char *path, size_t size)
+{
+	switch (file)
+	{
+	case LED_FILE_SCALE:
+		// TrimUI Brick LED configuration hardcoded, f1 and f2 share one scale
+		if (strcmp(filename, "m") == 0)
+			snprintf(path, size, LED_SYSFS_PATH "max_scale");
+		else if (strcmp(filename, "f1") == 0)
+			snprintf(path, size, LED_SYSFS_PATH "max_scale_f1f2");
+		else if (strcmp(filename, "f2") == 0)
+			return 0;
+		else
+			snprintf(path, size, LED_SYSFS_PATH "max_scale_%s", filename);
+		return 1;
+	case LED_FILE_CYCLES:
+		snprintf(path, size, LED_SYSFS_PATH "effect_cycles_%s", filename);
+		return 1;
+	case LED_FILE_DURATION:
+		snprintf(path, size, LED_SYSFS_PATH "effect_duration_%s", filename);
+		return 1;
+	case LED_FILE_RGB:
+		snprintf(path, size, LED_SYSFS_PATH "effect_rgb_hex_%s", filename);
+		return 1;
+	case LED_FILE_EFFECT:
+		snprintf(path, size, LED_SYSFS_PATH "effect_%s", filename);
+		return 1;
 	}
-	else
+	return 0;
+}
+
+// called with io held
+static void LED_write(LedSlot *slot, int file, int value)
+{
+	LedFile *f = &slot->files[file];
+	if (f->fd == -1)
 	{
-		snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/max_scale_%s", led->filename);
+		char path[256];
+		f->fd = -2;
+		if (LED_getPath(slot->filename, file, path, sizeof(path)))
+		{
+			// the files are kept read-only between writes, the fd stays writable once open
+			PLAT_chmod(path, 1);
+			int fd = open(path, O_WRONLY | O_CLOEXEC);
+			PLAT_chmod(path, 0);
+			if (fd >= 0)
+				f->fd = fd;
+			else
+				LOG_warn("unable to open %s: %s\n", path, strerror(errno));
+		}
 	}
+	if (f->fd < 0)
+		return;
+
+	char buf[16];
+	int len = file == LED_FILE_RGB ? snprintf(buf, sizeof(buf), "%06X\n", value) : snprintf(buf, sizeof(buf), "%i\n", value);
+	if (pwrite(f->fd, buf, len, 0) < 0)
+		LOG_warn("led write failed %s %i: %s\n", slot->filename, file, strerror(errno));
+}
 
-	if (strcmp(led->filename, "f2") != 0)
+// called with lock held, moves every requested change into writes
+static int LED_collect(LedWrite *writes)
+{
+	int count = 0;
+	for (int i = 0; i < leds.slot_count; i++)
 	{
-		// do nothing for f2
-		PLAT_chmod(filepath, 1);
-		file = fopen(filepath, "w");
-		if (file != NULL)
+		LedSlot *slot = &leds.slots[i];
+		int changed = 0;
+		for (int file = 0; file < LED_FILE_COUNT; file++)
 		{
-			fprintf(file, "%i\n", led->inbrightness);
-			fclose(file);
+			LedFile *f = &slot->files[file];
+			if (!f->pending)
+				continue;
+
+			int needed = !f->has_written || f->written != f->wanted || f->retrigger;
+			if (file == LED_FILE_EFFECT)
+				needed = needed || changed; // rewriting the effect is what applies the other files
+			if (needed)
+			{
+				writes[count++] = (LedWrite){slot, file, f->wanted};
+				f->written = f->wanted;
+				f->has_written = 1;
+				changed = 1;
+			}
+			f->pending = 0;
+			f->retrigger = 0;
 		}
-		PLAT_chmod(filepath, 0);
 	}
+	leds.dirty = 0;
+	return count;
 }
-void PLAT_setLedBrightness(LightSettings *led)
+
+void PLAT_flushLeds(void)
 {
-	char filepath[256];
-	FILE *file;
-	// TrimUI Brick LED configuration hardcoded
-	if (strcmp(led->filename, "m") == 0)
+	LedWrite writes[(MAX_LIGHTS + 1) * LED_FILE_COUNT];
+
+	pthread_mutex_lock(&leds.io);
+	pthread_mutex_lock(&leds.lock);
+	int count = LED_collect(writes);
+	pthread_mutex_unlock(&leds.lock);
+
+	for (int i = 0; i < count; i++)
+		LED_write(writes[i].slot, writes[i].file, writes[i].value);
+	pthread_mutex_unlock(&leds.io);
+}
+
+static void *LED_thread(void *arg)
+{
+	while (1)
+	{
+		pthread_mutex_lock(&leds.lock);
+		while (!leds.dirty)
+			pthread_cond_wait(&leds.wake, &leds.lock);
+		pthread_mutex_unlock(&leds.lock);
+
+		PLAT_flushLeds();
+		SDL_Delay(LED_FLUSH_INTERVAL); // anything requested meanwhile goes out together
+	}
+	return 0;
+}
+
+static void LED_request(LightSettings *led, int file, int value, int retrigger)
+{
+	pthread_mutex_lock(&leds.lock);
+
+	LedSlot *slot = NULL;
+	for (int i = 0; i < leds.slot_count; i++)
 	{
-		snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/max_scale");
+		if (strcmp(leds.slots[i].filename, led->filename) == 0)
+		{
+			slot = &leds.slots[i];
+			break;
+		}
 	}
-	else if (strcmp(led->filename, "f1") == 0)
+	if (!slot && leds.slot_count < MAX_LIGHTS + 1)
 	{
-		snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/max_scale_f1f2");
+		slot = &leds.slots[leds.slot_count++];
+		snprintf(slot->filename, sizeof(slot->filename), "%s", led->filename);
+		for (int i = 0; i < LED_FILE_COUNT; i++)
+			slot->files[i] = (LedFile){.fd = -1};
 	}
-	else
+	if (!slot)
 	{
-		snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/max_scale_%s", led->filename);
+		pthread_mutex_unlock(&leds.lock);
+		return;
 	}
 
-	if (strcmp(led->filename, "f2") != 0)
+	LedFile *f = &slot->files[file];
+	f->wanted = value;
+	f->pending = 1;
+	f->retrigger |= retrigger;
+	leds.dirty = 1;
+
+	if (!leds.started)
 	{
-		// do nothing for f2
-		PLAT_chmod(filepath, 1);
-		file = fopen(filepath, "w");
-		if (file != NULL)
+		if (pthread_create(&leds.pt, NULL, &LED_thread, NULL) == 0)
 		{
-			fprintf(file, "%i\n", led->brightness);
-			fclose(file);
+			pthread_detach(leds.pt);
+			atexit(PLAT_flushLeds); // don't lose the last state on the way out
+			leds.started = 1;
 		}
-		PLAT_chmod(filepath, 0);
 	}
+	pthread_cond_signal(&leds.wake);
+	pthread_mutex_unlock(&leds.lock);
+
+	if (!leds.started)
+		PLAT_flushLeds(); // no thread, write it now
+}
+
+void PLAT_setLedInbrightness(LightSettings *led)
+{
+	LED_request(led, LED_FILE_SCALE, led->inbrightness, 0);
+}
+void PLAT_setLedBrightness(LightSettings *led)
+{
+	LED_request(led, LED_FILE_SCALE, led->brightness, 0);
 }
 void PLAT_setLedEffect(LightSettings *led)
 {
-	char filepath[256];
-	FILE *file;
-	// first set brightness
-	snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/effect_%s", led->filename);
-	PLAT_chmod(filepath, 1);
-	file = fopen(filepath, "w");
-	if (file != NULL)
-	{
-		fprintf(file, "%i\n", led->effect);
-		fclose(file);
-	}
-	PLAT_chmod(filepath, 0);
+	// a finite animation has to be restarted even if it's the same one
+	LED_request(led, LED_FILE_EFFECT, led->effect, led->cycles != -1);
 }
 void PLAT_setLedEffectCycles(LightSettings *led)
 {
-	char filepath[256];
-	FILE *file;
-	// first set brightness
-	snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/effect_cycles_%s", led->filename);
-	PLAT_chmod(filepath, 1);
-	file = fopen(filepath, "w");
-	if (file != NULL)
-	{
-		fprintf(file, "%i\n", led->cycles);
-		fclose(file);
-	}
-	PLAT_chmod(filepath, 0);
+	LED_request(led, LED_FILE_CYCLES, led->cycles, 0);
 }
 void PLAT_setLedEffectSpeed(LightSettings *led)
 {
-	char filepath[256];
-	FILE *file;
-	// first set brightness
-	snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/effect_duration_%s", led->filename);
-	PLAT_chmod(filepath, 1);
-	file = fopen(filepath, "w");
-	if (file != NULL)
-	{
-		fprintf(file, "%i\n", led->speed);
-		fclose(file);
-	}
-	PLAT_chmod(filepath, 0);
+	LED_request(led, LED_FILE_DURATION, led->speed, 0);
 }
 void PLAT_setLedColor(LightSettings *led)
 {
-	char filepath[256];
-	FILE *file;
-	// first set brightness
-	snprintf(filepath, sizeof(filepath), "/sys/class/led_anim/effect_rgb_hex_%s", led->filename);
-	PLAT_chmod(filepath, 1);
-	file = fopen(filepath, "w");
-	if (file != NULL)
-	{
-		fprintf(file, "%06X\n", led->color1);
-		fclose(file);
-	}
-	PLAT_chmod(filepath, 0);
+	LED_request(led, LED_FILE_RGB, led->color1, 0);
 }
 
 //////////////////////////////////////////////
@@ -128,6 +128,13 @@
 
 ///////////////////////////////
 
+// AdvSIMD is mandatory on the a53, the check keeps host builds of the common code on C
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAS_NEON
+#endif
+
+///////////////////////////////
+
 #define MAIN_ROW_COUNT 7
 #define PADDING 5
 